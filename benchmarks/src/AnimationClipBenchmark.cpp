@@ -0,0 +1,170 @@
+#include "Benchmark.h"
+#include "BenchmarkGame.h"
+
+// The number of clips playing at once.
+#define CLIP_COUNT 200
+// The duration of the clips, in milliseconds.
+#define CLIP_DURATION 1000
+// The number of events in each clip, such as footsteps and sounds.
+#define CLIP_EVENT_COUNT 64
+// The time of a frame, in milliseconds.
+#define CLIP_FRAME_TIME 16.0f
+// The number of characters in the crowd.
+#define CROWD_CHARACTER_COUNT 300
+// The number of joints of each character, each animated by its own clip.
+#define CROWD_JOINT_COUNT 16
+// The number of keyframes of the clip of a joint.
+#define CROWD_KEY_COUNT 9
+
+/**
+ * Listener that counts the events it receives, and plays the clips again when they
+ * end. Events are timed from the start of a clip, so a repeating clip would only
+ * send them the first time through.
+ */
+class EventCounter : public AnimationClip::Listener
+{
+public:
+
+    EventCounter() : eventCount(0)
+    {
+    }
+
+    void animationEvent(AnimationClip* clip, EventType type)
+    {
+        if (type == TIME)
+            ++eventCount;
+        else if (type == END)
+            clip->play();
+    }
+
+    unsigned int eventCount;
+};
+
+static void clipListenerBenchmark(Benchmark* benchmark)
+{
+    BenchmarkGame* game = static_cast<BenchmarkGame*>(Game::getInstance());
+
+    EventCounter counter;
+    std::vector<Node*> nodes;
+    std::vector<AnimationClip*> clips;
+    unsigned int keyTimes[] = { 0, CLIP_DURATION };
+    float keyValues[] = { 0.0f, 1.0f };
+    for (unsigned int i = 0; i < CLIP_COUNT; ++i)
+    {
+        Node* node = Node::create();
+        Animation* animation = node->createAnimation("walk", Transform::ANIMATE_TRANSLATE_X, 2, keyTimes, keyValues, Curve::LINEAR);
+        AnimationClip* clip = animation->getClip();
+        clip->addEndListener(&counter);
+        clip->play();
+        nodes.push_back(node);
+        clips.push_back(clip);
+    }
+    AnimationClip** c = &clips[0];
+
+    // The clips without events, for the cost of the rest of the update.
+    benchmark->measure("200 clips, no events", CLIP_COUNT, [game]
+    {
+        game->updateSystems(CLIP_FRAME_TIME);
+    });
+
+    for (unsigned int i = 0; i < CLIP_COUNT; ++i)
+    {
+        for (unsigned int j = 0; j < CLIP_EVENT_COUNT; ++j)
+        {
+            c[i]->addListener(&counter, j * CLIP_DURATION / CLIP_EVENT_COUNT);
+        }
+    }
+    benchmark->measure("200 clips x 64 events, dispatch", CLIP_COUNT, [game]
+    {
+        game->updateSystems(CLIP_FRAME_TIME);
+    });
+
+    // Every frame, each clip has one of its events moved to another time, as when
+    // gameplay code adds and removes footstep events.
+    unsigned int frame = 0;
+    benchmark->measure("200 clips x 64 events, add and remove", CLIP_COUNT, [game, c, &counter, &frame]
+    {
+        unsigned int from = (frame % CLIP_EVENT_COUNT) * CLIP_DURATION / CLIP_EVENT_COUNT;
+        unsigned int to = from + CLIP_DURATION / (2 * CLIP_EVENT_COUNT);
+        if (frame / CLIP_EVENT_COUNT % 2)
+            std::swap(from, to);
+        ++frame;
+
+        for (unsigned int i = 0; i < CLIP_COUNT; ++i)
+        {
+            c[i]->removeListener(&counter, from);
+            c[i]->addListener(&counter, to);
+        }
+        game->updateSystems(CLIP_FRAME_TIME);
+    });
+
+    benchmark->report("events dispatched", "%u", counter.eventCount);
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        clips[i]->removeEndListener(&counter);
+        clips[i]->stop();
+        SAFE_RELEASE(nodes[i]);
+    }
+}
+
+static Benchmark clipListeners("clip-listeners", &clipListenerBenchmark);
+
+static void crowdBenchmark(Benchmark* benchmark)
+{
+    BenchmarkGame* game = static_cast<BenchmarkGame*>(Game::getInstance());
+
+    // Each character is a chain of joints swinging about their z axis, at its own speed.
+    unsigned int keyTimes[CROWD_KEY_COUNT];
+    float keyValues[CROWD_KEY_COUNT * 4];
+    for (unsigned int k = 0; k < CROWD_KEY_COUNT; ++k)
+    {
+        keyTimes[k] = k * CLIP_DURATION / (CROWD_KEY_COUNT - 1);
+        Quaternion rotation;
+        Quaternion::createFromAxisAngle(Vector3::unitZ(), sinf(k * MATH_PIX2 / (CROWD_KEY_COUNT - 1)) * 0.3f, &rotation);
+        memcpy(&keyValues[k * 4], &rotation.x, 4 * sizeof(float));
+    }
+    std::vector<Node*> characters;
+    std::vector<AnimationClip*> clips;
+    for (unsigned int i = 0; i < CROWD_CHARACTER_COUNT; ++i)
+    {
+        Node* character = Node::create();
+        Node* parent = character;
+        for (unsigned int j = 0; j < CROWD_JOINT_COUNT; ++j)
+        {
+            Node* joint = Node::create();
+            joint->setTranslation(0.0f, 0.1f, 0.0f);
+            parent->addChild(joint);
+            parent = joint;
+
+            Animation* animation = joint->createAnimation("walk", Transform::ANIMATE_ROTATE, CROWD_KEY_COUNT, keyTimes, keyValues, Curve::LINEAR);
+            AnimationClip* clip = animation->getClip();
+            clip->setRepeatCount(AnimationClip::REPEAT_INDEFINITE);
+            clip->setSpeed(0.8f + (i % 5) * 0.1f);
+            clip->play();
+            clips.push_back(clip);
+            SAFE_RELEASE(joint);
+        }
+        characters.push_back(character);
+    }
+
+    // The number of job threads is set by the jobThreads property of game.config.
+    // Run this with 1 to N threads to see how evaluating the clips scales.
+    unsigned int threadCount = game->getJobController()->getWorkerCount() + 1;
+    benchmark->report("job threads", "%u", threadCount);
+    benchmark->measure("300 characters x 16 joints, update", CROWD_CHARACTER_COUNT, [game]
+    {
+        game->updateSystems(CLIP_FRAME_TIME);
+    });
+
+    for (size_t i = 0; i < clips.size(); ++i)
+    {
+        clips[i]->stop();
+    }
+    for (size_t i = 0; i < characters.size(); ++i)
+    {
+        SAFE_RELEASE(characters[i]);
+    }
+}
+
+static Benchmark crowd("animation-crowd", &crowdBenchmark);
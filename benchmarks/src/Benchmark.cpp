@@ -0,0 +1,97 @@
+#include "Benchmark.h"
+
+// The number of rounds a kernel is timed over.
+#define BENCHMARK_ROUND_COUNT 5
+// The minimum time of a round, in milliseconds.
+#define BENCHMARK_ROUND_TIME 200.0
+
+Benchmark::Benchmark(const char* name, Function function)
+    : _name(name), _function(function)
+{
+    GP_ASSERT(name);
+    GP_ASSERT(function);
+    getBenchmarks().push_back(this);
+}
+
+const char* Benchmark::getName() const
+{
+    return _name;
+}
+
+void Benchmark::run()
+{
+    print("%s\n", _name);
+    _function(this);
+}
+
+double Benchmark::measure(const char* label, unsigned int itemCount, const Kernel& kernel)
+{
+    GP_ASSERT(label);
+    GP_ASSERT(kernel);
+
+    kernel();
+
+    double best = 0.0;
+    for (unsigned int round = 0; round < BENCHMARK_ROUND_COUNT; ++round)
+    {
+        unsigned int runCount = 0;
+        double start = Game::getAbsoluteTime();
+        double elapsed;
+        do
+        {
+            kernel();
+            ++runCount;
+            elapsed = Game::getAbsoluteTime() - start;
+        }
+        while (elapsed < BENCHMARK_ROUND_TIME);
+
+        double time = elapsed / runCount;
+        if (round == 0 || time < best)
+        {
+            best = time;
+        }
+    }
+
+    if (itemCount > 0)
+    {
+        print("  %-48s %12.4f ms %14.1f /ms\n", label, best, itemCount / best);
+    }
+    else
+    {
+        print("  %-48s %12.4f ms\n", label, best);
+    }
+    return best;
+}
+
+double Benchmark::measureOnce(const char* label, const Kernel& kernel)
+{
+    GP_ASSERT(label);
+    GP_ASSERT(kernel);
+
+    double start = Game::getAbsoluteTime();
+    kernel();
+    double time = Game::getAbsoluteTime() - start;
+
+    print("  %-48s %12.4f ms\n", label, time);
+    return time;
+}
+
+void Benchmark::report(const char* label, const char* format, ...)
+{
+    GP_ASSERT(label);
+    GP_ASSERT(format);
+
+    char value[256];
+    va_list arguments;
+    va_start(arguments, format);
+    vsnprintf(value, sizeof(value), format, arguments);
+    va_end(arguments);
+
+    print("  %-48s %15s\n", label, value);
+}
+
+std::vector<Benchmark*>& Benchmark::getBenchmarks()
+{
+    static std::vector<Benchmark*> benchmarks;
+    return benchmarks;
+}
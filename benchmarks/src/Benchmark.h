@@ -0,0 +1,105 @@
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include "gameplay.h"
+
+using namespace gameplay;
+
+/**
+ * Defines a benchmark, a function that times kernels of the engine and prints the results.
+ *
+ * A benchmark registers itself when it is constructed, so a static Benchmark declared
+ * in a source file is all it takes for the BenchmarkGame to run it.
+ */
+class Benchmark
+{
+public:
+
+    /**
+     * Function that sets up the data of a benchmark and times its kernels.
+     */
+    typedef void (*Function)(Benchmark* benchmark);
+
+    /**
+     * Function that runs a kernel once.
+     */
+    typedef std::function<void()> Kernel;
+
+    /**
+     * Constructor. Registers the benchmark.
+     *
+     * @param name The name of the benchmark.
+     * @param function The function of the benchmark.
+     */
+    Benchmark(const char* name, Function function);
+
+    /**
+     * Gets the name of the benchmark.
+     *
+     * @return The name of the benchmark.
+     */
+    const char* getName() const;
+
+    /**
+     * Runs the benchmark.
+     */
+    void run();
+
+    /**
+     * Times a kernel and prints the result.
+     *
+     * The kernel is run once to warm up, then over several rounds that each run it for at
+     * least a minimum time. The time of the fastest round is reported, since it is the one
+     * least disturbed by the rest of the system.
+     *
+     * @param label The label of the result.
+     * @param itemCount The number of items the kernel processes each time it runs, used to
+     *      print the rate in items per millisecond, or 0 to print the time only.
+     * @param kernel The kernel.
+     *
+     * @return The time of one run of the kernel, in milliseconds.
+     */
+    double measure(const char* label, unsigned int itemCount, const Kernel& kernel);
+
+    /**
+     * Times a kernel that runs only once, such as a load, and prints the result.
+     *
+     * @param label The label of the result.
+     * @param kernel The kernel.
+     *
+     * @return The time of the kernel, in milliseconds.
+     */
+    double measureOnce(const char* label, const Kernel& kernel);
+
+    /**
+     * Prints a result that is not a time, such as a size or a count.
+     *
+     * @param label The label of the result.
+     * @param format The format of the value, as for printf.
+     */
+    void report(const char* label, const char* format, ...);
+
+    /**
+     * Gets the registered benchmarks.
+     *
+     * @return The benchmarks, in the order they were registered.
+     */
+    static std::vector<Benchmark*>& getBenchmarks();
+
+private:
+
+    /**
+     * Hidden copy constructor.
+     */
+    Benchmark(const Benchmark& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    Benchmark& operator=(const Benchmark&);
+
+    const char* _name;
+    Function _function;
+};
+
+#endif
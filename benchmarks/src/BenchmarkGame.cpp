@@ -0,0 +1,51 @@
+#include "BenchmarkGame.h"
+#include "Benchmark.h"
+
+// Declare our game instance
+BenchmarkGame game;
+
+BenchmarkGame::BenchmarkGame()
+{
+}
+
+void BenchmarkGame::updateSystems(float elapsedTime)
+{
+    updateOnce(elapsedTime);
+}
+
+void BenchmarkGame::initialize()
+{
+    int argc = 0;
+    char** argv = NULL;
+    getArguments(&argc, &argv);
+
+    // Run the benchmarks named on the command line, or all of them.
+    std::vector<Benchmark*>& benchmarks = Benchmark::getBenchmarks();
+    for (size_t i = 0, count = benchmarks.size(); i < count; ++i)
+    {
+        bool selected = (argc <= 1);
+        for (int j = 1; j < argc && !selected; ++j)
+        {
+            selected = (strcmp(argv[j], benchmarks[i]->getName()) == 0);
+        }
+        if (selected)
+        {
+            benchmarks[i]->run();
+        }
+    }
+
+    exit();
+}
+
+void BenchmarkGame::finalize()
+{
+}
+
+void BenchmarkGame::update(float elapsedTime)
+{
+}
+
+void BenchmarkGame::render(float elapsedTime)
+{
+    clear(CLEAR_COLOR_DEPTH, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0);
+}
@@ -0,0 +1,54 @@
+#ifndef BENCHMARKGAME_H_
+#define BENCHMARKGAME_H_
+
+#include "gameplay.h"
+
+using namespace gameplay;
+
+/**
+ * Main game class of the benchmarks.
+ *
+ * Runs the registered benchmarks once the game is initialized, prints their results and
+ * exits. The names of benchmarks may be given on the command line to run only those.
+ */
+class BenchmarkGame: public Game
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    BenchmarkGame();
+
+    /**
+     * Updates the internal systems of the game, such as the animation and particle
+     * controllers, once by the given elapsed time.
+     *
+     * @param elapsedTime The elapsed time, in milliseconds.
+     */
+    void updateSystems(float elapsedTime);
+
+protected:
+
+    /**
+     * @see Game::initialize
+     */
+    void initialize();
+
+    /**
+     * @see Game::finalize
+     */
+    void finalize();
+
+    /**
+     * @see Game::update
+     */
+    void update(float elapsedTime);
+
+    /**
+     * @see Game::render
+     */
+    void render(float elapsedTime);
+};
+
+#endif
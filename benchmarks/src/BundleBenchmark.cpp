@@ -0,0 +1,184 @@
+#include "Benchmark.h"
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// The bundle written and loaded by the benchmark, in the resource path.
+#define BUNDLE_FILE "res/benchmark.gpb"
+// The number of meshes in the bundle, about 500 MB in all.
+#define BUNDLE_MESH_COUNT 36
+// The number of vertices on each side of the grid of a mesh.
+#define BUNDLE_GRID_SIZE 512
+// The number of floats of a vertex: a position, a normal and a texture coordinate.
+#define BUNDLE_VERTEX_SIZE 8
+// The type of a mesh in the reference table of a bundle.
+#define BUNDLE_TYPE_MESH 34
+
+/**
+ * Writes a bundle of large grid meshes, as exported for a level.
+ *
+ * @return The size of the bundle in bytes, or 0 if it could not be written.
+ */
+static size_t writeBundle()
+{
+    unsigned int vertexCount = BUNDLE_GRID_SIZE * BUNDLE_GRID_SIZE;
+    unsigned int indexCount = (BUNDLE_GRID_SIZE - 1) * (BUNDLE_GRID_SIZE - 1) * 6;
+    std::vector<float> vertices(vertexCount * BUNDLE_VERTEX_SIZE);
+    std::vector<unsigned int> indices(indexCount);
+    for (unsigned int z = 0, v = 0, i = 0; z < BUNDLE_GRID_SIZE; ++z)
+    {
+        for (unsigned int x = 0; x < BUNDLE_GRID_SIZE; ++x, ++v)
+        {
+            float* vertex = &vertices[v * BUNDLE_VERTEX_SIZE];
+            vertex[0] = (float)x;
+            vertex[1] = sinf(x * 0.1f) * cosf(z * 0.1f);
+            vertex[2] = (float)z;
+            vertex[3] = 0.0f;
+            vertex[4] = 1.0f;
+            vertex[5] = 0.0f;
+            vertex[6] = (float)x / (BUNDLE_GRID_SIZE - 1);
+            vertex[7] = (float)z / (BUNDLE_GRID_SIZE - 1);
+            if (x + 1 < BUNDLE_GRID_SIZE && z + 1 < BUNDLE_GRID_SIZE)
+            {
+                indices[i++] = v;
+                indices[i++] = v + BUNDLE_GRID_SIZE;
+                indices[i++] = v + 1;
+                indices[i++] = v + 1;
+                indices[i++] = v + BUNDLE_GRID_SIZE;
+                indices[i++] = v + BUNDLE_GRID_SIZE + 1;
+            }
+        }
+    }
+    unsigned int elements[] = { VertexFormat::POSITION, 3, VertexFormat::NORMAL, 3, VertexFormat::TEXCOORD0, 2 };
+    unsigned int elementCount = 3;
+    unsigned int vertexByteCount = vertexCount * BUNDLE_VERTEX_SIZE * sizeof(float);
+    unsigned int indexByteCount = indexCount * sizeof(unsigned int);
+    float bounds[] = { 0.0f, -1.0f, 0.0f, BUNDLE_GRID_SIZE, 1.0f, BUNDLE_GRID_SIZE, BUNDLE_GRID_SIZE * 0.5f, 0.0f, BUNDLE_GRID_SIZE * 0.5f, BUNDLE_GRID_SIZE * 0.75f };
+    unsigned int partHeader[] = { Mesh::TRIANGLES, Mesh::INDEX32, indexByteCount };
+    unsigned int partCount = 1;
+    unsigned int meshSize = 4 + sizeof(elements) + 4 + vertexByteCount + sizeof(bounds) + 4 + sizeof(partHeader) + indexByteCount;
+
+    // The header and the reference table come first, with the offset of each mesh.
+    std::vector<std::string> ids;
+    unsigned int offset = 9 + 2 + 4;
+    for (unsigned int i = 0; i < BUNDLE_MESH_COUNT; ++i)
+    {
+        char id[16];
+        sprintf(id, "mesh%u", i);
+        ids.push_back(id);
+        offset += 4 + (unsigned int)ids[i].size() + 4 + 4;
+    }
+
+    Stream* stream = FileSystem::open(BUNDLE_FILE, FileSystem::WRITE);
+    if (stream == NULL)
+    {
+        GP_WARN("Failed to open bundle '%s' for writing.", BUNDLE_FILE);
+        return 0;
+    }
+    unsigned char version[] = { 1, 2 };
+    unsigned int refCount = BUNDLE_MESH_COUNT;
+    stream->write(GP_FILE_IDENTIFIER, 1, 9);
+    stream->write(version, 1, 2);
+    stream->write(&refCount, 4, 1);
+    for (unsigned int i = 0; i < BUNDLE_MESH_COUNT; ++i)
+    {
+        unsigned int length = (unsigned int)ids[i].size();
+        unsigned int type = BUNDLE_TYPE_MESH;
+        unsigned int meshOffset = offset + i * meshSize;
+        stream->write(&length, 4, 1);
+        stream->write(ids[i].c_str(), 1, length);
+        stream->write(&type, 4, 1);
+        stream->write(&meshOffset, 4, 1);
+    }
+    bool written = true;
+    for (unsigned int i = 0; i < BUNDLE_MESH_COUNT; ++i)
+    {
+        stream->write(&elementCount, 4, 1);
+        stream->write(elements, 4, 6);
+        stream->write(&vertexByteCount, 4, 1);
+        stream->write(&vertices[0], 1, vertexByteCount);
+        stream->write(bounds, 4, 10);
+        stream->write(&partCount, 4, 1);
+        stream->write(partHeader, 4, 3);
+        written &= stream->write(&indices[0], 1, indexByteCount) == indexByteCount;
+    }
+    size_t size = (size_t)stream->position();
+    SAFE_DELETE(stream);
+    if (!written)
+    {
+        GP_WARN("Failed to write bundle '%s'.", BUNDLE_FILE);
+        return 0;
+    }
+    return size;
+}
+
+/**
+ * Drops the bundle from the page cache of the operating system, so that it is read from
+ * the disk again as on a cold start.
+ *
+ * @return true if the bundle was dropped, false if this is not supported.
+ */
+static bool dropBundle()
+{
+#ifdef __linux__
+    FILE* file = FileSystem::openFile(BUNDLE_FILE, "rb");
+    if (file == NULL)
+        return false;
+    // Pages that are still dirty from writing the bundle are not dropped.
+    fdatasync(fileno(file));
+    bool dropped = posix_fadvise(fileno(file), 0, 0, POSIX_FADV_DONTNEED) == 0;
+    fclose(file);
+    return dropped;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Opens the bundle and loads all of its meshes.
+ */
+static void loadBundle()
+{
+    Bundle* bundle = Bundle::create(BUNDLE_FILE);
+    GP_ASSERT(bundle);
+    for (unsigned int i = 0, count = bundle->getObjectCount(); i < count; ++i)
+    {
+        Mesh* mesh = bundle->loadMesh(bundle->getObjectId(i));
+        GP_ASSERT(mesh);
+        SAFE_RELEASE(mesh);
+    }
+    SAFE_RELEASE(bundle);
+}
+
+static void bundleBenchmark(Benchmark* benchmark)
+{
+    size_t size = writeBundle();
+    if (size == 0)
+        return;
+    unsigned int megabytes = (unsigned int)(size >> 20);
+    benchmark->report("bundle size", "%u MB", megabytes);
+
+    if (dropBundle())
+    {
+        benchmark->measure("36 meshes, cold (MB)", megabytes, []
+        {
+            dropBundle();
+            loadBundle();
+        });
+    }
+    else
+    {
+        benchmark->report("36 meshes, cold (MB)", "not supported");
+    }
+    benchmark->measure("36 meshes, warm (MB)", megabytes, []
+    {
+        loadBundle();
+    });
+
+    std::string path = FileSystem::getResourcePath();
+    path += BUNDLE_FILE;
+    remove(path.c_str());
+}
+
+static Benchmark bundle("bundle", &bundleBenchmark);
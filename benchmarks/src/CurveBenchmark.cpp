@@ -0,0 +1,169 @@
+#include "Benchmark.h"
+
+// The number of joints of the skeleton, each animated by a curve.
+#define CURVE_JOINT_COUNT 200
+// The number of clips playing the animation at once, each at its own time.
+#define CURVE_CLIP_COUNT 500
+// The number of keyframes of each curve, 10 seconds sampled at 30 frames per second.
+#define CURVE_POINT_COUNT 300
+// The number of components of each curve: a scale, a rotation and a translation.
+#define CURVE_COMPONENT_COUNT 10
+// The time a clip advances by every frame, as a fraction of the animation.
+#define CURVE_FRAME_TIME (16.0f / 10000.0f)
+// The number of times each baked curve is compared with its curve.
+#define CURVE_ERROR_SAMPLE_COUNT 1000
+
+static void curveBenchmark(Benchmark* benchmark)
+{
+    std::vector<Curve*> curves;
+    float value[CURVE_COMPONENT_COUNT];
+    for (unsigned int i = 0; i < CURVE_JOINT_COUNT; ++i)
+    {
+        Curve* curve = Curve::create(CURVE_POINT_COUNT, CURVE_COMPONENT_COUNT);
+        for (unsigned int j = 0; j < CURVE_POINT_COUNT; ++j)
+        {
+            for (unsigned int k = 0; k < CURVE_COMPONENT_COUNT; ++k)
+            {
+                value[k] = sinf((float)(i + j + k));
+            }
+            curve->setPoint(j, (float)j / (CURVE_POINT_COUNT - 1), value, Curve::LINEAR);
+        }
+        curves.push_back(curve);
+    }
+
+    std::vector<float> times(CURVE_CLIP_COUNT);
+    std::vector<Curve::Cursor> cursors(CURVE_CLIP_COUNT * CURVE_JOINT_COUNT);
+    std::vector<float> pose(CURVE_JOINT_COUNT * CURVE_COMPONENT_COUNT);
+    Curve** c = &curves[0];
+    float* t = &times[0];
+    Curve::Cursor* cursor = &cursors[0];
+    float* dst = &pose[0];
+
+    // Spread the clips over the animation.
+    Benchmark::Kernel resetClips = [t]
+    {
+        for (unsigned int i = 0; i < CURVE_CLIP_COUNT; ++i)
+        {
+            t[i] = (float)i / CURVE_CLIP_COUNT;
+        }
+    };
+
+    // Advance every clip by a frame, looping at the end of the animation.
+    Benchmark::Kernel advanceClips = [t]
+    {
+        for (unsigned int i = 0; i < CURVE_CLIP_COUNT; ++i)
+        {
+            t[i] += CURVE_FRAME_TIME;
+            if (t[i] > 1.0f)
+                t[i] -= 1.0f;
+        }
+    };
+
+    const unsigned int evaluationCount = CURVE_CLIP_COUNT * CURVE_JOINT_COUNT;
+
+    resetClips();
+    benchmark->measure("500 clips x 200 joints, binary search", evaluationCount, [&advanceClips, c, t, dst]
+    {
+        advanceClips();
+        for (unsigned int i = 0; i < CURVE_CLIP_COUNT; ++i)
+        {
+            for (unsigned int j = 0; j < CURVE_JOINT_COUNT; ++j)
+            {
+                c[j]->evaluate(t[i], 0.0f, 1.0f, 0.0f, &dst[j * CURVE_COMPONENT_COUNT]);
+            }
+        }
+    });
+
+    resetClips();
+    benchmark->measure("500 clips x 200 joints, cursor", evaluationCount, [&advanceClips, c, t, cursor, dst]
+    {
+        advanceClips();
+        for (unsigned int i = 0; i < CURVE_CLIP_COUNT; ++i)
+        {
+            for (unsigned int j = 0; j < CURVE_JOINT_COUNT; ++j)
+            {
+                c[j]->evaluate(t[i], 0.0f, 1.0f, 0.0f, &dst[j * CURVE_COMPONENT_COUNT], cursor[i * CURVE_JOINT_COUNT + j]);
+            }
+        }
+    });
+
+    // Every clip seeks to a random time every frame, so the cursors never help.
+    benchmark->measure("500 clips x 200 joints, binary search, seeking", evaluationCount, [c, t, dst]
+    {
+        for (unsigned int i = 0; i < CURVE_CLIP_COUNT; ++i)
+        {
+            t[i] = MATH_RANDOM_0_1();
+            for (unsigned int j = 0; j < CURVE_JOINT_COUNT; ++j)
+            {
+                c[j]->evaluate(t[i], 0.0f, 1.0f, 0.0f, &dst[j * CURVE_COMPONENT_COUNT]);
+            }
+        }
+    });
+
+    benchmark->measure("500 clips x 200 joints, cursor, seeking", evaluationCount, [c, t, cursor, dst]
+    {
+        for (unsigned int i = 0; i < CURVE_CLIP_COUNT; ++i)
+        {
+            t[i] = MATH_RANDOM_0_1();
+            for (unsigned int j = 0; j < CURVE_JOINT_COUNT; ++j)
+            {
+                c[j]->evaluate(t[i], 0.0f, 1.0f, 0.0f, &dst[j * CURVE_COMPONENT_COUNT], cursor[i * CURVE_JOINT_COUNT + j]);
+            }
+        }
+    });
+
+    // Bake the curves at the rate they are keyed at, as Animation::bake does for the frame
+    // rate an animation was exported at. A curve keeps the time, value and tangents of each point.
+    std::vector<BakedCurve*> bakedCurves;
+    unsigned int curveSize = 0;
+    unsigned int bakedSize = 0;
+    for (unsigned int i = 0; i < CURVE_JOINT_COUNT; ++i)
+    {
+        BakedCurve* baked = BakedCurve::create(c[i], CURVE_POINT_COUNT);
+        curveSize += CURVE_POINT_COUNT * (1 + 3 * CURVE_COMPONENT_COUNT) * sizeof(float);
+        bakedSize += baked->getDataSize();
+        bakedCurves.push_back(baked);
+    }
+    BakedCurve** b = &bakedCurves[0];
+    benchmark->report("200 joints, curve data", "%u KB", curveSize >> 10);
+    benchmark->report("200 joints, baked data", "%u KB", bakedSize >> 10);
+
+    resetClips();
+    benchmark->measure("500 clips x 200 joints, baked", evaluationCount, [&advanceClips, b, t, dst]
+    {
+        advanceClips();
+        for (unsigned int i = 0; i < CURVE_CLIP_COUNT; ++i)
+        {
+            for (unsigned int j = 0; j < CURVE_JOINT_COUNT; ++j)
+            {
+                b[j]->evaluate(t[i], 0.0f, 1.0f, 0.0f, &dst[j * CURVE_COMPONENT_COUNT]);
+            }
+        }
+    });
+
+    // Compare the baked curves with the curves at random times, between their frames.
+    float expected[CURVE_COMPONENT_COUNT];
+    float maxError = 0.0f;
+    for (unsigned int i = 0; i < CURVE_JOINT_COUNT; ++i)
+    {
+        for (unsigned int j = 0; j < CURVE_ERROR_SAMPLE_COUNT; ++j)
+        {
+            float time = MATH_RANDOM_0_1();
+            c[i]->evaluate(time, 0.0f, 1.0f, 0.0f, expected);
+            b[i]->evaluate(time, 0.0f, 1.0f, 0.0f, value);
+            for (unsigned int k = 0; k < CURVE_COMPONENT_COUNT; ++k)
+            {
+                maxError = std::max(maxError, fabsf(value[k] - expected[k]));
+            }
+        }
+    }
+    benchmark->report("200 joints, baked max error", "%f", maxError);
+
+    for (size_t i = 0; i < curves.size(); ++i)
+    {
+        SAFE_RELEASE(curves[i]);
+        SAFE_RELEASE(bakedCurves[i]);
+    }
+}
+
+static Benchmark curves("curves", &curveBenchmark);
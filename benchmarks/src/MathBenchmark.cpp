@@ -0,0 +1,95 @@
+#include "Benchmark.h"
+
+// The number of matrices and vectors each kernel processes.
+#define MATH_ITEM_COUNT 4096
+
+#if defined(GP_USE_NEON)
+#define MATH_KERNELS "NEON"
+#elif defined(GP_USE_SSE) && defined(__AVX__)
+#define MATH_KERNELS "SSE + AVX"
+#elif defined(GP_USE_SSE)
+#define MATH_KERNELS "SSE"
+#else
+#define MATH_KERNELS "scalar"
+#endif
+
+static void mathBenchmark(Benchmark* benchmark)
+{
+    // The kernels are selected when the library is compiled, by GP_NO_SSE, GP_USE_NEON and
+    // the instruction sets enabled. Build the library and the benchmarks with the same flags
+    // and run this once per build to compare them.
+    benchmark->report("kernels", "%s", MATH_KERNELS);
+
+    std::vector<Matrix> matrices(MATH_ITEM_COUNT);
+    std::vector<Matrix> results(MATH_ITEM_COUNT);
+    std::vector<Vector4> vectors(MATH_ITEM_COUNT);
+    std::vector<Vector4> transformed(MATH_ITEM_COUNT);
+    std::vector<Vector3> points(MATH_ITEM_COUNT);
+    std::vector<Vector3> transformedPoints(MATH_ITEM_COUNT);
+    for (unsigned int i = 0; i < MATH_ITEM_COUNT; ++i)
+    {
+        Matrix::createRotation(Vector3(1.0f, (float)i, 0.5f), 0.001f * i, &matrices[i]);
+        matrices[i].translate((float)i, 1.0f, -1.0f);
+        vectors[i].set((float)i, 1.0f, 2.0f, 1.0f);
+        points[i].set((float)i, 2.0f, 1.0f);
+    }
+    Matrix m;
+    Matrix::createLookAt(Vector3(1.0f, 2.0f, 3.0f), Vector3::zero(), Vector3::unitY(), &m);
+
+    Matrix* src = &matrices[0];
+    Matrix* dst = &results[0];
+    Vector4* v = &vectors[0];
+    Vector4* vdst = &transformed[0];
+    Vector3* p = &points[0];
+    Vector3* pdst = &transformedPoints[0];
+
+    benchmark->measure("Matrix::multiply", MATH_ITEM_COUNT, [&m, src, dst]
+    {
+        for (unsigned int i = 0; i < MATH_ITEM_COUNT; ++i)
+        {
+            Matrix::multiply(m, src[i], &dst[i]);
+        }
+    });
+    benchmark->measure("Matrix::multiply, array", MATH_ITEM_COUNT, [&m, src, dst]
+    {
+        Matrix::multiply(m, src, MATH_ITEM_COUNT, dst);
+    });
+    benchmark->measure("Matrix::add", MATH_ITEM_COUNT, [&m, src, dst]
+    {
+        for (unsigned int i = 0; i < MATH_ITEM_COUNT; ++i)
+        {
+            Matrix::add(m, src[i], &dst[i]);
+        }
+    });
+    benchmark->measure("Matrix::transpose", MATH_ITEM_COUNT, [src, dst]
+    {
+        for (unsigned int i = 0; i < MATH_ITEM_COUNT; ++i)
+        {
+            src[i].transpose(&dst[i]);
+        }
+    });
+    benchmark->measure("Matrix::transformVector", MATH_ITEM_COUNT, [&m, v, vdst]
+    {
+        for (unsigned int i = 0; i < MATH_ITEM_COUNT; ++i)
+        {
+            m.transformVector(v[i], &vdst[i]);
+        }
+    });
+    benchmark->measure("Matrix::transformVector, array", MATH_ITEM_COUNT, [&m, v, vdst]
+    {
+        m.transformVector(v, MATH_ITEM_COUNT, vdst);
+    });
+    benchmark->measure("Matrix::transformPoint", MATH_ITEM_COUNT, [&m, p, pdst]
+    {
+        for (unsigned int i = 0; i < MATH_ITEM_COUNT; ++i)
+        {
+            m.transformPoint(p[i], &pdst[i]);
+        }
+    });
+    benchmark->measure("Matrix::transformPoint, array", MATH_ITEM_COUNT, [&m, p, pdst]
+    {
+        m.transformPoint(p, MATH_ITEM_COUNT, pdst);
+    });
+}
+
+static Benchmark math("math", &mathBenchmark);
@@ -0,0 +1,106 @@
+#include "Benchmark.h"
+#include "BenchmarkGame.h"
+
+// The texture of the particles.
+#define PARTICLE_TEXTURE "res/logo_white.png"
+// The lifetime of the particles, in milliseconds.
+#define PARTICLE_ENERGY 2000L
+
+/**
+ * Creates a node with a started emitter that keeps about the given number of particles alive.
+ */
+static Node* createEmitter(unsigned int particleCount, bool rotation)
+{
+    ParticleEmitter* emitter = ParticleEmitter::create(PARTICLE_TEXTURE, ParticleEmitter::BLEND_ADDITIVE, particleCount);
+    emitter->setEmissionRate(particleCount * 1000 / PARTICLE_ENERGY);
+    emitter->setEnergy(PARTICLE_ENERGY, PARTICLE_ENERGY);
+    emitter->setSize(1.0f, 2.0f, 0.5f, 1.0f);
+    emitter->setColor(Vector4(1.0f, 0.5f, 0.0f, 1.0f), Vector4(0.1f, 0.1f, 0.1f, 0.0f), Vector4(0.5f, 0.0f, 0.0f, 0.0f), Vector4::zero());
+    emitter->setPosition(Vector3::zero(), Vector3(1.0f, 1.0f, 1.0f));
+    emitter->setVelocity(Vector3(0.0f, 4.0f, 0.0f), Vector3(2.0f, 1.0f, 2.0f));
+    emitter->setAcceleration(Vector3(0.0f, -9.8f, 0.0f), Vector3::zero());
+    if (rotation)
+    {
+        emitter->setRotationPerParticle(-1.0f, 1.0f);
+        emitter->setRotation(0.5f, 1.0f, Vector3::unitY(), Vector3(0.2f, 0.0f, 0.2f));
+    }
+
+    Node* node = Node::create();
+    node->setDrawable(emitter);
+    emitter->start();
+    SAFE_RELEASE(emitter);
+    return node;
+}
+
+/**
+ * Measures the update of emitters in their steady state, where as many particles
+ * are emitted as expire every step.
+ */
+static void measureEmitters(Benchmark* benchmark, const char* label, unsigned int emitterCount, unsigned int particleCount, bool rotation)
+{
+    BenchmarkGame* game = static_cast<BenchmarkGame*>(Game::getInstance());
+    ParticleController* controller = game->getParticleController();
+
+    std::vector<Node*> nodes;
+    for (unsigned int i = 0; i < emitterCount; ++i)
+    {
+        nodes.push_back(createEmitter(particleCount, rotation));
+    }
+
+    // Step through the lifetime of the first particles to reach the steady state.
+    float step = static_cast<ParticleEmitter*>(nodes[0]->getDrawable())->getUpdateStep();
+    for (float time = 0.0f; time < PARTICLE_ENERGY * 1.5f; time += step)
+    {
+        game->updateSystems(step);
+    }
+
+    benchmark->measure(label, controller->getParticleCount(), [game, step]
+    {
+        game->updateSystems(step);
+    });
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        SAFE_RELEASE(nodes[i]);
+    }
+}
+
+static void particleBenchmark(Benchmark* benchmark)
+{
+    // Time the simulation on the calling thread only.
+    ParticleController* controller = Game::getInstance()->getParticleController();
+    bool parallel = controller->isParallelEnabled();
+    controller->setParallelEnabled(false);
+
+    measureEmitters(benchmark, "1 emitter, 10k particles", 1, 10000, false);
+    measureEmitters(benchmark, "1 emitter, 10k particles, rotation", 1, 10000, true);
+    measureEmitters(benchmark, "1 emitter, 100k particles", 1, 100000, false);
+    measureEmitters(benchmark, "100 emitters, 1k particles", 100, 1000, false);
+
+    controller->setParallelEnabled(parallel);
+}
+
+static void particleParallelBenchmark(Benchmark* benchmark)
+{
+    // The number of job threads is set by the jobThreads property of game.config.
+    // Run this with 1 to N threads to see how the simulation scales.
+    ParticleController* controller = Game::getInstance()->getParticleController();
+    bool parallel = controller->isParallelEnabled();
+    unsigned int threadCount = Game::getInstance()->getJobController()->getWorkerCount() + 1;
+    benchmark->report("job threads", "%u", threadCount);
+
+    controller->setParallelEnabled(false);
+    measureEmitters(benchmark, "100 emitters, 1k particles, serial", 100, 1000, false);
+    measureEmitters(benchmark, "16 emitters, 10k particles, serial", 16, 10000, false);
+    measureEmitters(benchmark, "1 emitter, 100k particles, serial", 1, 100000, false);
+
+    controller->setParallelEnabled(true);
+    measureEmitters(benchmark, "100 emitters, 1k particles, parallel", 100, 1000, false);
+    measureEmitters(benchmark, "16 emitters, 10k particles, parallel", 16, 10000, false);
+    measureEmitters(benchmark, "1 emitter, 100k particles, parallel", 1, 100000, false);
+
+    controller->setParallelEnabled(parallel);
+}
+
+static Benchmark particles("particles", &particleBenchmark);
+static Benchmark particlesParallel("particles-parallel", &particleParallelBenchmark);
@@ -0,0 +1,89 @@
+#include "Benchmark.h"
+
+// The scene file written and read by the benchmark, in the resource path.
+#define SERIALIZER_FILE "res/benchmark.scene"
+// The number of nodes in the scene.
+#define SERIALIZER_NODE_COUNT 100000
+
+/**
+ * Creates a scene of nodes with ids and transforms.
+ *
+ * The nodes are all at the root of the scene, since the serialized properties of a node
+ * refer back to its parent.
+ */
+static Scene* createScene()
+{
+    Scene* scene = Scene::create();
+    char id[16];
+    for (unsigned int i = 0; i < SERIALIZER_NODE_COUNT; ++i)
+    {
+        sprintf(id, "node%u", i);
+        Node* node = Node::create(id);
+        node->setTranslation((float)(i % 100) * 4.0f, 0.0f, (float)(i / 100) * 4.0f);
+        node->rotateY((float)i * 0.01f);
+        if (i % 3 == 0)
+            node->setScale(2.0f);
+        scene->addNode(node);
+        SAFE_RELEASE(node);
+    }
+    return scene;
+}
+
+/**
+ * Writes a scene to the benchmark file.
+ */
+static void writeScene(Scene* scene)
+{
+    Serializer* writer = SerializerBinary::createWriter(SERIALIZER_FILE);
+    GP_ASSERT(writer);
+    writer->writeObject(NULL, scene);
+    writer->close();
+    SAFE_DELETE(writer);
+}
+
+/**
+ * Reads the scene of the benchmark file.
+ */
+static Scene* readScene()
+{
+    Serializer* reader = Serializer::createReader(SERIALIZER_FILE);
+    GP_ASSERT(reader);
+    Scene* scene = dynamic_cast<Scene*>(reader->readObject(NULL));
+    reader->close();
+    SAFE_DELETE(reader);
+    return scene;
+}
+
+static void serializerBenchmark(Benchmark* benchmark)
+{
+    Scene* scene = createScene();
+    benchmark->measure("100k nodes, write", SERIALIZER_NODE_COUNT, [scene]
+    {
+        writeScene(scene);
+    });
+    SAFE_RELEASE(scene);
+
+    FILE* file = FileSystem::openFile(SERIALIZER_FILE, "rb");
+    if (file)
+    {
+        fseek(file, 0, SEEK_END);
+        benchmark->report("file size", "%ld KB", ftell(file) >> 10);
+        fclose(file);
+    }
+
+    unsigned int nodeCount = 0;
+    benchmark->measure("100k nodes, read", SERIALIZER_NODE_COUNT, [&nodeCount]
+    {
+        Scene* scene = readScene();
+        GP_ASSERT(scene);
+        nodeCount = scene->getNodeCount();
+        SAFE_RELEASE(scene);
+    });
+    benchmark->report("nodes read", "%u", nodeCount);
+
+    std::string path = FileSystem::getResourcePath();
+    path += SERIALIZER_FILE;
+    remove(path.c_str());
+}
+
+static Benchmark serializer("serializer", &serializerBenchmark);
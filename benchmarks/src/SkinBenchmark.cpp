@@ -0,0 +1,256 @@
+#include "Benchmark.h"
+
+// The bundle of the skinned character written and loaded by the benchmark, in the resource path.
+#define SKIN_FILE "res/benchmark_skin.gpb"
+// The number of vertices of the skinned mesh.
+#define SKIN_VERTEX_COUNT 100000
+// The number of joints of the skeleton, a chain from the root joint.
+#define SKIN_JOINT_COUNT 64
+// The length of each joint of the chain.
+#define SKIN_JOINT_LENGTH 0.05f
+// The number of floats of a vertex: a position, a normal, 4 blend weights and 4 blend indices.
+#define SKIN_VERTEX_SIZE 14
+// The types of a node and of a mesh in the reference table of a bundle.
+#define SKIN_TYPE_NODE 2
+#define SKIN_TYPE_MESH 34
+
+/**
+ * An object in the reference table of a bundle.
+ */
+struct SkinReference
+{
+    std::string id;
+    unsigned int type;
+    unsigned int offset;
+};
+
+static inline void writeData(std::vector<unsigned char>* data, const void* bytes, size_t size)
+{
+    const unsigned char* begin = (const unsigned char*)bytes;
+    data->insert(data->end(), begin, begin + size);
+}
+
+static inline void writeUInt(std::vector<unsigned char>* data, unsigned int value)
+{
+    writeData(data, &value, sizeof(value));
+}
+
+static inline void writeString(std::vector<unsigned char>* data, const std::string& value)
+{
+    writeUInt(data, (unsigned int)value.size());
+    writeData(data, value.c_str(), value.size());
+}
+
+/**
+ * Writes the joint of the chain at the given index, with the rest of the chain as its child.
+ */
+static void writeJoint(std::vector<unsigned char>* data, std::vector<SkinReference>* references, unsigned int index)
+{
+    char id[16];
+    sprintf(id, "j%u", index);
+    SkinReference reference = { id, SKIN_TYPE_NODE, (unsigned int)data->size() };
+    references->push_back(reference);
+
+    Matrix transform;
+    if (index > 0)
+        Matrix::createTranslation(0.0f, SKIN_JOINT_LENGTH, 0.0f, &transform);
+    writeUInt(data, 2);
+    writeData(data, transform.m, sizeof(transform.m));
+    writeString(data, "");
+    writeUInt(data, index + 1 < SKIN_JOINT_COUNT ? 1 : 0);
+    if (index + 1 < SKIN_JOINT_COUNT)
+        writeJoint(data, references, index + 1);
+    unsigned char noCamera = 0, noLight = 0;
+    writeData(data, &noCamera, 1);
+    writeData(data, &noLight, 1);
+    writeString(data, "");
+}
+
+/**
+ * Writes a bundle of a character whose mesh is skinned to a chain of joints, each vertex
+ * influenced by 4 joints.
+ *
+ * @param vertices Filled with the vertices of the mesh in its bind pose.
+ *
+ * @return true if the bundle was written, false otherwise.
+ */
+static bool writeBundle(std::vector<float>* vertices)
+{
+    vertices->resize(SKIN_VERTEX_COUNT * SKIN_VERTEX_SIZE);
+    float height = SKIN_JOINT_COUNT * SKIN_JOINT_LENGTH;
+    for (unsigned int v = 0; v < SKIN_VERTEX_COUNT; ++v)
+    {
+        float* vertex = &(*vertices)[v * SKIN_VERTEX_SIZE];
+        float angle = v * 0.1f;
+        float y = height * v / SKIN_VERTEX_COUNT;
+        vertex[0] = cosf(angle) * 0.2f;
+        vertex[1] = y;
+        vertex[2] = sinf(angle) * 0.2f;
+        vertex[3] = cosf(angle);
+        vertex[4] = 0.0f;
+        vertex[5] = sinf(angle);
+        vertex[6] = 0.1f;
+        vertex[7] = 0.6f;
+        vertex[8] = 0.2f;
+        vertex[9] = 0.1f;
+        int joint = (int)(y / SKIN_JOINT_LENGTH);
+        for (int i = 0; i < 4; ++i)
+            vertex[10 + i] = (float)std::min(std::max(joint + i - 1, 0), SKIN_JOINT_COUNT - 1);
+    }
+
+    // The character node has the root joint and the skinned body as children.
+    std::vector<unsigned char> data;
+    std::vector<SkinReference> references;
+    Matrix identity;
+    unsigned char noCamera = 0, noLight = 0;
+    SkinReference character = { "character", SKIN_TYPE_NODE, 0 };
+    references.push_back(character);
+    writeUInt(&data, 1);
+    writeData(&data, identity.m, sizeof(identity.m));
+    writeString(&data, "");
+    writeUInt(&data, 2);
+    writeJoint(&data, &references, 0);
+
+    SkinReference body = { "body", SKIN_TYPE_NODE, (unsigned int)data.size() };
+    references.push_back(body);
+    writeUInt(&data, 1);
+    writeData(&data, identity.m, sizeof(identity.m));
+    writeString(&data, "");
+    writeUInt(&data, 0);
+    writeData(&data, &noCamera, 1);
+    writeData(&data, &noLight, 1);
+    writeString(&data, "#mesh");
+    unsigned char hasSkin = 1;
+    writeData(&data, &hasSkin, 1);
+    writeData(&data, identity.m, sizeof(identity.m));
+    writeUInt(&data, SKIN_JOINT_COUNT);
+    for (unsigned int i = 0; i < SKIN_JOINT_COUNT; ++i)
+    {
+        char id[16];
+        sprintf(id, "#j%u", i);
+        writeString(&data, id);
+    }
+    writeUInt(&data, SKIN_JOINT_COUNT * 16);
+    for (unsigned int i = 0; i < SKIN_JOINT_COUNT; ++i)
+    {
+        Matrix inverseBindPose;
+        Matrix::createTranslation(0.0f, -SKIN_JOINT_LENGTH * i, 0.0f, &inverseBindPose);
+        writeData(&data, inverseBindPose.m, sizeof(inverseBindPose.m));
+    }
+    writeUInt(&data, 0);
+
+    writeData(&data, &noCamera, 1);
+    writeData(&data, &noLight, 1);
+    writeString(&data, "");
+
+    // The mesh draws its vertices as triangles in order.
+    SkinReference mesh = { "mesh", SKIN_TYPE_MESH, (unsigned int)data.size() };
+    references.push_back(mesh);
+    unsigned int elements[] = { VertexFormat::POSITION, 3, VertexFormat::NORMAL, 3, VertexFormat::BLENDWEIGHTS, 4, VertexFormat::BLENDINDICES, 4 };
+    unsigned int indexCount = SKIN_VERTEX_COUNT / 3 * 3;
+    std::vector<unsigned int> indices(indexCount);
+    for (unsigned int i = 0; i < indexCount; ++i)
+        indices[i] = i;
+    float bounds[] = { -0.2f, 0.0f, -0.2f, 0.2f, height, 0.2f, 0.0f, height * 0.5f, 0.0f, height * 0.5f };
+    unsigned int partHeader[] = { Mesh::TRIANGLES, Mesh::INDEX32, indexCount * (unsigned int)sizeof(unsigned int) };
+    writeUInt(&data, 4);
+    writeData(&data, elements, sizeof(elements));
+    writeUInt(&data, SKIN_VERTEX_COUNT * SKIN_VERTEX_SIZE * sizeof(float));
+    writeData(&data, &(*vertices)[0], vertices->size() * sizeof(float));
+    writeData(&data, bounds, sizeof(bounds));
+    writeUInt(&data, 1);
+    writeData(&data, partHeader, sizeof(partHeader));
+    writeData(&data, &indices[0], indexCount * sizeof(unsigned int));
+
+    // The header and the reference table come before the objects, so offset them by its size.
+    unsigned int offset = 9 + 2 + 4;
+    for (size_t i = 0; i < references.size(); ++i)
+        offset += 4 + (unsigned int)references[i].id.size() + 4 + 4;
+    std::vector<unsigned char> header;
+    unsigned char version[] = { 1, 2 };
+    writeData(&header, GP_FILE_IDENTIFIER, 9);
+    writeData(&header, version, 2);
+    writeUInt(&header, (unsigned int)references.size());
+    for (size_t i = 0; i < references.size(); ++i)
+    {
+        writeString(&header, references[i].id);
+        writeUInt(&header, references[i].type);
+        writeUInt(&header, references[i].offset + offset);
+    }
+
+    Stream* stream = FileSystem::open(SKIN_FILE, FileSystem::WRITE);
+    if (stream == NULL)
+    {
+        GP_WARN("Failed to open bundle '%s' for writing.", SKIN_FILE);
+        return false;
+    }
+    bool written = stream->write(&header[0], 1, header.size()) == header.size() &&
+                   stream->write(&data[0], 1, data.size()) == data.size();
+    SAFE_DELETE(stream);
+    if (!written)
+        GP_WARN("Failed to write bundle '%s'.", SKIN_FILE);
+    return written;
+}
+
+/**
+ * Bends the chain of joints of a skin by an angle that changes with the frame.
+ */
+static void poseJoints(MeshSkin* skin, unsigned int frame)
+{
+    for (unsigned int i = 1, count = skin->getJointCount(); i < count; ++i)
+        skin->getJoint(i)->setRotation(Vector3::unitZ(), sinf(frame * 0.05f + i * 0.1f) * 0.05f);
+}
+
+static void skinBenchmark(Benchmark* benchmark)
+{
+    std::vector<float> vertices;
+    if (!writeBundle(&vertices))
+        return;
+    Bundle* bundle = Bundle::create(SKIN_FILE);
+    Node* character = bundle ? bundle->loadNode("character") : NULL;
+    SAFE_RELEASE(bundle);
+    Node* body = character ? character->findNode("body") : NULL;
+    Model* model = body ? dynamic_cast<Model*>(body->getDrawable()) : NULL;
+    MeshSkin* skin = model ? model->getSkin() : NULL;
+    if (skin == NULL || skin->getJointCount() != SKIN_JOINT_COUNT || !skin->setCpuSkinning(&vertices[0]))
+    {
+        GP_WARN("Failed to load the skinned character of bundle '%s'.", SKIN_FILE);
+        SAFE_RELEASE(character);
+        return;
+    }
+
+    // The number of job threads is set by the jobThreads property of game.config.
+    // Run this with 1 to N threads to see how skinning on the CPU scales.
+    unsigned int threadCount = Game::getInstance()->getJobController()->getWorkerCount() + 1;
+    benchmark->report("job threads", "%u", threadCount);
+
+    // Skinning in the vertex shader costs the CPU only the matrix palette of the pose.
+    unsigned int frame = 0;
+    benchmark->measure("64 joints, palette (GPU skinning)", SKIN_JOINT_COUNT, [skin, &frame]
+    {
+        poseJoints(skin, frame++);
+        skin->updateMatrixPalette();
+    });
+
+    std::vector<float> skinned(vertices.size());
+    float* data = &skinned[0];
+    benchmark->measure("100k vertices, skinVertices (CPU skinning)", SKIN_VERTEX_COUNT, [skin, data, &frame]
+    {
+        poseJoints(skin, frame++);
+        skin->skinVertices(data);
+    });
+
+    skin->setDualQuaternionEnabled(true);
+    benchmark->measure("100k vertices, skinVertices (dual quaternion)", SKIN_VERTEX_COUNT, [skin, data, &frame]
+    {
+        poseJoints(skin, frame++);
+        skin->skinVertices(data);
+    });
+
+    SAFE_RELEASE(character);
+    std::string path = FileSystem::getResourcePath();
+    path += SKIN_FILE;
+    remove(path.c_str());
+}
+
+static Benchmark skin("skin", &skinBenchmark);
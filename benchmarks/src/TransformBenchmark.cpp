@@ -0,0 +1,110 @@
+#include "Benchmark.h"
+
+// The number of hierarchies in the scene.
+#define TRANSFORM_HIERARCHY_COUNT 500
+// The number of nodes in each hierarchy, a binary tree about 7 levels deep.
+#define TRANSFORM_HIERARCHY_SIZE 100
+
+/**
+ * Creates a scene of hierarchies, about as many nodes as a crowd of animated characters.
+ */
+static Scene* createScene(std::vector<Node*>& nodes)
+{
+    Scene* scene = Scene::create();
+    for (unsigned int i = 0; i < TRANSFORM_HIERARCHY_COUNT; ++i)
+    {
+        size_t first = nodes.size();
+        for (unsigned int j = 0; j < TRANSFORM_HIERARCHY_SIZE; ++j)
+        {
+            Node* node = Node::create();
+            node->setTranslation((float)(j % 3), 1.0f, 0.0f);
+            if (j == 0)
+            {
+                node->setTranslation((float)(i % 25) * 4.0f, 0.0f, (float)(i / 25) * 4.0f);
+                scene->addNode(node);
+            }
+            else
+            {
+                nodes[first + (j - 1) / 2]->addChild(node);
+            }
+            nodes.push_back(node);
+            SAFE_RELEASE(node);
+        }
+    }
+    return scene;
+}
+
+static void transformBenchmark(Benchmark* benchmark)
+{
+    std::vector<Node*> nodes;
+    Scene* scene = createScene(nodes);
+    unsigned int nodeCount = (unsigned int)nodes.size();
+    std::vector<Node*>* allNodes = &nodes;
+
+    // Every node is rotated, as when a skeleton is animated. The AnimationController
+    // suspends the transform change notifications while it animates, and so does this.
+    float angle = 0.0f;
+    Benchmark::Kernel animateAll = [allNodes, &angle]
+    {
+        angle += 0.01f;
+        Quaternion rotation;
+        Quaternion::createFromAxisAngle(Vector3::unitZ(), angle, &rotation);
+        Transform::suspendTransformChanged();
+        for (size_t i = 0, count = allNodes->size(); i < count; ++i)
+        {
+            (*allNodes)[i]->setRotation(rotation);
+        }
+        Transform::resumeTransformChanged();
+    };
+
+    // Only the roots are moved, as when characters walk around.
+    Benchmark::Kernel animateRoots = [allNodes]
+    {
+        for (size_t i = 0, count = allNodes->size(); i < count; i += TRANSFORM_HIERARCHY_SIZE)
+        {
+            (*allNodes)[i]->rotateY(0.01f);
+        }
+    };
+
+    // Resolve the world matrices as drawing the nodes does.
+    Benchmark::Kernel resolveLazily = [allNodes]
+    {
+        for (size_t i = 0, count = allNodes->size(); i < count; ++i)
+        {
+            (*allNodes)[i]->getWorldMatrix();
+        }
+    };
+
+    Benchmark::Kernel updateTransforms = [scene]
+    {
+        scene->updateTransforms();
+    };
+
+    benchmark->measure("animate all nodes", nodeCount, animateAll);
+    benchmark->measure("animate all nodes, getWorldMatrix", nodeCount, [&animateAll, &resolveLazily]
+    {
+        animateAll();
+        resolveLazily();
+    });
+    benchmark->measure("animate all nodes, updateTransforms", nodeCount, [&animateAll, &updateTransforms]
+    {
+        animateAll();
+        updateTransforms();
+    });
+
+    benchmark->measure("move roots", nodeCount, animateRoots);
+    benchmark->measure("move roots, getWorldMatrix", nodeCount, [&animateRoots, &resolveLazily]
+    {
+        animateRoots();
+        resolveLazily();
+    });
+    benchmark->measure("move roots, updateTransforms", nodeCount, [&animateRoots, &updateTransforms]
+    {
+        animateRoots();
+        updateTransforms();
+    });
+
+    SAFE_RELEASE(scene);
+}
+
+static Benchmark transforms("transforms", &transformBenchmark);
@@ -24,13 +24,16 @@ LOCAL_SRC_FILES := \
     Animation.cpp \
     AnimationClip.cpp \
     AnimationController.cpp \
+    AnimationRetarget.cpp \
     AnimationTarget.cpp \
     AnimationValue.cpp \
     AudioBuffer.cpp \
     AudioController.cpp \
     AudioListener.cpp \
     AudioSource.cpp \
+    BakedCurve.cpp \
     BoundingBox.cpp \
+    BoundingBoxTree.cpp \
     BoundingSphere.cpp \
     Bundle.cpp \
     Button.cpp \
@@ -50,16 +53,19 @@ LOCAL_SRC_FILES := \
     Form.cpp \
     FrameBuffer.cpp \
     Frustum.cpp \
+    FrustumCuller.cpp \
     Game.cpp \
     Gamepad.cpp \
     HeightField.cpp \
     Image.cpp \
     ImageControl.cpp \
+    JobController.cpp \
     Joint.cpp \
     JoystickControl.cpp \
     Label.cpp \
     Layout.cpp \
     Light.cpp \
+    LoadController.cpp \
     Logger.cpp \
     Material.cpp \
     MaterialParameter.cpp \
@@ -71,6 +77,7 @@ LOCAL_SRC_FILES := \
     MeshSkin.cpp \
     Model.cpp \
     Node.cpp \
+    ParticleController.cpp \
     ParticleEmitter.cpp \
     Pass.cpp \
     PhysicsCharacter.cpp \
@@ -96,10 +103,12 @@ LOCAL_SRC_FILES := \
     Ray.cpp \
     Rectangle.cpp \
     Ref.cpp \
+    RenderQueue.cpp \
     RenderState.cpp \
     RenderTarget.cpp \
     Scene.cpp \
     SceneLoader.cpp \
+    SceneStreamer.cpp \
     ScreenDisplayer.cpp \
     Script.cpp \
     ScriptController.cpp \
@@ -107,6 +116,7 @@ LOCAL_SRC_FILES := \
     Slider.cpp \
     Sprite.cpp \
     SpriteBatch.cpp \
+    TaskGraph.cpp \
     Technique.cpp \
     Terrain.cpp \
     TerrainPatch.cpp \
@@ -20,14 +20,17 @@ SOURCES += src/AbsoluteLayout.cpp \
     src/Animation.cpp \
     src/AnimationClip.cpp \
     src/AnimationController.cpp \
+    src/AnimationRetarget.cpp \
     src/AnimationTarget.cpp \
     src/AnimationValue.cpp \
     src/AudioBuffer.cpp \
     src/AudioController.cpp \
     src/AudioListener.cpp \
     src/AudioSource.cpp \
+    src/BakedCurve.cpp \
     src/BoundingBox.cpp \
     src/BoundingBox.inl \
+    src/BoundingBoxTree.cpp \
     src/BoundingSphere.cpp \
     src/BoundingSphere.inl \
     src/Bundle.cpp \
@@ -47,6 +50,7 @@ SOURCES += src/AbsoluteLayout.cpp \
     src/Form.cpp \
     src/FrameBuffer.cpp \
     src/Frustum.cpp \
+    src/FrustumCuller.cpp \
     src/Game.cpp \
     src/Game.inl \
     src/Gamepad.cpp \
@@ -54,17 +58,20 @@ SOURCES += src/AbsoluteLayout.cpp \
     src/Image.cpp \
     src/Image.inl \
     src/ImageControl.cpp \
+    src/JobController.cpp \
     src/Joint.cpp \
     src/JoystickControl.cpp \
     src/Label.cpp \
     src/Layout.cpp \
     src/Light.cpp \
+    src/LoadController.cpp \
     src/Logger.cpp \
     src/Material.cpp \
     src/MaterialParameter.cpp \
     src/MathUtil.cpp \
     src/MathUtil.inl \
     src/MathUtilNeon.inl \
+    src/MathUtilSSE.inl \
     src/Matrix.cpp \
     src/Matrix.inl \
     src/Mesh.cpp \
@@ -74,6 +81,7 @@ SOURCES += src/AbsoluteLayout.cpp \
     src/MeshSkin.cpp \
     src/Model.cpp \
     src/Node.cpp \
+    src/ParticleController.cpp \
     src/ParticleEmitter.cpp \
     src/Pass.cpp \
     src/PhysicsCharacter.cpp \
@@ -105,10 +113,12 @@ SOURCES += src/AbsoluteLayout.cpp \
     src/Ray.inl \
     src/Rectangle.cpp \
     src/Ref.cpp \
+    src/RenderQueue.cpp \
     src/RenderState.cpp \
     src/RenderTarget.cpp \
     src/Scene.cpp \
     src/SceneLoader.cpp \
+    src/SceneStreamer.cpp \
     src/ScreenDisplayer.cpp \
     src/Script.cpp \
     src/ScriptController.cpp \
@@ -120,6 +130,7 @@ SOURCES += src/AbsoluteLayout.cpp \
     src/Slider.cpp \
     src/Sprite.cpp \
     src/SpriteBatch.cpp \
+    src/TaskGraph.cpp \
     src/Technique.cpp \
     src/Terrain.cpp \
     src/TerrainPatch.cpp \
@@ -149,14 +160,17 @@ HEADERS += src/AbsoluteLayout.h \
     src/Animation.h \
     src/AnimationClip.h \
     src/AnimationController.h \
+    src/AnimationRetarget.h \
     src/AnimationTarget.h \
     src/AnimationValue.h \
     src/AudioBuffer.h \
     src/AudioController.h \
     src/AudioListener.h \
     src/AudioSource.h \
+    src/BakedCurve.h \
     src/Base.h \
     src/BoundingBox.h \
+    src/BoundingBoxTree.h \
     src/BoundingSphere.h \
     src/Bundle.h \
     src/Button.h \
@@ -175,6 +189,7 @@ HEADERS += src/AbsoluteLayout.h \
     src/Form.h \
     src/FrameBuffer.h \
     src/Frustum.h \
+    src/FrustumCuller.h \
     src/Game.h \
     src/Gamepad.h \
     src/gameplay.h \
@@ -182,12 +197,14 @@ HEADERS += src/AbsoluteLayout.h \
     src/HeightField.h \
     src/Image.h \
     src/ImageControl.h \
+    src/JobController.h \
     src/Joint.h \
     src/JoystickControl.h \
     src/Keyboard.h \
     src/Label.h \
     src/Layout.h \
     src/Light.h \
+    src/LoadController.h \
     src/Logger.h \
     src/Material.h \
     src/MaterialParameter.h \
@@ -200,6 +217,7 @@ HEADERS += src/AbsoluteLayout.h \
     src/Model.h \
     src/Mouse.h \
     src/Node.h \
+    src/ParticleController.h \
     src/ParticleEmitter.h \
     src/Pass.h \
     src/PhysicsCharacter.h \
@@ -223,10 +241,13 @@ HEADERS += src/AbsoluteLayout.h \
     src/Ray.h \
     src/Rectangle.h \
     src/Ref.h \
+    src/RenderQueue.h \
     src/RenderState.h \
     src/RenderTarget.h \
+    src/ResourceCache.h \
     src/Scene.h \
     src/SceneLoader.h \
+    src/SceneStreamer.h \
     src/ScreenDisplayer.h \
     src/Script.h \
     src/ScriptController.h \
@@ -238,6 +259,7 @@ HEADERS += src/AbsoluteLayout.h \
     src/Slider.h \
     src/Sprite.h \
     src/SpriteBatch.h \
+    src/TaskGraph.h \
     src/Stream.h \
     src/Technique.h \
     src/Terrain.h \
@@ -15,6 +15,10 @@
 // Attributes
 attribute vec4 a_position;
 
+#if defined(INSTANCED)
+attribute mat4 a_instanceMatrix;
+#endif
+
 #if defined(SKINNING)
 attribute vec4 a_blendWeights;
 attribute vec4 a_blendIndices;
@@ -34,18 +38,34 @@ attribute vec3 a_color;
 
 ///////////////////////////////////////////////////////////
 // Uniforms
+#if defined(INSTANCED)
+// Instances are transformed by their world matrix attribute, and must be scaled uniformly.
+uniform mat4 u_viewProjectionMatrix;
+#define u_worldViewProjectionMatrix (u_viewProjectionMatrix * a_instanceMatrix)
+#else
 uniform mat4 u_worldViewProjectionMatrix;
+#endif
 
 #if defined(SKINNING)
+#if defined(SKINNING_DUAL_QUATERNION)
+uniform vec4 u_dualQuaternionPalette[SKINNING_JOINT_COUNT * 2];
+#else
 uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];
 #endif
+#endif
 
 #if defined(LIGHTING)
+#if defined(INSTANCED)
+uniform mat4 u_viewMatrix;
+#define u_inverseTransposeWorldViewMatrix (u_viewMatrix * a_instanceMatrix)
+#define u_worldViewMatrix (u_viewMatrix * a_instanceMatrix)
+#else
 uniform mat4 u_inverseTransposeWorldViewMatrix;
 
 #if (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0) || defined(SPECULAR)
 uniform mat4 u_worldViewMatrix;
 #endif
+#endif
 
 #if (DIRECTIONAL_LIGHT_COUNT > 0)
 uniform vec3 u_directionalLightDirection[DIRECTIONAL_LIGHT_COUNT];
@@ -67,7 +87,11 @@ uniform vec3 u_cameraPosition;
 #endif
 
 #if defined(CLIP_PLANE)
+#if defined(INSTANCED)
+#define u_worldMatrix a_instanceMatrix
+#else
 uniform mat4 u_worldMatrix;
+#endif
 uniform vec4 u_clipPlane;
 #endif
 
@@ -106,7 +130,11 @@ varying vec3 v_cameraDirection;
 #endif
 
 #if defined(SKINNING)
+#if defined(SKINNING_DUAL_QUATERNION)
+#include "skinning-dq.vert"
+#else
 #include "skinning.vert"
+#endif
 #else
 #include "skinning-none.vert" 
 #endif
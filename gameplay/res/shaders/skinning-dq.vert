@@ -0,0 +1,60 @@
+vec4 _skinnedReal;
+vec4 _skinnedDual;
+
+void blendDualQuaternion(float blendWeight, int jointIndex)
+{
+    vec4 real = u_dualQuaternionPalette[jointIndex];
+    vec4 dual = u_dualQuaternionPalette[jointIndex + 1];
+    // Blend in the hemisphere of the first joint.
+    if (dot(_skinnedReal, real) < 0.0)
+        blendWeight = -blendWeight;
+    _skinnedReal += blendWeight * real;
+    _skinnedDual += blendWeight * dual;
+}
+
+void blendDualQuaternions()
+{
+    _skinnedReal = u_dualQuaternionPalette[int(a_blendIndices[0]) * 2] * a_blendWeights[0];
+    _skinnedDual = u_dualQuaternionPalette[int(a_blendIndices[0]) * 2 + 1] * a_blendWeights[0];
+    blendDualQuaternion(a_blendWeights[1], int(a_blendIndices[1]) * 2);
+    blendDualQuaternion(a_blendWeights[2], int(a_blendIndices[2]) * 2);
+    blendDualQuaternion(a_blendWeights[3], int(a_blendIndices[3]) * 2);
+    float len = length(_skinnedReal);
+    _skinnedReal /= len;
+    _skinnedDual /= len;
+}
+
+vec3 rotateVector(vec3 v)
+{
+    return v + 2.0 * cross(_skinnedReal.xyz, cross(_skinnedReal.xyz, v) + _skinnedReal.w * v);
+}
+
+vec4 getPosition()
+{
+    blendDualQuaternions();
+    vec3 translation = 2.0 * (_skinnedReal.w * _skinnedDual.xyz - _skinnedDual.w * _skinnedReal.xyz + cross(_skinnedReal.xyz, _skinnedDual.xyz));
+    return vec4(rotateVector(a_position.xyz) + translation, a_position.w);
+}
+
+#if defined(LIGHTING)
+
+vec3 getNormal()
+{
+    return rotateVector(a_normal);
+}
+
+#if defined(BUMPED)
+
+vec3 getTangent()
+{
+    return rotateVector(a_tangent);
+}
+
+vec3 getBinormal()
+{
+    return rotateVector(a_binormal);
+}
+
+#endif
+
+#endif
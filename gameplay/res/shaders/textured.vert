@@ -15,6 +15,10 @@
 // Atributes
 attribute vec4 a_position;
 
+#if defined(INSTANCED)
+attribute mat4 a_instanceMatrix;
+#endif
+
 #if defined(SKINNING)
 attribute vec4 a_blendWeights;
 attribute vec4 a_blendIndices;
@@ -38,17 +42,33 @@ attribute vec3 a_binormal;
 
 ///////////////////////////////////////////////////////////
 // Uniforms
+#if defined(INSTANCED)
+// Instances are transformed by their world matrix attribute, and must be scaled uniformly.
+uniform mat4 u_viewProjectionMatrix;
+#define u_worldViewProjectionMatrix (u_viewProjectionMatrix * a_instanceMatrix)
+#else
 uniform mat4 u_worldViewProjectionMatrix;
+#endif
 #if defined(SKINNING)
+#if defined(SKINNING_DUAL_QUATERNION)
+uniform vec4 u_dualQuaternionPalette[SKINNING_JOINT_COUNT * 2];
+#else
 uniform vec4 u_matrixPalette[SKINNING_JOINT_COUNT * 3];
 #endif
+#endif
 
 #if defined(LIGHTING)
+#if defined(INSTANCED)
+uniform mat4 u_viewMatrix;
+#define u_inverseTransposeWorldViewMatrix (u_viewMatrix * a_instanceMatrix)
+#define u_worldViewMatrix (u_viewMatrix * a_instanceMatrix)
+#else
 uniform mat4 u_inverseTransposeWorldViewMatrix;
 
 #if defined(SPECULAR) || (POINT_LIGHT_COUNT > 0) || (SPOT_LIGHT_COUNT > 0)
 uniform mat4 u_worldViewMatrix;
 #endif
+#endif
 
 #if defined(BUMPED) && (DIRECTIONAL_LIGHT_COUNT > 0)
 uniform vec3 u_directionalLightDirection[DIRECTIONAL_LIGHT_COUNT];
@@ -80,7 +100,11 @@ uniform vec2 u_textureOffset;
 #endif
 
 #if defined(CLIP_PLANE)
+#if defined(INSTANCED)
+#define u_worldMatrix a_instanceMatrix
+#else
 uniform mat4 u_worldMatrix;
+#endif
 uniform vec4 u_clipPlane;
 #endif
 
@@ -122,7 +146,11 @@ varying vec3 v_cameraDirection;
 #endif
 
 #if defined(SKINNING)
+#if defined(SKINNING_DUAL_QUATERNION)
+#include "skinning-dq.vert"
+#else
 #include "skinning.vert"
+#endif
 #else
 #include "skinning-none.vert" 
 #endif
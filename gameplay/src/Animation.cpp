@@ -5,6 +5,8 @@
 #include "AnimationTarget.h"
 #include "Game.h"
 #include "Transform.h"
+#include "BakedCurve.h"
+#include "AnimationRetarget.h"
 
 #define ANIMATION_INDEFINITE_STR "INDEFINITE"
 #define ANIMATION_CLIP 0
@@ -91,7 +93,7 @@ Animation::~Animation()
 Animation::Channel::Channel(Animation* animation, AnimationTarget* target, int propertyId,
                             Curve* curve, unsigned long duration) :
     _animation(animation), _target(target), _propertyId(propertyId),
-    _curve(curve), _duration(duration)
+    _curve(curve), _bakedCurve(NULL), _duration(duration), _retarget(NULL), _retargetIndex(0)
 {
     GP_ASSERT(_animation);
     GP_ASSERT(_target);
@@ -106,13 +108,44 @@ Animation::Channel::Channel(Animation* animation, AnimationTarget* target, int p
 }
 
 Animation::Channel::Channel(const Channel& copy, Animation* animation, AnimationTarget* target)
-    : _animation(animation), _target(target), _propertyId(copy._propertyId), _curve(copy._curve), _duration(copy._duration)
+    : _animation(animation), _target(target), _propertyId(copy._propertyId), _curve(copy._curve),
+      _bakedCurve(copy._bakedCurve), _duration(copy._duration), _retarget(copy._retarget), _retargetIndex(copy._retargetIndex)
 {
-    GP_ASSERT(_curve);
+    GP_ASSERT(_curve || _bakedCurve);
     GP_ASSERT(_target);
     GP_ASSERT(_animation);
 
-    _curve->addRef();
+    if (_curve)
+        _curve->addRef();
+    if (_bakedCurve)
+        _bakedCurve->addRef();
+    if (_retarget)
+        _retarget->addRef();
+    _target->addChannel(this);
+    _animation->addRef();
+}
+
+Animation::Channel::Channel(Animation* animation, AnimationTarget* target, AnimationRetarget* retarget, unsigned int retargetIndex)
+    : _animation(animation), _target(target), _propertyId(0), _curve(NULL), _bakedCurve(NULL), _duration(0),
+      _retarget(retarget), _retargetIndex(retargetIndex)
+{
+    GP_ASSERT(_target);
+    GP_ASSERT(_animation);
+    GP_ASSERT(_retarget && _retargetIndex < _retarget->_mappings.size());
+
+    const AnimationRetarget::JointMapping& mapping = _retarget->_mappings[_retargetIndex];
+    _propertyId = mapping.propertyId;
+    _curve = mapping.curve;
+    _bakedCurve = mapping.bakedCurve;
+    _duration = mapping.duration;
+    GP_ASSERT(_curve || _bakedCurve);
+    GP_ASSERT(_target->getAnimationPropertyComponentCount(_propertyId));
+
+    if (_curve)
+        _curve->addRef();
+    if (_bakedCurve)
+        _bakedCurve->addRef();
+    _retarget->addRef();
     _target->addChannel(this);
     _animation->addRef();
 }
@@ -120,6 +153,8 @@ Animation::Channel::Channel(const Channel& copy, Animation* animation, Animation
 Animation::Channel::~Channel()
 {
     SAFE_RELEASE(_curve);
+    SAFE_RELEASE(_bakedCurve);
+    SAFE_RELEASE(_retarget);
     SAFE_RELEASE(_animation);
 }
 
@@ -128,6 +163,26 @@ Curve* Animation::Channel::getCurve() const
     return _curve;
 }
 
+BakedCurve* Animation::Channel::getBakedCurve() const
+{
+    return _bakedCurve;
+}
+
+unsigned int Animation::Channel::getComponentCount() const
+{
+    return _bakedCurve ? _bakedCurve->getComponentCount() : _curve->getComponentCount();
+}
+
+void Animation::Channel::bake(unsigned int sampleRate)
+{
+    if (_bakedCurve)
+        return;
+
+    GP_ASSERT(_curve);
+    _bakedCurve = bakeCurve(_curve, _duration, sampleRate);
+    SAFE_RELEASE(_curve);
+}
+
 const char* Animation::getId() const
 {
     return _id.c_str();
@@ -343,9 +398,45 @@ Animation::Channel* Animation::createChannel(AnimationTarget* target, int proper
     unsigned int propertyComponentCount = target->getAnimationPropertyComponentCount(propertyId);
     GP_ASSERT(propertyComponentCount > 0);
 
-    Curve* curve = Curve::create(keyCount, propertyComponentCount);
+    Curve* curve = createCurve(propertyId, propertyComponentCount, target->_targetType == AnimationTarget::TRANSFORM,
+                               keyCount, keyTimes, keyValues, type);
+    unsigned long duration = keyTimes[keyCount-1] - keyTimes[0];
+
+    Channel* channel = new Channel(this, target, propertyId, curve, duration);
+    curve->release();
+    addChannel(channel);
+    return channel;
+}
+
+Animation::Channel* Animation::createChannel(AnimationTarget* target, int propertyId, Curve* curve, BakedCurve* bakedCurve, unsigned long duration)
+{
+    GP_ASSERT(target);
     GP_ASSERT(curve);
-    if (target->_targetType == AnimationTarget::TRANSFORM)
+    GP_ASSERT(target->getAnimationPropertyComponentCount(propertyId) == curve->getComponentCount());
+
+    Channel* channel = new Channel(this, target, propertyId, curve, duration);
+    if (bakedCurve)
+    {
+        // Keep only the baked curve, as Channel::bake does.
+        bakedCurve->addRef();
+        channel->_bakedCurve = bakedCurve;
+        SAFE_RELEASE(channel->_curve);
+    }
+    addChannel(channel);
+    return channel;
+}
+
+Curve* Animation::createCurve(int propertyId, unsigned int componentCount, bool transform,
+                              unsigned int keyCount, unsigned int* keyTimes, float* keyValues, unsigned int type)
+{
+    GP_ASSERT(componentCount > 0);
+    GP_ASSERT(keyCount > 0);
+    GP_ASSERT(keyTimes);
+    GP_ASSERT(keyValues);
+
+    Curve* curve = Curve::create(keyCount, componentCount);
+    GP_ASSERT(curve);
+    if (transform)
         setTransformRotationOffset(curve, propertyId);
 
     unsigned int lowest = keyTimes[0];
@@ -356,13 +447,13 @@ Animation::Channel* Animation::createChannel(AnimationTarget* target, int proper
     normalizedKeyTimes[0] = 0.0f;
     curve->setPoint(0, normalizedKeyTimes[0], keyValues, (Curve::InterpolationType) type);
 
-    unsigned int pointOffset = propertyComponentCount;
+    unsigned int pointOffset = componentCount;
     unsigned int i = 1;
     for (; i < keyCount - 1; i++)
     {
         normalizedKeyTimes[i] = (float) (keyTimes[i] - lowest) / (float) duration;
         curve->setPoint(i, normalizedKeyTimes[i], (keyValues + pointOffset), (Curve::InterpolationType) type);
-        pointOffset += propertyComponentCount;
+        pointOffset += componentCount;
     }
     if (keyCount > 1) {
         i = keyCount - 1;
@@ -372,10 +463,20 @@ Animation::Channel* Animation::createChannel(AnimationTarget* target, int proper
 
     SAFE_DELETE_ARRAY(normalizedKeyTimes);
 
-    Channel* channel = new Channel(this, target, propertyId, curve, duration);
-    curve->release();
-    addChannel(channel);
-    return channel;
+    return curve;
+}
+
+BakedCurve* Animation::bakeCurve(const Curve* curve, unsigned long duration, unsigned int sampleRate)
+{
+    GP_ASSERT(curve);
+    GP_ASSERT(sampleRate > 0);
+
+    // Sample the whole duration of the channel, including both end points.
+    unsigned int frameCount = 1;
+    if (curve->getPointCount() > 1)
+        frameCount = std::max(2u, (unsigned int)ceil((double)duration * sampleRate / 1000.0) + 1);
+
+    return BakedCurve::create(curve, frameCount);
 }
 
 Animation::Channel* Animation::createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount,
@@ -448,6 +549,17 @@ void Animation::removeChannel(Channel* channel)
     }
 }
 
+void Animation::bake(unsigned int sampleRate)
+{
+    GP_ASSERT(sampleRate > 0);
+
+    for (size_t i = 0, count = _channels.size(); i < count; ++i)
+    {
+        GP_ASSERT(_channels[i]);
+        _channels[i]->bake(sampleRate);
+    }
+}
+
 void Animation::setTransformRotationOffset(Curve* curve, unsigned int propertyId)
 {
     GP_ASSERT(curve);
@@ -11,6 +11,8 @@ namespace gameplay
 class AnimationTarget;
 class AnimationController;
 class AnimationClip;
+class BakedCurve;
+class AnimationRetarget;
 
 /**
  * Defines a generic property animation.
@@ -25,6 +27,7 @@ class Animation : public Ref, public Serializable
     friend class Serializer::Activator;
     friend class AnimationClip;
     friend class AnimationTarget;
+    friend class AnimationRetarget;
     friend class Bundle;
 
 public:
@@ -114,6 +117,19 @@ public:
      */
     bool isTarget(AnimationTarget* target) const;
 
+    /**
+     * Bakes the channels of this animation for faster evaluation.
+     *
+     * The curve of each channel is resampled at the given rate and replaced by a
+     * BakedCurve, which evaluates every interpolation type with a linear interpolation
+     * between frames and stores its values quantized to 16 bits. This trades some accuracy
+     * for memory and evaluation time, so it is best suited to densely keyed animations such
+     * as skeletal animations. Channels that are already baked are left unchanged.
+     *
+     * @param sampleRate The number of frames per second to sample the curves at.
+     */
+    void bake(unsigned int sampleRate);
+
     /**
      * @see Serializeable::getSerializedClassName
      */
@@ -142,21 +158,29 @@ private:
         friend class AnimationClip;
         friend class Animation;
         friend class AnimationTarget;
+        friend class AnimationRetarget;
 
     private:
 
         Channel(Animation* animation, AnimationTarget* target, int propertyId, Curve* curve, unsigned long duration);
+        Channel(Animation* animation, AnimationTarget* target, AnimationRetarget* retarget, unsigned int retargetIndex);
         Channel(const Channel& copy, Animation* animation, AnimationTarget* target);
         Channel(const Channel&);
         ~Channel();
         Channel& operator=(const Channel&);
         Curve* getCurve() const;
+        BakedCurve* getBakedCurve() const;
+        unsigned int getComponentCount() const;
+        void bake(unsigned int sampleRate);
 
         Animation* _animation;                // Reference to the animation this channel belongs to.
         AnimationTarget* _target;             // The target of this channel.
         int _propertyId;                      // The target property this channel targets.
-        Curve* _curve;                        // The curve used to represent the animation data.
+        Curve* _curve;                        // The curve used to represent the animation data, or NULL once baked.
+        BakedCurve* _bakedCurve;              // The baked animation data, or NULL if the channel is not baked.
         unsigned long _duration;              // The length of the animation (in milliseconds).
+        AnimationRetarget* _retarget;         // The retarget table correcting the values of the channel, or NULL.
+        unsigned int _retargetIndex;          // The index of the channel in the retarget table.
     };
 
     /**
@@ -222,6 +246,12 @@ private:
     Channel* createChannel(AnimationTarget* target, int propertyId, unsigned int keyCount,
                            unsigned int* keyTimes, float* keyValues, unsigned int type);
 
+    /**
+     * Creates a channel within this animation from a curve created ahead with createCurve(),
+     * and the curve baked from it with bakeCurve() if any.
+     */
+    Channel* createChannel(AnimationTarget* target, int propertyId, Curve* curve, BakedCurve* bakedCurve, unsigned long duration);
+
     /**
      * Creates a channel within this animation.
      */
@@ -242,7 +272,25 @@ private:
     /**
      * Sets the rotation offset in a Curve representing a Transform's animation data.
      */
-    void setTransformRotationOffset(Curve* curve, unsigned int propertyId);
+    static void setTransformRotationOffset(Curve* curve, unsigned int propertyId);
+
+    /**
+     * Creates the curve of a channel from its keys, with the key times normalized over its duration.
+     *
+     * This does not use the target of the channel, so that the curves of a bundle can be
+     * created on a loader thread.
+     *
+     * @param propertyId The property of the target that is animated.
+     * @param componentCount The number of components of the property.
+     * @param transform true if the target is a Transform, false otherwise.
+     */
+    static Curve* createCurve(int propertyId, unsigned int componentCount, bool transform,
+                              unsigned int keyCount, unsigned int* keyTimes, float* keyValues, unsigned int type);
+
+    /**
+     * Bakes a curve at a sample rate, as Channel::bake does. This may be called on any thread.
+     */
+    static BakedCurve* bakeCurve(const Curve* curve, unsigned long duration, unsigned int sampleRate);
 
     /**
      * Clones this animation.
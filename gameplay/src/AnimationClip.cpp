@@ -1,7 +1,14 @@
 #include "Base.h"
 #include "AnimationClip.h"
+#include "BakedCurve.h"
+#include "AnimationRetarget.h"
 #include "Animation.h"
 #include "AnimationTarget.h"
+#include "AnimationController.h"
+#include "Transform.h"
+#include "Joint.h"
+#include "MeshSkin.h"
+#include "Model.h"
 #include "Game.h"
 #include "Quaternion.h"
 #include "ScriptController.h"
@@ -15,7 +22,8 @@ AnimationClip::AnimationClip(const char* id, Animation* animation, unsigned long
     : _id(id), _animation(animation), _startTime(startTime), _endTime(endTime), _duration(_endTime - _startTime), 
       _stateBits(0x00), _repeatCount(1.0f), _loopBlendTime(0), _activeDuration(_duration * _repeatCount), _speed(1.0f), _timeStarted(0), 
       _elapsedTime(0), _crossFadeToClip(NULL), _crossFadeOutElapsed(0), _crossFadeOutDuration(0), _blendWeight(1.0f),
-      _beginListeners(NULL), _endListeners(NULL), _listeners(NULL), _listenerItr(NULL)
+      _listenerIndex(0), _removedListenerCount(0), _percentComplete(0.0f),
+      _detailLayer(false), _lodPhase(0), _lodInterval(1), _lodEvaluate(true), _lodSpan(0), _lodProgress(0), _lodStep(0.0f)
 {
     GP_REGISTER_SCRIPT_EVENTS();
 
@@ -25,9 +33,9 @@ AnimationClip::AnimationClip(const char* id, Animation* animation, unsigned long
     for (size_t i = 0, count = _animation->_channels.size(); i < count; i++)
     {
         GP_ASSERT(_animation->_channels[i]);
-        GP_ASSERT(_animation->_channels[i]->getCurve());
-        _values.push_back(new AnimationValue(_animation->_channels[i]->getCurve()->getComponentCount()));
+        _values.push_back(new AnimationValue(_animation->_channels[i]->getComponentCount()));
     }
+    _cursors.resize(_values.size());
 }
 
 AnimationClip::~AnimationClip()
@@ -41,30 +49,10 @@ AnimationClip::~AnimationClip()
     _values.clear();
 
     SAFE_RELEASE(_crossFadeToClip);
-    SAFE_DELETE(_beginListeners);
-    SAFE_DELETE(_endListeners);
-
-    if (_listeners)
-    {
-        *_listenerItr = _listeners->begin();
-        while (*_listenerItr != _listeners->end())
-        {
-            ListenerEvent* lEvt = **_listenerItr;
-            SAFE_DELETE(lEvt);
-            ++(*_listenerItr);
-        }
-        SAFE_DELETE(_listeners);
-    }
-    SAFE_DELETE(_listenerItr);
 }
 
 AnimationClip::ListenerEvent::ListenerEvent(Listener* listener, unsigned long eventTime)
-{
-    _listener = listener;
-    _eventTime = eventTime;
-}
-
-AnimationClip::ListenerEvent::~ListenerEvent()
+    : _listener(listener), _eventTime(eventTime)
 {
 }
 
@@ -170,6 +158,16 @@ float AnimationClip::getBlendWeight() const
     return _blendWeight;
 }
 
+void AnimationClip::setDetailLayer(bool detailLayer)
+{
+    _detailLayer = detailLayer;
+}
+
+bool AnimationClip::isDetailLayer() const
+{
+    return _detailLayer;
+}
+
 void AnimationClip::setLoopBlendTime(float loopBlendTime)
 {
     if (loopBlendTime < 0.0f)
@@ -288,131 +286,111 @@ void AnimationClip::addListener(AnimationClip::Listener* listener, unsigned long
     GP_ASSERT(listener);
     GP_ASSERT(eventTime < _activeDuration);
 
-    ListenerEvent* listenerEvent = new ListenerEvent(listener, eventTime);
-
-    if (!_listeners)
-    {
-        _listeners = new std::list<ListenerEvent*>;
-        _listeners->push_front(listenerEvent);
+    // Insert after the events at the same time, so they are triggered in the order they were added.
+    std::vector<ListenerEvent>::iterator itr = std::upper_bound(_listeners.begin(), _listeners.end(), eventTime,
+        [](unsigned long time, const ListenerEvent& lst){ return time < lst._eventTime; });
+    unsigned int index = (unsigned int)(itr - _listeners.begin());
+    _listeners.insert(itr, ListenerEvent(listener, eventTime));
 
-        _listenerItr = new std::list<ListenerEvent*>::iterator;
-        if (isClipStateBitSet(CLIP_IS_PLAYING_BIT))
-            *_listenerItr = _listeners->begin();
-    }
-    else
+    // If playing, keep the index past the triggered events. Otherwise, it will just be
+    // set the next time the clip gets played. An event inserted at the index is between
+    // the last triggered event and the next one, so it is triggered unless the clip has
+    // already passed its time.
+    if (isClipStateBitSet(CLIP_IS_PLAYING_BIT))
     {
-        for (std::list<ListenerEvent*>::iterator itr = _listeners->begin(); itr != _listeners->end(); itr++)
+        if (index < _listenerIndex ||
+            (index == _listenerIndex && ((_speed >= 0.0f && _elapsedTime >= (float)eventTime) || (_speed < 0.0f && _elapsedTime > (float)eventTime))))
         {
-            GP_ASSERT(*itr);
-            if (eventTime < (*itr)->_eventTime)
-            {
-                itr = _listeners->insert(itr, listenerEvent);
-
-                // If playing, update the iterator if we need to.
-                // otherwise, it will just be set the next time the clip gets played.
-                if (isClipStateBitSet(CLIP_IS_PLAYING_BIT))
-                {
-                    float currentTime = fmodf(_elapsedTime, (float)_duration);
-                    GP_ASSERT(**_listenerItr || *_listenerItr == _listeners->end());
-                    if ((_speed >= 0.0f && currentTime < eventTime && (*_listenerItr == _listeners->end() || eventTime < (**_listenerItr)->_eventTime)) ||
-                        (_speed <= 0 && currentTime > eventTime && (*_listenerItr == _listeners->begin() || eventTime > (**_listenerItr)->_eventTime)))
-                    {
-                        *_listenerItr = itr;
-                    }
-                }
-                return;
-            }
+            _listenerIndex++;
         }
-        _listeners->push_back(listenerEvent);
     }
 }
 
 void AnimationClip::removeListener(AnimationClip::Listener* listener, unsigned long eventTime)
 {
-    if (_listeners)
+    GP_ASSERT(listener);
+
+    // Removed events are only marked, so that listeners can be removed while events are
+    // being triggered, and are compacted on the next update.
+    std::vector<ListenerEvent>::iterator itr = std::upper_bound(_listeners.begin(), _listeners.end(), eventTime,
+        [](unsigned long time, const ListenerEvent& lst){ return time < lst._eventTime; });
+    while (itr != _listeners.begin())
     {
-        GP_ASSERT(listener);
-        std::list<ListenerEvent*>::iterator iter = std::find_if(_listeners->begin(), _listeners->end(), [&](ListenerEvent* lst){ return lst->_eventTime == eventTime && lst->_listener == listener; });
-        if (iter != _listeners->end())
+        --itr;
+        if (itr->_eventTime != eventTime)
+            break;
+        if (itr->_listener == listener)
         {
-            if (isClipStateBitSet(CLIP_IS_PLAYING_BIT))
-            {
-                float currentTime = fmodf(_elapsedTime, (float)_duration);
-                GP_ASSERT(**_listenerItr || *_listenerItr == _listeners->end());
-
-                // We the listener has not been triggered yet, then check if it is next to be triggered, remove it, and update the iterator
-                if (((_speed >= 0.0f && currentTime < eventTime) || (_speed <= 0 && currentTime > eventTime)) &&
-                    *iter == **_listenerItr)
-                {
-                    *_listenerItr = _listeners->erase(iter);
-                    return;
-                }
-            }
-            _listeners->erase(iter);
+            itr->_listener = NULL;
+            _removedListenerCount++;
+            return;
         }
     }
 }
 
 void AnimationClip::addBeginListener(AnimationClip::Listener* listener)
 {
-    if (!_beginListeners)
-        _beginListeners = new std::vector<Listener*>;
-
     GP_ASSERT(listener);
-    _beginListeners->push_back(listener);
+    _beginListeners.push_back(listener);
 }
 
 void AnimationClip::removeBeginListener(AnimationClip::Listener* listener)
 {
-    if (_beginListeners)
+    GP_ASSERT(listener);
+    std::vector<Listener*>::iterator iter = std::find(_beginListeners.begin(), _beginListeners.end(), listener);
+    if (iter != _beginListeners.end())
     {
-        GP_ASSERT(listener);
-        std::vector<Listener*>::iterator iter = std::find(_beginListeners->begin(), _beginListeners->end(), listener);
-        if (iter != _beginListeners->end())
-        {
-            _beginListeners->erase(iter);
-        }
+        _beginListeners.erase(iter);
     }
 }
 
 void AnimationClip::addEndListener(AnimationClip::Listener* listener)
 {
-    if (!_endListeners)
-        _endListeners = new std::vector<Listener*>;
-
     GP_ASSERT(listener);
-    _endListeners->push_back(listener);
+    _endListeners.push_back(listener);
 }
 
 void AnimationClip::removeEndListener(AnimationClip::Listener* listener)
 {
-    if (_endListeners)
+    GP_ASSERT(listener);
+    std::vector<Listener*>::iterator iter = std::find(_endListeners.begin(), _endListeners.end(), listener);
+    if (iter != _endListeners.end())
     {
-        GP_ASSERT(listener);
-        std::vector<Listener*>::iterator iter = std::find(_endListeners->begin(), _endListeners->end(), listener);
-        if (iter != _endListeners->end())
-        {
-            _endListeners->erase(iter);
-        }
+        _endListeners.erase(iter);
     }
 }
 
-bool AnimationClip::update(float elapsedTime)
+float AnimationClip::getPercentComplete(float elapsedTime) const
 {
-    if (isClipStateBitSet(CLIP_IS_PAUSED_BIT))
+    // Current time within a loop of the clip
+    float currentTime = 0.0f;
+
+    if (_repeatCount != REPEAT_INDEFINITE && ((_speed >= 0.0f && elapsedTime >= _activeDuration) || (_speed <= 0.0f && elapsedTime <= 0.0f)))
     {
-        return false;
+        // Ensure we end off at the endpoints of our clip (-speed==0, +speed==_duration)
+        currentTime = _speed < 0.0f ? 0.0f : _duration;
     }
-
-    if (isClipStateBitSet(CLIP_IS_MARKED_FOR_REMOVAL_BIT))
+    else if (_duration != 0)
     {
-        // If the marked for removal bit is set, it means stop() was called on the AnimationClip at some point
-        // after the last update call. Reset the flag, and return true so the AnimationClip is removed from the 
-        // running clips on the AnimationController.
-        onEnd();
-        return true;
+        // If _duration == 0, we have a "pose", at time 0. Otherwise the animation is running normally.
+        if (_repeatCount == REPEAT_INDEFINITE && elapsedTime < 0)
+            elapsedTime += _activeDuration;
+        currentTime = fmodf(elapsedTime, _duration + _loopBlendTime);
     }
 
+    // Compute percentage complete for the current loop (prevent a divide by zero if _duration==0).
+    // Note that we don't use (currentTime/(_duration+_loopBlendTime)). That's because we want a
+    // % value that is outside the 0-1 range for loop smoothing/blending purposes.
+    float percentComplete = _duration == 0 ? 1 : currentTime / (float)_duration;
+
+    if (_loopBlendTime == 0.0f)
+        percentComplete = MATH_CLAMP(percentComplete, 0.0f, 1.0f);
+
+    return percentComplete;
+}
+
+void AnimationClip::advance(float elapsedTime)
+{
     if (!isClipStateBitSet(CLIP_IS_STARTED_BIT))
     {
         // Clip is just starting
@@ -432,76 +410,22 @@ bool AnimationClip::update(float elapsedTime)
         }
     }
 
-    // Current time within a loop of the clip
-    float currentTime = 0.0f;
-
     // Check to see if clip is complete.
     if (_repeatCount != REPEAT_INDEFINITE && ((_speed >= 0.0f && _elapsedTime >= _activeDuration) || (_speed <= 0.0f && _elapsedTime <= 0.0f)))
     {
         // We finished our active duration (including repeats), so clamp to our end value.
         resetClipStateBit(CLIP_IS_STARTED_BIT);
-
-        // Ensure we end off at the endpoints of our clip (-speed==0, +speed==_duration)
-        currentTime = _speed < 0.0f ? 0.0f : _duration;
-    }
-    else
-    {
-        // If _duration == 0, we have a "pose". Just set currentTime to 0.
-        if (_duration == 0)
-        {
-            currentTime = 0.0f;
-        }
-        else
-        {
-            // Animation is running normally.
-            currentTime = fmodf(_elapsedTime, _duration + _loopBlendTime);
-        }
     }
 
     // Notify any listeners of Animation events.
-    if (_listeners)
-    {
-        GP_ASSERT(_listenerItr);
-
-        if (_speed >= 0.0f)
-        {
-            while (*_listenerItr != _listeners->end() && _elapsedTime >= (long) (**_listenerItr)->_eventTime)
-            {
-                GP_ASSERT(_listenerItr);
-                GP_ASSERT(**_listenerItr);
-                GP_ASSERT((**_listenerItr)->_listener);
-
-                (**_listenerItr)->_listener->animationEvent(this, Listener::TIME);
-                ++(*_listenerItr);
-            }
-        }
-        else
-        {
-            while (*_listenerItr != _listeners->begin() && _elapsedTime <= (long) (**_listenerItr)->_eventTime)
-            {
-                GP_ASSERT(_listenerItr);
-                GP_ASSERT(**_listenerItr);
-                GP_ASSERT((**_listenerItr)->_listener);
-
-                (**_listenerItr)->_listener->animationEvent(this, Listener::TIME);
-                --(*_listenerItr);
-            }
-        }
-    }
+    dispatchListeners();
 
     // Fire script update event
     fireScriptEvent<void>(GP_GET_SCRIPT_EVENT(AnimationClip, clipUpdate), this, _elapsedTime);
 
-    // Add back in start time, and divide by the total animation's duration to get the actual percentage complete
     GP_ASSERT(_animation);
-
-    // Compute percentage complete for the current loop (prevent a divide by zero if _duration==0).
-    // Note that we don't use (currentTime/(_duration+_loopBlendTime)). That's because we want a
-    // % value that is outside the 0-1 range for loop smoothing/blending purposes.
-    float percentComplete = _duration == 0 ? 1 : currentTime / (float)_duration;
-
-    if (_loopBlendTime == 0.0f)
-        percentComplete = MATH_CLAMP(percentComplete, 0.0f, 1.0f);
+    float percentComplete = getPercentComplete(_elapsedTime);
+    _lodStep = elapsedTime * _speed;
 
     // If we're cross fading, compute blend weights
     if (isClipStateBitSet(CLIP_IS_FADING_OUT_BIT))
@@ -551,39 +475,185 @@ bool AnimationClip::update(float elapsedTime)
         }
     }
     
-    // Evaluate this clip.
-    Animation::Channel* channel = NULL;
-    AnimationValue* value = NULL;
-    AnimationTarget* target = NULL;
+    _percentComplete = percentComplete;
+}
+
+bool AnimationClip::evaluate()
+{
+    GP_ASSERT(_animation);
+
+    if (_lodInterval <= 1)
+    {
+        evaluateCurves(_percentComplete);
+        _lodSpan = 0;
+        return true;
+    }
+
+    // Interpolate from the values of the previous frame to the values sampled on the last
+    // evaluation frame at the end of the span, so that the interpolated values follow the
+    // curves instead of lagging a span behind them. The first half of _lodValues holds the
+    // values interpolated from and the second half the values interpolated to.
+    size_t channelCount = _animation->_channels.size();
+    size_t valueCount = 0;
+    for (size_t i = 0; i < channelCount; i++)
+        valueCount += _values[i]->_componentCount;
+    _lodValues.resize(valueCount * 2);
+
+    bool evaluated = _lodEvaluate || _lodSpan == 0;
+    if (evaluated)
+    {
+        // Without previous values (the clip was just throttled or restarted), start from the values at the current position.
+        if (_lodSpan == 0)
+            evaluateCurves(_percentComplete);
+        for (size_t i = 0, offset = 0; i < channelCount; offset += _values[i]->_componentCount, i++)
+            memcpy(&_lodValues[offset], _values[i]->_value, _values[i]->_componentCount * sizeof(float));
+
+        // Sample the position the clip reaches on the last frame of the span, assuming the frame time holds.
+        evaluateCurves(getPercentComplete(_elapsedTime + _lodStep * (_lodInterval - 1)));
+
+        for (size_t i = 0, offset = valueCount; i < channelCount; offset += _values[i]->_componentCount, i++)
+            memcpy(&_lodValues[offset], _values[i]->_value, _values[i]->_componentCount * sizeof(float));
+
+        _lodSpan = _lodInterval;
+        _lodProgress = 0;
+    }
+
+    if (_lodProgress < _lodSpan)
+        _lodProgress++;
+    float t = (float)_lodProgress / (float)_lodSpan;
+    for (size_t i = 0, offset = 0; i < channelCount; i++)
+    {
+        Animation::Channel* channel = _animation->_channels[i];
+        AnimationValue* value = _values[i];
+        const float* from = &_lodValues[offset];
+        const float* to = &_lodValues[valueCount + offset];
+        unsigned int componentCount = value->_componentCount;
+        offset += componentCount;
+        for (unsigned int c = 0; c < componentCount; c++)
+            value->_value[c] = from[c] + (to[c] - from[c]) * t;
+
+        // Normalize interpolated rotations, along the shortest path.
+        int rotationOffset = -1;
+        if (channel->_target->_targetType == AnimationTarget::TRANSFORM)
+        {
+            switch (channel->_propertyId)
+            {
+            case Transform::ANIMATE_ROTATE:
+            case Transform::ANIMATE_ROTATE_TRANSLATE:
+                rotationOffset = 0;
+                break;
+            case Transform::ANIMATE_SCALE_ROTATE:
+            case Transform::ANIMATE_SCALE_ROTATE_TRANSLATE:
+                rotationOffset = 3;
+                break;
+            }
+        }
+        if (rotationOffset >= 0)
+        {
+            const float* qa = from + rotationOffset;
+            const float* qb = to + rotationOffset;
+            float sign = (qa[0] * qb[0] + qa[1] * qb[1] + qa[2] * qb[2] + qa[3] * qb[3]) < 0.0f ? -1.0f : 1.0f;
+            float* q = value->_value + rotationOffset;
+            float lengthSq = 0.0f;
+            for (unsigned int c = 0; c < 4; c++)
+            {
+                q[c] = qa[c] + (qb[c] * sign - qa[c]) * t;
+                lengthSq += q[c] * q[c];
+            }
+            if (lengthSq > 0.0f)
+            {
+                float scale = 1.0f / sqrt(lengthSq);
+                for (unsigned int c = 0; c < 4; c++)
+                    q[c] *= scale;
+            }
+        }
+    }
+
+    return evaluated;
+}
+
+void AnimationClip::evaluateCurves(float percentComplete)
+{
+    GP_ASSERT(_animation);
+
+    // Evaluate the point on the curve of each channel. This only writes to the clip's own
+    // values and cursors, so different clips may be evaluated concurrently.
     size_t channelCount = _animation->_channels.size();
     float percentageStart = (float)_startTime / (float)_animation->_duration;
     float percentageEnd = (float)_endTime / (float)_animation->_duration;
     float percentageBlend = (float)_loopBlendTime / (float)_animation->_duration;
     for (size_t i = 0; i < channelCount; i++)
     {
-        channel = _animation->_channels[i];
+        Animation::Channel* channel = _animation->_channels[i];
         GP_ASSERT(channel);
-        target = channel->_target;
-        GP_ASSERT(target);
-        value = _values[i];
+        AnimationValue* value = _values[i];
         GP_ASSERT(value);
 
-        // Evaluate the point on Curve
-        GP_ASSERT(channel->getCurve());
-        channel->getCurve()->evaluate(percentComplete, percentageStart, percentageEnd, percentageBlend, value->_value);
+        if (channel->getBakedCurve())
+        {
+            channel->getBakedCurve()->evaluate(percentComplete, percentageStart, percentageEnd, percentageBlend, value->_value);
+        }
+        else
+        {
+            GP_ASSERT(channel->getCurve());
+            channel->getCurve()->evaluate(percentComplete, percentageStart, percentageEnd, percentageBlend, value->_value, _cursors[i]);
+        }
 
-        // Set the animation value on the target property.
-        target->setAnimationPropertyValue(channel->_propertyId, value, _blendWeight);
+        // Correct the value for the bind pose of a retargeted joint.
+        if (channel->_retarget)
+            channel->_retarget->correct(channel->_retargetIndex, value->_value);
     }
+}
+
+void AnimationClip::apply(float blendWeight)
+{
+    GP_ASSERT(_animation);
 
-    // When ended. Probably should move to it's own method so we can call it when the clip is ended early.
-    if (isClipStateBitSet(CLIP_IS_MARKED_FOR_REMOVAL_BIT) || !isClipStateBitSet(CLIP_IS_STARTED_BIT))
+    for (size_t i = 0, channelCount = _animation->_channels.size(); i < channelCount; i++)
     {
-        onEnd();
-        return true;
+        Animation::Channel* channel = _animation->_channels[i];
+        GP_ASSERT(channel);
+        AnimationTarget* target = channel->_target;
+        GP_ASSERT(target);
+        AnimationValue* value = _values[i];
+        GP_ASSERT(value);
+
+        // Set the animation value on the target property. Transforms are blended into
+        // the pose buffer of the controller, which writes them once per update.
+        if (target->_targetType == AnimationTarget::TRANSFORM && _animation->_controller)
+            _animation->_controller->blendPose(static_cast<Transform*>(target), channel->_propertyId, value, blendWeight);
+        else
+            target->setAnimationPropertyValue(channel->_propertyId, value, blendWeight);
+    }
+}
+
+Node* AnimationClip::getLodNode() const
+{
+    GP_ASSERT(_animation);
+
+    for (size_t i = 0, count = _animation->_channels.size(); i < count; ++i)
+    {
+        AnimationTarget* target = _animation->_channels[i]->_target;
+        if (target->_targetType != AnimationTarget::TRANSFORM)
+            continue;
+
+        // Joints are measured by the model they skin, since they have no bounds of their own.
+        Joint* joint = dynamic_cast<Joint*>(target);
+        if (joint)
+        {
+            MeshSkin* skin = joint->_skin.skin;
+            if (skin && skin->getModel() && skin->getModel()->getNode())
+                return skin->getModel()->getNode();
+            return joint;
+        }
+        return dynamic_cast<Node*>(target);
     }
+    return NULL;
+}
 
-    return false;
+bool AnimationClip::isEnded() const
+{
+    return isClipStateBitSet(CLIP_IS_MARKED_FOR_REMOVAL_BIT) || !isClipStateBitSet(CLIP_IS_STARTED_BIT);
 }
 
 void AnimationClip::onBegin()
@@ -592,31 +662,25 @@ void AnimationClip::onBegin()
 
     // Initialize animation to play.
     setClipStateBit(CLIP_IS_STARTED_BIT);
+    _lodSpan = 0;
     if (_speed >= 0)
     {
         _elapsedTime = (Game::getGameTime() - _timeStarted) * _speed;
 
-        if (_listeners)
-            *_listenerItr = _listeners->begin();
+        _listenerIndex = 0;
     }
     else
     {
         _elapsedTime = _activeDuration + (Game::getGameTime() - _timeStarted) * _speed;
 
-        if (_listeners)
-            *_listenerItr = _listeners->end();
+        _listenerIndex = (unsigned int)_listeners.size();
     }
     
     // Notify begin listeners if any.
-    if (_beginListeners)
+    for (size_t i = 0; i < _beginListeners.size(); ++i)
     {
-        std::vector<Listener*>::iterator listener = _beginListeners->begin();
-        while (listener != _beginListeners->end())
-        {
-            GP_ASSERT(*listener);
-            (*listener)->animationEvent(this, Listener::BEGIN);
-            listener++;
-        }
+        GP_ASSERT(_beginListeners[i]);
+        _beginListeners[i]->animationEvent(this, Listener::BEGIN);
     }
 
     // Fire script begin event
@@ -633,15 +697,10 @@ void AnimationClip::onEnd()
     resetClipStateBit(CLIP_ALL_BITS);
 
     // Notify end listeners if any.
-    if (_endListeners)
+    for (size_t i = 0; i < _endListeners.size(); ++i)
     {
-        std::vector<Listener*>::iterator listener = _endListeners->begin();
-        while (listener != _endListeners->end())
-        {
-            GP_ASSERT(*listener);
-            (*listener)->animationEvent(this, Listener::END);
-            listener++;
-        }
+        GP_ASSERT(_endListeners[i]);
+        _endListeners[i]->animationEvent(this, Listener::END);
     }
 
     // Fire script end event
@@ -665,6 +724,55 @@ void AnimationClip::resetClipStateBit(unsigned char bit)
     _stateBits &= ~bit;
 }
 
+void AnimationClip::compactListeners()
+{
+    unsigned int count = (unsigned int)_listeners.size();
+    unsigned int kept = 0;
+    unsigned int index = _listenerIndex;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (_listeners[i]._listener)
+        {
+            _listeners[kept++] = _listeners[i];
+        }
+        else if (i < _listenerIndex)
+        {
+            index--;
+        }
+    }
+    // Resizing down keeps the capacity, so events added later do not allocate.
+    _listeners.resize(kept, ListenerEvent(NULL, 0));
+    _listenerIndex = index;
+    _removedListenerCount = 0;
+}
+
+void AnimationClip::dispatchListeners()
+{
+    if (_removedListenerCount > 0)
+        compactListeners();
+
+    // Listeners may add or remove events when called back, so the array is indexed
+    // afresh for every event rather than through an iterator.
+    if (_speed >= 0.0f)
+    {
+        while (_listenerIndex < _listeners.size() && _elapsedTime >= (float)_listeners[_listenerIndex]._eventTime)
+        {
+            Listener* listener = _listeners[_listenerIndex++]._listener;
+            if (listener)
+                listener->animationEvent(this, Listener::TIME);
+        }
+    }
+    else
+    {
+        while (_listenerIndex > 0 && _elapsedTime <= (float)_listeners[_listenerIndex - 1]._eventTime)
+        {
+            Listener* listener = _listeners[--_listenerIndex]._listener;
+            if (listener)
+                listener->animationEvent(this, Listener::TIME);
+        }
+    }
+}
+
 AnimationClip* AnimationClip::clone(Animation* animation) const
 {
     // Don't clone the elapsed time, listeners or crossfade information.
@@ -672,6 +780,7 @@ AnimationClip* AnimationClip::clone(Animation* animation) const
     newClip->setSpeed(getSpeed());
     newClip->setRepeatCount(getRepeatCount());
     newClip->setBlendWeight(getBlendWeight());
+    newClip->setDetailLayer(isDetailLayer());
     
     size_t size = _values.size();
     newClip->_values.resize(size, NULL);
@@ -11,6 +11,7 @@ namespace gameplay
 
 class Animation;
 class AnimationValue;
+class Node;
 
 /**
  * Defines the runtime session of an Animation to be played.
@@ -19,6 +20,7 @@ class AnimationClip : public Ref, public ScriptTarget
 {
     friend class AnimationController;
     friend class Animation;
+    friend class AnimationRetarget;
 
     GP_SCRIPT_EVENTS_START();
     GP_SCRIPT_EVENT(clipBegin, "<AnimationClip>");
@@ -191,6 +193,25 @@ public:
      */
     float getBlendWeight() const;
 
+    /**
+     * Sets whether the AnimationClip is a detail layer.
+     *
+     * A detail layer adds secondary motion on top of the other clips playing on its
+     * targets, such as breathing or facial animation. The AnimationController skips detail
+     * layers for nodes that are small on screen when its animation LOD is enabled.
+     *
+     * @param detailLayer true if the clip is a detail layer, false otherwise.
+     * @see AnimationController::setLodEnabled
+     */
+    void setDetailLayer(bool detailLayer);
+
+    /**
+     * Determines whether the AnimationClip is a detail layer.
+     *
+     * @return true if the clip is a detail layer, false otherwise.
+     */
+    bool isDetailLayer() const;
+
     /**
      * Sets the time (in milliseconds) to append to the clip's active duration
      * to use for blending the end points of the clip when looping.
@@ -300,6 +321,8 @@ private:
      * ListenerEvent.
      *
      * Internal structure used for storing the event time at which an AnimationClip::Listener should be called back.
+     * Events are stored by value in an array sorted by event time; a removed event has a NULL listener until
+     * the array is compacted.
      */
     struct ListenerEvent
     {
@@ -308,17 +331,7 @@ private:
          */
         ListenerEvent(Listener* listener, unsigned long eventTime);
 
-        /**
-         * Destructor.
-         */
-        ~ListenerEvent();
-
-        /**
-         * Hidden copy assignment operator.
-         */
-        ListenerEvent& operator=(const ListenerEvent&);
-
-        Listener* _listener;        // This listener to call back when this event is triggered.
+        Listener* _listener;        // This listener to call back when this event is triggered, or NULL if removed.
         unsigned long _eventTime;   // The time at which the listener will be called back at during the playback of the AnimationClip.
     };
 
@@ -348,9 +361,55 @@ private:
     AnimationClip& operator=(const AnimationClip&);
 
     /**
-     * Updates the animation with the elapsed time.
+     * Advances the clip by the elapsed time, notifying its listeners and updating its
+     * cross fade, and computes the position to evaluate the clip at.
      */
-    bool update(float elapsedTime);
+    void advance(float elapsedTime);
+
+    /**
+     * Evaluates the animation values of the clip at the position computed by advance().
+     *
+     * When the clip is updated every frame, this evaluates the curves of its channels.
+     * Otherwise the curves are only evaluated on the frames selected by the controller,
+     * at the position the clip reaches on the last frame before the next evaluation, and
+     * the values are interpolated from the values of the previous frame towards them.
+     *
+     * This only writes to the clip's own animation values, so separate clips may be
+     * evaluated on separate threads.
+     *
+     * @return true if the curves were evaluated, false if the values were interpolated.
+     */
+    bool evaluate();
+
+    /**
+     * Evaluates the curves of the clip's channels at a position of the clip.
+     *
+     * @param percentComplete The position to evaluate the curves at, as computed by getPercentComplete().
+     */
+    void evaluateCurves(float percentComplete);
+
+    /**
+     * Gets the position within the current loop of the clip at an elapsed time, from 0 to 1,
+     * or past 1 while blending the end of a loop into its start.
+     */
+    float getPercentComplete(float elapsedTime) const;
+
+    /**
+     * Applies the evaluated animation values to the targets of the clip's channels.
+     *
+     * @param blendWeight The weight to blend the values into the targets with.
+     */
+    void apply(float blendWeight);
+
+    /**
+     * Determines whether the clip ended during the last call to advance().
+     */
+    bool isEnded() const;
+
+    /**
+     * Gets the node whose screen size determines the level of detail the clip is animated at.
+     */
+    Node* getLodNode() const;
 
     /**
      * Handles when the AnimationClip begins.
@@ -386,6 +445,16 @@ private:
      */
     AnimationClip* clone(Animation* animation) const;
 
+    /**
+     * Removes the listener events marked as removed, keeping the position of the next event to trigger.
+     */
+    void compactListeners();
+
+    /**
+     * Triggers the listener events passed since the last update.
+     */
+    void dispatchListeners();
+
     std::string _id;                            // AnimationClip ID.
     Animation* _animation;                      // The Animation this clip is created from.
     unsigned long _startTime;                   // Start time of the clip.
@@ -403,10 +472,21 @@ private:
     unsigned long _crossFadeOutDuration;        // The duration of the cross fade.
     float _blendWeight;                         // The clip's blendweight.
     std::vector<AnimationValue*> _values;       // AnimationValue holder.
-    std::vector<Listener*>* _beginListeners;    // Collection of begin listeners on the clip.
-    std::vector<Listener*>* _endListeners;      // Collection of end listeners on the clip.
-    std::list<ListenerEvent*>* _listeners;      // Ordered collection of listeners on the clip.
-    std::list<ListenerEvent*>::iterator* _listenerItr;  // Iterator to the next listener event to be triggered.
+    std::vector<Curve::Cursor> _cursors;        // The last evaluated position of each channel's curve.
+    std::vector<Listener*> _beginListeners;     // Collection of begin listeners on the clip.
+    std::vector<Listener*> _endListeners;       // Collection of end listeners on the clip.
+    std::vector<ListenerEvent> _listeners;      // Listener events on the clip, sorted by event time.
+    unsigned int _listenerIndex;                // Index past the triggered events (forward), or past the events left to trigger (in reverse).
+    unsigned int _removedListenerCount;         // Number of removed listener events waiting to be compacted.
+    float _percentComplete;                     // The position to evaluate the clip at, computed by advance().
+    bool _detailLayer;                          // Whether the clip is a detail layer, skipped at low animation LOD.
+    unsigned int _lodPhase;                     // Offset of the frames the curves are evaluated on, to spread the clips over frames.
+    unsigned int _lodInterval;                  // Number of frames between evaluations of the curves, set by the controller.
+    bool _lodEvaluate;                          // Whether the curves are evaluated this frame, set by the controller.
+    unsigned int _lodSpan;                      // Number of frames to interpolate over, or 0 to evaluate the curves on the next frame.
+    unsigned int _lodProgress;                  // Number of frames interpolated since the curves were evaluated.
+    std::vector<float> _lodValues;              // The values interpolated from and to, for each channel.
+    float _lodStep;                             // The clip time advanced in the last frame, used to sample the end of a span.
 };
 
 }
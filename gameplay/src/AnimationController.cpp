@@ -2,31 +2,110 @@
 #include "AnimationController.h"
 #include "Game.h"
 #include "Curve.h"
+#include "Camera.h"
+#include "Scene.h"
+
+// The number of clips evaluated by a single job.
+#define ANIMATION_CONTROLLER_JOB_SIZE 4
 
 namespace gameplay
 {
 
 AnimationController::AnimationController()
-    : _state(STOPPED)
+    : _state(STOPPED), _updating(false), _lodEnabled(false), _lodCamera(NULL), _lodFrame(0), _lodPhase(0),
+      _evaluatedClips(0), _interpolatedClips(0), _skippedClips(0)
 {
+    _lodScreenSizes[LOD_FULL] = 0.0f;
+    _lodScreenSizes[LOD_REDUCED] = 0.25f;
+    _lodScreenSizes[LOD_MINIMAL] = 0.08f;
+    _lodScreenSizes[LOD_FROZEN] = 0.01f;
+    _lodIntervals[LOD_FULL] = 1;
+    _lodIntervals[LOD_REDUCED] = 2;
+    _lodIntervals[LOD_MINIMAL] = 4;
+    _lodIntervals[LOD_FROZEN] = 1;
 }
 
 AnimationController::~AnimationController()
 {
+    SAFE_RELEASE(_lodCamera);
 }
 
 void AnimationController::stopAllAnimations() 
 {
-    std::list<AnimationClip*>::iterator clipIter = _runningClips.begin();
-    while (clipIter != _runningClips.end())
+    for (size_t i = 0; i < _runningClips.size(); ++i)
     {
-        AnimationClip* clip = *clipIter;
-        GP_ASSERT(clip);
-        clip->stop();
-        clipIter++;
+        AnimationClip* clip = _runningClips[i];
+        if (clip)
+            clip->stop();
     }
 }
 
+void AnimationController::setLodEnabled(bool enabled)
+{
+    _lodEnabled = enabled;
+}
+
+bool AnimationController::isLodEnabled() const
+{
+    return _lodEnabled;
+}
+
+void AnimationController::setLodCamera(Camera* camera)
+{
+    if (_lodCamera != camera)
+    {
+        SAFE_RELEASE(_lodCamera);
+        _lodCamera = camera;
+        if (_lodCamera)
+            _lodCamera->addRef();
+    }
+}
+
+Camera* AnimationController::getLodCamera() const
+{
+    return _lodCamera;
+}
+
+void AnimationController::setLodScreenSize(LodLevel level, float screenSize)
+{
+    GP_ASSERT(level > LOD_FULL && level <= LOD_FROZEN);
+    _lodScreenSizes[level] = screenSize;
+}
+
+float AnimationController::getLodScreenSize(LodLevel level) const
+{
+    GP_ASSERT(level >= LOD_FULL && level <= LOD_FROZEN);
+    return _lodScreenSizes[level];
+}
+
+void AnimationController::setLodUpdateInterval(LodLevel level, unsigned int interval)
+{
+    GP_ASSERT(level == LOD_REDUCED || level == LOD_MINIMAL);
+    GP_ASSERT(interval > 0);
+    _lodIntervals[level] = interval;
+}
+
+unsigned int AnimationController::getLodUpdateInterval(LodLevel level) const
+{
+    GP_ASSERT(level >= LOD_FULL && level <= LOD_FROZEN);
+    return _lodIntervals[level];
+}
+
+unsigned int AnimationController::getEvaluatedClipCount() const
+{
+    return _evaluatedClips;
+}
+
+unsigned int AnimationController::getInterpolatedClipCount() const
+{
+    return _interpolatedClips;
+}
+
+unsigned int AnimationController::getSkippedClipCount() const
+{
+    return _skippedClips;
+}
+
 AnimationController::State AnimationController::getState() const
 {
     return _state;
@@ -39,13 +118,13 @@ void AnimationController::initialize()
 
 void AnimationController::finalize()
 {
-    std::list<AnimationClip*>::iterator itr = _runningClips.begin();
-    for ( ; itr != _runningClips.end(); itr++)
+    for (size_t i = 0, count = _runningClips.size(); i < count; ++i)
     {
-        AnimationClip* clip = *itr;
+        AnimationClip* clip = _runningClips[i];
         SAFE_RELEASE(clip);
     }
     _runningClips.clear();
+    SAFE_RELEASE(_lodCamera);
     _state = STOPPED;
 }
 
@@ -71,62 +150,304 @@ void AnimationController::schedule(AnimationClip* clip)
 
     GP_ASSERT(clip);
     clip->addRef();
+    clip->_lodPhase = _lodPhase++;
     _runningClips.push_back(clip);
 }
 
 void AnimationController::unschedule(AnimationClip* clip)
 {
-    std::list<AnimationClip*>::iterator clipItr = _runningClips.begin();
-    while (clipItr != _runningClips.end())
+    std::vector<AnimationClip*>::iterator itr = std::find(_runningClips.begin(), _runningClips.end(), clip);
+    if (itr != _runningClips.end())
     {
-        AnimationClip* rClip = (*clipItr);
-        if (rClip == clip)
-        {
-            _runningClips.erase(clipItr);
-            SAFE_RELEASE(clip);
-            break;
-        }
-        clipItr++;
+        // Keep the indices of the other clips valid while updating.
+        *itr = NULL;
+        SAFE_RELEASE(clip);
+        if (!_updating)
+            compactRunningClips();
     }
 
     if (_runningClips.empty())
         _state = IDLE;
 }
 
+void AnimationController::compactRunningClips()
+{
+    _runningClips.erase(std::remove(_runningClips.begin(), _runningClips.end(), (AnimationClip*)NULL), _runningClips.end());
+}
+
+AnimationController::LodLevel AnimationController::getLodLevel(AnimationClip* clip) const
+{
+    GP_ASSERT(clip);
+
+    Node* node = clip->getLodNode();
+    if (node == NULL)
+        return LOD_FULL;
+    Camera* camera = _lodCamera;
+    if (camera == NULL && node->getScene())
+        camera = node->getScene()->getActiveCamera();
+    if (camera == NULL)
+        return LOD_FULL;
+
+    // Nodes without bounds are always animated in full.
+    const BoundingSphere& sphere = node->getBoundingSphere();
+    if (sphere.radius <= 0.0f)
+        return LOD_FULL;
+    if (!camera->getFrustum().intersects(sphere))
+        return LOD_FROZEN;
+
+    // The projected height of the sphere, as a fraction of the viewport height.
+    float screenSize;
+    if (camera->getType() == Camera::PERSPECTIVE)
+    {
+        Vector3 center;
+        camera->getViewMatrix().transformPoint(sphere.center, &center);
+        float depth = -center.z;
+        if (depth <= sphere.radius)
+            return LOD_FULL;
+        screenSize = sphere.radius * camera->getProjectionMatrix().m[5] / depth;
+    }
+    else
+    {
+        screenSize = sphere.radius * camera->getProjectionMatrix().m[5];
+    }
+
+    for (int level = LOD_FROZEN; level > LOD_FULL; --level)
+    {
+        if (screenSize < _lodScreenSizes[level])
+            return (LodLevel)level;
+    }
+    return LOD_FULL;
+}
+
+void AnimationController::blendPose(Transform* transform, int propertyId, AnimationValue* value, float blendWeight)
+{
+    GP_ASSERT(transform);
+    GP_ASSERT(value);
+
+    if (transform->isStatic())
+        return;
+
+    // Start the pose of the transform from its current local values, so clips blend as they would into the transform.
+    if (transform->_poseIndex == -1)
+    {
+        transform->_poseIndex = (int)_poses.size();
+        _poses.push_back(Pose());
+        Pose& pose = _poses.back();
+        pose.transform = transform;
+        pose.scale = transform->_scale;
+        pose.rotation = transform->_rotation;
+        pose.translation = transform->_translation;
+        pose.dirtyBits = 0;
+    }
+
+    Pose& pose = _poses[transform->_poseIndex];
+    pose.dirtyBits |= Transform::blendAnimationPropertyValue(propertyId, value, blendWeight, &pose.scale, &pose.rotation, &pose.translation);
+}
+
+void AnimationController::applyPoses()
+{
+    for (size_t i = 0, count = _poses.size(); i < count; ++i)
+    {
+        Pose& pose = _poses[i];
+        Transform* transform = pose.transform;
+        if (transform == NULL)
+            continue;
+
+        transform->_poseIndex = -1;
+        if (pose.dirtyBits)
+        {
+            transform->_scale = pose.scale;
+            transform->_rotation = pose.rotation;
+            transform->_translation = pose.translation;
+            transform->dirty(pose.dirtyBits);
+        }
+    }
+    _poses.clear();
+}
+
+void AnimationController::removePose(Transform* transform)
+{
+    GP_ASSERT(transform);
+    GP_ASSERT(transform->_poseIndex >= 0 && transform->_poseIndex < (int)_poses.size());
+
+    _poses[transform->_poseIndex].transform = NULL;
+    transform->_poseIndex = -1;
+}
+
+void AnimationController::applyClip(const UpdatedClip& updated)
+{
+    if (updated.skipped)
+    {
+        _skippedClips++;
+        return;
+    }
+    if (updated.evaluated)
+        _evaluatedClips++;
+    else
+        _interpolatedClips++;
+    updated.clip->apply(updated.blendWeight);
+}
+
 void AnimationController::update(float elapsedTime)
 {
     if (_state != RUNNING)
         return;
     
     Transform::suspendTransformChanged();
+    _updating = true;
 
-    // Loop through running clips and call update() on them.
-    std::list<AnimationClip*>::iterator clipIter = _runningClips.begin();
-    while (clipIter != _runningClips.end())
+    // Evaluate the clips in jobs only when there are enough of them to split across the workers.
+    // Otherwise each clip is evaluated and applied as soon as it advances.
+    Game* game = Game::getInstance();
+    JobController* jobs = game ? game->getJobController() : NULL;
+    bool parallel = jobs && jobs->getWorkerCount() > 0 && _runningClips.size() > ANIMATION_CONTROLLER_JOB_SIZE;
+    _evaluatedClips = 0;
+    _interpolatedClips = 0;
+    _skippedClips = 0;
+
+    // Advance the running clips in order. Listeners may schedule clips, which are appended
+    // and advanced in this update too.
+    _updatedClips.clear();
+    for (size_t i = 0; i < _runningClips.size(); ++i)
     {
-        AnimationClip* clip = (*clipIter);
-        GP_ASSERT(clip);
-        clip->addRef();
+        AnimationClip* clip = _runningClips[i];
+        if (clip == NULL)
+            continue;
+
         if (clip->isClipStateBitSet(AnimationClip::CLIP_IS_RESTARTED_BIT))
         {   // If the CLIP_IS_RESTARTED_BIT is set, we should end the clip and 
             // move it from where it is in the running clips list to the back.
+            clip->addRef();
             clip->onEnd();
             clip->setClipStateBit(AnimationClip::CLIP_IS_PLAYING_BIT);
+            _runningClips[i] = NULL;
             _runningClips.push_back(clip);
-            clipIter = _runningClips.erase(clipIter);
+            clip->release();
         }
-        else if (clip->update(elapsedTime))
+        else if (clip->isClipStateBitSet(AnimationClip::CLIP_IS_PAUSED_BIT))
         {
-            clip->release();
-            clipIter = _runningClips.erase(clipIter);
+            continue;
+        }
+        else if (clip->isClipStateBitSet(AnimationClip::CLIP_IS_MARKED_FOR_REMOVAL_BIT))
+        {
+            // stop() was called on the clip after its last update.
+            _runningClips[i] = NULL;
+            clip->onEnd();
+            SAFE_RELEASE(clip);
         }
         else
         {
-            clipIter++;
+            // Keep the clip alive until it is evaluated and applied after all clips advance.
+            if (parallel)
+                clip->addRef();
+            clip->advance(elapsedTime);
+            UpdatedClip updated = { clip, clip->_blendWeight, false, false };
+            bool ended = clip->isEnded();
+
+            if (ended)
+            {
+                // Notify the clip now rather than after it is evaluated, so that clips played by its
+                // end listeners start in this update.
+                bool restarted = clip->isClipStateBitSet(AnimationClip::CLIP_IS_RESTARTED_BIT);
+                _runningClips[i] = NULL;
+                clip->onEnd();
+                bool requeued = restarted && !clip->isClipStateBitSet(AnimationClip::CLIP_IS_PLAYING_BIT);
+                if (requeued)
+                {
+                    // play() was called while the clip advanced, so run it again from the start.
+                    clip->setClipStateBit(AnimationClip::CLIP_IS_PLAYING_BIT);
+                    _runningClips.push_back(clip);
+                }
+                else if (parallel)
+                {
+                    clip->release();
+                }
+
+                if (clip->isClipStateBitSet(AnimationClip::CLIP_IS_PLAYING_BIT))
+                {
+                    // The clip runs again from the back of the running clips, later in this update.
+                    if (parallel || !requeued)
+                        clip->release();
+                    continue;
+                }
+
+                // Apply the final position of the clip, with the weight it had before onEnd() reset it.
+                // Without jobs, the clip is released once it is applied.
+                clip->_lodInterval = 1;
+                clip->_lodEvaluate = true;
+            }
+            else
+            {
+                // Select how often the clip is evaluated.
+                LodLevel level = _lodEnabled ? getLodLevel(clip) : LOD_FULL;
+                if (level == LOD_FROZEN || (level == LOD_MINIMAL && clip->isDetailLayer()))
+                {
+                    updated.skipped = true;
+                    clip->_lodSpan = 0;
+                }
+                else
+                {
+                    clip->_lodInterval = _lodIntervals[level];
+                    clip->_lodEvaluate = (_lodFrame + clip->_lodPhase) % clip->_lodInterval == 0;
+                }
+            }
+
+            if (parallel)
+            {
+                _updatedClips.push_back(updated);
+            }
+            else
+            {
+                if (!updated.skipped)
+                    updated.evaluated = clip->evaluate();
+                applyClip(updated);
+                if (ended)
+                    clip->release();
+            }
+        }
+    }
+    _lodFrame++;
+
+    // Evaluate the curves of the clips.
+    unsigned int updatedCount = (unsigned int)_updatedClips.size();
+    if (updatedCount > ANIMATION_CONTROLLER_JOB_SIZE)
+    {
+        jobs->parallelFor(updatedCount, ANIMATION_CONTROLLER_JOB_SIZE, [this](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                UpdatedClip& updated = _updatedClips[i];
+                if (!updated.skipped)
+                    updated.evaluated = updated.clip->evaluate();
+            }
+        });
+    }
+    else
+    {
+        for (unsigned int i = 0; i < updatedCount; ++i)
+        {
+            UpdatedClip& updated = _updatedClips[i];
+            if (!updated.skipped)
+                updated.evaluated = updated.clip->evaluate();
         }
-        clip->release();
     }
 
+    // Merge the values of the clips in order, and write the blended poses to the transforms.
+    for (unsigned int i = 0; i < updatedCount; ++i)
+    {
+        applyClip(_updatedClips[i]);
+    }
+    applyPoses();
+
+    for (unsigned int i = 0; i < updatedCount; ++i)
+    {
+        _updatedClips[i].clip->release();
+    }
+    _updatedClips.clear();
+
+    _updating = false;
+    compactRunningClips();
+
     Transform::resumeTransformChanged();
 
     if (_runningClips.empty())
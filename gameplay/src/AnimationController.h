@@ -4,12 +4,42 @@
 #include "AnimationClip.h"
 #include "Animation.h"
 #include "AnimationTarget.h"
+#include "Vector3.h"
+#include "Quaternion.h"
 
 namespace gameplay
 {
 
+class Transform;
+class Camera;
+class Node;
+
 /**
  * Defines a class for controlling game animation.
+ *
+ * Animations of transforms (nodes and joints) are blended into a pose buffer while the
+ * running clips are updated: each animated transform gets a local pose (scale, rotation
+ * and translation) that every clip blends its values into, in the order the clips run.
+ * The poses are written to the transforms once all the clips are updated, marking each
+ * transform dirty once and notifying transform changes once per frame. Clip listeners
+ * called during the update therefore still see the transforms of the previous frame.
+ *
+ * Each update runs in phases. The running clips are first advanced in order on the
+ * calling thread, which notifies their listeners and updates cross fades. The curves of
+ * the clips are then evaluated as independent jobs on the JobController, since each clip
+ * only writes to its own values. Finally the values are merged into the pose buffer in
+ * the order of the clips, so the result does not depend on how the jobs were scheduled,
+ * and the clips that ended are notified.
+ *
+ * The controller can lower the cost of animating nodes that are small on screen (animation
+ * LOD). When LOD is enabled, the node animated by each clip (the node of the model skinned
+ * by a joint, for skeletons) is measured by the size of its bounding sphere projected by
+ * the camera, as a fraction of the viewport height. Below the screen size of each level,
+ * the curves of the clip are evaluated less often, with the values interpolated on the
+ * frames in between; at LOD_MINIMAL detail layers are skipped too; and the clips of nodes
+ * outside the view frustum or below the screen size of LOD_FROZEN are not evaluated, so
+ * their nodes keep their pose. Clips are still advanced every frame, so their timing and
+ * listeners are not affected.
  */
 class AnimationController
 {
@@ -17,13 +47,116 @@ class AnimationController
     friend class Animation;
     friend class AnimationClip;
     friend class SceneLoader;
+    friend class Transform;
 
 public:
 
+    /**
+     * The levels of detail clips are animated at.
+     */
+    enum LodLevel
+    {
+        LOD_FULL,
+        LOD_REDUCED,
+        LOD_MINIMAL,
+        LOD_FROZEN
+    };
+
     /** 
      * Stops all AnimationClips currently playing on the AnimationController.
      */
     void stopAllAnimations();
+
+    /**
+     * Sets whether clips are animated at a level of detail based on the screen size of
+     * their nodes. LOD is disabled by default.
+     *
+     * @param enabled true to enable animation LOD, false to evaluate every clip every frame.
+     */
+    void setLodEnabled(bool enabled);
+
+    /**
+     * Determines whether clips are animated at a level of detail based on the screen size
+     * of their nodes.
+     *
+     * @return true if animation LOD is enabled, false otherwise.
+     */
+    bool isLodEnabled() const;
+
+    /**
+     * Sets the camera the screen size of animated nodes is measured from.
+     *
+     * If no camera is set, the active camera of the scene of each node is used.
+     *
+     * @param camera The camera, or NULL.
+     */
+    void setLodCamera(Camera* camera);
+
+    /**
+     * Gets the camera the screen size of animated nodes is measured from.
+     *
+     * @return The camera, or NULL.
+     */
+    Camera* getLodCamera() const;
+
+    /**
+     * Sets the screen size below which nodes are animated at a level of detail.
+     *
+     * The defaults are 0.25 for LOD_REDUCED, 0.08 for LOD_MINIMAL and 0.01 for LOD_FROZEN.
+     *
+     * @param level The level of detail, other than LOD_FULL.
+     * @param screenSize The height of the bounding sphere of the node on screen, as a fraction of the viewport height.
+     */
+    void setLodScreenSize(LodLevel level, float screenSize);
+
+    /**
+     * Gets the screen size below which nodes are animated at a level of detail.
+     *
+     * @param level The level of detail.
+     *
+     * @return The screen size, as a fraction of the viewport height.
+     */
+    float getLodScreenSize(LodLevel level) const;
+
+    /**
+     * Sets the number of frames between evaluations of the clips animated at a level of detail.
+     *
+     * The defaults are 2 for LOD_REDUCED and 4 for LOD_MINIMAL.
+     *
+     * @param level The level of detail, LOD_REDUCED or LOD_MINIMAL.
+     * @param interval The number of frames between evaluations, at least 1.
+     */
+    void setLodUpdateInterval(LodLevel level, unsigned int interval);
+
+    /**
+     * Gets the number of frames between evaluations of the clips animated at a level of detail.
+     *
+     * @param level The level of detail.
+     *
+     * @return The number of frames between evaluations.
+     */
+    unsigned int getLodUpdateInterval(LodLevel level) const;
+
+    /**
+     * Gets the number of clips whose curves were evaluated by the last update.
+     *
+     * @return The number of evaluated clips.
+     */
+    unsigned int getEvaluatedClipCount() const;
+
+    /**
+     * Gets the number of clips whose values were interpolated between evaluations by the last update.
+     *
+     * @return The number of interpolated clips.
+     */
+    unsigned int getInterpolatedClipCount() const;
+
+    /**
+     * Gets the number of clips that were frozen or skipped as detail layers by the last update.
+     *
+     * @return The number of skipped clips.
+     */
+    unsigned int getSkippedClipCount() const;
        
 private:
 
@@ -94,9 +227,74 @@ private:
      * Callback for when the controller receives a frame update event.
      */
     void update(float elapsedTime);
-    
+
+    /**
+     * Blends an animation value of a transform property into the pose of the transform.
+     */
+    void blendPose(Transform* transform, int propertyId, AnimationValue* value, float blendWeight);
+
+    /**
+     * Writes the blended poses to their transforms and clears the pose buffer.
+     */
+    void applyPoses();
+
+    /**
+     * Removes the pose of a transform that is being destroyed.
+     */
+    void removePose(Transform* transform);
+
+    /**
+     * The local pose of an animated transform.
+     */
+    struct Pose
+    {
+        Transform* transform;
+        Vector3 scale;
+        Quaternion rotation;
+        Vector3 translation;
+        char dirtyBits;
+    };
+
+    /**
+     * Removes the clips that were unscheduled from the running clips.
+     */
+    void compactRunningClips();
+
+    /**
+     * Gets the level of detail to animate a clip at.
+     */
+    LodLevel getLodLevel(AnimationClip* clip) const;
+
+    /**
+     * A clip advanced during the update, along with the weight it is applied with.
+     */
+    struct UpdatedClip
+    {
+        AnimationClip* clip;
+        float blendWeight;
+        bool skipped;
+        bool evaluated;
+    };
+
+    /**
+     * Applies an evaluated clip to the poses of its transforms and counts it in the statistics.
+     */
+    void applyClip(const UpdatedClip& updated);
+
     State _state;                                 // The current state of the AnimationController.
-    std::list<AnimationClip*> _runningClips;      // A list of running AnimationClips.
+    std::vector<AnimationClip*> _runningClips;    // The running AnimationClips, with NULL entries for clips unscheduled during an update.
+    std::vector<UpdatedClip> _updatedClips;       // The clips advanced during the update.
+    std::vector<Pose> _poses;                     // The poses of the transforms animated during the update.
+    bool _updating;                               // Whether the controller is updating its clips.
+    bool _lodEnabled;                             // Whether clips are animated at a level of detail.
+    Camera* _lodCamera;                           // The camera the screen size of nodes is measured from, or NULL.
+    float _lodScreenSizes[LOD_FROZEN + 1];        // The screen size below which each level of detail is used.
+    unsigned int _lodIntervals[LOD_FROZEN + 1];   // The number of frames between evaluations at each level of detail.
+    unsigned int _lodFrame;                       // The number of updates, to select the frames clips are evaluated on.
+    unsigned int _lodPhase;                       // The evaluation phase given to the next scheduled clip.
+    unsigned int _evaluatedClips;                 // The number of clips evaluated by the last update.
+    unsigned int _interpolatedClips;              // The number of clips interpolated by the last update.
+    unsigned int _skippedClips;                   // The number of clips skipped by the last update.
 };
 
 }
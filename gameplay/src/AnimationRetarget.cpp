@@ -0,0 +1,373 @@
+#include "Base.h"
+#include "AnimationRetarget.h"
+#include "Animation.h"
+#include "AnimationClip.h"
+#include "BakedCurve.h"
+#include "Joint.h"
+#include "MeshSkin.h"
+#include "Transform.h"
+
+// Bones shorter than this are not scaled when translations are retargeted.
+#define ANIMATION_RETARGET_EPSILON 1e-6f
+// Bind poses whose components differ by less than this are considered the same.
+#define ANIMATION_RETARGET_BIND_EPSILON 1e-4f
+
+namespace gameplay
+{
+
+// Gets the transform of a joint relative to its parent joint in the bind pose.
+static inline void getBindTransform(Joint* joint, Vector3* scale, Quaternion* rotation, Vector3* translation)
+{
+    Matrix bind;
+    joint->getInverseBindPose().invert(&bind);
+    Joint* parent = dynamic_cast<Joint*>(joint->getParent());
+    if (parent)
+        Matrix::multiply(parent->getInverseBindPose(), bind, &bind);
+    bind.decompose(scale, rotation, translation);
+    rotation->normalize();
+}
+
+static inline float divide(float a, float b)
+{
+    return fabs(b) > ANIMATION_RETARGET_EPSILON ? a / b : 1.0f;
+}
+
+static inline bool isBindEqual(const Vector3& a, const Vector3& b)
+{
+    return fabs(a.x - b.x) < ANIMATION_RETARGET_BIND_EPSILON &&
+           fabs(a.y - b.y) < ANIMATION_RETARGET_BIND_EPSILON &&
+           fabs(a.z - b.z) < ANIMATION_RETARGET_BIND_EPSILON;
+}
+
+static inline bool isBindEqual(const Quaternion& a, const Quaternion& b)
+{
+    // q and -q are the same rotation.
+    float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    return fabs(dot) > 1.0f - ANIMATION_RETARGET_BIND_EPSILON;
+}
+
+AnimationRetarget::AnimationRetarget()
+    : _animation(NULL), _jointCount(0), _mappedChannelCount(0), _correctBindPose(false)
+{
+}
+
+AnimationRetarget::~AnimationRetarget()
+{
+    for (size_t i = 0, count = _mappings.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_mappings[i].curve);
+        SAFE_RELEASE(_mappings[i].bakedCurve);
+    }
+    SAFE_RELEASE(_animation);
+}
+
+AnimationRetarget* AnimationRetarget::create(Animation* animation, MeshSkin* skin, bool correctBindPose,
+                                             const std::map<std::string, std::string>* jointIds)
+{
+    GP_ASSERT(animation);
+    GP_ASSERT(skin);
+
+    AnimationRetarget* retarget = new AnimationRetarget();
+    retarget->_animation = animation;
+    animation->addRef();
+    retarget->_jointCount = skin->getJointCount();
+    retarget->_correctBindPose = correctBindPose;
+
+    // Match the joint targeted by each channel with a joint of the skin. This is the only
+    // place joints are looked up by id.
+    size_t channelCount = animation->_channels.size();
+    retarget->_mappings.resize(channelCount);
+    for (size_t i = 0; i < channelCount; ++i)
+    {
+        Animation::Channel* channel = animation->_channels[i];
+        GP_ASSERT(channel);
+        JointMapping& mapping = retarget->_mappings[i];
+        mapping.jointIndex = -1;
+        mapping.propertyId = channel->_propertyId;
+        mapping.curve = NULL;
+        mapping.bakedCurve = NULL;
+        mapping.duration = channel->_duration;
+        mapping.corrected = false;
+        mapping.scale.set(1.0f, 1.0f, 1.0f);
+        mapping.rotation.setIdentity();
+        mapping.translationScale = 1.0f;
+
+        Joint* source = dynamic_cast<Joint*>(channel->_target);
+        if (!source || !source->getId())
+            continue;
+
+        const char* id = source->getId();
+        if (jointIds)
+        {
+            std::map<std::string, std::string>::const_iterator itr = jointIds->find(id);
+            if (itr != jointIds->end())
+                id = itr->second.c_str();
+        }
+        Joint* target = skin->getJoint(id);
+        if (!target)
+            continue;
+
+        mapping.jointIndex = skin->getJointIndex(target);
+        mapping.curve = channel->getCurve();
+        mapping.bakedCurve = channel->getBakedCurve();
+        if (mapping.curve)
+            mapping.curve->addRef();
+        if (mapping.bakedCurve)
+            mapping.bakedCurve->addRef();
+        retarget->_mappedChannelCount++;
+
+        if (correctBindPose)
+        {
+            getBindTransform(source, &mapping.sourceScale, &mapping.sourceRotation, &mapping.sourceTranslation);
+            setTargetBindPose(&mapping, target);
+        }
+    }
+
+    if (retarget->_mappedChannelCount < channelCount)
+    {
+        GP_WARN("Only %u of the %u channels of animation '%s' were mapped onto the joints of the skin.",
+            retarget->_mappedChannelCount, (unsigned int)channelCount, animation->getId());
+    }
+
+    return retarget;
+}
+
+void AnimationRetarget::setTargetBindPose(JointMapping* mapping, Joint* target)
+{
+    GP_ASSERT(mapping);
+    GP_ASSERT(target);
+
+    getBindTransform(target, &mapping->targetScale, &mapping->targetRotation, &mapping->targetTranslation);
+
+    // Joints with the same bind pose need no correction.
+    mapping->corrected = !isBindEqual(mapping->sourceScale, mapping->targetScale) ||
+                         !isBindEqual(mapping->sourceRotation, mapping->targetRotation) ||
+                         !isBindEqual(mapping->sourceTranslation, mapping->targetTranslation);
+    if (!mapping->corrected)
+        return;
+
+    const Vector3& sourceScale = mapping->sourceScale;
+    const Vector3& targetScale = mapping->targetScale;
+    mapping->scale.set(divide(targetScale.x, sourceScale.x), divide(targetScale.y, sourceScale.y), divide(targetScale.z, sourceScale.z));
+    Quaternion sourceRotation(mapping->sourceRotation);
+    sourceRotation.inverse();
+    Quaternion::multiply(mapping->targetRotation, sourceRotation, &mapping->rotation);
+    mapping->translationScale = divide(mapping->targetTranslation.length(), mapping->sourceTranslation.length());
+}
+
+bool AnimationRetarget::isBindPoseOf(MeshSkin* skin) const
+{
+    GP_ASSERT(skin);
+
+    for (size_t i = 0, count = _mappings.size(); i < count; ++i)
+    {
+        const JointMapping& mapping = _mappings[i];
+        if (mapping.jointIndex < 0)
+            continue;
+
+        Joint* joint = skin->getJoint((unsigned int)mapping.jointIndex);
+        GP_ASSERT(joint);
+        Vector3 scale, translation;
+        Quaternion rotation;
+        getBindTransform(joint, &scale, &rotation, &translation);
+        if (!isBindEqual(scale, mapping.targetScale) || !isBindEqual(rotation, mapping.targetRotation) ||
+            !isBindEqual(translation, mapping.targetTranslation))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+AnimationRetarget* AnimationRetarget::rebind(MeshSkin* skin) const
+{
+    GP_ASSERT(skin);
+
+    AnimationRetarget* retarget = new AnimationRetarget();
+    retarget->_animation = _animation;
+    _animation->addRef();
+    retarget->_jointCount = _jointCount;
+    retarget->_mappedChannelCount = _mappedChannelCount;
+    retarget->_correctBindPose = _correctBindPose;
+    retarget->_mappings = _mappings;
+    for (size_t i = 0, count = retarget->_mappings.size(); i < count; ++i)
+    {
+        JointMapping& mapping = retarget->_mappings[i];
+        if (mapping.curve)
+            mapping.curve->addRef();
+        if (mapping.bakedCurve)
+            mapping.bakedCurve->addRef();
+        if (mapping.jointIndex >= 0)
+            setTargetBindPose(&mapping, skin->getJoint((unsigned int)mapping.jointIndex));
+    }
+    return retarget;
+}
+
+Animation* AnimationRetarget::getAnimation() const
+{
+    return _animation;
+}
+
+unsigned int AnimationRetarget::getJointCount() const
+{
+    return _jointCount;
+}
+
+unsigned int AnimationRetarget::getMappedChannelCount() const
+{
+    return _mappedChannelCount;
+}
+
+int AnimationRetarget::getJointIndex(unsigned int channelIndex) const
+{
+    GP_ASSERT(channelIndex < _mappings.size());
+    return _mappings[channelIndex].jointIndex;
+}
+
+Animation* AnimationRetarget::createAnimation(MeshSkin* skin, const char* id)
+{
+    GP_ASSERT(skin);
+
+    if (skin->getJointCount() != _jointCount)
+    {
+        GP_WARN("Failed to retarget animation '%s': the skin has %u joints rather than %u.",
+            _animation->getId(), skin->getJointCount(), _jointCount);
+        return NULL;
+    }
+    if (_mappedChannelCount == 0)
+        return NULL;
+
+    // The bind pose corrections are for the joints of the skin the table was created for,
+    // so a skin with other bind poses gets a table of its own.
+    AnimationRetarget* retarget = this;
+    if (_correctBindPose && !isBindPoseOf(skin))
+        retarget = rebind(skin);
+    else
+        addRef();
+
+    Animation* animation = new Animation(id ? id : _animation->getId());
+    for (size_t i = 0, count = _mappings.size(); i < count; ++i)
+    {
+        if (_mappings[i].jointIndex < 0)
+            continue;
+
+        Joint* joint = skin->getJoint((unsigned int)_mappings[i].jointIndex);
+        GP_ASSERT(joint);
+        Animation::Channel* channel = new Animation::Channel(animation, joint, retarget, (unsigned int)i);
+        animation->addChannel(channel);
+    }
+    SAFE_RELEASE(retarget);
+    // Release the animation because a newly created animation has a ref count of 1
+    // and the channels hold the ref to animation.
+    animation->release();
+
+    // Clone the clips
+    if (_animation->_clipDefault)
+    {
+        animation->_clipDefault = _animation->_clipDefault->clone(animation);
+    }
+
+    if (_animation->_clips)
+    {
+        for (std::vector<AnimationClip*>::iterator it = _animation->_clips->begin(); it != _animation->_clips->end(); ++it)
+        {
+            AnimationClip* newClip = (*it)->clone(animation);
+            animation->addClip(newClip);
+        }
+    }
+    return animation;
+}
+
+void AnimationRetarget::correct(unsigned int channelIndex, float* value) const
+{
+    GP_ASSERT(channelIndex < _mappings.size());
+    GP_ASSERT(value);
+
+    const JointMapping& mapping = _mappings[channelIndex];
+    if (!mapping.corrected)
+        return;
+
+    // Offsets of the scale, rotation and translation in the value of the property, or -1.
+    int scaleOffset = -1;
+    int rotationOffset = -1;
+    int translationOffset = -1;
+    switch (mapping.propertyId)
+    {
+    case Transform::ANIMATE_SCALE_UNIT:
+        value[0] *= mapping.scale.x;
+        return;
+    case Transform::ANIMATE_SCALE_X:
+        value[0] *= mapping.scale.x;
+        return;
+    case Transform::ANIMATE_SCALE_Y:
+        value[0] *= mapping.scale.y;
+        return;
+    case Transform::ANIMATE_SCALE_Z:
+        value[0] *= mapping.scale.z;
+        return;
+    case Transform::ANIMATE_TRANSLATE_X:
+        value[0] = mapping.targetTranslation.x + (value[0] - mapping.sourceTranslation.x) * mapping.translationScale;
+        return;
+    case Transform::ANIMATE_TRANSLATE_Y:
+        value[0] = mapping.targetTranslation.y + (value[0] - mapping.sourceTranslation.y) * mapping.translationScale;
+        return;
+    case Transform::ANIMATE_TRANSLATE_Z:
+        value[0] = mapping.targetTranslation.z + (value[0] - mapping.sourceTranslation.z) * mapping.translationScale;
+        return;
+    case Transform::ANIMATE_SCALE:
+        scaleOffset = 0;
+        break;
+    case Transform::ANIMATE_ROTATE:
+        rotationOffset = 0;
+        break;
+    case Transform::ANIMATE_TRANSLATE:
+        translationOffset = 0;
+        break;
+    case Transform::ANIMATE_ROTATE_TRANSLATE:
+        rotationOffset = 0;
+        translationOffset = 4;
+        break;
+    case Transform::ANIMATE_SCALE_ROTATE:
+        scaleOffset = 0;
+        rotationOffset = 3;
+        break;
+    case Transform::ANIMATE_SCALE_TRANSLATE:
+        scaleOffset = 0;
+        translationOffset = 3;
+        break;
+    case Transform::ANIMATE_SCALE_ROTATE_TRANSLATE:
+        scaleOffset = 0;
+        rotationOffset = 3;
+        translationOffset = 7;
+        break;
+    default:
+        return;
+    }
+
+    if (scaleOffset >= 0)
+    {
+        float* s = value + scaleOffset;
+        s[0] *= mapping.scale.x;
+        s[1] *= mapping.scale.y;
+        s[2] *= mapping.scale.z;
+    }
+    if (rotationOffset >= 0)
+    {
+        float* r = value + rotationOffset;
+        Quaternion rotation(r[0], r[1], r[2], r[3]);
+        Quaternion::multiply(mapping.rotation, rotation, &rotation);
+        r[0] = rotation.x;
+        r[1] = rotation.y;
+        r[2] = rotation.z;
+        r[3] = rotation.w;
+    }
+    if (translationOffset >= 0)
+    {
+        float* t = value + translationOffset;
+        t[0] = mapping.targetTranslation.x + (t[0] - mapping.sourceTranslation.x) * mapping.translationScale;
+        t[1] = mapping.targetTranslation.y + (t[1] - mapping.sourceTranslation.y) * mapping.translationScale;
+        t[2] = mapping.targetTranslation.z + (t[2] - mapping.sourceTranslation.z) * mapping.translationScale;
+    }
+}
+
+}
@@ -0,0 +1,180 @@
+#ifndef ANIMATIONRETARGET_H_
+#define ANIMATIONRETARGET_H_
+
+#include "Ref.h"
+#include "Vector3.h"
+#include "Quaternion.h"
+
+namespace gameplay
+{
+
+class Animation;
+class BakedCurve;
+class Curve;
+class Joint;
+class MeshSkin;
+
+/**
+ * Defines a table that maps the channels of an animation onto the joints of a skeleton.
+ *
+ * An animation is bound to the joints it was loaded for. A retarget table is built once
+ * for an animation and a skin: each channel of the animation that targets a joint is
+ * matched by id with a joint of the skin, and the index of that joint in the skin is
+ * stored. Animations are then created for any skin with the same joint layout (such as
+ * the clones of a character) by index, without looking up joints by id again. The
+ * created animations share the curves of the source animation, which are kept by the
+ * table, so the source skeleton may be destroyed once the table is created.
+ *
+ * When the bind poses of the two skeletons differ, the table also stores a correction
+ * for each joint, computed from the inverse bind pose matrices of the joints. Rotations
+ * are applied relative to the bind pose of the source joint, translations are offset
+ * from the bind pose of the target joint and scaled by the ratio of the lengths of the
+ * two bones, and scales are applied relative to the bind scale of the source joint.
+ * The bind poses of both joints are kept, so that an animation created for a skin with
+ * other bind poses gets corrections rebuilt for its own joints.
+ */
+class AnimationRetarget : public Ref
+{
+    friend class Animation;
+    friend class AnimationClip;
+
+public:
+
+    /**
+     * Creates a retarget table mapping the channels of an animation onto the joints of a skin.
+     *
+     * @param animation The animation to retarget, whose channels target joints.
+     * @param skin The skin whose joints the animation is mapped onto.
+     * @param correctBindPose true to correct for the difference between the bind poses
+     *      of the source and target joints, false to apply the animated values as is.
+     * @param jointIds Optional map from the ids of the source joints to the ids of the
+     *      target joints, for skeletons that name their joints differently. Joints that
+     *      are not in the map are matched by their own id.
+     *
+     * @return The new retarget table.
+     * @script{create}
+     */
+    static AnimationRetarget* create(Animation* animation, MeshSkin* skin, bool correctBindPose = true,
+                                     const std::map<std::string, std::string>* jointIds = NULL);
+
+    /**
+     * Gets the animation that is retargeted.
+     *
+     * @return The source animation.
+     */
+    Animation* getAnimation() const;
+
+    /**
+     * Gets the number of joints of the skins that animations can be created for.
+     *
+     * @return The number of joints.
+     */
+    unsigned int getJointCount() const;
+
+    /**
+     * Gets the number of channels of the source animation that are mapped onto a joint.
+     *
+     * @return The number of mapped channels.
+     */
+    unsigned int getMappedChannelCount() const;
+
+    /**
+     * Gets the index of the joint that a channel of the source animation is mapped onto.
+     *
+     * @param channelIndex The index of the channel in the source animation.
+     *
+     * @return The index of the joint in the skin, or -1 if the channel is not mapped.
+     */
+    int getJointIndex(unsigned int channelIndex) const;
+
+    /**
+     * Creates an animation of the joints of a skin from the source animation.
+     *
+     * The skin must have the same joint layout as the skin the table was created for.
+     * The new animation has the clips of the source animation, and shares its curves.
+     * If the bind poses of the skin differ from those of the skin the table was created
+     * for, the bind pose corrections are rebuilt for the joints of this skin.
+     *
+     * @param skin The skin to animate.
+     * @param id The id of the new animation, or NULL to use the id of the source animation.
+     *
+     * @return The new animation, or NULL if the skin does not match the table.
+     */
+    Animation* createAnimation(MeshSkin* skin, const char* id = NULL);
+
+private:
+
+    /**
+     * The joint that a channel is mapped onto, and its bind pose correction.
+     */
+    struct JointMapping
+    {
+        int jointIndex;                 // Index of the joint in the skin, or -1 if the channel is not mapped.
+        int propertyId;                 // The property of the joint that the channel animates.
+        Curve* curve;                   // The curve of the channel, or NULL if it is baked or not mapped.
+        BakedCurve* bakedCurve;         // The baked curve of the channel, or NULL if it is not baked or not mapped.
+        unsigned long duration;         // The duration of the channel.
+        bool corrected;                 // Whether the bind pose correction is applied.
+        Vector3 scale;                  // Bind scale of the target joint divided by that of the source joint.
+        Quaternion rotation;            // Bind rotation of the target joint times the inverse of that of the source joint.
+        float translationScale;         // Length of the target bone divided by that of the source bone.
+        Vector3 sourceScale;            // Bind scale of the source joint.
+        Quaternion sourceRotation;      // Bind rotation of the source joint.
+        Vector3 sourceTranslation;      // Bind translation of the source joint.
+        Vector3 targetScale;            // Bind scale of the target joint.
+        Quaternion targetRotation;      // Bind rotation of the target joint.
+        Vector3 targetTranslation;      // Bind translation of the target joint.
+    };
+
+    /**
+     * Constructor.
+     */
+    AnimationRetarget();
+
+    /**
+     * Destructor.
+     */
+    ~AnimationRetarget();
+
+    /**
+     * Hidden copy constructor.
+     */
+    AnimationRetarget(const AnimationRetarget& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    AnimationRetarget& operator=(const AnimationRetarget&);
+
+    /**
+     * Sets the target joint of a mapping, and computes the bind pose correction from the
+     * bind pose of the source joint to that of the target joint.
+     */
+    static void setTargetBindPose(JointMapping* mapping, Joint* target);
+
+    /**
+     * Determines whether the mapped joints of a skin have the bind poses the corrections
+     * of the table were computed for.
+     */
+    bool isBindPoseOf(MeshSkin* skin) const;
+
+    /**
+     * Creates a copy of the table with the bind pose corrections rebuilt for the joints of a skin.
+     */
+    AnimationRetarget* rebind(MeshSkin* skin) const;
+
+    /**
+     * Applies the bind pose correction of a channel to an evaluated value of its property.
+     */
+    void correct(unsigned int channelIndex, float* value) const;
+
+    Animation* _animation;                  // The source animation.
+    unsigned int _jointCount;               // Number of joints of the skin the table was created for.
+    unsigned int _mappedChannelCount;       // Number of channels mapped onto a joint.
+    bool _correctBindPose;                  // Whether the bind poses of the source and target joints are corrected for.
+    std::vector<JointMapping> _mappings;    // The mapping of each channel of the source animation.
+};
+
+}
+
+#endif
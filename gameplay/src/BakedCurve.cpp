@@ -0,0 +1,291 @@
+#include "Base.h"
+#include "BakedCurve.h"
+#include "Curve.h"
+
+// Components whose values vary by less than this are stored once rather than per frame.
+#define BAKED_CURVE_CONSTANT_EPSILON    1e-6f
+
+// The components stored by the smallest-three encoding are within [-1/sqrt(2), 1/sqrt(2)]
+// and are quantized to 15 bits.
+#define BAKED_CURVE_QUATERNION_RANGE    0.707106781f
+#define BAKED_CURVE_QUATERNION_MAX      32767.0f
+
+namespace gameplay
+{
+
+// Encodes a quaternion (x, y, z, w) in three 16-bit values.
+static inline void encodeQuaternion(const float* q, unsigned short* dst)
+{
+    float x = q[0], y = q[1], z = q[2], w = q[3];
+    float length = sqrt(x * x + y * y + z * z + w * w);
+    float v[4] = { x, y, z, w };
+    if (length > 0.0f)
+    {
+        for (unsigned int i = 0; i < 4; ++i)
+            v[i] /= length;
+    }
+    else
+    {
+        v[3] = 1.0f;
+    }
+
+    // Drop the largest component, making it positive so it can be restored from the others.
+    unsigned int largest = 0;
+    for (unsigned int i = 1; i < 4; ++i)
+    {
+        if (fabs(v[i]) > fabs(v[largest]))
+            largest = i;
+    }
+    float sign = v[largest] < 0.0f ? -1.0f : 1.0f;
+
+    unsigned short values[3];
+    for (unsigned int i = 0, j = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        float n = (v[i] * sign + BAKED_CURVE_QUATERNION_RANGE) * (BAKED_CURVE_QUATERNION_MAX / (2.0f * BAKED_CURVE_QUATERNION_RANGE));
+        n = n < 0.0f ? 0.0f : (n > BAKED_CURVE_QUATERNION_MAX ? BAKED_CURVE_QUATERNION_MAX : n);
+        values[j++] = (unsigned short)(n + 0.5f);
+    }
+    dst[0] = (unsigned short)(values[0] | ((largest >> 1) << 15));
+    dst[1] = (unsigned short)(values[1] | ((largest & 1) << 15));
+    dst[2] = values[2];
+}
+
+// Decodes a quaternion (x, y, z, w) encoded by encodeQuaternion.
+static inline void decodeQuaternion(const unsigned short* src, float* dst)
+{
+    const float scale = (2.0f * BAKED_CURVE_QUATERNION_RANGE) / BAKED_CURVE_QUATERNION_MAX;
+    unsigned int largest = ((src[0] >> 15) << 1) | (src[1] >> 15);
+    float a = (float)(src[0] & 0x7FFF) * scale - BAKED_CURVE_QUATERNION_RANGE;
+    float b = (float)(src[1] & 0x7FFF) * scale - BAKED_CURVE_QUATERNION_RANGE;
+    float c = (float)(src[2] & 0x7FFF) * scale - BAKED_CURVE_QUATERNION_RANGE;
+    float d = 1.0f - a * a - b * b - c * c;
+    d = d > 0.0f ? sqrt(d) : 0.0f;
+
+    switch (largest)
+    {
+    case 0:
+        dst[0] = d; dst[1] = a; dst[2] = b; dst[3] = c;
+        break;
+    case 1:
+        dst[0] = a; dst[1] = d; dst[2] = b; dst[3] = c;
+        break;
+    case 2:
+        dst[0] = a; dst[1] = b; dst[2] = d; dst[3] = c;
+        break;
+    default:
+        dst[0] = a; dst[1] = b; dst[2] = c; dst[3] = d;
+        break;
+    }
+}
+
+BakedCurve::BakedCurve()
+    : _frameCount(0), _componentCount(0), _quaternionOffset(-1), _animatedCount(0), _frameStride(0),
+      _animated(NULL), _ranges(NULL), _constants(NULL), _frames(NULL)
+{
+}
+
+BakedCurve::~BakedCurve()
+{
+    SAFE_DELETE_ARRAY(_animated);
+    SAFE_DELETE_ARRAY(_ranges);
+    SAFE_DELETE_ARRAY(_constants);
+    SAFE_DELETE_ARRAY(_frames);
+}
+
+BakedCurve* BakedCurve::create(const Curve* curve, unsigned int frameCount)
+{
+    GP_ASSERT(curve);
+    GP_ASSERT(frameCount > 0);
+
+    BakedCurve* baked = new BakedCurve();
+    unsigned int componentCount = curve->getComponentCount();
+    baked->_frameCount = frameCount;
+    baked->_componentCount = componentCount;
+    if (curve->_quaternionOffset)
+        baked->_quaternionOffset = (int)*curve->_quaternionOffset;
+
+    // Sample the curve at uniformly spaced times.
+    std::vector<float> samples(frameCount * componentCount);
+    for (unsigned int i = 0; i < frameCount; ++i)
+    {
+        float time = frameCount > 1 ? (float)i / (float)(frameCount - 1) : 0.0f;
+        curve->evaluate(time, &samples[i * componentCount]);
+    }
+
+    // Find the range of each component other than the rotation, and keep those that vary.
+    baked->_constants = new float[componentCount];
+    memcpy(baked->_constants, &samples[0], componentCount * sizeof(float));
+    std::vector<unsigned int> animated;
+    std::vector<float> ranges;
+    for (unsigned int c = 0; c < componentCount; ++c)
+    {
+        if (baked->_quaternionOffset >= 0 && c >= (unsigned int)baked->_quaternionOffset && c < (unsigned int)baked->_quaternionOffset + 4)
+            continue;
+
+        float minValue = samples[c];
+        float maxValue = samples[c];
+        for (unsigned int i = 1; i < frameCount; ++i)
+        {
+            float value = samples[i * componentCount + c];
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+        }
+        if (maxValue - minValue > BAKED_CURVE_CONSTANT_EPSILON * std::max(1.0f, fabs(minValue)))
+        {
+            animated.push_back(c);
+            ranges.push_back(minValue);
+            ranges.push_back((maxValue - minValue) / 65535.0f);
+        }
+    }
+
+    baked->_animatedCount = (unsigned int)animated.size();
+    baked->_frameStride = baked->_animatedCount + (baked->_quaternionOffset >= 0 ? 3 : 0);
+    if (baked->_animatedCount > 0)
+    {
+        baked->_animated = new unsigned int[baked->_animatedCount];
+        memcpy(baked->_animated, &animated[0], baked->_animatedCount * sizeof(unsigned int));
+        baked->_ranges = new float[baked->_animatedCount * 2];
+        memcpy(baked->_ranges, &ranges[0], baked->_animatedCount * 2 * sizeof(float));
+    }
+
+    // Quantize the frames.
+    if (baked->_frameStride > 0)
+    {
+        baked->_frames = new unsigned short[frameCount * baked->_frameStride];
+        for (unsigned int i = 0; i < frameCount; ++i)
+        {
+            const float* sample = &samples[i * componentCount];
+            unsigned short* frame = baked->_frames + i * baked->_frameStride;
+            for (unsigned int a = 0; a < baked->_animatedCount; ++a)
+            {
+                float step = baked->_ranges[a * 2 + 1];
+                float n = (sample[baked->_animated[a]] - baked->_ranges[a * 2]) / step;
+                n = n < 0.0f ? 0.0f : (n > 65535.0f ? 65535.0f : n);
+                frame[a] = (unsigned short)(n + 0.5f);
+            }
+            if (baked->_quaternionOffset >= 0)
+            {
+                encodeQuaternion(sample + baked->_quaternionOffset, frame + baked->_animatedCount);
+            }
+        }
+    }
+
+    return baked;
+}
+
+unsigned int BakedCurve::getFrameCount() const
+{
+    return _frameCount;
+}
+
+unsigned int BakedCurve::getComponentCount() const
+{
+    return _componentCount;
+}
+
+unsigned int BakedCurve::getDataSize() const
+{
+    return _frameCount * _frameStride * sizeof(unsigned short) +
+           _animatedCount * (sizeof(unsigned int) + 2 * sizeof(float)) +
+           _componentCount * sizeof(float);
+}
+
+void BakedCurve::evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst) const
+{
+    GP_ASSERT(dst && startTime >= 0.0f && startTime <= endTime && endTime <= 1.0f && loopBlendTime >= 0.0f);
+
+    // Components that do not change are copied, and the others are overwritten.
+    memcpy(dst, _constants, _componentCount * sizeof(float));
+    if (_frameStride == 0)
+        return;
+
+    float localTime = startTime + (endTime - startTime) * time;
+    if (loopBlendTime == 0.0f)
+    {
+        // If no loop blend time is specified, clamp time to end points
+        if (localTime < startTime)
+            localTime = startTime;
+        else if (localTime > endTime)
+            localTime = endTime;
+    }
+
+    float last = (float)(_frameCount - 1);
+    if (localTime > endTime)
+    {
+        // Looping forward, from the end of the subregion to its start.
+        float t = std::min((localTime - endTime) / loopBlendTime, 1.0f);
+        interpolate((unsigned int)(endTime * last + 0.5f), (unsigned int)(startTime * last + 0.5f), t, dst);
+    }
+    else if (localTime < startTime)
+    {
+        // Looping in reverse, from the start of the subregion to its end.
+        float t = std::min((startTime - localTime) / loopBlendTime, 1.0f);
+        interpolate((unsigned int)(startTime * last + 0.5f), (unsigned int)(endTime * last + 0.5f), t, dst);
+    }
+    else
+    {
+        sample(localTime, dst);
+    }
+}
+
+void BakedCurve::sample(float time, float* dst) const
+{
+    if (_frameCount == 1)
+    {
+        interpolate(0, 0, 0.0f, dst);
+        return;
+    }
+
+    float position = time * (float)(_frameCount - 1);
+    unsigned int from = (unsigned int)position;
+    if (from >= _frameCount - 1)
+        from = _frameCount - 2;
+    interpolate(from, from + 1, position - (float)from, dst);
+}
+
+void BakedCurve::interpolate(unsigned int from, unsigned int to, float t, float* dst) const
+{
+    GP_ASSERT(from < _frameCount && to < _frameCount);
+
+    const unsigned short* a = _frames + from * _frameStride;
+    const unsigned short* b = _frames + to * _frameStride;
+    for (unsigned int i = 0; i < _animatedCount; ++i)
+    {
+        float va = (float)a[i];
+        float vb = (float)b[i];
+        dst[_animated[i]] = _ranges[i * 2] + (va + (vb - va) * t) * _ranges[i * 2 + 1];
+    }
+
+    if (_quaternionOffset >= 0)
+    {
+        // Normalized linear interpolation along the shortest path.
+        float qa[4];
+        float qb[4];
+        decodeQuaternion(a + _animatedCount, qa);
+        decodeQuaternion(b + _animatedCount, qb);
+        if (qa[0] * qb[0] + qa[1] * qb[1] + qa[2] * qb[2] + qa[3] * qb[3] < 0.0f)
+        {
+            qb[0] = -qb[0];
+            qb[1] = -qb[1];
+            qb[2] = -qb[2];
+            qb[3] = -qb[3];
+        }
+        float* q = dst + _quaternionOffset;
+        float lengthSq = 0.0f;
+        for (unsigned int i = 0; i < 4; ++i)
+        {
+            q[i] = qa[i] + (qb[i] - qa[i]) * t;
+            lengthSq += q[i] * q[i];
+        }
+        if (lengthSq > 0.0f)
+        {
+            float scale = 1.0f / sqrt(lengthSq);
+            for (unsigned int i = 0; i < 4; ++i)
+                q[i] *= scale;
+        }
+    }
+}
+
+}
@@ -0,0 +1,124 @@
+#ifndef BAKEDCURVE_H_
+#define BAKEDCURVE_H_
+
+#include "Ref.h"
+
+namespace gameplay
+{
+
+class Curve;
+
+/**
+ * Defines a curve that has been resampled at a fixed rate and quantized for fast sampling.
+ *
+ * A baked curve stores the values of a Curve at uniformly spaced times in a single
+ * contiguous buffer of 16-bit values. Each component is quantized over the range of
+ * values it takes, and components that are constant are stored once rather than per
+ * frame. The rotation of a transform curve is stored in the smallest-three encoding:
+ * the three smallest components of the unit quaternion, with the index of the dropped
+ * largest component packed in their spare bits.
+ *
+ * Evaluating a baked curve is the same for every interpolation type of the source curve:
+ * a linear interpolation between the two nearest frames, normalized for the rotation.
+ * The source curve is no longer needed once baked.
+ */
+class BakedCurve : public Ref
+{
+public:
+
+    /**
+     * Creates a baked curve by sampling a curve at uniformly spaced times.
+     *
+     * @param curve The curve to bake.
+     * @param frameCount The number of samples to take over the curve, including both end points.
+     *
+     * @return The new baked curve.
+     * @script{create}
+     */
+    static BakedCurve* create(const Curve* curve, unsigned int frameCount);
+
+    /**
+     * Gets the number of frames in the curve.
+     *
+     * @return The number of frames.
+     */
+    unsigned int getFrameCount() const;
+
+    /**
+     * Gets the number of float values in the value of the curve.
+     *
+     * @return The number of components.
+     */
+    unsigned int getComponentCount() const;
+
+    /**
+     * Gets the number of bytes of memory used by the baked values.
+     *
+     * @return The size of the baked data, in bytes.
+     */
+    unsigned int getDataSize() const;
+
+    /**
+     * Evaluates the curve at the given position value (between 0.0 and 1.0 inclusive)
+     * within the specified subregion of the curve.
+     *
+     * This matches Curve::evaluate(float, float, float, float, float*), except that the
+     * subregion starts and ends exactly at the given times rather than at the points of
+     * the curve that precede them.
+     *
+     * @param time The position within the subregion of the curve to evaluate the curve at.
+     * @param startTime Start time for the subregion (between 0.0 - 1.0).
+     * @param endTime End time for the subregion (between 0.0 - 1.0).
+     * @param loopBlendTime Time to blend between the end points of the subregion, as a
+     *      fraction of the curve, when time is outside the range 0-1. A value of zero
+     *      disables looping.
+     * @param dst The evaluated value of the curve at the given time.
+     */
+    void evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst) const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    BakedCurve();
+
+    /**
+     * Destructor.
+     */
+    ~BakedCurve();
+
+    /**
+     * Hidden copy constructor.
+     */
+    BakedCurve(const BakedCurve& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    BakedCurve& operator=(const BakedCurve&);
+
+    /**
+     * Decodes the value of a frame at the given time.
+     */
+    void sample(float time, float* dst) const;
+
+    /**
+     * Decodes and interpolates the animated components of two frames.
+     */
+    void interpolate(unsigned int from, unsigned int to, float t, float* dst) const;
+
+    unsigned int _frameCount;           // Number of frames.
+    unsigned int _componentCount;       // Number of components in the curve's value.
+    int _quaternionOffset;              // Offset of the rotation in the curve's value, or -1.
+    unsigned int _animatedCount;        // Number of components other than the rotation that are stored per frame.
+    unsigned int _frameStride;          // Number of 16-bit values per frame.
+    unsigned int* _animated;            // Component index of each animated component.
+    float* _ranges;                     // Minimum and quantization step of each animated component.
+    float* _constants;                  // Value of each component that does not change (unused entries for animated ones).
+    unsigned short* _frames;            // Frame data.
+};
+
+}
+
+#endif
@@ -11,6 +11,7 @@
 #include <cwctype>
 #include <cctype>
 #include <cmath>
+#include <cfloat>
 #include <cstdarg>
 #include <ctime>
 #include <iostream>
@@ -22,6 +23,7 @@
 #include <set>
 #include <stack>
 #include <map>
+#include <unordered_map>
 #include <queue>
 #include <algorithm>
 #include <limits>
@@ -30,6 +32,8 @@
 #include <typeinfo>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chrono>
 #include "Logger.h"
 
@@ -232,10 +236,12 @@ extern int strcmpnocase(const char* s1, const char* s2);
         #define GLEW_STATIC
         #include <GL/glew.h>
         #define GP_USE_VAO
+        #define GP_USE_INSTANCING
 #elif __linux__
         #define GLEW_STATIC
         #include <GL/glew.h>
         #define GP_USE_VAO
+        #define GP_USE_INSTANCING
 #elif __APPLE__
     #include "TargetConditionals.h"
     #if TARGET_OS_IPHONE || TARGET_IPHONE_SIMULATOR
@@ -274,6 +280,7 @@ extern int strcmpnocase(const char* s1, const char* s2);
 #define VERTEX_ATTRIBUTE_BLENDWEIGHTS_NAME          "a_blendWeights"
 #define VERTEX_ATTRIBUTE_BLENDINDICES_NAME          "a_blendIndices"
 #define VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME       "a_texCoord"
+#define VERTEX_ATTRIBUTE_INSTANCE_MATRIX_NAME       "a_instanceMatrix"
 
 // Hardware buffer
 namespace gameplay
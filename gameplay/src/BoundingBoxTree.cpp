@@ -0,0 +1,528 @@
+#include "Base.h"
+#include "BoundingBoxTree.h"
+
+namespace gameplay
+{
+
+// Returns the surface area of the given box, used as the cost of visiting it.
+static inline float getSurfaceArea(const BoundingBox& box)
+{
+    float dx = box.max.x - box.min.x;
+    float dy = box.max.y - box.min.y;
+    float dz = box.max.z - box.min.z;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+static inline void mergeBoxes(const BoundingBox& box1, const BoundingBox& box2, BoundingBox* dst)
+{
+    dst->min.set(std::min(box1.min.x, box2.min.x), std::min(box1.min.y, box2.min.y), std::min(box1.min.z, box2.min.z));
+    dst->max.set(std::max(box1.max.x, box2.max.x), std::max(box1.max.y, box2.max.y), std::max(box1.max.z, box2.max.z));
+}
+
+static inline bool containsBox(const BoundingBox& outer, const BoundingBox& inner)
+{
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+// Classifies a box against a frustum: -1 if outside, 1 if entirely inside, 0 if intersecting.
+static int classifyBox(const BoundingBox& box, const Frustum& frustum)
+{
+    const Plane* planes[6] = { &frustum.getNear(), &frustum.getFar(), &frustum.getLeft(),
+                               &frustum.getRight(), &frustum.getBottom(), &frustum.getTop() };
+    int result = 1;
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        const Vector3& n = planes[i]->getNormal();
+        float d = planes[i]->getDistance();
+
+        // The corner furthest along the plane normal decides if the box is outside,
+        // and the corner furthest against it decides if the box is entirely inside.
+        float maxDistance = n.x * (n.x >= 0.0f ? box.max.x : box.min.x) +
+                            n.y * (n.y >= 0.0f ? box.max.y : box.min.y) +
+                            n.z * (n.z >= 0.0f ? box.max.z : box.min.z) + d;
+        if (maxDistance < 0.0f)
+            return -1;
+
+        float minDistance = n.x * (n.x >= 0.0f ? box.min.x : box.max.x) +
+                            n.y * (n.y >= 0.0f ? box.min.y : box.max.y) +
+                            n.z * (n.z >= 0.0f ? box.min.z : box.max.z) + d;
+        if (minDistance < 0.0f)
+            result = 0;
+    }
+    return result;
+}
+
+BoundingBoxTree::BoundingBoxTree(float margin)
+    : _root(NULL_PROXY), _freeList(NULL_PROXY), _proxyCount(0), _margin(margin)
+{
+}
+
+BoundingBoxTree::~BoundingBoxTree()
+{
+}
+
+int BoundingBoxTree::createProxy(const BoundingBox& box, void* userData)
+{
+    int proxy = allocateNode();
+    TreeNode& node = _nodes[proxy];
+    node.box.min.set(box.min.x - _margin, box.min.y - _margin, box.min.z - _margin);
+    node.box.max.set(box.max.x + _margin, box.max.y + _margin, box.max.z + _margin);
+    node.userData = userData;
+    node.height = 0;
+
+    insertLeaf(proxy);
+    ++_proxyCount;
+
+    return proxy;
+}
+
+void BoundingBoxTree::destroyProxy(int proxy)
+{
+    GP_ASSERT(proxy >= 0 && proxy < (int)_nodes.size());
+    GP_ASSERT(_nodes[proxy].isLeaf());
+
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --_proxyCount;
+}
+
+bool BoundingBoxTree::moveProxy(int proxy, const BoundingBox& box)
+{
+    GP_ASSERT(proxy >= 0 && proxy < (int)_nodes.size());
+    GP_ASSERT(_nodes[proxy].isLeaf());
+
+    if (containsBox(_nodes[proxy].box, box))
+        return false;
+
+    removeLeaf(proxy);
+    _nodes[proxy].box.min.set(box.min.x - _margin, box.min.y - _margin, box.min.z - _margin);
+    _nodes[proxy].box.max.set(box.max.x + _margin, box.max.y + _margin, box.max.z + _margin);
+    insertLeaf(proxy);
+
+    return true;
+}
+
+void* BoundingBoxTree::getUserData(int proxy) const
+{
+    GP_ASSERT(proxy >= 0 && proxy < (int)_nodes.size());
+    return _nodes[proxy].userData;
+}
+
+const BoundingBox& BoundingBoxTree::getFatBox(int proxy) const
+{
+    GP_ASSERT(proxy >= 0 && proxy < (int)_nodes.size());
+    return _nodes[proxy].box;
+}
+
+unsigned int BoundingBoxTree::getProxyCount() const
+{
+    return _proxyCount;
+}
+
+unsigned int BoundingBoxTree::getHeight() const
+{
+    return _root == NULL_PROXY ? 0 : (unsigned int)_nodes[_root].height;
+}
+
+unsigned int BoundingBoxTree::query(const BoundingBox& box, std::vector<int>& proxies) const
+{
+    size_t count = proxies.size();
+    if (_root == NULL_PROXY)
+        return 0;
+
+    std::vector<int> stack;
+    stack.push_back(_root);
+    while (!stack.empty())
+    {
+        const TreeNode& node = _nodes[stack.back()];
+        int index = stack.back();
+        stack.pop_back();
+
+        if (!node.box.intersects(box))
+            continue;
+
+        if (node.isLeaf())
+        {
+            proxies.push_back(index);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+    return (unsigned int)(proxies.size() - count);
+}
+
+unsigned int BoundingBoxTree::query(const BoundingSphere& sphere, std::vector<int>& proxies) const
+{
+    size_t count = proxies.size();
+    if (_root == NULL_PROXY)
+        return 0;
+
+    std::vector<int> stack;
+    stack.push_back(_root);
+    while (!stack.empty())
+    {
+        const TreeNode& node = _nodes[stack.back()];
+        int index = stack.back();
+        stack.pop_back();
+
+        if (!node.box.intersects(sphere))
+            continue;
+
+        if (node.isLeaf())
+        {
+            proxies.push_back(index);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+    return (unsigned int)(proxies.size() - count);
+}
+
+unsigned int BoundingBoxTree::query(const Frustum& frustum, std::vector<int>& proxies) const
+{
+    size_t count = proxies.size();
+    if (_root == NULL_PROXY)
+        return 0;
+
+    std::vector<int> stack;
+    stack.push_back(_root);
+    while (!stack.empty())
+    {
+        int index = stack.back();
+        stack.pop_back();
+
+        int classification = classifyBox(_nodes[index].box, frustum);
+        if (classification < 0)
+            continue;
+
+        if (classification > 0 || _nodes[index].isLeaf())
+        {
+            addLeaves(index, proxies);
+        }
+        else
+        {
+            stack.push_back(_nodes[index].child1);
+            stack.push_back(_nodes[index].child2);
+        }
+    }
+    return (unsigned int)(proxies.size() - count);
+}
+
+unsigned int BoundingBoxTree::query(const Ray& ray, std::vector<int>& proxies, float maxDistance) const
+{
+    size_t count = proxies.size();
+    if (_root == NULL_PROXY)
+        return 0;
+
+    std::vector<int> stack;
+    stack.push_back(_root);
+    while (!stack.empty())
+    {
+        const TreeNode& node = _nodes[stack.back()];
+        int index = stack.back();
+        stack.pop_back();
+
+        float distance = node.box.intersects(ray);
+        if (distance == Ray::INTERSECTS_NONE || distance > maxDistance)
+            continue;
+
+        if (node.isLeaf())
+        {
+            proxies.push_back(index);
+        }
+        else
+        {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+    return (unsigned int)(proxies.size() - count);
+}
+
+int BoundingBoxTree::allocateNode()
+{
+    int index;
+    if (_freeList == NULL_PROXY)
+    {
+        index = (int)_nodes.size();
+        _nodes.push_back(TreeNode());
+    }
+    else
+    {
+        // Free nodes are linked through their parent index.
+        index = _freeList;
+        _freeList = _nodes[index].parent;
+    }
+
+    TreeNode& node = _nodes[index];
+    node.userData = NULL;
+    node.parent = NULL_PROXY;
+    node.child1 = NULL_PROXY;
+    node.child2 = NULL_PROXY;
+    node.height = 0;
+    return index;
+}
+
+void BoundingBoxTree::freeNode(int node)
+{
+    _nodes[node].parent = _freeList;
+    _nodes[node].height = -1;
+    _freeList = node;
+}
+
+void BoundingBoxTree::insertLeaf(int leaf)
+{
+    if (_root == NULL_PROXY)
+    {
+        _root = leaf;
+        _nodes[leaf].parent = NULL_PROXY;
+        return;
+    }
+
+    // Find the best sibling for the new leaf, descending into the child that
+    // least increases the total surface area of the tree.
+    BoundingBox leafBox = _nodes[leaf].box;
+    int index = _root;
+    while (!_nodes[index].isLeaf())
+    {
+        int child1 = _nodes[index].child1;
+        int child2 = _nodes[index].child2;
+
+        BoundingBox combined;
+        mergeBoxes(_nodes[index].box, leafBox, &combined);
+        float area = getSurfaceArea(_nodes[index].box);
+        float combinedArea = getSurfaceArea(combined);
+
+        // Cost of creating a new parent for this node and the new leaf, and the
+        // minimum cost of pushing the leaf further down the tree.
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        BoundingBox box;
+        mergeBoxes(leafBox, _nodes[child1].box, &box);
+        float cost1 = getSurfaceArea(box) + inheritanceCost;
+        if (!_nodes[child1].isLeaf())
+            cost1 -= getSurfaceArea(_nodes[child1].box);
+
+        mergeBoxes(leafBox, _nodes[child2].box, &box);
+        float cost2 = getSurfaceArea(box) + inheritanceCost;
+        if (!_nodes[child2].isLeaf())
+            cost2 -= getSurfaceArea(_nodes[child2].box);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? child1 : child2;
+    }
+    int sibling = index;
+
+    // Create a new parent for the sibling and the leaf.
+    int oldParent = _nodes[sibling].parent;
+    int newParent = allocateNode();
+    _nodes[newParent].parent = oldParent;
+    mergeBoxes(leafBox, _nodes[sibling].box, &_nodes[newParent].box);
+    _nodes[newParent].height = _nodes[sibling].height + 1;
+    _nodes[newParent].child1 = sibling;
+    _nodes[newParent].child2 = leaf;
+    _nodes[sibling].parent = newParent;
+    _nodes[leaf].parent = newParent;
+
+    if (oldParent != NULL_PROXY)
+    {
+        if (_nodes[oldParent].child1 == sibling)
+            _nodes[oldParent].child1 = newParent;
+        else
+            _nodes[oldParent].child2 = newParent;
+    }
+    else
+    {
+        _root = newParent;
+    }
+
+    // Walk back up the tree fixing heights and boxes.
+    refit(_nodes[leaf].parent);
+}
+
+void BoundingBoxTree::removeLeaf(int leaf)
+{
+    if (leaf == _root)
+    {
+        _root = NULL_PROXY;
+        return;
+    }
+
+    int parent = _nodes[leaf].parent;
+    int grandParent = _nodes[parent].parent;
+    int sibling = _nodes[parent].child1 == leaf ? _nodes[parent].child2 : _nodes[parent].child1;
+
+    // Replace the parent with the sibling.
+    if (grandParent != NULL_PROXY)
+    {
+        if (_nodes[grandParent].child1 == parent)
+            _nodes[grandParent].child1 = sibling;
+        else
+            _nodes[grandParent].child2 = sibling;
+        _nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        refit(grandParent);
+    }
+    else
+    {
+        _root = sibling;
+        _nodes[sibling].parent = NULL_PROXY;
+        freeNode(parent);
+    }
+}
+
+void BoundingBoxTree::refit(int node)
+{
+    while (node != NULL_PROXY)
+    {
+        node = balance(node);
+
+        TreeNode& n = _nodes[node];
+        n.height = 1 + std::max(_nodes[n.child1].height, _nodes[n.child2].height);
+        mergeBoxes(_nodes[n.child1].box, _nodes[n.child2].box, &n.box);
+
+        node = n.parent;
+    }
+}
+
+int BoundingBoxTree::balance(int iA)
+{
+    TreeNode* a = &_nodes[iA];
+    if (a->isLeaf() || a->height < 2)
+        return iA;
+
+    int iB = a->child1;
+    int iC = a->child2;
+    TreeNode* b = &_nodes[iB];
+    TreeNode* c = &_nodes[iC];
+
+    int difference = c->height - b->height;
+
+    // Rotate C up.
+    if (difference > 1)
+    {
+        int iF = c->child1;
+        int iG = c->child2;
+        TreeNode* f = &_nodes[iF];
+        TreeNode* g = &_nodes[iG];
+
+        // Swap A and C.
+        c->child1 = iA;
+        c->parent = a->parent;
+        a->parent = iC;
+
+        // A's old parent should point to C.
+        if (c->parent != NULL_PROXY)
+        {
+            if (_nodes[c->parent].child1 == iA)
+                _nodes[c->parent].child1 = iC;
+            else
+                _nodes[c->parent].child2 = iC;
+        }
+        else
+        {
+            _root = iC;
+        }
+
+        // Keep the taller grandchild under C.
+        if (f->height > g->height)
+        {
+            c->child2 = iF;
+            a->child2 = iG;
+            g->parent = iA;
+            mergeBoxes(b->box, g->box, &a->box);
+            mergeBoxes(a->box, f->box, &c->box);
+            a->height = 1 + std::max(b->height, g->height);
+            c->height = 1 + std::max(a->height, f->height);
+        }
+        else
+        {
+            c->child2 = iG;
+            a->child2 = iF;
+            f->parent = iA;
+            mergeBoxes(b->box, f->box, &a->box);
+            mergeBoxes(a->box, g->box, &c->box);
+            a->height = 1 + std::max(b->height, f->height);
+            c->height = 1 + std::max(a->height, g->height);
+        }
+        return iC;
+    }
+
+    // Rotate B up.
+    if (difference < -1)
+    {
+        int iD = b->child1;
+        int iE = b->child2;
+        TreeNode* d = &_nodes[iD];
+        TreeNode* e = &_nodes[iE];
+
+        // Swap A and B.
+        b->child1 = iA;
+        b->parent = a->parent;
+        a->parent = iB;
+
+        // A's old parent should point to B.
+        if (b->parent != NULL_PROXY)
+        {
+            if (_nodes[b->parent].child1 == iA)
+                _nodes[b->parent].child1 = iB;
+            else
+                _nodes[b->parent].child2 = iB;
+        }
+        else
+        {
+            _root = iB;
+        }
+
+        // Keep the taller grandchild under B.
+        if (d->height > e->height)
+        {
+            b->child2 = iD;
+            a->child1 = iE;
+            e->parent = iA;
+            mergeBoxes(c->box, e->box, &a->box);
+            mergeBoxes(a->box, d->box, &b->box);
+            a->height = 1 + std::max(c->height, e->height);
+            b->height = 1 + std::max(a->height, d->height);
+        }
+        else
+        {
+            b->child2 = iE;
+            a->child1 = iD;
+            d->parent = iA;
+            mergeBoxes(c->box, d->box, &a->box);
+            mergeBoxes(a->box, e->box, &b->box);
+            a->height = 1 + std::max(c->height, d->height);
+            b->height = 1 + std::max(a->height, e->height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
+
+void BoundingBoxTree::addLeaves(int node, std::vector<int>& proxies) const
+{
+    if (_nodes[node].isLeaf())
+    {
+        proxies.push_back(node);
+    }
+    else
+    {
+        addLeaves(_nodes[node].child1, proxies);
+        addLeaves(_nodes[node].child2, proxies);
+    }
+}
+
+}
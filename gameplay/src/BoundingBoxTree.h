@@ -0,0 +1,200 @@
+#ifndef BOUNDINGBOXTREE_H_
+#define BOUNDINGBOXTREE_H_
+
+#include "BoundingBox.h"
+#include "BoundingSphere.h"
+#include "Frustum.h"
+#include "Ray.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a dynamic bounding volume hierarchy of axis-aligned bounding boxes.
+ *
+ * Each object in the tree is represented by a proxy, a leaf that stores an enlarged
+ * ("fat") bounding box of the object along with a user pointer. Moving an object only
+ * restructures the tree when the object leaves its fat bounding box, so objects that
+ * move a little every frame are cheap to keep up to date. Leaves are inserted where they
+ * least increase the surface area of the tree, and the tree is kept balanced with
+ * rotations, so queries visit a logarithmic number of nodes for small query volumes.
+ *
+ * Queries report the proxies whose fat bounding box intersects the query volume, which
+ * is a conservative superset of the objects that intersect it.
+ */
+class BoundingBoxTree
+{
+public:
+
+    /**
+     * Value returned for an invalid or missing proxy.
+     */
+    static const int NULL_PROXY = -1;
+
+    /**
+     * Constructor.
+     *
+     * @param margin The distance by which the bounding boxes of proxies are enlarged
+     *      in every direction.
+     */
+    BoundingBoxTree(float margin = 0.1f);
+
+    /**
+     * Destructor.
+     */
+    ~BoundingBoxTree();
+
+    /**
+     * Adds a proxy for an object to the tree.
+     *
+     * @param box The bounding box of the object.
+     * @param userData The user pointer to store with the proxy.
+     *
+     * @return The new proxy.
+     */
+    int createProxy(const BoundingBox& box, void* userData);
+
+    /**
+     * Removes a proxy from the tree.
+     *
+     * @param proxy The proxy to remove.
+     */
+    void destroyProxy(int proxy);
+
+    /**
+     * Updates the bounding box of a proxy.
+     *
+     * @param proxy The proxy to update.
+     * @param box The new bounding box of the object.
+     *
+     * @return true if the proxy left its fat bounding box and was reinserted; false otherwise.
+     */
+    bool moveProxy(int proxy, const BoundingBox& box);
+
+    /**
+     * Gets the user pointer stored with a proxy.
+     *
+     * @param proxy The proxy.
+     *
+     * @return The user pointer.
+     */
+    void* getUserData(int proxy) const;
+
+    /**
+     * Gets the fat bounding box stored for a proxy.
+     *
+     * @param proxy The proxy.
+     *
+     * @return The enlarged bounding box of the proxy.
+     */
+    const BoundingBox& getFatBox(int proxy) const;
+
+    /**
+     * Gets the number of proxies in the tree.
+     *
+     * @return The number of proxies.
+     */
+    unsigned int getProxyCount() const;
+
+    /**
+     * Gets the height of the tree, which is zero for an empty tree or a single proxy.
+     *
+     * @return The height of the tree.
+     */
+    unsigned int getHeight() const;
+
+    /**
+     * Finds the proxies whose fat bounding box intersects the given bounding box.
+     *
+     * @param box The bounding box to test.
+     * @param proxies The list to append the intersecting proxies to.
+     *
+     * @return The number of proxies appended.
+     */
+    unsigned int query(const BoundingBox& box, std::vector<int>& proxies) const;
+
+    /**
+     * Finds the proxies whose fat bounding box intersects the given bounding sphere.
+     *
+     * @param sphere The bounding sphere to test.
+     * @param proxies The list to append the intersecting proxies to.
+     *
+     * @return The number of proxies appended.
+     */
+    unsigned int query(const BoundingSphere& sphere, std::vector<int>& proxies) const;
+
+    /**
+     * Finds the proxies whose fat bounding box intersects the given frustum.
+     *
+     * Subtrees that are entirely inside the frustum are reported without testing
+     * their proxies individually.
+     *
+     * @param frustum The frustum to test.
+     * @param proxies The list to append the intersecting proxies to.
+     *
+     * @return The number of proxies appended.
+     */
+    unsigned int query(const Frustum& frustum, std::vector<int>& proxies) const;
+
+    /**
+     * Finds the proxies whose fat bounding box intersects the given ray.
+     *
+     * @param ray The ray to test.
+     * @param proxies The list to append the intersecting proxies to.
+     * @param maxDistance The maximum distance along the ray to test.
+     *
+     * @return The number of proxies appended.
+     */
+    unsigned int query(const Ray& ray, std::vector<int>& proxies, float maxDistance = FLT_MAX) const;
+
+private:
+
+    /**
+     * A node of the tree. Leaves are proxies; internal nodes always have two children.
+     */
+    struct TreeNode
+    {
+        BoundingBox box;
+        void* userData;
+        int parent;
+        int child1;
+        int child2;
+        int height;
+
+        bool isLeaf() const { return child1 == NULL_PROXY; }
+    };
+
+    /**
+     * Hidden copy constructor.
+     */
+    BoundingBoxTree(const BoundingBoxTree& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    BoundingBoxTree& operator=(const BoundingBoxTree&);
+
+    int allocateNode();
+
+    void freeNode(int node);
+
+    void insertLeaf(int leaf);
+
+    void removeLeaf(int leaf);
+
+    int balance(int node);
+
+    void refit(int node);
+
+    void addLeaves(int node, std::vector<int>& proxies) const;
+
+    std::vector<TreeNode> _nodes;
+    int _root;
+    int _freeList;
+    unsigned int _proxyCount;
+    float _margin;
+};
+
+}
+
+#endif
@@ -1,9 +1,11 @@
 #include "Base.h"
 #include "Bundle.h"
 #include "FileSystem.h"
+#include "ResourceCache.h"
 #include "MeshPart.h"
 #include "Scene.h"
 #include "Joint.h"
+#include "BakedCurve.h"
 
 // Minimum version numbers supported
 #define BUNDLE_VERSION_MAJOR_REQUIRED   1 
@@ -30,13 +32,28 @@
 #define BUNDLE_VERSION_MAJOR_FONT_FORMAT  1
 #define BUNDLE_VERSION_MINOR_FONT_FORMAT  5
 
+// Size of the pages touched to fault mapped mesh data in on a loader thread.
+#define BUNDLE_PAGE_SIZE                4096
+
 namespace gameplay
 {
 
-static std::vector<Bundle*> __bundleCache;
+static ResourceCache<Bundle> __bundleCache;
+
+// Hashes a reference id (FNV-1a).
+static inline unsigned int hashId(const char* id)
+{
+    unsigned int hash = 2166136261u;
+    while (*id)
+    {
+        hash ^= (unsigned char)*id++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
 
 Bundle::Bundle(const char* path) :
-    _path(path), _referenceCount(0), _references(NULL), _stream(NULL), _trackedNodes(NULL)
+    _path(path), _referenceCount(0), _references(NULL), _stream(NULL), _trackedNodes(NULL), _stepLoad(NULL)
 {
 }
 
@@ -45,11 +62,7 @@ Bundle::~Bundle()
     clearLoadSession();
 
     // Remove this Bundle from the cache.
-    std::vector<Bundle*>::iterator itr = std::find(__bundleCache.begin(), __bundleCache.end(), this);
-    if (itr != __bundleCache.end())
-    {
-        __bundleCache.erase(itr);
-    }
+    __bundleCache.remove(_path, this);
 
     SAFE_DELETE_ARRAY(_references);
 
@@ -168,25 +181,64 @@ static std::string readString(Stream* stream)
     return str;
 }
 
+// Reads an array and its length from a bundle file, for the readers that run on a loader thread.
+template <class T>
+static bool readStreamArray(Stream* stream, std::vector<T>* values, unsigned int readSize = sizeof(T))
+{
+    GP_ASSERT(stream);
+    GP_ASSERT(values);
+    GP_ASSERT(sizeof(T) >= readSize);
+
+    unsigned int length;
+    if (stream->read(&length, 4, 1) != 1)
+        return false;
+    values->resize(length);
+    return length == 0 || stream->read(&(*values)[0], readSize, length) == length;
+}
+
+// Touches each page of data mapped from a file, so that it is faulted in on a loader thread
+// rather than when it is uploaded on the main thread.
+static inline void touchPages(const unsigned char* data, size_t size)
+{
+    volatile unsigned char sum = 0;
+    for (size_t i = 0; i < size; i += BUNDLE_PAGE_SIZE)
+        sum += data[i];
+    if (size > 0)
+        sum += data[size - 1];
+}
+
 Bundle* Bundle::create(const char* path)
 {
     GP_ASSERT(path);
 
     // Search the cache for this bundle.
-    for (size_t i = 0, count = __bundleCache.size(); i < count; ++i)
+    Bundle* cached = __bundleCache.acquire(path);
+    if (cached)
     {
-        Bundle* p = __bundleCache[i];
-        GP_ASSERT(p);
-        if (p->_path == path)
-        {
-            // Found a match
-            p->addRef();
-            return p;
-        }
+        // Found a match
+        return cached;
     }
 
-    // Open the bundle.
-    Stream* stream = FileSystem::open(path);
+    Bundle* bundle = open(path);
+    if (bundle == NULL)
+        return NULL;
+
+    // Add to the bundle cache.
+    return addToCache(bundle);
+}
+
+Bundle* Bundle::getCached(const char* path)
+{
+    GP_ASSERT(path);
+    return __bundleCache.acquire(path);
+}
+
+Bundle* Bundle::open(const char* path)
+{
+    GP_ASSERT(path);
+
+    // Open the bundle, mapped into memory where possible so that mesh data is uploaded straight from the file.
+    Stream* stream = FileSystem::open(path, FileSystem::READ | FileSystem::MAPPED);
     if (!stream)
     {
         GP_WARN("Failed to open file '%s'.", path);
@@ -249,28 +301,80 @@ Bundle* Bundle::create(const char* path)
     bundle->_referenceCount = refCount;
     bundle->_references = refs;
     bundle->_stream = stream;
+    bundle->buildReferenceIndex();
 
     return bundle;
 }
 
+Bundle* Bundle::addToCache(Bundle* bundle)
+{
+    GP_ASSERT(bundle);
+
+    Bundle* cached = __bundleCache.acquire(bundle->_path);
+    if (cached)
+    {
+        SAFE_RELEASE(bundle);
+        return cached;
+    }
+    __bundleCache.add(bundle->_path, bundle);
+    return bundle;
+}
+
 Bundle::Reference* Bundle::find(const char* id) const
 {
     GP_ASSERT(id);
     GP_ASSERT(_references);
 
     // Search the ref table for the given id (case-sensitive).
-    for (unsigned int i = 0; i < _referenceCount; ++i)
+    if (_referenceTable.empty())
+        return NULL;
+    unsigned int mask = (unsigned int)_referenceTable.size() - 1;
+    for (unsigned int slot = hashId(id) & mask; _referenceTable[slot] != 0; slot = (slot + 1) & mask)
     {
-        if (_references[i].id == id)
+        Reference* ref = &_references[_referenceTable[slot] - 1];
+        if (ref->id == id)
         {
             // Found a match
-            return &_references[i];
+            return ref;
         }
     }
 
     return NULL;
 }
 
+void Bundle::buildReferenceIndex()
+{
+    // Size the table to a power of two at least twice the reference count, so that
+    // probe sequences stay short.
+    unsigned int size = 1;
+    while (size < _referenceCount * 2)
+        size <<= 1;
+    _referenceTable.assign(size, 0);
+    unsigned int mask = size - 1;
+    for (unsigned int i = 0; i < _referenceCount; ++i)
+    {
+        // Keep the first of duplicate ids, as a linear search of the table would.
+        const std::string& id = _references[i].id;
+        unsigned int slot = hashId(id.c_str()) & mask;
+        while (_referenceTable[slot] != 0 && _references[_referenceTable[slot] - 1].id != id)
+            slot = (slot + 1) & mask;
+        if (_referenceTable[slot] == 0)
+            _referenceTable[slot] = i + 1;
+    }
+
+    // Sort the references with an id by offset.
+    _referenceOffsets.clear();
+    _referenceOffsets.reserve(_referenceCount);
+    for (unsigned int i = 0; i < _referenceCount; ++i)
+    {
+        if (_references[i].id.length() > 0)
+            _referenceOffsets.push_back(i);
+    }
+    Reference* references = _references;
+    std::stable_sort(_referenceOffsets.begin(), _referenceOffsets.end(),
+        [references](unsigned int a, unsigned int b){ return references[a].offset < references[b].offset; });
+}
+
 void Bundle::clearLoadSession()
 {
     for (size_t i = 0, count = _meshSkins.size(); i < count; ++i)
@@ -292,12 +396,12 @@ const char* Bundle::getIdFromOffset(unsigned int offset) const
     if (offset > 0)
     {
         GP_ASSERT(_references);
-        for (unsigned int i = 0; i < _referenceCount; ++i)
+        Reference* references = _references;
+        std::vector<unsigned int>::const_iterator itr = std::lower_bound(_referenceOffsets.begin(), _referenceOffsets.end(), offset,
+            [references](unsigned int index, unsigned int value){ return references[index].offset < value; });
+        if (itr != _referenceOffsets.end() && _references[*itr].offset == offset)
         {
-            if (_references[i].offset == offset && _references[i].id.length() > 0)
-            {
-                return _references[i].id.c_str();
-            }
+            return _references[*itr].id.c_str();
         }
     }
     return NULL;
@@ -393,6 +497,34 @@ Scene* Bundle::loadScene(const char* id)
 {
     clearLoadSession();
 
+    unsigned int childrenCount;
+    Scene* scene = readScene(id, &childrenCount);
+    if (scene == NULL)
+        return NULL;
+
+    // Read each child directly into the scene.
+    for (unsigned int i = 0; i < childrenCount; i++)
+    {
+        Node* node = readNode(scene, NULL);
+        if (node)
+        {
+            scene->addNode(node);
+            node->release(); // scene now owns node
+        }
+    }
+
+    if (!readSceneEnd(scene))
+    {
+        SAFE_RELEASE(scene);
+        return NULL;
+    }
+    return scene;
+}
+
+Scene* Bundle::readScene(const char* id, unsigned int* childCount)
+{
+    GP_ASSERT(childCount);
+
     Reference* ref = NULL;
     if (id)
     {
@@ -416,26 +548,19 @@ Scene* Bundle::loadScene(const char* id)
     Scene* scene = Scene::create(getIdFromOffset());
 
     // Read the number of children.
-    unsigned int childrenCount;
-    if (!read(&childrenCount))
+    if (!read(childCount))
     {
         GP_ERROR("Failed to read the scene's number of children.");
         SAFE_RELEASE(scene);
         return NULL;
     }
-    if (childrenCount > 0)
-    {
-        // Read each child directly into the scene.
-        for (unsigned int i = 0; i < childrenCount; i++)
-        {
-            Node* node = readNode(scene, NULL);
-            if (node)
-            {
-                scene->addNode(node);
-                node->release(); // scene now owns node
-            }
-        }
-    }
+    return scene;
+}
+
+bool Bundle::readSceneEnd(Scene* scene)
+{
+    GP_ASSERT(scene);
+
     // Read active camera.
     std::string xref = readString(_stream);
     if (xref.length() > 1 && xref[0] == '#') // TODO: Handle full xrefs
@@ -452,44 +577,48 @@ Scene* Bundle::loadScene(const char* id)
     if (!read(&red))
     {
         GP_ERROR("Failed to read red component of the scene's ambient color in bundle '%s'.", _path.c_str());
-        SAFE_RELEASE(scene);
-        return NULL;
+        return false;
     }
     if (!read(&green))
     {
         GP_ERROR("Failed to read green component of the scene's ambient color in bundle '%s'.", _path.c_str());
-        SAFE_RELEASE(scene);
-        return NULL;
+        return false;
     }
     if (!read(&blue))
     {
         GP_ERROR("Failed to read blue component of the scene's ambient color in bundle '%s'.", _path.c_str());
-        SAFE_RELEASE(scene);
-        return NULL;
+        return false;
     }
     scene->setAmbientColor(Vector3(red, green, blue));
 
-    // Parse animations.
+    // Parse animations, unless they were read ahead.
     GP_ASSERT(_references);
     GP_ASSERT(_stream);
-    for (unsigned int i = 0; i < _referenceCount; ++i)
+    if (_stepLoad)
     {
-        Reference* ref = &_references[i];
-        if (ref->type == BUNDLE_TYPE_ANIMATIONS)
+        createPreparedAnimations(scene);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < _referenceCount; ++i)
         {
-            // Found a match.
-            if (_stream->seek(ref->offset, SEEK_SET) == false)
+            Reference* ref = &_references[i];
+            if (ref->type == BUNDLE_TYPE_ANIMATIONS)
             {
-                GP_ERROR("Failed to seek to object '%s' in bundle '%s'.", ref->id.c_str(), _path.c_str());
-                return NULL;
+                // Found a match.
+                if (_stream->seek(ref->offset, SEEK_SET) == false)
+                {
+                    GP_ERROR("Failed to seek to object '%s' in bundle '%s'.", ref->id.c_str(), _path.c_str());
+                    return false;
+                }
+                readAnimations(scene);
             }
-            readAnimations(scene);
         }
     }
 
     resolveJointReferences(scene, NULL);
 
-    return scene;
+    return true;
 }
 
 Node* Bundle::loadNode(const char* id)
@@ -975,27 +1104,36 @@ Model* Bundle::readModel(const char* nodeId)
     std::string xref = readString(_stream);
     if (xref.length() > 1 && xref[0] == '#') // TODO: Handle full xrefs
     {
-        Mesh* mesh = loadMesh(xref.c_str() + 1, nodeId);
+        // Read whether the model is skinned first, the mesh is read from elsewhere in the bundle.
+        unsigned char hasSkin;
+        if (!read(&hasSkin))
+        {
+            GP_ERROR("Failed to load whether model with mesh '%s' has a mesh skin in bundle '%s'.", xref.c_str() + 1, _path.c_str());
+            return NULL;
+        }
+
+        // Keep the vertices of skinned meshes to skin them on the CPU.
+        Game* game = Game::getInstance();
+        unsigned char* vertexData = NULL;
+        bool cpuSkinning = hasSkin && game && game->getConfig()->cpuSkinning;
+        Mesh* mesh = loadMesh(xref.c_str() + 1, nodeId, cpuSkinning ? &vertexData : NULL);
         if (mesh)
         {
             Model* model = Model::create(mesh);
             SAFE_RELEASE(mesh);
 
             // Read skin.
-            unsigned char hasSkin;
-            if (!read(&hasSkin))
-            {
-                GP_ERROR("Failed to load whether model with mesh '%s' has a mesh skin in bundle '%s'.", xref.c_str() + 1, _path.c_str());
-                return NULL;
-            }
             if (hasSkin)
             {
                 MeshSkin* skin = readMeshSkin();
                 if (skin)
                 {
                     model->setSkin(skin);
+                    if (vertexData)
+                        skin->setCpuSkinning(vertexData);
                 }
             }
+            SAFE_DELETE_ARRAY(vertexData);
             // Read material.
             unsigned int materialCount;
             if (!read(&materialCount))
@@ -1233,6 +1371,13 @@ void Bundle::readAnimation(Scene* scene)
     {
         animation = readAnimationChannel(scene, animation, animationId.c_str());
     }
+
+    // Bake the animation at load time if a sample rate is configured.
+    Game* game = Game::getInstance();
+    if (animation && game && game->getConfig()->animationSampleRate > 0)
+    {
+        animation->bake(game->getConfig()->animationSampleRate);
+    }
 }
 
 void Bundle::readAnimations(Scene* scene)
@@ -1362,11 +1507,38 @@ Mesh* Bundle::loadMesh(const char* id)
     return loadMesh(id, NULL);
 }
 
-Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
+Mesh* Bundle::loadMesh(const char* id, const char* nodeId, unsigned char** vertexData)
 {
     GP_ASSERT(_stream);
     GP_ASSERT(id);
 
+    // Use the mesh read ahead by the step load, if any.
+    if (_stepLoad)
+    {
+        std::map<std::string, PreparedMesh>::iterator itr = _stepLoad->meshes.find(id);
+        if (itr != _stepLoad->meshes.end())
+        {
+            PreparedMesh& prepared = itr->second;
+            if (prepared.mesh && vertexData == NULL)
+            {
+                prepared.mesh->addRef();
+                return prepared.mesh;
+            }
+            if (prepared.data)
+            {
+                Mesh* mesh = createMesh(id, prepared.data, vertexData != NULL);
+                if (mesh && vertexData)
+                {
+                    // The data is kept for the other models that use the mesh, so the caller gets a copy.
+                    size_t size = (size_t)prepared.data->vertexCount * prepared.data->vertexFormat.getVertexSize();
+                    *vertexData = new unsigned char[size];
+                    memcpy(*vertexData, prepared.data->vertexData, size);
+                }
+                return mesh;
+            }
+        }
+    }
+
     // Save the file position.
     long position = _stream->position();
     if (position == -1L)
@@ -1383,20 +1555,49 @@ Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
         return NULL;
     }
 
-    // Read mesh data.
-    MeshData* meshData = readMeshData();
+    // Read mesh data. The vertex data is copied when the caller keeps it.
+    MeshData* meshData = readMeshData(_stream, vertexData == NULL);
     if (meshData == NULL)
     {
         GP_ERROR("Failed to load mesh data for mesh '%s'.", id);
         return NULL;
     }
 
+    Mesh* mesh = createMesh(id, meshData, vertexData != NULL);
+    if (mesh == NULL)
+    {
+        SAFE_DELETE(meshData);
+        return NULL;
+    }
+
+    if (vertexData)
+    {
+        *vertexData = meshData->vertexData;
+        meshData->vertexData = NULL;
+    }
+    SAFE_DELETE(meshData);
+
+    // Restore file pointer.
+    if (_stream->seek(position, SEEK_SET) == false)
+    {
+        GP_ERROR("Failed to restore file pointer after loading mesh '%s'.", id);
+        SAFE_RELEASE(mesh);
+        return NULL;
+    }
+
+    return mesh;
+}
+
+Mesh* Bundle::createMesh(const char* id, const MeshData* meshData, bool dynamic)
+{
+    GP_ASSERT(id);
+    GP_ASSERT(meshData);
+
     // Create mesh.
-    Mesh* mesh = Mesh::createMesh(meshData->vertexFormat, meshData->vertexCount, false);
+    Mesh* mesh = Mesh::createMesh(meshData->vertexFormat, meshData->vertexCount, dynamic);
     if (mesh == NULL)
     {
         GP_ERROR("Failed to create mesh '%s'.", id);
-        SAFE_DELETE_ARRAY(meshData);
         return NULL;
     }
 
@@ -1419,29 +1620,22 @@ Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
         if (part == NULL)
         {
             GP_ERROR("Failed to create mesh part (with index %d) for mesh '%s'.", i, id);
-            SAFE_DELETE(meshData);
+            SAFE_RELEASE(mesh);
             return NULL;
         }
         part->setIndexData(partData->indexData, 0, partData->indexCount);
     }
 
-    SAFE_DELETE(meshData);
-
-    // Restore file pointer.
-    if (_stream->seek(position, SEEK_SET) == false)
-    {
-        GP_ERROR("Failed to restore file pointer after loading mesh '%s'.", id);
-        return NULL;
-    }
-
     return mesh;
 }
 
-Bundle::MeshData* Bundle::readMeshData()
+Bundle::MeshData* Bundle::readMeshData(Stream* stream, bool mapped)
 {
+    GP_ASSERT(stream);
+
     // Read vertex format/elements.
     unsigned int vertexElementCount;
-    if (_stream->read(&vertexElementCount, 4, 1) != 1)
+    if (stream->read(&vertexElementCount, 4, 1) != 1)
     {
         GP_ERROR("Failed to load vertex element count.");
         return NULL;
@@ -1456,13 +1650,13 @@ Bundle::MeshData* Bundle::readMeshData()
     for (unsigned int i = 0; i < vertexElementCount; ++i)
     {
         unsigned int vUsage, vSize;
-        if (_stream->read(&vUsage, 4, 1) != 1)
+        if (stream->read(&vUsage, 4, 1) != 1)
         {
             GP_ERROR("Failed to load vertex usage.");
             SAFE_DELETE_ARRAY(vertexElements);
             return NULL;
         }
-        if (_stream->read(&vSize, 4, 1) != 1)
+        if (stream->read(&vSize, 4, 1) != 1)
         {
             GP_ERROR("Failed to load vertex size.");
             SAFE_DELETE_ARRAY(vertexElements);
@@ -1478,7 +1672,7 @@ Bundle::MeshData* Bundle::readMeshData()
 
     // Read vertex data.
     unsigned int vertexByteCount;
-    if (_stream->read(&vertexByteCount, 4, 1) != 1)
+    if (stream->read(&vertexByteCount, 4, 1) != 1)
     {
         GP_ERROR("Failed to load vertex byte count.");
         SAFE_DELETE(meshData);
@@ -1493,22 +1687,32 @@ Bundle::MeshData* Bundle::readMeshData()
 
     GP_ASSERT(meshData->vertexFormat.getVertexSize());
     meshData->vertexCount = vertexByteCount / meshData->vertexFormat.getVertexSize();
-    meshData->vertexData = new unsigned char[vertexByteCount];
-    if (_stream->read(meshData->vertexData, 1, vertexByteCount) != vertexByteCount)
+    // Point into the mapped file if possible; the data is only read when it is uploaded.
+    if (mapped)
+        meshData->vertexData = (unsigned char*)stream->readInPlace(vertexByteCount);
+    if (meshData->vertexData)
     {
-        GP_ERROR("Failed to load vertex data.");
-        SAFE_DELETE(meshData);
-        return NULL;
+        meshData->mapped = true;
+    }
+    else
+    {
+        meshData->vertexData = new unsigned char[vertexByteCount];
+        if (stream->read(meshData->vertexData, 1, vertexByteCount) != vertexByteCount)
+        {
+            GP_ERROR("Failed to load vertex data.");
+            SAFE_DELETE(meshData);
+            return NULL;
+        }
     }
 
     // Read mesh bounds (bounding box and bounding sphere).
-    if (_stream->read(&meshData->boundingBox.min.x, 4, 3) != 3 || _stream->read(&meshData->boundingBox.max.x, 4, 3) != 3)
+    if (stream->read(&meshData->boundingBox.min.x, 4, 3) != 3 || stream->read(&meshData->boundingBox.max.x, 4, 3) != 3)
     {
         GP_ERROR("Failed to load mesh bounding box.");
         SAFE_DELETE(meshData);
         return NULL;
     }
-    if (_stream->read(&meshData->boundingSphere.center.x, 4, 3) != 3 || _stream->read(&meshData->boundingSphere.radius, 4, 1) != 1)
+    if (stream->read(&meshData->boundingSphere.center.x, 4, 3) != 3 || stream->read(&meshData->boundingSphere.radius, 4, 1) != 1)
     {
         GP_ERROR("Failed to load mesh bounding sphere.");
         SAFE_DELETE(meshData);
@@ -1517,7 +1721,7 @@ Bundle::MeshData* Bundle::readMeshData()
 
     // Read mesh parts.
     unsigned int meshPartCount;
-    if (_stream->read(&meshPartCount, 4, 1) != 1)
+    if (stream->read(&meshPartCount, 4, 1) != 1)
     {
         GP_ERROR("Failed to load mesh part count.");
         SAFE_DELETE(meshData);
@@ -1527,19 +1731,19 @@ Bundle::MeshData* Bundle::readMeshData()
     {
         // Read primitive type, index format and index count.
         unsigned int pType, iFormat, iByteCount;
-        if (_stream->read(&pType, 4, 1) != 1)
+        if (stream->read(&pType, 4, 1) != 1)
         {
             GP_ERROR("Failed to load primitive type for mesh part with index %d.", i);
             SAFE_DELETE(meshData);
             return NULL;
         }
-        if (_stream->read(&iFormat, 4, 1) != 1)
+        if (stream->read(&iFormat, 4, 1) != 1)
         {
             GP_ERROR("Failed to load index format for mesh part with index %d.", i);
             SAFE_DELETE(meshData);
             return NULL;
         }
-        if (_stream->read(&iByteCount, 4, 1) != 1)
+        if (stream->read(&iByteCount, 4, 1) != 1)
         {
             GP_ERROR("Failed to load index byte count for mesh part with index %d.", i);
             SAFE_DELETE(meshData);
@@ -1572,12 +1776,21 @@ Bundle::MeshData* Bundle::readMeshData()
         GP_ASSERT(indexSize);
         partData->indexCount = iByteCount / indexSize;
 
-        partData->indexData = new unsigned char[iByteCount];
-        if (_stream->read(partData->indexData, 1, iByteCount) != iByteCount)
+        if (mapped)
+            partData->indexData = (unsigned char*)stream->readInPlace(iByteCount);
+        if (partData->indexData)
         {
-            GP_ERROR("Failed to read index data for mesh part with index %d.", i);
-            SAFE_DELETE(meshData);
-            return NULL;
+            partData->mapped = true;
+        }
+        else
+        {
+            partData->indexData = new unsigned char[iByteCount];
+            if (stream->read(partData->indexData, 1, iByteCount) != iByteCount)
+            {
+                GP_ERROR("Failed to read index data for mesh part with index %d.", i);
+                SAFE_DELETE(meshData);
+                return NULL;
+            }
         }
     }
 
@@ -1624,13 +1837,439 @@ Bundle::MeshData* Bundle::readMeshData(const char* url)
     }
 
     // Read mesh data from current file position.
-    MeshData* meshData = bundle->readMeshData();
+    MeshData* meshData = readMeshData(bundle->_stream);
 
     SAFE_RELEASE(bundle);
 
     return meshData;
 }
 
+Bundle::StepLoad* Bundle::beginLoad(const char* path, const char* id, bool node)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(id);
+
+    StepLoad* load = new StepLoad();
+    load->path = path;
+    load->id = id;
+    load->type = node ? BUNDLE_TYPE_NODE : BUNDLE_TYPE_SCENE;
+
+    // Share the bundle if it is loaded, so that its header is not read again.
+    load->bundle = getCached(path);
+    return load;
+}
+
+bool Bundle::prepareLoad(StepLoad* load)
+{
+    GP_ASSERT(load);
+
+    if (load->bundle == NULL)
+    {
+        load->bundle = open(load->path.c_str());
+        if (load->bundle == NULL)
+            return false;
+        load->opened = true;
+    }
+
+    // Read through a file of our own, since the bundle may be in use on the main thread.
+    load->stream = FileSystem::open(load->path.c_str(), FileSystem::READ | FileSystem::MAPPED);
+    if (load->stream == NULL)
+    {
+        GP_ERROR("Failed to open file '%s'.", load->path.c_str());
+        return false;
+    }
+    return load->bundle->prepare(load);
+}
+
+bool Bundle::loadStep(StepLoad* load, Ref** object)
+{
+    GP_ASSERT(load);
+    GP_ASSERT(load->bundle);
+    GP_ASSERT(object);
+
+    // Share a bundle opened on a loader thread with the next loads.
+    if (load->opened)
+    {
+        load->bundle = addToCache(load->bundle);
+        load->opened = false;
+    }
+    Bundle* bundle = load->bundle;
+
+    // Create one of the meshes read ahead per step. Dynamic meshes are created by their models.
+    while (load->nextMesh != load->meshes.end())
+    {
+        std::map<std::string, PreparedMesh>::iterator itr = load->nextMesh++;
+        PreparedMesh& prepared = itr->second;
+        if (prepared.dynamic || prepared.data == NULL)
+            continue;
+        prepared.mesh = bundle->createMesh(itr->first.c_str(), prepared.data, false);
+        SAFE_DELETE(prepared.data);
+        load->stepIndex++;
+        return false;
+    }
+
+    // Restore the load session, which other loads of the bundle may have used since the last step.
+    bundle->_stepLoad = load;
+    bundle->_meshSkins.swap(load->meshSkins);
+    bool done = true;
+    if (load->type == BUNDLE_TYPE_NODE)
+    {
+        // Build the node, and its joints and animations.
+        bundle->_trackedNodes = new std::map<std::string, Node*>();
+        Node* node = bundle->loadNode(load->id.c_str(), NULL, NULL);
+        if (node)
+        {
+            bundle->resolveJointReferences(NULL, node);
+            bundle->createPreparedAnimations(NULL);
+        }
+        SAFE_DELETE(bundle->_trackedNodes);
+        *object = node;
+    }
+    else if (load->scene == NULL)
+    {
+        load->scene = bundle->readScene(load->id.empty() ? NULL : load->id.c_str(), &load->childCount);
+        done = load->scene == NULL;
+    }
+    else if (!bundle->_stream->seek(load->position, SEEK_SET))
+    {
+        GP_ERROR("Failed to seek to the next node of scene '%s' in bundle '%s'.", load->scene->getId(), load->path.c_str());
+    }
+    else if (load->childIndex < load->childCount)
+    {
+        // Build one top level node of the scene per step.
+        Node* node = bundle->readNode(load->scene, NULL);
+        if (node)
+        {
+            load->scene->addNode(node);
+            node->release(); // scene now owns node
+        }
+        load->childIndex++;
+        done = false;
+    }
+    else if (bundle->readSceneEnd(load->scene))
+    {
+        *object = load->scene;
+        load->scene = NULL;
+    }
+    if (!done)
+        load->position = bundle->_stream->position();
+    bundle->_meshSkins.swap(load->meshSkins);
+    bundle->_stepLoad = NULL;
+    load->stepIndex++;
+    return done;
+}
+
+float Bundle::getLoadProgress(const StepLoad* load)
+{
+    GP_ASSERT(load);
+
+    if (load->stepCount == 0)
+        return 0.0f;
+    return std::min((float)load->stepIndex / (float)load->stepCount, 1.0f);
+}
+
+bool Bundle::prepare(StepLoad* load) const
+{
+    GP_ASSERT(load);
+    GP_ASSERT(load->stream);
+
+    Stream* stream = load->stream;
+
+    // Find the scene or node.
+    const Reference* ref = NULL;
+    if (load->id.empty())
+    {
+        for (unsigned int i = 0; i < _referenceCount && ref == NULL; ++i)
+        {
+            if (_references[i].type == BUNDLE_TYPE_SCENE)
+                ref = &_references[i];
+        }
+        if (ref == NULL)
+        {
+            GP_ERROR("Failed to load scene from bundle '%s'; bundle contains no scene objects.", _path.c_str());
+            return false;
+        }
+    }
+    else
+    {
+        ref = find(load->id.c_str());
+        if (ref == NULL || ref->type != load->type)
+        {
+            GP_ERROR("No %s with id '%s' in bundle '%s'.", load->type == BUNDLE_TYPE_NODE ? "node" : "scene", load->id.c_str(), _path.c_str());
+            return false;
+        }
+    }
+    if (stream->seek(ref->offset, SEEK_SET) == false)
+    {
+        GP_ERROR("Failed to seek to object '%s' in bundle '%s'.", ref->id.c_str(), _path.c_str());
+        return false;
+    }
+
+    // Find the meshes of the nodes.
+    unsigned int childrenCount = 0;
+    if (load->type == BUNDLE_TYPE_SCENE)
+    {
+        if (stream->read(&childrenCount, 4, 1) != 1)
+        {
+            GP_ERROR("Failed to read the number of children of scene '%s' in bundle '%s'.", ref->id.c_str(), _path.c_str());
+            return false;
+        }
+        for (unsigned int i = 0; i < childrenCount; i++)
+        {
+            if (!prepareNode(stream, load))
+                return false;
+        }
+    }
+    else if (!prepareNode(stream, load))
+    {
+        return false;
+    }
+
+    // Read the meshes, faulting in the pages of mapped data.
+    for (std::map<std::string, PreparedMesh>::iterator itr = load->meshes.begin(); itr != load->meshes.end(); ++itr)
+    {
+        PreparedMesh& prepared = itr->second;
+        ref = find(itr->first.c_str());
+        if (ref == NULL || ref->type != BUNDLE_TYPE_MESH || stream->seek(ref->offset, SEEK_SET) == false)
+        {
+            GP_ERROR("Failed to locate ref for mesh '%s' in bundle '%s'.", itr->first.c_str(), _path.c_str());
+            return false;
+        }
+        prepared.data = readMeshData(stream, !prepared.dynamic);
+        if (prepared.data == NULL)
+        {
+            GP_ERROR("Failed to load mesh data for mesh '%s' in bundle '%s'.", itr->first.c_str(), _path.c_str());
+            return false;
+        }
+        if (prepared.data->mapped)
+            touchPages(prepared.data->vertexData, (size_t)prepared.data->vertexCount * prepared.data->vertexFormat.getVertexSize());
+        for (size_t i = 0, count = prepared.data->parts.size(); i < count; ++i)
+        {
+            MeshPartData* partData = prepared.data->parts[i];
+            if (partData->mapped)
+                touchPages(partData->indexData, (size_t)partData->indexCount * (partData->indexFormat == Mesh::INDEX32 ? 4 : partData->indexFormat == Mesh::INDEX16 ? 2 : 1));
+        }
+    }
+    load->nextMesh = load->meshes.begin();
+
+    // A step creates each static mesh, then builds the node, or reads the scene, builds
+    // each of its top level nodes and reads the end of the scene.
+    for (std::map<std::string, PreparedMesh>::iterator itr = load->meshes.begin(); itr != load->meshes.end(); ++itr)
+    {
+        if (!itr->second.dynamic)
+            load->stepCount++;
+    }
+    load->stepCount += load->type == BUNDLE_TYPE_NODE ? 1 : childrenCount + 2;
+
+    // Create the curves of all the animation channels, baked if a sample rate is configured.
+    // Their targets are looked up when the nodes are built, since those of a node may be
+    // joints outside of its hierarchy.
+    Game* game = Game::getInstance();
+    unsigned int sampleRate = game ? game->getConfig()->animationSampleRate : 0;
+    unsigned int animationIndex = 0;
+    for (unsigned int i = 0; i < _referenceCount; ++i)
+    {
+        ref = &_references[i];
+        if (ref->type != BUNDLE_TYPE_ANIMATIONS)
+            continue;
+        unsigned int animationCount;
+        if (stream->seek(ref->offset, SEEK_SET) == false || stream->read(&animationCount, 4, 1) != 1)
+        {
+            GP_ERROR("Failed to read the number of animations for object '%s' in bundle '%s'.", ref->id.c_str(), _path.c_str());
+            return false;
+        }
+        for (unsigned int j = 0; j < animationCount; j++, animationIndex++)
+        {
+            const std::string animationId = readString(stream);
+            unsigned int channelCount;
+            if (stream->read(&channelCount, 4, 1) != 1)
+            {
+                GP_ERROR("Failed to read animation channel count for animation '%s'.", animationId.c_str());
+                return false;
+            }
+            for (unsigned int k = 0; k < channelCount; k++)
+            {
+                PreparedChannel* channel = new PreparedChannel();
+                load->channels.push_back(channel);
+                channel->animation = animationIndex;
+                channel->animationId = animationId;
+                channel->targetId = readString(stream);
+
+                std::vector<unsigned int> keyTimes;
+                std::vector<float> values;
+                std::vector<float> tangents;
+                std::vector<unsigned int> interpolation;
+                if (channel->targetId.empty() ||
+                    stream->read(&channel->targetAttribute, 4, 1) != 1 ||
+                    !readStreamArray(stream, &keyTimes, sizeof(unsigned int)) ||
+                    !readStreamArray(stream, &values) ||
+                    !readStreamArray(stream, &tangents) ||
+                    !readStreamArray(stream, &tangents) ||
+                    !readStreamArray(stream, &interpolation, sizeof(unsigned int)))
+                {
+                    GP_ERROR("Failed to read animation channel %d for animation '%s'.", k, animationId.c_str());
+                    return false;
+                }
+                if (keyTimes.empty() || values.size() % keyTimes.size() != 0)
+                {
+                    GP_ERROR("Invalid keys for animation channel %d of animation '%s'.", k, animationId.c_str());
+                    return false;
+                }
+
+                // The targets of bundle animations are nodes, whose properties have as many
+                // components as there are values per key.
+                // TODO: This code currently assumes LINEAR only.
+                unsigned int componentCount = (unsigned int)(values.size() / keyTimes.size());
+                channel->curve = Animation::createCurve(channel->targetAttribute, componentCount, true,
+                                                        (unsigned int)keyTimes.size(), &keyTimes[0], &values[0], Curve::LINEAR);
+                channel->duration = keyTimes.back() - keyTimes[0];
+                if (sampleRate > 0)
+                    channel->bakedCurve = Animation::bakeCurve(channel->curve, channel->duration, sampleRate);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool Bundle::prepareNode(Stream* stream, StepLoad* load) const
+{
+    GP_ASSERT(stream);
+    GP_ASSERT(load);
+
+    const char* id = getIdFromOffset((unsigned int)stream->position());
+    GP_ASSERT(id);
+
+    // Skip the node type and transform, and the parent ID.
+    if (stream->seek(sizeof(unsigned int) + sizeof(float) * 16, SEEK_CUR) == false)
+    {
+        GP_ERROR("Failed to skip over node type and transform for node '%s' in bundle '%s'.", id, _path.c_str());
+        return false;
+    }
+    readString(stream);
+
+    // Read children.
+    unsigned int childrenCount;
+    if (stream->read(&childrenCount, 4, 1) != 1)
+    {
+        GP_ERROR("Failed to read children count for node '%s' in bundle '%s'.", id, _path.c_str());
+        return false;
+    }
+    for (unsigned int i = 0; i < childrenCount; i++)
+    {
+        if (!prepareNode(stream, load))
+            return false;
+    }
+
+    // Skip the camera and light.
+    unsigned char cameraType;
+    if (stream->read(&cameraType, 1, 1) != 1 ||
+        (cameraType != 0 && stream->seek(sizeof(float) * (cameraType == Camera::PERSPECTIVE ? 4 : 5), SEEK_CUR) == false))
+    {
+        GP_ERROR("Failed to skip over camera for node '%s' in bundle '%s'.", id, _path.c_str());
+        return false;
+    }
+    unsigned char lightType;
+    if (stream->read(&lightType, 1, 1) != 1 ||
+        (lightType != 0 && stream->seek(sizeof(float) * (lightType == Light::POINT ? 4 : lightType == Light::SPOT ? 6 : 3), SEEK_CUR) == false))
+    {
+        GP_ERROR("Failed to skip over light for node '%s' in bundle '%s'.", id, _path.c_str());
+        return false;
+    }
+
+    // Read the mesh of the model, and skip its skin and materials.
+    std::string xref = readString(stream);
+    if (xref.length() > 1 && xref[0] == '#') // TODO: Handle full xrefs
+    {
+        unsigned char hasSkin;
+        if (stream->read(&hasSkin, 1, 1) != 1)
+        {
+            GP_ERROR("Failed to load whether model with mesh '%s' has a mesh skin in bundle '%s'.", xref.c_str() + 1, _path.c_str());
+            return false;
+        }
+
+        // Skinned meshes keep their vertices to be skinned on the CPU, as in readModel().
+        Game* game = Game::getInstance();
+        PreparedMesh& prepared = load->meshes[xref.substr(1)];
+        if (hasSkin && game && game->getConfig()->cpuSkinning)
+            prepared.dynamic = true;
+
+        if (hasSkin)
+        {
+            unsigned int jointCount;
+            if (stream->seek(sizeof(float) * 16, SEEK_CUR) == false || stream->read(&jointCount, 4, 1) != 1)
+            {
+                GP_ERROR("Failed to skip over mesh skin for node '%s' in bundle '%s'.", id, _path.c_str());
+                return false;
+            }
+            for (unsigned int i = 0; i < jointCount; i++)
+                readString(stream);
+            unsigned int bindPoseCount;
+            if (stream->read(&bindPoseCount, 4, 1) != 1 || stream->seek(sizeof(float) * bindPoseCount, SEEK_CUR) == false)
+            {
+                GP_ERROR("Failed to skip over joint bind poses for node '%s' in bundle '%s'.", id, _path.c_str());
+                return false;
+            }
+        }
+
+        unsigned int materialCount;
+        if (stream->read(&materialCount, 4, 1) != 1)
+        {
+            GP_ERROR("Failed to load material count for model with mesh '%s' in bundle '%s'.", xref.c_str() + 1, _path.c_str());
+            return false;
+        }
+        for (unsigned int i = 0; i < materialCount; i++)
+            readString(stream);
+    }
+
+    return true;
+}
+
+void Bundle::createPreparedAnimations(Scene* scene)
+{
+    GP_ASSERT(_stepLoad);
+
+    Animation* animation = NULL;
+    for (size_t i = 0, count = _stepLoad->channels.size(); i < count; ++i)
+    {
+        PreparedChannel* channel = _stepLoad->channels[i];
+        if (i > 0 && channel->animation != _stepLoad->channels[i - 1]->animation)
+            animation = NULL;
+
+        // Find the target among the loaded nodes, or in the scene.
+        AnimationTarget* target = NULL;
+        if (_trackedNodes)
+        {
+            std::map<std::string, Node*>::iterator itr = _trackedNodes->find(channel->targetId);
+            if (itr == _trackedNodes->end())
+                continue;
+            target = itr->second;
+        }
+        else
+        {
+            GP_ASSERT(scene);
+            target = scene->findNode(channel->targetId.c_str());
+            if (target == NULL)
+            {
+                GP_ERROR("Failed to find the animation target (with id '%s') for animation '%s'.", channel->targetId.c_str(), channel->animationId.c_str());
+                continue;
+            }
+        }
+
+        if (animation == NULL)
+        {
+            // The channels hold the reference to the animation.
+            animation = new Animation(channel->animationId.c_str());
+            animation->createChannel(target, channel->targetAttribute, channel->curve, channel->bakedCurve, channel->duration);
+            animation->release();
+        }
+        else
+        {
+            animation->createChannel(target, channel->targetAttribute, channel->curve, channel->bakedCurve, channel->duration);
+        }
+    }
+}
+
 Font* Bundle::loadFont(const char* id)
 {
     GP_ASSERT(id);
@@ -1871,23 +2510,25 @@ Bundle::Reference::~Reference()
 }
 
 Bundle::MeshPartData::MeshPartData() :
-		primitiveType(Mesh::TRIANGLES), indexFormat(Mesh::INDEX32), indexCount(0), indexData(NULL)
+		primitiveType(Mesh::TRIANGLES), indexFormat(Mesh::INDEX32), indexCount(0), indexData(NULL), mapped(false)
 {
 }
 
 Bundle::MeshPartData::~MeshPartData()
 {
-    SAFE_DELETE_ARRAY(indexData);
+    if (!mapped)
+        SAFE_DELETE_ARRAY(indexData);
 }
 
 Bundle::MeshData::MeshData(const VertexFormat& vertexFormat)
-    : vertexFormat(vertexFormat), vertexCount(0), vertexData(NULL), primitiveType(Mesh::TRIANGLES)
+    : vertexFormat(vertexFormat), vertexCount(0), vertexData(NULL), primitiveType(Mesh::TRIANGLES), mapped(false)
 {
 }
 
 Bundle::MeshData::~MeshData()
 {
-    SAFE_DELETE_ARRAY(vertexData);
+    if (!mapped)
+        SAFE_DELETE_ARRAY(vertexData);
 
     for (unsigned int i = 0; i < parts.size(); ++i)
     {
@@ -1895,4 +2536,47 @@ Bundle::MeshData::~MeshData()
     }
 }
 
+Bundle::PreparedMesh::PreparedMesh()
+    : data(NULL), mesh(NULL), dynamic(false)
+{
+}
+
+Bundle::PreparedChannel::PreparedChannel()
+    : animation(0), targetAttribute(0), curve(NULL), bakedCurve(NULL), duration(0)
+{
+}
+
+Bundle::PreparedChannel::~PreparedChannel()
+{
+    SAFE_RELEASE(curve);
+    SAFE_RELEASE(bakedCurve);
+}
+
+Bundle::StepLoad::StepLoad()
+    : type(0), bundle(NULL), opened(false), stream(NULL), scene(NULL), childCount(0), childIndex(0), position(0),
+      stepCount(0), stepIndex(0)
+{
+    nextMesh = meshes.end();
+}
+
+Bundle::StepLoad::~StepLoad()
+{
+    for (std::map<std::string, PreparedMesh>::iterator itr = meshes.begin(); itr != meshes.end(); ++itr)
+    {
+        SAFE_DELETE(itr->second.data);
+        SAFE_RELEASE(itr->second.mesh);
+    }
+    for (size_t i = 0, count = channels.size(); i < count; ++i)
+    {
+        SAFE_DELETE(channels[i]);
+    }
+    for (size_t i = 0, count = meshSkins.size(); i < count; ++i)
+    {
+        SAFE_DELETE(meshSkins[i]);
+    }
+    SAFE_RELEASE(scene);
+    SAFE_DELETE(stream);
+    SAFE_RELEASE(bundle);
+}
+
 }
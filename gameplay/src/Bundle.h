@@ -18,6 +18,7 @@ class Bundle : public Ref
 {
     friend class PhysicsController;
     friend class SceneLoader;
+    friend class LoadController;
 
 public:
 
@@ -150,6 +151,7 @@ private:
         Mesh::IndexFormat indexFormat;
         unsigned int indexCount;
         unsigned char* indexData;
+        bool mapped;                    // Whether indexData points into the mapped bundle file rather than being owned.
     };
 
     struct MeshData
@@ -164,6 +166,66 @@ private:
         BoundingSphere boundingSphere;
         Mesh::PrimitiveType primitiveType;
         std::vector<MeshPartData*> parts;
+        bool mapped;                    // Whether vertexData points into the mapped bundle file rather than being owned.
+    };
+
+    /**
+     * A mesh read ahead on a loader thread.
+     */
+    struct PreparedMesh
+    {
+        PreparedMesh();
+
+        MeshData* data;                 // The mesh data, deleted once the mesh is created.
+        Mesh* mesh;                     // The mesh, shared by the models that use it.
+        bool dynamic;                   // Whether the mesh is skinned on the CPU, so that each model creates its own dynamic mesh from the data.
+    };
+
+    /**
+     * An animation channel read ahead on a loader thread, whose target is looked up by id.
+     */
+    struct PreparedChannel
+    {
+        PreparedChannel();
+        ~PreparedChannel();
+
+        unsigned int animation;         // The index of the animation of the channel, so that channels of the same animation are grouped.
+        std::string animationId;
+        std::string targetId;
+        unsigned int targetAttribute;
+        Curve* curve;
+        BakedCurve* bakedCurve;         // The curve baked at the configured sample rate, if any.
+        unsigned long duration;
+    };
+
+    /**
+     * A scene or node loaded in steps by the LoadController.
+     *
+     * The meshes and animation curves are read on a loader thread by prepareLoad(). The
+     * meshes are then created one per step on the main thread by loadStep(), followed by
+     * the nodes, one top level node of a scene per step.
+     */
+    struct StepLoad
+    {
+        StepLoad();
+        ~StepLoad();
+
+        std::string path;
+        std::string id;                                     // The id of the scene or node, or empty for the first scene.
+        unsigned int type;                                  // BUNDLE_TYPE_SCENE or BUNDLE_TYPE_NODE.
+        Bundle* bundle;
+        bool opened;                                        // Whether the bundle was opened by the loader thread rather than taken from the cache.
+        Stream* stream;                                     // The file read by the loader thread, which mapped mesh data points into.
+        std::map<std::string, PreparedMesh> meshes;         // The meshes of the models, by mesh id.
+        std::map<std::string, PreparedMesh>::iterator nextMesh;
+        std::vector<PreparedChannel*> channels;
+        std::vector<MeshSkinData*> meshSkins;               // The load session, kept between steps since the bundle may be shared.
+        Scene* scene;
+        unsigned int childCount;
+        unsigned int childIndex;
+        long position;                                      // The file position of the next step.
+        unsigned int stepCount;                             // The number of steps of the load, known once it is prepared.
+        unsigned int stepIndex;                             // The number of steps done.
     };
 
     Bundle(const char* path);
@@ -178,6 +240,58 @@ private:
      */
     Bundle& operator=(const Bundle&);
 
+    /**
+     * Finds the bundle loaded from a path, and adds a reference to it.
+     *
+     * @return The bundle, or NULL if no bundle is loaded from the path.
+     */
+    static Bundle* getCached(const char* path);
+
+    /**
+     * Opens a bundle without looking it up in or adding it to the cache, so that it may
+     * be called on a loader thread.
+     */
+    static Bundle* open(const char* path);
+
+    /**
+     * Adds a bundle returned by open() to the cache.
+     *
+     * If a bundle was cached for the same path in the meantime, the given bundle is
+     * released and the cached bundle is returned instead, with a reference added.
+     */
+    static Bundle* addToCache(Bundle* bundle);
+
+    /**
+     * Starts loading a scene or node in steps, with the bundle from the cache if it is loaded.
+     *
+     * @param path The path of the bundle.
+     * @param id The id of the scene, empty for the first scene, or the id of the node.
+     * @param node true to load a node, false to load a scene.
+     */
+    static StepLoad* beginLoad(const char* path, const char* id, bool node);
+
+    /**
+     * Reads the meshes and animations of a step load on a loader thread.
+     *
+     * @return true if successful, false if an error occurred.
+     */
+    static bool prepareLoad(StepLoad* load);
+
+    /**
+     * Runs a step of a step load on the main thread.
+     *
+     * @param load The step load.
+     * @param object Receives the loaded scene or node once the load is done, or NULL if it failed.
+     *
+     * @return true if the load is done, false if more steps remain.
+     */
+    static bool loadStep(StepLoad* load, Ref** object);
+
+    /**
+     * Gets the fraction of the steps of a step load that are done, from 0 to 1.
+     */
+    static float getLoadProgress(const StepLoad* load);
+
     /**
      * Finds a reference by ID.
      */
@@ -250,10 +364,23 @@ private:
      *
      * @param id The ID of the mesh to load.
      * @param nodeId The id of the mesh's model's parent node.
+     * @param vertexData If not NULL, the mesh is created dynamic and this receives its vertex
+     *      data, which the caller must delete (with delete[]).
      * 
      * @return The loaded mesh, or NULL if the mesh could not be loaded.
      */
-    Mesh* loadMesh(const char* id, const char* nodeId);
+    Mesh* loadMesh(const char* id, const char* nodeId, unsigned char** vertexData = NULL);
+
+    /**
+     * Creates a mesh from mesh data.
+     *
+     * @param id The ID of the mesh.
+     * @param meshData The mesh data.
+     * @param dynamic true to create a dynamic mesh, false otherwise.
+     *
+     * @return The new mesh, or NULL if the mesh could not be created.
+     */
+    Mesh* createMesh(const char* id, const MeshData* meshData, bool dynamic);
 
     /**
      * Reads an unsigned int from the current file position.
@@ -364,9 +491,14 @@ private:
     Model* readModel(const char* nodeId);
 
     /**
-     * Reads mesh data from the current file position.
+     * Reads mesh data from the current position of a bundle file.
+     *
+     * @param stream The bundle file.
+     * @param mapped true to point the vertex and index data into the bundle file when it
+     *      is mapped into memory rather than copying them. Such data is read-only and only
+     *      valid while the file is open.
      */
-    MeshData* readMeshData();
+    static MeshData* readMeshData(Stream* stream, bool mapped = false);
 
     /**
      * Reads mesh data for the specified URL.
@@ -388,6 +520,46 @@ private:
      */
     MeshSkin* readMeshSkin();
 
+    /**
+     * Reads a scene from the current file position, up to its top level nodes.
+     *
+     * @param id The ID of the scene, or NULL for the first scene.
+     * @param childCount Receives the number of top level nodes of the scene.
+     *
+     * @return The new scene, or NULL if there was an error.
+     */
+    Scene* readScene(const char* id, unsigned int* childCount);
+
+    /**
+     * Reads the rest of a scene from the current file position, after its top level nodes,
+     * and its animations.
+     *
+     * @return True if successful, false if an error occurred.
+     */
+    bool readSceneEnd(Scene* scene);
+
+    /**
+     * Reads the ids of the meshes of a node and its children from a bundle file, skipping
+     * everything else. This only reads the reference table of the bundle, so that it may be
+     * called on a loader thread.
+     *
+     * @return True if successful, false if an error occurred.
+     */
+    bool prepareNode(Stream* stream, StepLoad* load) const;
+
+    /**
+     * Reads the meshes and the animation channels of a step load from its file, on a loader thread.
+     *
+     * @return True if successful, false if an error occurred.
+     */
+    bool prepare(StepLoad* load) const;
+
+    /**
+     * Creates the animations of the channels read ahead by the current step load, for the
+     * tracked nodes or the nodes of a scene.
+     */
+    void createPreparedAnimations(Scene* scene);
+
     /**
      * Reads an animation from the current file position.
      * 
@@ -450,15 +622,23 @@ private:
      */
     bool skipNode();
 
+    /**
+     * Builds the hash table of the references by id and their index by offset.
+     */
+    void buildReferenceIndex();
+
     unsigned char _version[2];
     std::string _path;
     std::string _materialPath;
     unsigned int _referenceCount;
     Reference* _references;
+    std::vector<unsigned int> _referenceTable;      // Open-addressed hash table of the references by id (index + 1, or 0 if empty).
+    std::vector<unsigned int> _referenceOffsets;    // Indices of the references sorted by offset.
     Stream* _stream;
 
     std::vector<MeshSkinData*> _meshSkins;
     std::map<std::string, Node*>* _trackedNodes;
+    StepLoad* _stepLoad;                            // The step load whose step is running, if any.
 };
 
 }
@@ -88,6 +88,20 @@ Curve* Curve::create(unsigned int pointCount, unsigned int componentCount)
     return new Curve(pointCount, componentCount);
 }
 
+Curve::Cursor::Cursor()
+    : _index(0), _min(0), _max(0), _startTime(-1.0f), _endTime(-1.0f)
+{
+}
+
+void Curve::Cursor::reset()
+{
+    _index = 0;
+    _min = 0;
+    _max = 0;
+    _startTime = -1.0f;
+    _endTime = -1.0f;
+}
+
 Curve::Curve(unsigned int pointCount, unsigned int componentCount)
     : _pointCount(pointCount), _componentCount(componentCount), _componentSize(sizeof(float)*componentCount), _quaternionOffset(NULL), _points(NULL)
 {
@@ -211,6 +225,16 @@ void Curve::evaluate(float time, float* dst) const
 }
 
 void Curve::evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst) const
+{
+    evaluate(time, startTime, endTime, loopBlendTime, dst, (Cursor*)NULL);
+}
+
+void Curve::evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst, Cursor& cursor) const
+{
+    evaluate(time, startTime, endTime, loopBlendTime, dst, &cursor);
+}
+
+void Curve::evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst, Cursor* cursor) const
 {
     assert(dst && startTime >= 0.0f && startTime <= endTime && endTime <= 1.0f && loopBlendTime >= 0.0f);
 
@@ -227,8 +251,24 @@ void Curve::evaluate(float time, float startTime, float endTime, float loopBlend
     if (startTime > 0.0f || endTime < 1.0f)
     {
         // Evaluating a sub section of the curve
-        min = determineIndex(startTime, 0, max);
-        max = determineIndex(endTime, min, max);
+        if (cursor && cursor->_startTime == startTime && cursor->_endTime == endTime && cursor->_max <= max)
+        {
+            min = cursor->_min;
+            max = cursor->_max;
+        }
+        else
+        {
+            min = determineIndex(startTime, 0, max);
+            max = determineIndex(endTime, min, max);
+            if (cursor)
+            {
+                cursor->_startTime = startTime;
+                cursor->_endTime = endTime;
+                cursor->_min = min;
+                cursor->_max = max;
+                cursor->_index = min;
+            }
+        }
 
         // Convert time to fall within the subregion
         localTime = _points[min].time + (_points[max].time - _points[min].time) * time;
@@ -283,8 +323,16 @@ void Curve::evaluate(float time, float startTime, float endTime, float loopBlend
     }
     else
     {
-        // Locate the points we are interpolating between using a binary search.
-        index = determineIndex(localTime, min, max);
+        // Locate the points we are interpolating between, starting from the cached segment if any.
+        if (cursor)
+        {
+            index = determineIndex(localTime, min, max, cursor->_index);
+            cursor->_index = index;
+        }
+        else
+        {
+            index = determineIndex(localTime, min, max);
+        }
         from = &_points[index];
         to = &_points[index == max ? index : index+1];
 
@@ -1267,6 +1315,28 @@ int Curve::determineIndex(float time, unsigned int min, unsigned int max) const
     return max;
 }
 
+unsigned int Curve::determineIndex(float time, unsigned int min, unsigned int max, unsigned int hint) const
+{
+    // Check the hinted segment, then the next and previous ones, which covers playback
+    // in either direction that does not skip a whole segment between evaluations.
+    if (hint >= min && hint < max)
+    {
+        if (time >= _points[hint].time)
+        {
+            if (time < _points[hint + 1].time)
+                return hint;
+            if (hint + 1 < max && time < _points[hint + 2].time)
+                return hint + 1;
+        }
+        else if (hint > min && time >= _points[hint - 1].time)
+        {
+            return hint - 1;
+        }
+    }
+
+    return (unsigned int)determineIndex(time, min, max);
+}
+
 int Curve::getInterpolationType(const char* curveId)
 {
     if (strcmp(curveId, "BEZIER") == 0)
@@ -16,9 +16,44 @@ class Curve : public Ref
     friend class AnimationClip;
     friend class AnimationController;
     friend class MeshSkin;
+    friend class BakedCurve;
 
 public:
 
+    /**
+     * Caches the position of the last evaluation of a curve, so that the next evaluation
+     * at a nearby time can find its segment without searching all the points.
+     *
+     * Animation playback is almost always monotonic, so each animation clip keeps a cursor
+     * per channel. A cursor caches positions for a single curve and subregion, so it must be
+     * reset before being used with another curve. When the time has jumped (on seeks and
+     * loops) or the subregion changes, evaluation falls back to a binary search.
+     */
+    class Cursor
+    {
+        friend class Curve;
+
+    public:
+
+        /**
+         * Constructor.
+         */
+        Cursor();
+
+        /**
+         * Invalidates the cached position, so the next evaluation searches the whole curve.
+         */
+        void reset();
+
+    private:
+
+        unsigned int _index;                // The index of the point starting the last evaluated segment.
+        unsigned int _min;                  // The first point of the cached subregion.
+        unsigned int _max;                  // The last point of the cached subregion.
+        float _startTime;                   // The start time of the cached subregion, or -1 if nothing is cached.
+        float _endTime;                     // The end time of the cached subregion.
+    };
+
     /**
      * Types of interpolation.
      *
@@ -414,6 +449,27 @@ public:
      */
     void evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst) const;
 
+    /**
+     * Evaluates the curve at the given position value (between 0.0 and 1.0 inclusive)
+     * within the specified subregion of the curve, starting the search for the segment
+     * to interpolate from the last position evaluated with the given cursor.
+     *
+     * This is equivalent to evaluate(float, float, float, float, float*), but finds the
+     * segment in constant time when the curve is evaluated at increasing or decreasing
+     * times that move by at most one segment between evaluations, and caches the points
+     * bounding the subregion.
+     *
+     * @param time The position within the subregion of the curve to evaluate the curve at.
+     * @param startTime Start time for the subregion (between 0.0 - 1.0).
+     * @param endTime End time for the subregion (between 0.0 - 1.0).
+     * @param loopBlendTime Time (in milliseconds) to blend between the end points of the curve
+     *      for looping purposes when time is outside the range 0-1. A value of zero here
+     *      disables curve looping.
+     * @param dst The evaluated value of the curve at the given time.
+     * @param cursor The cursor holding the last position evaluated, which is updated.
+     */
+    void evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst, Cursor& cursor) const;
+
     /**
      * Linear interpolation function.
      */
@@ -523,6 +579,17 @@ private:
      */
     int determineIndex(float time, unsigned int min, unsigned int max) const;
 
+    /**
+     * Determines the current keyframe to interpolate from based on the specified time,
+     * checking the segment of the given hint and its neighbors before searching.
+     */
+    unsigned int determineIndex(float time, unsigned int min, unsigned int max, unsigned int hint) const;
+
+    /**
+     * Evaluates the curve, using and updating the cursor if it is not NULL.
+     */
+    void evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst, Cursor* cursor) const;
+
     /**
      * Sets the offset for the beginning of a Quaternion piece of data within the curve's value span at the specified
      * index. The next four components of data starting at the given index will be interpolated as a Quaternion.
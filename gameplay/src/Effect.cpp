@@ -2,6 +2,7 @@
 #include "Effect.h"
 #include "FileSystem.h"
 #include "Game.h"
+#include "ResourceCache.h"
 
 #define OPENGL_ES_DEFINE  "OPENGL_ES"
 
@@ -9,7 +10,7 @@ namespace gameplay
 {
 
 // Cache of unique effects.
-static std::map<std::string, Effect*> __effectCache;
+static ResourceCache<Effect> __effectCache;
 static Effect* __currentEffect = NULL;
 
 Effect::Effect() : _program(0), _vshPath(""), _fshPath(""), _defines("")
@@ -19,7 +20,7 @@ Effect::Effect() : _program(0), _vshPath(""), _fshPath(""), _defines("")
 Effect::~Effect()
 {
     // Remove this effect from the cache.
-    __effectCache.erase(_id);
+    __effectCache.remove(_id, this);
 
     // Free uniforms.
     for (std::map<std::string, Uniform*>::iterator itr = _uniforms.begin(); itr != _uniforms.end(); ++itr)
@@ -41,12 +42,9 @@ Effect::~Effect()
     }
 }
 
-Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const char* defines)
+// Gets the id of an effect in the cache, from its shader paths and defines.
+static std::string getEffectId(const char* vshPath, const char* fshPath, const char* defines)
 {
-    GP_ASSERT(vshPath);
-    GP_ASSERT(fshPath);
-
-    // Search the effect cache for an identical effect that is already loaded.
     std::string uniqueId = vshPath;
     uniqueId += ';';
     uniqueId += fshPath;
@@ -55,52 +53,37 @@ Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const c
     {
         uniqueId += defines;
     }
-    std::map<std::string, Effect*>::const_iterator itr = __effectCache.find(uniqueId);
-    if (itr != __effectCache.end())
+    return uniqueId;
+}
+
+Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const char* defines)
+{
+    GP_ASSERT(vshPath);
+    GP_ASSERT(fshPath);
+
+    // Search the effect cache for an identical effect that is already loaded.
+    Effect* cached = getCached(vshPath, fshPath, defines);
+    if (cached)
     {
-        // Found an exiting effect with this id, so increase its ref count and return it.
-        GP_ASSERT(itr->second);
-        itr->second->addRef();
-        return itr->second;
+        // Found an existing effect with this id, whose ref count was increased by the cache.
+        return cached;
     }
 
     // Read source from file.
-    char* vshSource = FileSystem::readAll(vshPath);
-    if (vshSource == NULL)
+    std::string vshSource;
+    if (!readSource(vshPath, &vshSource))
     {
         GP_ERROR("Failed to read vertex shader from file '%s'.", vshPath);
         return NULL;
     }
-    char* fshSource = FileSystem::readAll(fshPath);
-    if (fshSource == NULL)
+    std::string fshSource;
+    if (!readSource(fshPath, &fshSource))
     {
         GP_ERROR("Failed to read fragment shader from file '%s'.", fshPath);
-        SAFE_DELETE_ARRAY(vshSource);
         return NULL;
     }
 
-    Effect* effect = createFromSource(vshPath, vshSource, fshPath, fshSource, defines);
-    
-    SAFE_DELETE_ARRAY(vshSource);
-    SAFE_DELETE_ARRAY(fshSource);
-
-    if (effect == NULL)
-    {
-        GP_ERROR("Failed to create effect from shaders '%s', '%s'.", vshPath, fshPath);
-    }
-    else
-    {
-        // Store this effect in the cache.
-        effect->_id = uniqueId;
-        __effectCache[uniqueId] = effect;
-    }
-
-    effect->_vshPath = vshPath;
-    effect->_fshPath = fshPath;
-    if (defines)
-        effect->_defines = defines;
-    
-    return effect;
+    return createFromExpandedSource(vshPath, vshSource, fshPath, fshSource, defines);
 }
 
 Effect* Effect::createFromSource(const char* vshSource, const char* fshSource, const char* defines)
@@ -232,7 +215,57 @@ static void writeShaderToErrorFile(const char* filePath, const char* source)
     }
 }
 
-Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines)
+Effect* Effect::getCached(const char* vshPath, const char* fshPath, const char* defines)
+{
+    GP_ASSERT(vshPath);
+    GP_ASSERT(fshPath);
+
+    return __effectCache.acquire(getEffectId(vshPath, fshPath, defines));
+}
+
+bool Effect::readSource(const char* path, std::string* source)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(source);
+
+    char* fileSource = FileSystem::readAll(path);
+    if (fileSource == NULL)
+        return false;
+
+    // Replace the #include "xxxxx.xxx" with the sources that come from file paths
+    source->clear();
+    replaceIncludes(path, fileSource, *source);
+    if (strlen(fileSource) != 0)
+        *source += "\n";
+    SAFE_DELETE_ARRAY(fileSource);
+    return true;
+}
+
+Effect* Effect::createFromExpandedSource(const char* vshPath, const std::string& vshSource, const char* fshPath, const std::string& fshSource, const char* defines)
+{
+    GP_ASSERT(vshPath);
+    GP_ASSERT(fshPath);
+
+    Effect* effect = createFromSource(vshPath, vshSource.c_str(), fshPath, fshSource.c_str(), defines, false);
+    if (effect == NULL)
+    {
+        GP_ERROR("Failed to create effect from shaders '%s', '%s'.", vshPath, fshPath);
+        return NULL;
+    }
+
+    // Store this effect in the cache.
+    effect->_id = getEffectId(vshPath, fshPath, defines);
+    __effectCache.add(effect->_id, effect);
+
+    effect->_vshPath = vshPath;
+    effect->_fshPath = fshPath;
+    if (defines)
+        effect->_defines = defines;
+
+    return effect;
+}
+
+Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines, bool expandIncludes)
 {
     GP_ASSERT(vshSource);
     GP_ASSERT(fshSource);
@@ -253,14 +286,14 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
     shaderSource[0] = definesStr.c_str();
     shaderSource[1] = "\n";
     std::string vshSourceStr = "";
-    if (vshPath)
+    if (vshPath && expandIncludes)
     {
         // Replace the #include "xxxxx.xxx" with the sources that come from file paths
         replaceIncludes(vshPath, vshSource, vshSourceStr);
         if (vshSource && strlen(vshSource) != 0)
             vshSourceStr += "\n";
     }
-    shaderSource[2] = vshPath ? vshSourceStr.c_str() :  vshSource;
+    shaderSource[2] = vshPath && expandIncludes ? vshSourceStr.c_str() :  vshSource;
     GL_ASSERT( vertexShader = glCreateShader(GL_VERTEX_SHADER) );
     GL_ASSERT( glShaderSource(vertexShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
     GL_ASSERT( glCompileShader(vertexShader) );
@@ -294,14 +327,14 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
 
     // Compile the fragment shader.
     std::string fshSourceStr;
-    if (fshPath)
+    if (fshPath && expandIncludes)
     {
         // Replace the #include "xxxxx.xxx" with the sources that come from file paths
         replaceIncludes(fshPath, fshSource, fshSourceStr);
         if (fshSource && strlen(fshSource) != 0)
             fshSourceStr += "\n";
     }
-    shaderSource[2] = fshPath ? fshSourceStr.c_str() : fshSource;
+    shaderSource[2] = fshPath && expandIncludes ? fshSourceStr.c_str() : fshSource;
     GL_ASSERT( fragmentShader = glCreateShader(GL_FRAGMENT_SHADER) );
     GL_ASSERT( glShaderSource(fragmentShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
     GL_ASSERT( glCompileShader(fragmentShader) );
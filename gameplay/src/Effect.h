@@ -26,6 +26,7 @@ class Uniform;
 class Effect: public Ref
 {
     friend class Pass;
+    friend class LoadController;
 
 public:
 
@@ -241,7 +242,24 @@ private:
      */
     Effect& operator=(const Effect&);
 
-    static Effect* createFromSource(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines = NULL);
+    static Effect* createFromSource(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines = NULL,
+                                    bool expandIncludes = true);
+
+    /**
+     * Finds an effect created from the given files in the cache, and adds a reference to it.
+     */
+    static Effect* getCached(const char* vshPath, const char* fshPath, const char* defines);
+
+    /**
+     * Reads the source of a shader file, with its includes expanded. This does not use
+     * the graphics API, so it may be called from any thread.
+     */
+    static bool readSource(const char* path, std::string* source);
+
+    /**
+     * Compiles an effect from shader sources read by readSource(), and adds it to the cache.
+     */
+    static Effect* createFromExpandedSource(const char* vshPath, const std::string& vshSource, const char* fshPath, const std::string& fshSource, const char* defines);
 
     GLuint _program;
     std::string _id;
@@ -22,7 +22,8 @@ public:
     enum StreamMode
     {
         READ = 1,
-        WRITE = 2
+        WRITE = 2,
+        MAPPED = 4
     };
 
     /**
@@ -148,6 +149,9 @@ public:
      * If <code>path</code> is a file path, the file at the specified location is opened relative to the currently set
      * resource path.
      *
+     * When <code>MAPPED</code> is combined with <code>READ</code>, the file is mapped into memory where supported,
+     * and the stream supports Stream::readInPlace(). Otherwise the file is read through a regular stream.
+     *
      * @param path The path to the resource to be opened, relative to the currently set resource path.
      * @param streamMode The stream mode used to open the file.
      * 
@@ -0,0 +1,291 @@
+#include "Base.h"
+#include "FrustumCuller.h"
+#include "Scene.h"
+#include "Terrain.h"
+#include "Sprite.h"
+#include "TileSet.h"
+#include "ParticleEmitter.h"
+#include "MeshSkin.h"
+#include "Joint.h"
+#include "Game.h"
+#include "MathUtil.h"
+
+// The number of bounding spheres tested by a single job.
+#define FRUSTUM_CULLER_JOB_SIZE 4096
+
+#if defined(GP_USE_NEON)
+#include <arm_neon.h>
+#elif defined(GP_USE_SSE)
+#include <xmmintrin.h>
+#endif
+
+namespace gameplay
+{
+
+// Gets the largest scale of the world transform of a node, along any of its axes.
+static inline float getWorldScale(Node* node)
+{
+    Vector3 scale;
+    node->getWorldMatrix().getScale(&scale);
+    return max(max(fabs(scale.x), fabs(scale.y)), fabs(scale.z));
+}
+
+// Gets the world-space bounding sphere of a drawable alone, without the bounds of the children
+// of its node that Node::getBoundingSphere() merges in. Returns false for drawables without bounds.
+static bool getDrawableBounds(Node* node, Drawable* drawable, BoundingSphere* sphere)
+{
+    Model* model = dynamic_cast<Model*>(drawable);
+    if (model)
+    {
+        if (model->getMesh() == NULL)
+            return false;
+        sphere->set(model->getMesh()->getBoundingSphere());
+
+        // Skinned meshes are bounded in the space of the parent of their root joint, as in Node::getBoundingSphere().
+        MeshSkin* skin = model->getSkin();
+        Node* jointParent = skin && skin->getRootJoint() ? skin->getRootJoint()->getParent() : NULL;
+        if (jointParent)
+        {
+            Matrix boundsMatrix;
+            Matrix::multiply(node->getWorldMatrix(), jointParent->getWorldMatrix(), &boundsMatrix);
+            sphere->transform(boundsMatrix);
+        }
+        else
+        {
+            sphere->transform(node->getWorldMatrix());
+        }
+        return true;
+    }
+
+    Terrain* terrain = dynamic_cast<Terrain*>(drawable);
+    if (terrain)
+    {
+        sphere->set(terrain->getBoundingBox());
+        sphere->transform(node->getWorldMatrix());
+        return true;
+    }
+
+    // Sprites and tile sets are drawn from the world translation of their node, offset by
+    // less than their size whatever their anchor, and scaled with the node.
+    Sprite* sprite = dynamic_cast<Sprite*>(drawable);
+    if (sprite)
+    {
+        sphere->center = node->getTranslationWorld();
+        sphere->radius = sqrt(sprite->getWidth() * sprite->getWidth() + sprite->getHeight() * sprite->getHeight()) * getWorldScale(node);
+        return true;
+    }
+    TileSet* tileSet = dynamic_cast<TileSet*>(drawable);
+    if (tileSet)
+    {
+        sphere->center = node->getTranslationWorld();
+        sphere->radius = sqrt(tileSet->getWidth() * tileSet->getWidth() + tileSet->getHeight() * tileSet->getHeight()) * getWorldScale(node);
+        return true;
+    }
+
+    // Particles are bounded by how far they can travel from the emitter over their lifetime.
+    ParticleEmitter* emitter = dynamic_cast<ParticleEmitter*>(drawable);
+    if (emitter)
+    {
+        float lifetime = emitter->getEnergyMax() * 0.001f;
+        float reach = emitter->getPosition().length() + emitter->getPositionVariance().length() +
+            (emitter->getVelocity().length() + emitter->getVelocityVariance().length()) * lifetime +
+            (emitter->getAcceleration().length() + emitter->getAccelerationVariance().length()) * 0.5f * lifetime * lifetime;
+
+        // Orbiting properties are transformed by the node, including its scale.
+        if (emitter->getOrbitPosition() || emitter->getOrbitVelocity() || emitter->getOrbitAcceleration())
+        {
+            reach *= max(getWorldScale(node), 1.0f);
+        }
+        sphere->center = node->getTranslationWorld();
+        sphere->radius = reach + max(emitter->getSizeStartMax(), emitter->getSizeEndMax());
+        return true;
+    }
+
+    return false;
+}
+
+FrustumCuller::FrustumCuller() : _culledCount(0)
+{
+    memset(_planes, 0, sizeof(_planes));
+}
+
+FrustumCuller::~FrustumCuller()
+{
+}
+
+void FrustumCuller::cull(Scene* scene, const Frustum& frustum)
+{
+    GP_ASSERT(scene);
+
+    _nodes.clear();
+    _centerX.clear();
+    _centerY.clear();
+    _centerZ.clear();
+    _radius.clear();
+    _visibleNodes.clear();
+    _culledCount = 0;
+
+    // Gather the world-space bounds of all enabled drawable nodes.
+    for (Node* node = scene->getFirstNode(); node != NULL; node = node->getNextSibling())
+    {
+        gatherNode(node);
+    }
+    unsigned int count = (unsigned int)_nodes.size();
+    if (count == 0)
+        return;
+
+    // Pad the arrays to a multiple of four so they can be tested four spheres at a time.
+    unsigned int paddedCount = (count + 3) & ~3;
+    _centerX.resize(paddedCount, 0.0f);
+    _centerY.resize(paddedCount, 0.0f);
+    _centerZ.resize(paddedCount, 0.0f);
+    _radius.resize(paddedCount, 0.0f);
+    _visibleMask.resize(paddedCount);
+
+    const Plane* planes[6] = { &frustum.getNear(), &frustum.getFar(), &frustum.getLeft(),
+                               &frustum.getRight(), &frustum.getBottom(), &frustum.getTop() };
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        const Vector3& normal = planes[i]->getNormal();
+        _planes[i][0] = normal.x;
+        _planes[i][1] = normal.y;
+        _planes[i][2] = normal.z;
+        _planes[i][3] = planes[i]->getDistance();
+    }
+
+    Game* game = Game::getInstance();
+    JobController* jobs = game ? game->getJobController() : NULL;
+    if (jobs && count > FRUSTUM_CULLER_JOB_SIZE)
+    {
+        jobs->parallelFor(count, FRUSTUM_CULLER_JOB_SIZE, [this](unsigned int begin, unsigned int end)
+        {
+            testRange(begin, end);
+        });
+    }
+    else
+    {
+        testRange(0, count);
+    }
+
+    // Compact the visible nodes into a list.
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        if (_visibleMask[i])
+            _visibleNodes.push_back(_nodes[i]);
+    }
+    _culledCount = count - (unsigned int)_visibleNodes.size();
+}
+
+unsigned int FrustumCuller::getVisibleCount() const
+{
+    return (unsigned int)_visibleNodes.size();
+}
+
+Node* FrustumCuller::getVisibleNode(unsigned int index) const
+{
+    GP_ASSERT(index < _visibleNodes.size());
+    return _visibleNodes[index];
+}
+
+unsigned int FrustumCuller::getCulledCount() const
+{
+    return _culledCount;
+}
+
+void FrustumCuller::gatherNode(Node* node)
+{
+    if (!node->isEnabled())
+        return;
+
+    Drawable* drawable = node->getDrawable();
+    if (drawable)
+    {
+        _nodes.push_back(node);
+        BoundingSphere sphere;
+        if (getDrawableBounds(node, drawable, &sphere))
+        {
+            _centerX.push_back(sphere.center.x);
+            _centerY.push_back(sphere.center.y);
+            _centerZ.push_back(sphere.center.z);
+            _radius.push_back(sphere.radius);
+        }
+        else
+        {
+            // Drawables without bounds always pass the plane tests.
+            _centerX.push_back(0.0f);
+            _centerY.push_back(0.0f);
+            _centerZ.push_back(0.0f);
+            _radius.push_back(FLT_MAX);
+        }
+    }
+
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        gatherNode(child);
+    }
+}
+
+void FrustumCuller::testRange(unsigned int begin, unsigned int end)
+{
+    GP_ASSERT((begin & 3) == 0);
+
+    // A sphere is visible when its signed distance to every plane is at least -radius,
+    // matching BoundingSphere::intersects(const Frustum&).
+#if defined(GP_USE_NEON) || defined(GP_USE_SSE)
+    for (unsigned int i = begin; i < end; i += 4)
+    {
+#if defined(GP_USE_NEON)
+        float32x4_t x = vld1q_f32(&_centerX[i]);
+        float32x4_t y = vld1q_f32(&_centerY[i]);
+        float32x4_t z = vld1q_f32(&_centerZ[i]);
+        float32x4_t r = vnegq_f32(vld1q_f32(&_radius[i]));
+        uint32x4_t visible = vdupq_n_u32(0xFFFFFFFF);
+        for (unsigned int p = 0; p < 6; ++p)
+        {
+            float32x4_t d = vdupq_n_f32(_planes[p][3]);
+            d = vmlaq_f32(d, x, vdupq_n_f32(_planes[p][0]));
+            d = vmlaq_f32(d, y, vdupq_n_f32(_planes[p][1]));
+            d = vmlaq_f32(d, z, vdupq_n_f32(_planes[p][2]));
+            visible = vandq_u32(visible, vcgeq_f32(d, r));
+        }
+        uint32_t mask[4];
+        vst1q_u32(mask, visible);
+        _visibleMask[i] = mask[0] != 0;
+        _visibleMask[i + 1] = mask[1] != 0;
+        _visibleMask[i + 2] = mask[2] != 0;
+        _visibleMask[i + 3] = mask[3] != 0;
+#else
+        __m128 x = _mm_loadu_ps(&_centerX[i]);
+        __m128 y = _mm_loadu_ps(&_centerY[i]);
+        __m128 z = _mm_loadu_ps(&_centerZ[i]);
+        __m128 r = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&_radius[i]));
+        __m128 visible = _mm_cmpeq_ps(r, r);
+        for (unsigned int p = 0; p < 6; ++p)
+        {
+            __m128 d = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(_planes[p][0])), _mm_set1_ps(_planes[p][3]));
+            d = _mm_add_ps(d, _mm_mul_ps(y, _mm_set1_ps(_planes[p][1])));
+            d = _mm_add_ps(d, _mm_mul_ps(z, _mm_set1_ps(_planes[p][2])));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(d, r));
+        }
+        int mask = _mm_movemask_ps(visible);
+        _visibleMask[i] = (mask & 1) != 0;
+        _visibleMask[i + 1] = (mask & 2) != 0;
+        _visibleMask[i + 2] = (mask & 4) != 0;
+        _visibleMask[i + 3] = (mask & 8) != 0;
+#endif
+    }
+#else
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        bool visible = true;
+        for (unsigned int p = 0; p < 6 && visible; ++p)
+        {
+            float d = _planes[p][0] * _centerX[i] + _planes[p][1] * _centerY[i] + _planes[p][2] * _centerZ[i] + _planes[p][3];
+            visible = d >= -_radius[i];
+        }
+        _visibleMask[i] = visible;
+    }
+#endif
+}
+
+}
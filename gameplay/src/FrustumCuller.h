@@ -0,0 +1,116 @@
+#ifndef FRUSTUMCULLER_H_
+#define FRUSTUMCULLER_H_
+
+#include "Frustum.h"
+
+namespace gameplay
+{
+
+class Scene;
+class Node;
+
+/**
+ * Defines a culling stage that determines which drawable nodes of a scene are visible in a frustum.
+ *
+ * The world-space bounding spheres of all enabled drawable nodes are gathered into
+ * contiguous arrays and tested against the six planes of the frustum several at a
+ * time using SIMD instructions, producing a compact list of the visible nodes.
+ *
+ * Each drawable is culled by its own bounds, rather than by the bounding sphere of its
+ * node, which also covers the node's children. Models and terrain are bounded by their
+ * mesh or height field, sprites and tile sets by their size, and particle emitters by
+ * how far their particles can travel over their lifetime. Text and forms have no bounds
+ * and are always considered visible.
+ *
+ * RenderQueue::add(Scene*) culls a scene with a culler before adding its drawables.
+ *
+ * A culler keeps its arrays between calls, so reusing the same culler every frame
+ * avoids allocating memory.
+ */
+class FrustumCuller
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    FrustumCuller();
+
+    /**
+     * Destructor.
+     */
+    ~FrustumCuller();
+
+    /**
+     * Determines the drawable nodes of the given scene that are visible in the given frustum.
+     *
+     * This replaces the results of the previous call.
+     *
+     * @param scene The scene to cull.
+     * @param frustum The frustum to cull the scene's nodes against.
+     */
+    void cull(Scene* scene, const Frustum& frustum);
+
+    /**
+     * Gets the number of nodes found visible by the last call to cull().
+     *
+     * @return The number of visible nodes.
+     */
+    unsigned int getVisibleCount() const;
+
+    /**
+     * Gets a node found visible by the last call to cull().
+     *
+     * Visible nodes are ordered as they are visited by Scene::visit.
+     *
+     * @param index The index of the visible node.
+     *
+     * @return The visible node at the given index.
+     */
+    Node* getVisibleNode(unsigned int index) const;
+
+    /**
+     * Gets the number of nodes culled by the last call to cull().
+     *
+     * @return The number of nodes outside the frustum.
+     */
+    unsigned int getCulledCount() const;
+
+private:
+
+    /**
+     * Hidden copy constructor.
+     */
+    FrustumCuller(const FrustumCuller& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    FrustumCuller& operator=(const FrustumCuller&);
+
+    /**
+     * Adds the given node and its descendants to the arrays to test, if they are enabled.
+     */
+    void gatherNode(Node* node);
+
+    /**
+     * Tests the gathered bounding spheres in the range [begin, end) against the planes.
+     *
+     * The beginning of the range must be a multiple of four.
+     */
+    void testRange(unsigned int begin, unsigned int end);
+
+    std::vector<Node*> _nodes;
+    std::vector<float> _centerX;
+    std::vector<float> _centerY;
+    std::vector<float> _centerZ;
+    std::vector<float> _radius;
+    std::vector<unsigned char> _visibleMask;
+    std::vector<Node*> _visibleNodes;
+    float _planes[6][4];
+    unsigned int _culledCount;
+};
+
+}
+
+#endif
@@ -9,6 +9,9 @@
 #include "Theme.h"
 #include "Form.h"
 
+// Number of threads that load resources in the background.
+#define LOAD_CONTROLLER_THREAD_COUNT 2
+
 /** @script{ignore} */
 GLenum __gl_error_code = GL_NO_ERROR;
 /** @script{ignore} */
@@ -64,8 +67,8 @@ Game::Game()
       _frameLastFPS(0), _frameCount(0), _frameRate(0), _width(0), _height(0),
       _clearDepth(1.0f), _clearStencil(0),
       _animationController(NULL), _audioController(NULL),
-      _physicsController(NULL), _aiController(NULL), _audioListener(NULL),
-      _timeEvents(NULL), _scriptController(NULL), _scriptTarget(NULL)
+      _physicsController(NULL), _aiController(NULL), _particleController(NULL), _jobController(NULL), _loadController(NULL), _audioListener(NULL),
+      _timeEvents(NULL), _scriptController(NULL), _scriptTarget(NULL), _frameGraph(NULL), _frameElapsedTime(0.0f)
 {
     GP_ASSERT(__gameInstance == NULL);
 
@@ -164,6 +167,15 @@ bool Game::startup()
     RenderState::initialize();
     FrameBuffer::initialize();
 
+    // The calling thread also runs jobs, so it counts as one of the job threads.
+    // Use a thread per hardware thread unless the config says otherwise.
+    unsigned int jobThreads = _config && _config->jobThreads ? _config->jobThreads : std::thread::hardware_concurrency();
+    _jobController = new JobController();
+    _jobController->initialize(jobThreads > 1 ? jobThreads - 1 : 0);
+
+    _loadController = new LoadController();
+    _loadController->initialize(LOAD_CONTROLLER_THREAD_COUNT);
+
     _animationController = new AnimationController();
     _animationController->initialize();
 
@@ -176,12 +188,17 @@ bool Game::startup()
     _aiController = new AIController();
     _aiController->initialize();
 
+    _particleController = new ParticleController();
+    _particleController->initialize();
+
     _scriptController = new ScriptController();
     _scriptController->initialize();
 
     // Load any gamepads, ui or physical.
     loadGamepads();
 
+    createFrameGraph();
+
     /* Set script handler
     if (_properties)
     {
@@ -236,9 +253,15 @@ void Game::shutdown()
         GP_ASSERT(_audioController);
         GP_ASSERT(_physicsController);
         GP_ASSERT(_aiController);
+        GP_ASSERT(_particleController);
+        GP_ASSERT(_loadController);
 
         Platform::signalShutdown();
 
+        // Stop loading resources before the game and its systems are torn down.
+        _loadController->finalize();
+        SAFE_DELETE(_loadController);
+
 		// Call user finalize
         finalize();
 
@@ -269,6 +292,11 @@ void Game::shutdown()
         SAFE_DELETE(_physicsController);
         _aiController->finalize();
         SAFE_DELETE(_aiController);
+        _particleController->finalize();
+        SAFE_DELETE(_particleController);
+        SAFE_DELETE(_frameGraph);
+        _jobController->finalize();
+        SAFE_DELETE(_jobController);
         
         ControlFactory::finalize();
 
@@ -294,12 +322,14 @@ void Game::pause()
         GP_ASSERT(_audioController);
         GP_ASSERT(_physicsController);
         GP_ASSERT(_aiController);
+        GP_ASSERT(_particleController);
         _state = PAUSED;
         _pausedTimeLast = Platform::getAbsoluteTime();
         _animationController->pause();
         _audioController->pause();
         _physicsController->pause();
         _aiController->pause();
+        _particleController->pause();
     }
     ++_pausedCount;
 }
@@ -316,12 +346,14 @@ void Game::resume()
             GP_ASSERT(_audioController);
             GP_ASSERT(_physicsController);
             GP_ASSERT(_aiController);
+        GP_ASSERT(_particleController);
             _state = RUNNING;
             _pausedTimeTotal += Platform::getAbsoluteTime() - _pausedTimeLast;
             _animationController->resume();
             _audioController->resume();
             _physicsController->resume();
             _aiController->resume();
+            _particleController->resume();
         }
     }
 }
@@ -377,42 +409,18 @@ void Game::frame()
         GP_ASSERT(_audioController);
         GP_ASSERT(_physicsController);
         GP_ASSERT(_aiController);
+        GP_ASSERT(_particleController);
+        GP_ASSERT(_jobController);
+        GP_ASSERT(_loadController);
+        GP_ASSERT(_frameGraph);
 
         // Update Time.
-        float elapsedTime = (frameTime - lastFrameTime);
+        _frameElapsedTime = (frameTime - lastFrameTime);
         lastFrameTime = frameTime;
 
-        // Update the scheduled and running animations.
-        _animationController->update(elapsedTime);
-
-        // Update the physics.
-        _physicsController->update(elapsedTime);
-
-        // Update AI.
-        _aiController->update(elapsedTime);
-
-        // Update gamepads.
-        Gamepad::updateInternal(elapsedTime);
-
-        // Application Update.
-        update(elapsedTime);
-
-        // Update forms.
-        Form::updateInternal(elapsedTime);
-
-        // Run script update.
-        if (_scriptTarget)
-            _scriptTarget->fireScriptEvent<void>(GP_GET_SCRIPT_EVENT(GameScriptTarget, update), elapsedTime);
-
-        // Audio Rendering.
-        _audioController->update(elapsedTime);
-
-        // Graphics Rendering.
-        render(elapsedTime);
-
-        // Run script render.
-        if (_scriptTarget)
-            _scriptTarget->fireScriptEvent<void>(GP_GET_SCRIPT_EVENT(GameScriptTarget, render), elapsedTime);
+        // Update the game systems and render. Tasks of the frame graph that
+        // don't depend on each other may run concurrently on worker threads.
+        _jobController->run(*_frameGraph);
 
         // Update FPS.
         ++_frameCount;
@@ -447,6 +455,59 @@ void Game::frame()
     }
 }
 
+void Game::createFrameGraph()
+{
+    _frameGraph = new TaskGraph();
+
+    // The tasks that touch nodes, the audio listener, the graphics and audio APIs or call
+    // back into application code run on the main thread, chained in the order the game
+    // systems have always been updated in. Particles are simulated last, on a worker thread,
+    // while the main thread updates audio: once the script update is done nothing moves
+    // the emitters' nodes until rendering, which waits for the particles. The emitters'
+    // world matrices are resolved on the main thread first, since resolving them lazily
+    // writes to shared parent nodes.
+    unsigned int loading = _frameGraph->addTask("loading", [this]{ _loadController->update(); }, TaskGraph::MAIN_THREAD);
+    unsigned int animation = _frameGraph->addTask("animation", [this]{ _animationController->update(_frameElapsedTime); }, TaskGraph::MAIN_THREAD);
+    unsigned int physics = _frameGraph->addTask("physics", [this]{ _physicsController->update(_frameElapsedTime); }, TaskGraph::MAIN_THREAD);
+    unsigned int ai = _frameGraph->addTask("ai", [this]{ _aiController->update(_frameElapsedTime); }, TaskGraph::MAIN_THREAD);
+    unsigned int gamepads = _frameGraph->addTask("gamepads", [this]{ Gamepad::updateInternal(_frameElapsedTime); }, TaskGraph::MAIN_THREAD);
+    unsigned int update = _frameGraph->addTask("update", [this]
+    {
+        // Application Update.
+        this->update(_frameElapsedTime);
+    }, TaskGraph::MAIN_THREAD);
+    unsigned int forms = _frameGraph->addTask("forms", [this]{ Form::updateInternal(_frameElapsedTime); }, TaskGraph::MAIN_THREAD);
+    unsigned int script = _frameGraph->addTask("script", [this]
+    {
+        if (_scriptTarget)
+            _scriptTarget->fireScriptEvent<void>(GP_GET_SCRIPT_EVENT(GameScriptTarget, update), _frameElapsedTime);
+    }, TaskGraph::MAIN_THREAD);
+    unsigned int particleNodes = _frameGraph->addTask("particleNodes", [this]{ _particleController->resolveNodes(); }, TaskGraph::MAIN_THREAD);
+    unsigned int particles = _frameGraph->addTask("particles", [this]{ _particleController->updateEmitters(_frameElapsedTime); });
+    unsigned int audio = _frameGraph->addTask("audio", [this]{ _audioController->update(_frameElapsedTime); }, TaskGraph::MAIN_THREAD);
+    unsigned int render = _frameGraph->addTask("render", [this]
+    {
+        // Graphics Rendering.
+        this->render(_frameElapsedTime);
+
+        // Run script render.
+        if (_scriptTarget)
+            _scriptTarget->fireScriptEvent<void>(GP_GET_SCRIPT_EVENT(GameScriptTarget, render), _frameElapsedTime);
+    }, TaskGraph::MAIN_THREAD);
+
+    _frameGraph->addDependency(animation, loading);
+    _frameGraph->addDependency(physics, animation);
+    _frameGraph->addDependency(ai, physics);
+    _frameGraph->addDependency(gamepads, ai);
+    _frameGraph->addDependency(update, gamepads);
+    _frameGraph->addDependency(forms, update);
+    _frameGraph->addDependency(script, forms);
+    _frameGraph->addDependency(particleNodes, script);
+    _frameGraph->addDependency(particles, particleNodes);
+    _frameGraph->addDependency(audio, particleNodes);
+    _frameGraph->addDependency(render, particles);
+}
+
 void Game::renderOnce(const char* function)
 {
     _scriptController->executeFunction<void>(function, NULL);
@@ -455,21 +516,30 @@ void Game::renderOnce(const char* function)
 
 void Game::updateOnce()
 {
-    GP_ASSERT(_animationController);
-    GP_ASSERT(_audioController);
-    GP_ASSERT(_physicsController);
-    GP_ASSERT(_aiController);
-
     // Update Time.
     static double lastFrameTime = getGameTime();
     double frameTime = getGameTime();
     float elapsedTime = (frameTime - lastFrameTime);
     lastFrameTime = frameTime;
 
+    updateOnce(elapsedTime);
+}
+
+void Game::updateOnce(float elapsedTime)
+{
+    GP_ASSERT(_animationController);
+    GP_ASSERT(_audioController);
+    GP_ASSERT(_physicsController);
+    GP_ASSERT(_aiController);
+    GP_ASSERT(_particleController);
+    GP_ASSERT(_loadController);
+
     // Update the internal controllers.
+    _loadController->update();
     _animationController->update(elapsedTime);
     _physicsController->update(elapsedTime);
     _aiController->update(elapsedTime);
+    _particleController->update(elapsedTime);
     _audioController->update(elapsedTime);
     if (_scriptTarget)
         _scriptTarget->fireScriptEvent<void>(GP_GET_SCRIPT_EVENT(GameScriptTarget, update), elapsedTime);
@@ -763,7 +833,7 @@ Game::Config* Game::getConfig()
 Game::Config::Config() :
     title(""), fullscreen(false), resizable(true),
     x(0), y(0), width(1920), height(1080), samples(4),
-    theme(""), gamepad("")
+    theme(""), gamepad(""), animationSampleRate(0), cpuSkinning(false), jobThreads(0)
 {
 }
 
@@ -794,6 +864,9 @@ void Game::Config::serialize(Serializer* serializer)
     serializer->writeInt("samples", samples, 0);
     serializer->writeString("theme", theme.c_str(), "");
     serializer->writeString("gamepad", gamepad.c_str(), "");
+    serializer->writeInt("animationSampleRate", animationSampleRate, 0);
+    serializer->writeBool("cpuSkinning", cpuSkinning, false);
+    serializer->writeInt("jobThreads", jobThreads, 0);
     
     // FIXME: seant
     /*
@@ -819,6 +892,9 @@ void Game::Config::deserialize(Serializer* serializer)
     samples = serializer->readInt("samples", 0);
     serializer->readString("theme", theme, "");
     serializer->readString("gamepad", gamepad, "");
+    animationSampleRate = serializer->readInt("animationSampleRate", 0);
+    cpuSkinning = serializer->readBool("cpuSkinning", false);
+    jobThreads = serializer->readInt("jobThreads", 0);
     
     // FIXME:
     // aliases read the pairs
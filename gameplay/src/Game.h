@@ -10,6 +10,10 @@
 #include "AnimationController.h"
 #include "PhysicsController.h"
 #include "AIController.h"
+#include "ParticleController.h"
+#include "JobController.h"
+#include "LoadController.h"
+#include "TaskGraph.h"
 #include "AudioListener.h"
 #include "Rectangle.h"
 #include "Vector4.h"
@@ -259,6 +263,46 @@ public:
      */
     inline AIController* getAIController() const;
 
+    /**
+     * Gets the particle controller for controlling the particle
+     * emitters associated with the game.
+     *
+     * @return The particle controller for this game.
+     */
+    inline ParticleController* getParticleController() const;
+
+    /**
+     * Gets the job controller for running work in parallel
+     * on the game's worker threads.
+     *
+     * @return The job controller for this game.
+     */
+    inline JobController* getJobController() const;
+
+    /**
+     * Gets the load controller for loading resources
+     * in the background.
+     *
+     * @return The load controller for this game.
+     */
+    inline LoadController* getLoadController() const;
+
+    /**
+     * Gets the task graph run by the game every frame while it is running.
+     *
+     * The graph contains the tasks "loading", "animation", "physics", "ai", "gamepads",
+     * "update", "forms", "script", "particleNodes", "particles", "audio" and "render",
+     * which finalize the resources loaded in the background, update the game systems,
+     * call update() and render(), and fire the script events. The "particles" task runs
+     * on a worker thread, alongside "audio" on the main thread. Games may
+     * add their own tasks and dependencies, for example to run simulation work
+     * alongside the built-in systems on worker threads. Tasks that touch the scene
+     * must depend on, or be depended on by, the built-in tasks that do the same.
+     *
+     * @return The frame task graph.
+     */
+    inline TaskGraph* getFrameGraph() const;
+
     /**
      * Gets the script controller for controlling the scripts
      * associated with the game.
@@ -666,6 +710,9 @@ public:
         unsigned int samples;        
         std::string theme;
         std::string gamepad;
+        unsigned int animationSampleRate;
+        bool cpuSkinning;
+        unsigned int jobThreads;
         std::vector<std::pair<std::string, std::string> > aliases;
     };
 
@@ -733,6 +780,18 @@ protected:
      */
     void updateOnce();
 
+    /**
+     * Updates the game's internal systems (audio, animation, physics) once
+     * by the given elapsed time, instead of the time since the last update.
+     *
+     * Note: This does not call the user-defined Game::update() function.
+     *
+     * This is useful for stepping the game systems at a fixed rate.
+     *
+     * @param elapsedTime The elapsed time, in milliseconds.
+     */
+    void updateOnce(float elapsedTime);
+
 private:
 
     struct ShutdownListener : public TimeListener
@@ -781,6 +840,11 @@ private:
      */
     void loadGamepads();
 
+    /**
+     * Creates the task graph that updates the game systems and renders every frame.
+     */
+    void createFrameGraph();
+
     void keyEventInternal(Keyboard::KeyEvent evt, int key);
     void touchEventInternal(Touch::TouchEvent evt, int x, int y, unsigned int contactIndex);
     bool mouseEventInternal(Mouse::MouseEvent evt, int x, int y, int wheelDelta);
@@ -812,10 +876,15 @@ private:
     AudioController* _audioController;          // Controls audio sources that are playing in the game.
     PhysicsController* _physicsController;      // Controls the simulation of a physics scene and entities.
     AIController* _aiController;                // Controls AI simulation.
+    ParticleController* _particleController;    // Controls the simulation of active particle emitters.
+    JobController* _jobController;              // Controls the worker threads used for parallel work.
+    LoadController* _loadController;            // Controls the loading of resources in the background.
     AudioListener* _audioListener;              // The audio listener in 3D space.
     std::priority_queue<TimeEvent, std::vector<TimeEvent>, std::less<TimeEvent> >* _timeEvents;
     ScriptController* _scriptController;        // Controls the scripting engine.
     ScriptTarget* _scriptTarget;                // Script target for the game
+    TaskGraph* _frameGraph;                     // The tasks run every frame.
+    float _frameElapsedTime;                    // The elapsed time of the current frame.
 
     // Note: Do not add STL object member variables on the stack; this will cause false memory leaks to be reported.
 
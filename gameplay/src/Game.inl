@@ -64,6 +64,26 @@ inline AIController* Game::getAIController() const
     return _aiController;
 }
 
+inline ParticleController* Game::getParticleController() const
+{
+    return _particleController;
+}
+
+inline JobController* Game::getJobController() const
+{
+    return _jobController;
+}
+
+inline LoadController* Game::getLoadController() const
+{
+    return _loadController;
+}
+
+inline TaskGraph* Game::getFrameGraph() const
+{
+    return _frameGraph;
+}
+
 template <class T>
 void Game::renderOnce(T* instance, void (T::*method)(void*), void* cookie)
 {
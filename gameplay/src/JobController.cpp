@@ -0,0 +1,294 @@
+#include "Base.h"
+#include "JobController.h"
+#include "TaskGraph.h"
+
+namespace gameplay
+{
+
+// Index of the calling thread's job queue. Threads that are not workers share queue 0.
+static thread_local unsigned int __queueIndex = 0;
+
+JobController::JobController()
+    : _queuedCount(0), _running(false)
+{
+}
+
+JobController::~JobController()
+{
+}
+
+unsigned int JobController::getWorkerCount() const
+{
+    return (unsigned int)_workers.size();
+}
+
+void JobController::initialize(unsigned int workerCount)
+{
+    _running = true;
+    for (unsigned int i = 0; i <= workerCount; ++i)
+    {
+        _queues.push_back(new JobQueue());
+    }
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        _workers.push_back(new std::thread(&workerThreadProc, this, i + 1));
+    }
+}
+
+void JobController::finalize()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _running = false;
+    }
+    _sleepCondition.notify_all();
+
+    for (size_t i = 0, count = _workers.size(); i < count; ++i)
+    {
+        _workers[i]->join();
+        SAFE_DELETE(_workers[i]);
+    }
+    _workers.clear();
+
+    for (size_t i = 0, count = _queues.size(); i < count; ++i)
+    {
+        GP_ASSERT(_queues[i]->jobs.empty());
+        SAFE_DELETE(_queues[i]);
+    }
+    _queues.clear();
+}
+
+void JobController::parallelFor(unsigned int count, unsigned int grainSize, const RangeFunction& function)
+{
+    if (count == 0)
+        return;
+
+    if (grainSize == 0)
+        grainSize = 1;
+
+    unsigned int jobCount = (count + grainSize - 1) / grainSize;
+    if (jobCount == 1 || _workers.empty())
+    {
+        for (unsigned int begin = 0; begin < count; begin += grainSize)
+        {
+            function(begin, min(begin + grainSize, count));
+        }
+        return;
+    }
+
+    // Queue every range but the first, which is run on the calling thread.
+    std::atomic<unsigned int> pending(jobCount - 1);
+    for (unsigned int begin = grainSize; begin < count; begin += grainSize)
+    {
+        Job job = { &function, begin, min(begin + grainSize, count), &pending, NULL };
+        push(job);
+    }
+
+    function(0, grainSize);
+
+    // Help out with queued work until all of our ranges are complete, and sleep
+    // while the last ones run on other threads.
+    while (pending.load() > 0)
+    {
+        if (runJob())
+            continue;
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _waitCondition.wait(lock, [this, &pending]{ return pending.load() == 0 || _queuedCount.load() > 0; });
+    }
+}
+
+void JobController::run(TaskGraph& graph)
+{
+    unsigned int taskCount = graph.getTaskCount();
+    if (taskCount == 0)
+        return;
+
+    GP_ASSERT(graph._remaining.load() == 0);
+    graph._remaining = taskCount;
+    for (unsigned int i = 0; i < taskCount; ++i)
+    {
+        TaskGraph::Task* task = graph._tasks[i];
+        task->pending = task->dependencyCount;
+    }
+    for (unsigned int i = 0; i < taskCount; ++i)
+    {
+        if (graph._tasks[i]->dependencyCount == 0)
+        {
+            scheduleTask(&graph, i);
+        }
+    }
+
+    // Run main thread tasks as they become ready and help with the rest.
+    while (graph._remaining.load() > 0)
+    {
+        Job job;
+        bool mainThreadJob = false;
+        {
+            std::lock_guard<std::mutex> lock(_mainThreadMutex);
+            if (!_mainThreadJobs.empty())
+            {
+                job = _mainThreadJobs.front();
+                _mainThreadJobs.pop_front();
+                mainThreadJob = true;
+            }
+        }
+
+        if (mainThreadJob)
+        {
+            runTask(job.graph, job.begin);
+        }
+        else if (!runJob())
+        {
+            std::unique_lock<std::mutex> lock(_sleepMutex);
+            _waitCondition.wait(lock, [this, &graph]{ return graph._remaining.load() == 0 || _queuedCount.load() > 0 || hasMainThreadJob(); });
+        }
+    }
+}
+
+void JobController::push(const Job& job)
+{
+    JobQueue* queue = _queues[__queueIndex];
+    {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->jobs.push_back(job);
+    }
+
+    // Take the sleep lock so a worker can't miss the new job between checking for work and going to sleep.
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        ++_queuedCount;
+    }
+    _sleepCondition.notify_one();
+    _waitCondition.notify_all();
+}
+
+bool JobController::pop(Job* job)
+{
+    GP_ASSERT(job);
+
+    if (_queuedCount.load() == 0)
+        return false;
+
+    // Take the most recent job from our own queue first since its data is most likely
+    // still in cache, then steal the oldest job from the other threads' queues.
+    unsigned int queueCount = (unsigned int)_queues.size();
+    for (unsigned int i = 0; i < queueCount; ++i)
+    {
+        unsigned int index = (__queueIndex + i) % queueCount;
+        JobQueue* queue = _queues[index];
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (queue->jobs.empty())
+            continue;
+
+        if (i == 0)
+        {
+            *job = queue->jobs.back();
+            queue->jobs.pop_back();
+        }
+        else
+        {
+            *job = queue->jobs.front();
+            queue->jobs.pop_front();
+        }
+        --_queuedCount;
+        return true;
+    }
+    return false;
+}
+
+bool JobController::runJob()
+{
+    Job job;
+    if (!pop(&job))
+        return false;
+
+    if (job.graph)
+    {
+        runTask(job.graph, job.begin);
+    }
+    else
+    {
+        (*job.function)(job.begin, job.end);
+        if (job.pending->fetch_sub(1) == 1)
+            notifyWaiters();
+    }
+    return true;
+}
+
+void JobController::runTask(TaskGraph* graph, unsigned int task)
+{
+    GP_ASSERT(graph && task < graph->_tasks.size());
+
+    TaskGraph::Task* t = graph->_tasks[task];
+    if (t->function)
+    {
+        t->function();
+    }
+
+    // Release the tasks that were waiting on this one.
+    for (size_t i = 0, count = t->dependents.size(); i < count; ++i)
+    {
+        unsigned int dependent = t->dependents[i];
+        if (graph->_tasks[dependent]->pending.fetch_sub(1) == 1)
+        {
+            scheduleTask(graph, dependent);
+        }
+    }
+    if (graph->_remaining.fetch_sub(1) == 1)
+        notifyWaiters();
+}
+
+void JobController::notifyWaiters()
+{
+    // Take the sleep lock so a waiting thread can't miss the notification between
+    // checking whether its work is done and going to sleep.
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+    }
+    _waitCondition.notify_all();
+}
+
+bool JobController::hasMainThreadJob()
+{
+    std::lock_guard<std::mutex> lock(_mainThreadMutex);
+    return !_mainThreadJobs.empty();
+}
+
+void JobController::scheduleTask(TaskGraph* graph, unsigned int task)
+{
+    Job job = { NULL, task, task + 1, NULL, graph };
+    if (graph->_tasks[task]->affinity == TaskGraph::MAIN_THREAD || _workers.empty())
+    {
+        // Main thread tasks, and every task when there are no workers, are run by the
+        // calling thread in the order they become ready.
+        {
+            std::lock_guard<std::mutex> lock(_mainThreadMutex);
+            _mainThreadJobs.push_back(job);
+        }
+        notifyWaiters();
+    }
+    else
+    {
+        push(job);
+    }
+}
+
+void JobController::workerThreadProc(JobController* controller, unsigned int queueIndex)
+{
+    GP_ASSERT(controller);
+    __queueIndex = queueIndex;
+
+    while (true)
+    {
+        if (controller->runJob())
+            continue;
+
+        std::unique_lock<std::mutex> lock(controller->_sleepMutex);
+        controller->_sleepCondition.wait(lock, [controller]{ return !controller->_running || controller->_queuedCount.load() > 0; });
+        if (!controller->_running)
+            break;
+    }
+}
+
+}
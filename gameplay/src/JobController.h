@@ -0,0 +1,147 @@
+#ifndef JOBCONTROLLER_H_
+#define JOBCONTROLLER_H_
+
+namespace gameplay
+{
+
+class TaskGraph;
+
+/**
+ * Defines a class for running work in parallel on a pool of worker threads.
+ *
+ * Every worker thread owns a queue of jobs. A thread pushes and pops jobs at the
+ * back of its own queue and, when it runs out of work, steals jobs from the front
+ * of the other threads' queues. Threads that wait for submitted work to finish run
+ * jobs themselves in the meantime, so work may be submitted from inside a running
+ * job without starving the pool, and sleep when there is nothing left for them to run.
+ */
+class JobController
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Function invoked for a range of indices [begin, end).
+     */
+    typedef std::function<void(unsigned int begin, unsigned int end)> RangeFunction;
+
+    /**
+     * Destructor.
+     */
+    ~JobController();
+
+    /**
+     * Gets the number of worker threads, not counting the calling thread.
+     *
+     * @return The number of worker threads.
+     */
+    unsigned int getWorkerCount() const;
+
+    /**
+     * Calls the given function over the index range [0, count) split into
+     * ranges of at most grainSize indices, and waits for all of them to complete.
+     *
+     * Ranges are always split at multiples of the grain size, independent of the
+     * number of worker threads.
+     *
+     * @param count The number of indices.
+     * @param grainSize The maximum number of indices handed to a single call.
+     * @param function The function to call for each range.
+     */
+    void parallelFor(unsigned int count, unsigned int grainSize, const RangeFunction& function);
+
+    /**
+     * Runs every task in the given graph once, respecting the dependencies
+     * between them, and waits for all of them to complete.
+     *
+     * Tasks with TaskGraph::MAIN_THREAD affinity run on the calling thread, so
+     * only one thread should run task graphs at a time.
+     *
+     * @param graph The task graph to run.
+     */
+    void run(TaskGraph& graph);
+
+private:
+
+    /**
+     * A unit of work: either a range submitted by parallelFor or a task of a running graph.
+     */
+    struct Job
+    {
+        const RangeFunction* function;
+        unsigned int begin;
+        unsigned int end;
+        std::atomic<unsigned int>* pending;
+        TaskGraph* graph;
+    };
+
+    /**
+     * A queue of jobs owned by one thread.
+     */
+    struct JobQueue
+    {
+        std::deque<Job> jobs;
+        std::mutex mutex;
+    };
+
+    /**
+     * Constructor.
+     */
+    JobController();
+
+    /**
+     * Constructor.
+     */
+    JobController(const JobController& copy);
+
+    /**
+     * Controller initialize.
+     *
+     * @param workerCount The number of worker threads to start.
+     */
+    void initialize(unsigned int workerCount);
+
+    /**
+     * Controller finalize.
+     */
+    void finalize();
+
+    void push(const Job& job);
+
+    bool pop(Job* job);
+
+    /**
+     * Runs a single job on the calling thread, taken from its own queue or stolen from another.
+     *
+     * @return true if a job was run, false if there was no work.
+     */
+    bool runJob();
+
+    void runTask(TaskGraph* graph, unsigned int task);
+
+    /**
+     * Wakes the threads waiting for submitted work to finish, after some of it finished.
+     */
+    void notifyWaiters();
+
+    bool hasMainThreadJob();
+
+    void scheduleTask(TaskGraph* graph, unsigned int task);
+
+    static void workerThreadProc(JobController* controller, unsigned int queueIndex);
+
+    std::vector<std::thread*> _workers;
+    std::vector<JobQueue*> _queues;
+    std::atomic<unsigned int> _queuedCount;
+    std::mutex _sleepMutex;
+    std::condition_variable _sleepCondition;
+    std::condition_variable _waitCondition;
+    std::deque<Job> _mainThreadJobs;
+    std::mutex _mainThreadMutex;
+    bool _running;
+};
+
+}
+
+#endif
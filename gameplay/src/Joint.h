@@ -22,6 +22,7 @@ class Joint : public Node
     friend class Node;
     friend class MeshSkin;
     friend class Bundle;
+    friend class AnimationClip;
 
 public:
 
@@ -80,14 +81,6 @@ protected:
      */
     void setInverseBindPose(const Matrix& m);
 
-    /**
-     * Updates the joint matrix.
-     * 
-     * @param bindShape The bind shape matrix.
-     * @param matrixPalette The matrix palette to update.
-     */
-    void updateJointMatrix(const Matrix& bindShape, Vector4* matrixPalette);
-
     /**
      * Called when this Joint's transform changes.
      */
@@ -149,7 +142,6 @@ private:
     void removeSkin(MeshSkin* skin);
 
     Matrix _bindPose;       // The Matrix representation of the Joint's bind pose.
-    bool _jointMatrixDirty; // Flag used to mark if the Joint's matrix is dirty.
     SkinReference _skin;    //Linked list of mesh skins that are referenced by this joint.
 };
 
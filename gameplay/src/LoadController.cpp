@@ -0,0 +1,640 @@
+#include "Base.h"
+#include "LoadController.h"
+#include "Bundle.h"
+#include "Effect.h"
+#include "FileSystem.h"
+#include "Game.h"
+#include "Image.h"
+#include "Scene.h"
+#include "Serializer.h"
+#include "Texture.h"
+
+// Default time spent finalizing loaded requests in a frame, in milliseconds.
+#define LOAD_CONTROLLER_FINALIZE_BUDGET 4.0f
+
+// Size of the reads used to read a file ahead.
+#define LOAD_CONTROLLER_READ_AHEAD_SIZE 65536
+
+namespace gameplay
+{
+
+// Reads a file through, so that its pages are in memory when it is read on the main thread.
+static bool readAhead(const char* path)
+{
+    std::unique_ptr<Stream> stream(FileSystem::open(path));
+    if (stream.get() == NULL || !stream->canRead())
+    {
+        GP_ERROR("Failed to open file '%s'.", path);
+        return false;
+    }
+    std::vector<char> buffer(LOAD_CONTROLLER_READ_AHEAD_SIZE);
+    while (stream->read(&buffer[0], 1, buffer.size()) == buffer.size())
+    {
+    }
+    return true;
+}
+
+static bool hasExtension(const char* path, const char* extension)
+{
+    const char* ext = strrchr(FileSystem::resolvePath(path), '.');
+    if (ext == NULL || strlen(ext) != strlen(extension))
+        return false;
+    for (size_t i = 0; ext[i]; ++i)
+    {
+        if (tolower(ext[i]) != extension[i])
+            return false;
+    }
+    return true;
+}
+
+// Splits the id of an object in a bundle from a path of the form "file#id".
+static void splitPath(const char* path, std::string* filePath, std::string* id)
+{
+    *filePath = path;
+    size_t pos = filePath->find('#');
+    if (pos != std::string::npos)
+    {
+        *id = filePath->substr(pos + 1);
+        filePath->erase(pos);
+    }
+}
+
+// The data of an image request, shared by its load and finalize functions.
+struct ImageLoad
+{
+    ImageLoad() : image(NULL) { }
+    ~ImageLoad() { SAFE_RELEASE(image); }
+
+    std::string path;
+    Image* image;
+};
+
+// The data of a texture request, shared by its load and finalize functions.
+struct TextureLoad
+{
+    TextureLoad() : generateMipmaps(false), image(NULL), texture(NULL) { }
+    ~TextureLoad() { SAFE_RELEASE(image); SAFE_RELEASE(texture); }
+
+    std::string path;
+    bool generateMipmaps;
+    Image* image;
+    Texture* texture;
+};
+
+// The data of an effect request, shared by its load and finalize functions.
+struct EffectLoad
+{
+    EffectLoad() : hasDefines(false), effect(NULL) { }
+    ~EffectLoad() { SAFE_RELEASE(effect); }
+
+    std::string vshPath;
+    std::string fshPath;
+    std::string defines;
+    bool hasDefines;
+    std::string vshSource;
+    std::string fshSource;
+    Effect* effect;
+};
+
+// The data of a scene file request, shared by its load and finalize functions.
+struct SceneLoad
+{
+    SceneLoad() : reader(NULL) { }
+    ~SceneLoad() { SAFE_DELETE(reader); }
+
+    std::string path;
+    Serializer* reader;
+};
+
+// The data of a bundle request, shared by its load and finalize functions.
+struct BundleLoad
+{
+    BundleLoad() : bundle(NULL), opened(false) { }
+    ~BundleLoad() { SAFE_RELEASE(bundle); }
+
+    std::string path;
+    Bundle* bundle;
+    bool opened;
+};
+
+LoadController::Request::Request()
+    : _state(QUEUED), _cancelled(false), _loadResult(false), _resource(NULL)
+{
+}
+
+LoadController::Request::~Request()
+{
+    SAFE_RELEASE(_resource);
+}
+
+LoadController::Request::State LoadController::Request::getState() const
+{
+    return (State)_state.load();
+}
+
+bool LoadController::Request::isDone() const
+{
+    return _state >= COMPLETE;
+}
+
+float LoadController::Request::getProgress() const
+{
+    switch (_state)
+    {
+    case QUEUED:
+    case LOADING:
+        return 0.0f;
+    case LOADED:
+        // Requests that are finalized in steps report the steps done.
+        return 0.5f + 0.5f * (_progress ? _progress() : 0.0f);
+    default:
+        return 1.0f;
+    }
+}
+
+Ref* LoadController::Request::getResource() const
+{
+    return _state == COMPLETE ? _resource : NULL;
+}
+
+void LoadController::Request::cancel()
+{
+    _cancelled = true;
+}
+
+LoadController::LoadController()
+    : _pendingCount(0), _batchCount(0), _finalizeBudget(LOAD_CONTROLLER_FINALIZE_BUDGET), _running(false)
+{
+}
+
+LoadController::~LoadController()
+{
+}
+
+void LoadController::initialize(unsigned int threadCount)
+{
+    _running = true;
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        _threads.push_back(new std::thread(&loaderThreadProc, this));
+    }
+}
+
+void LoadController::finalize()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _queuedCondition.notify_all();
+
+    for (size_t i = 0, count = _threads.size(); i < count; ++i)
+    {
+        _threads[i]->join();
+        SAFE_DELETE(_threads[i]);
+    }
+    _threads.clear();
+
+    // Drop the requests that are not finished, without calling their callbacks.
+    for (size_t i = 0, count = _queued.size(); i < count; ++i)
+    {
+        _queued[i]->_state = Request::CANCELLED;
+        SAFE_RELEASE(_queued[i]);
+    }
+    _queued.clear();
+    for (size_t i = 0, count = _loaded.size(); i < count; ++i)
+    {
+        _loaded[i]->_state = Request::CANCELLED;
+        SAFE_RELEASE(_loaded[i]);
+    }
+    _loaded.clear();
+    _pendingCount = 0;
+    _batchCount = 0;
+}
+
+void LoadController::update()
+{
+    double startTime = Game::getAbsoluteTime();
+    do
+    {
+        // The request stays queued until its last step is done. Only the main thread
+        // removes requests, so the front is still the same request after a step.
+        Request* request;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_loaded.empty())
+                return;
+            request = _loaded.front();
+        }
+        finalizeStep(request);
+    }
+    while (Game::getAbsoluteTime() - startTime < _finalizeBudget);
+}
+
+LoadController::Request* LoadController::load(const LoadFunction& load, const FinalizeFunction& finalize, const Callback& callback)
+{
+    FinalizeFunction finalizeOnce = finalize;
+    return loadSteps(load, [finalizeOnce](Ref** resource)
+    {
+        *resource = finalizeOnce ? finalizeOnce() : NULL;
+        return true;
+    }, nullptr, callback);
+}
+
+LoadController::Request* LoadController::loadSteps(const LoadFunction& load, const FinalizeStepFunction& finalize,
+                                                   const ProgressFunction& progress, const Callback& callback)
+{
+    Request* request = new Request();
+    request->_load = load;
+    request->_finalize = finalize;
+    request->_progress = progress;
+    request->_callback = callback;
+
+    // The controller holds a reference to the request until it is finalized.
+    request->addRef();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pendingCount++;
+        _batchCount++;
+        if (!_threads.empty())
+        {
+            _queued.push_back(request);
+            _queuedCondition.notify_one();
+            return request;
+        }
+    }
+
+    // Without loader threads, load the request right away and finalize it with the others.
+    loadRequest(request);
+    return request;
+}
+
+LoadController::Request* LoadController::loadImage(const char* path, const Callback& callback)
+{
+    GP_ASSERT(path);
+
+    std::shared_ptr<ImageLoad> data(new ImageLoad());
+    data->path = path;
+    return load([data]
+    {
+        data->image = Image::create(data->path.c_str());
+        return data->image != NULL;
+    },
+    [data]() -> Ref*
+    {
+        Image* image = data->image;
+        data->image = NULL;
+        return image;
+    }, callback);
+}
+
+LoadController::Request* LoadController::loadTexture(const char* path, bool generateMipmaps, const Callback& callback)
+{
+    GP_ASSERT(path);
+
+    std::shared_ptr<TextureLoad> data(new TextureLoad());
+    data->path = path;
+    data->generateMipmaps = generateMipmaps;
+
+    // The levels of a DDS or PVR file.
+    std::shared_ptr<Texture::FileData> file(new Texture::FileData());
+
+    // Textures that are already loaded are not read again.
+    data->texture = Texture::getCached(path);
+    return load([data, file]
+    {
+        if (data->texture)
+            return true;
+        if (hasExtension(data->path.c_str(), ".png"))
+        {
+            data->image = Image::create(data->path.c_str());
+            return data->image != NULL;
+        }
+        return Texture::readFile(data->path.c_str(), file.get());
+    },
+    [data, file]() -> Ref*
+    {
+        // The texture may have been loaded by another request in the meantime.
+        if (data->texture == NULL)
+            data->texture = Texture::getCached(data->path.c_str());
+        if (data->texture)
+        {
+            if (data->generateMipmaps)
+                data->texture->generateMipmaps();
+        }
+        else
+        {
+            if (data->image)
+                data->texture = Texture::create(data->image, data->generateMipmaps);
+            else
+                data->texture = Texture::create(file.get());
+            if (data->texture)
+                Texture::addToCache(data->path.c_str(), data->texture);
+        }
+        Texture* texture = data->texture;
+        data->texture = NULL;
+        return texture;
+    }, callback);
+}
+
+LoadController::Request* LoadController::loadEffect(const char* vshPath, const char* fshPath, const char* defines, const Callback& callback)
+{
+    GP_ASSERT(vshPath);
+    GP_ASSERT(fshPath);
+
+    std::shared_ptr<EffectLoad> data(new EffectLoad());
+    data->vshPath = vshPath;
+    data->fshPath = fshPath;
+    data->hasDefines = defines != NULL;
+    if (defines)
+        data->defines = defines;
+
+    // Effects that are already loaded are not read again.
+    data->effect = Effect::getCached(vshPath, fshPath, defines);
+    return load([data]
+    {
+        if (data->effect)
+            return true;
+        if (!Effect::readSource(data->vshPath.c_str(), &data->vshSource))
+        {
+            GP_ERROR("Failed to read vertex shader from file '%s'.", data->vshPath.c_str());
+            return false;
+        }
+        if (!Effect::readSource(data->fshPath.c_str(), &data->fshSource))
+        {
+            GP_ERROR("Failed to read fragment shader from file '%s'.", data->fshPath.c_str());
+            return false;
+        }
+        return true;
+    },
+    [data]() -> Ref*
+    {
+        const char* defines = data->hasDefines ? data->defines.c_str() : NULL;
+
+        // The effect may have been loaded by another request in the meantime.
+        if (data->effect == NULL)
+            data->effect = Effect::getCached(data->vshPath.c_str(), data->fshPath.c_str(), defines);
+        if (data->effect == NULL)
+        {
+            data->effect = Effect::createFromExpandedSource(data->vshPath.c_str(), data->vshSource,
+                                                            data->fshPath.c_str(), data->fshSource, defines);
+        }
+        Effect* effect = data->effect;
+        data->effect = NULL;
+        return effect;
+    }, callback);
+}
+
+LoadController::Request* LoadController::loadBundle(const char* path, const Callback& callback)
+{
+    GP_ASSERT(path);
+
+    std::shared_ptr<BundleLoad> data(new BundleLoad());
+    data->path = path;
+
+    // Bundles that are already loaded are not read again.
+    data->bundle = Bundle::getCached(path);
+    return load([data]
+    {
+        if (data->bundle)
+            return true;
+        data->bundle = Bundle::open(data->path.c_str());
+        data->opened = data->bundle != NULL;
+        return data->opened;
+    },
+    [data]() -> Ref*
+    {
+        // The bundle may have been loaded by another request in the meantime.
+        if (data->opened)
+            data->bundle = Bundle::addToCache(data->bundle);
+        Bundle* bundle = data->bundle;
+        data->bundle = NULL;
+        return bundle;
+    }, callback);
+}
+
+LoadController::Request* LoadController::loadScene(const char* path, const Callback& callback)
+{
+    GP_ASSERT(path);
+
+    std::string filePath;
+    std::string id;
+    splitPath(path, &filePath, &id);
+    if (!hasExtension(filePath.c_str(), ".gpb"))
+    {
+        std::shared_ptr<SceneLoad> data(new SceneLoad());
+        data->path = filePath;
+        return load([data]
+        {
+            // Parse a JSON scene, or read a binary one ahead, so that only the objects
+            // are created on the main thread.
+            data->reader = Serializer::createReader(data->path.c_str());
+            if (data->reader == NULL)
+                return false;
+            return data->reader->getFormat() != Serializer::BINARY || readAhead(data->path.c_str());
+        },
+        [data]() -> Ref*
+        {
+            Scene* scene = dynamic_cast<Scene*>(data->reader->readObject(NULL));
+            SAFE_DELETE(data->reader);
+            return scene;
+        }, callback);
+    }
+
+    std::shared_ptr<Bundle::StepLoad> data(Bundle::beginLoad(filePath.c_str(), id.c_str(), false));
+    return loadSteps([data]
+    {
+        return Bundle::prepareLoad(data.get());
+    },
+    [data](Ref** resource)
+    {
+        return Bundle::loadStep(data.get(), resource);
+    },
+    [data]
+    {
+        return Bundle::getLoadProgress(data.get());
+    }, callback);
+}
+
+LoadController::Request* LoadController::loadNode(const char* path, const Callback& callback)
+{
+    GP_ASSERT(path);
+
+    std::string filePath;
+    std::string id;
+    splitPath(path, &filePath, &id);
+    if (id.empty())
+    {
+        GP_WARN("No node id in path '%s'.", path);
+        return load(nullptr, nullptr, callback);
+    }
+
+    std::shared_ptr<Bundle::StepLoad> data(Bundle::beginLoad(filePath.c_str(), id.c_str(), true));
+    return loadSteps([data]
+    {
+        return Bundle::prepareLoad(data.get());
+    },
+    [data](Ref** resource)
+    {
+        return Bundle::loadStep(data.get(), resource);
+    },
+    [data]
+    {
+        return Bundle::getLoadProgress(data.get());
+    }, callback);
+}
+
+void LoadController::wait(Request* request)
+{
+    GP_ASSERT(request);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    // Load the request here if no loader thread has picked it up yet.
+    std::deque<Request*>::iterator itr = std::find(_queued.begin(), _queued.end(), request);
+    if (itr != _queued.end())
+    {
+        _queued.erase(itr);
+        lock.unlock();
+        loadRequest(request);
+        lock.lock();
+    }
+
+    // Wait for a loader thread to load it, unless it is already finalized.
+    _loadedCondition.wait(lock, [this, request]
+    {
+        return request->isDone() || std::find(_loaded.begin(), _loaded.end(), request) != _loaded.end();
+    });
+    itr = std::find(_loaded.begin(), _loaded.end(), request);
+    if (itr != _loaded.end())
+    {
+        lock.unlock();
+        finalizeRequest(request);
+    }
+}
+
+float LoadController::getFinalizeBudget() const
+{
+    return _finalizeBudget;
+}
+
+void LoadController::setFinalizeBudget(float budget)
+{
+    _finalizeBudget = budget;
+}
+
+unsigned int LoadController::getPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _pendingCount;
+}
+
+float LoadController::getProgress() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_batchCount == 0)
+        return 1.0f;
+
+    // Loaded requests are halfway done, and further along as their finalize steps are done.
+    float done = (float)(_batchCount - _pendingCount);
+    for (size_t i = 0, count = _loaded.size(); i < count; ++i)
+    {
+        done += _loaded[i]->getProgress();
+    }
+    return done / (float)_batchCount;
+}
+
+void LoadController::loadRequest(Request* request)
+{
+    GP_ASSERT(request);
+
+    if (!request->_cancelled)
+    {
+        request->_state = Request::LOADING;
+        request->_loadResult = request->_load ? request->_load() : true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        request->_state = Request::LOADED;
+        _loaded.push_back(request);
+    }
+    _loadedCondition.notify_all();
+}
+
+bool LoadController::finalizeStep(Request* request)
+{
+    GP_ASSERT(request);
+
+    if (!request->_cancelled && request->_loadResult && request->_finalize)
+    {
+        if (!request->_finalize(&request->_resource))
+            return false;
+    }
+
+    Request::State state = Request::FAILED;
+    if (request->_cancelled)
+    {
+        state = Request::CANCELLED;
+        SAFE_RELEASE(request->_resource);
+    }
+    else if (request->_resource)
+    {
+        state = Request::COMPLETE;
+    }
+
+    // Free the data shared by the load and finalize functions.
+    request->_load = nullptr;
+    request->_finalize = nullptr;
+    request->_progress = nullptr;
+    Callback callback;
+    callback.swap(request->_callback);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::deque<Request*>::iterator itr = std::find(_loaded.begin(), _loaded.end(), request);
+        GP_ASSERT(itr != _loaded.end());
+        _loaded.erase(itr);
+        request->_state = state;
+        _pendingCount--;
+        if (_pendingCount == 0)
+            _batchCount = 0;
+    }
+    _loadedCondition.notify_all();
+
+    if (callback)
+        callback(request);
+    request->release();
+    return true;
+}
+
+void LoadController::finalizeRequest(Request* request)
+{
+    GP_ASSERT(request);
+
+    while (!finalizeStep(request))
+    {
+    }
+}
+
+void LoadController::loaderThreadProc(LoadController* controller)
+{
+    GP_ASSERT(controller);
+
+    for (;;)
+    {
+        Request* request;
+        {
+            std::unique_lock<std::mutex> lock(controller->_mutex);
+            controller->_queuedCondition.wait(lock, [controller]
+            {
+                return !controller->_running || !controller->_queued.empty();
+            });
+            if (!controller->_running)
+                return;
+            request = controller->_queued.front();
+            controller->_queued.pop_front();
+        }
+        controller->loadRequest(request);
+    }
+}
+
+}
@@ -0,0 +1,375 @@
+#ifndef LOADCONTROLLER_H_
+#define LOADCONTROLLER_H_
+
+#include "Ref.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a class for loading resources in the background.
+ *
+ * Loading a resource is split in two steps. The files are read, decoded and parsed on
+ * loader threads, which are separate from the worker threads of the JobController so
+ * that long file reads never hold up the parallel work of a frame. The resource is then
+ * finalized on the main thread, where its graphics objects are created and it is added
+ * to the resource caches. The game finalizes loaded requests once per frame, and stops
+ * when the finalize budget for the frame is spent, so that a large batch of loads is
+ * spread over several frames instead of stalling one. Scenes and nodes are finalized in
+ * steps, a mesh or a top level node at a time, so that a large scene is spread over
+ * several frames too.
+ *
+ * Each load returns a request that reports its state and progress, and holds the
+ * resource once it is complete. A callback may also be given, which is called on the
+ * main thread when the request finishes.
+ */
+class LoadController
+{
+    friend class Game;
+
+public:
+
+    /**
+     * Defines a request to load a resource in the background.
+     */
+    class Request : public Ref
+    {
+        friend class LoadController;
+
+    public:
+
+        /**
+         * The state of a request.
+         */
+        enum State
+        {
+            QUEUED,
+            LOADING,
+            LOADED,
+            COMPLETE,
+            FAILED,
+            CANCELLED
+        };
+
+        /**
+         * Gets the state of the request.
+         *
+         * @return The state of the request.
+         */
+        State getState() const;
+
+        /**
+         * Determines whether the request is finished, whether it completed, failed or was cancelled.
+         *
+         * @return true if the request is finished, false otherwise.
+         */
+        bool isDone() const;
+
+        /**
+         * Gets the progress of the request, from 0 when it is queued to 1 when it is finished.
+         *
+         * A loaded request is halfway done. Scenes and nodes loaded from a bundle then move
+         * towards 1 as their finalize steps are done. This must be called from the main thread.
+         *
+         * @return The progress of the request.
+         */
+        float getProgress() const;
+
+        /**
+         * Gets the loaded resource.
+         *
+         * The request holds a reference to the resource, which is released when the request
+         * is destroyed. Add a reference to the resource to keep it past the request.
+         *
+         * @return The resource, or NULL if the request is not complete.
+         */
+        Ref* getResource() const;
+
+        /**
+         * Cancels the request.
+         *
+         * A request that is being loaded is cancelled once its load step finishes. The
+         * callback of a cancelled request is still called.
+         */
+        void cancel();
+
+    private:
+
+        /**
+         * Constructor.
+         */
+        Request();
+
+        /**
+         * Destructor.
+         */
+        ~Request();
+
+        /**
+         * Hidden copy constructor.
+         */
+        Request(const Request& copy);
+
+        /**
+         * Hidden copy assignment operator.
+         */
+        Request& operator=(const Request&);
+
+        std::atomic<int> _state;
+        std::atomic<bool> _cancelled;
+        bool _loadResult;
+        std::function<bool()> _load;
+        std::function<bool(Ref**)> _finalize;
+        std::function<float()> _progress;
+        std::function<void(Request*)> _callback;
+        Ref* _resource;
+    };
+
+    /**
+     * Function that reads and decodes the data of a resource, called on a loader thread.
+     * It must not use the graphics API or the resource caches, and returns false on failure.
+     */
+    typedef std::function<bool()> LoadFunction;
+
+    /**
+     * Function that creates a resource from the decoded data, called on the main thread.
+     * It returns the new resource, with a reference owned by the request, or NULL on failure.
+     */
+    typedef std::function<Ref*()> FinalizeFunction;
+
+    /**
+     * Function called on the main thread when a request finishes.
+     */
+    typedef std::function<void(Request*)> Callback;
+
+    /**
+     * Destructor.
+     */
+    ~LoadController();
+
+    /**
+     * Queues a request to load a resource with the given functions.
+     *
+     * @param load The function that reads and decodes the data of the resource on a loader thread.
+     * @param finalize The function that creates the resource on the main thread.
+     * @param callback Optional function called on the main thread when the request finishes.
+     *
+     * @return The new request.
+     * @script{create}
+     */
+    Request* load(const LoadFunction& load, const FinalizeFunction& finalize, const Callback& callback = nullptr);
+
+    /**
+     * Queues a request to load an image. The resource of the request is an Image.
+     *
+     * @param path The path of the PNG file.
+     * @param callback Optional function called on the main thread when the request finishes.
+     *
+     * @return The new request.
+     * @script{create}
+     */
+    Request* loadImage(const char* path, const Callback& callback = nullptr);
+
+    /**
+     * Queues a request to load a texture. The resource of the request is a Texture.
+     *
+     * PNG, DDS and PVR files are read and decoded on a loader thread, and only the
+     * texture object is created when the request is finalized.
+     *
+     * @param path The path of the texture file.
+     * @param generateMipmaps true to generate a full mipmap chain, false otherwise.
+     * @param callback Optional function called on the main thread when the request finishes.
+     *
+     * @return The new request.
+     * @script{create}
+     */
+    Request* loadTexture(const char* path, bool generateMipmaps = false, const Callback& callback = nullptr);
+
+    /**
+     * Queues a request to load an effect. The resource of the request is an Effect.
+     *
+     * The shader files are read and their includes are expanded on a loader thread,
+     * and the shaders are compiled when the effect is created.
+     *
+     * @param vshPath The path to the vertex shader file.
+     * @param fshPath The path to the fragment shader file.
+     * @param defines A new-line delimited list of preprocessor defines.
+     * @param callback Optional function called on the main thread when the request finishes.
+     *
+     * @return The new request.
+     * @script{create}
+     */
+    Request* loadEffect(const char* vshPath, const char* fshPath, const char* defines = NULL, const Callback& callback = nullptr);
+
+    /**
+     * Queues a request to load a bundle. The resource of the request is a Bundle.
+     *
+     * The header and reference table of the bundle are read on a loader thread. Scenes and
+     * nodes loaded from the bundle while a reference to it is held share it, rather than
+     * reading it again.
+     *
+     * @param path The path of the .gpb bundle.
+     * @param callback Optional function called on the main thread when the request finishes.
+     *
+     * @return The new request.
+     * @script{create}
+     */
+    Request* loadBundle(const char* path, const Callback& callback = nullptr);
+
+    /**
+     * Queues a request to load a scene. The resource of the request is a Scene.
+     *
+     * The meshes and animations of a .gpb bundle are read on a loader thread, and the
+     * meshes are created and the nodes built when the request is finalized, in steps.
+     * Other scene files are parsed on a loader thread, and their objects are created when
+     * the request is finalized. Paths to a .gpb bundle may end with '#' and the id of the scene in the
+     * bundle; the first scene of the bundle is loaded otherwise.
+     *
+     * @param path The path of the scene file or bundle.
+     * @param callback Optional function called on the main thread when the request finishes.
+     *
+     * @return The new request.
+     * @script{create}
+     */
+    Request* loadScene(const char* path, const Callback& callback = nullptr);
+
+    /**
+     * Queues a request to load a node and its children from a bundle. The resource of the
+     * request is a Node.
+     *
+     * The meshes and animations of the bundle are read on a loader thread, and the meshes
+     * are created and the node built when the request is finalized, in steps.
+     *
+     * @param path The path of the .gpb bundle, followed by '#' and the id of the node.
+     * @param callback Optional function called on the main thread when the request finishes.
+     *
+     * @return The new request.
+     * @script{create}
+     */
+    Request* loadNode(const char* path, const Callback& callback = nullptr);
+
+    /**
+     * Waits for a request to finish, loading and finalizing it on the calling thread
+     * if it has not been picked up by a loader thread yet.
+     *
+     * This must be called from the main thread.
+     *
+     * @param request The request to wait for.
+     */
+    void wait(Request* request);
+
+    /**
+     * Gets the time spent finalizing loaded requests in a frame, in milliseconds.
+     *
+     * @return The finalize budget.
+     */
+    float getFinalizeBudget() const;
+
+    /**
+     * Sets the time spent finalizing loaded requests in a frame, in milliseconds.
+     *
+     * At least one request is finalized each frame, however long it takes.
+     *
+     * @param budget The finalize budget.
+     */
+    void setFinalizeBudget(float budget);
+
+    /**
+     * Gets the number of requests that are not finished.
+     *
+     * @return The number of pending requests.
+     */
+    unsigned int getPendingCount() const;
+
+    /**
+     * Gets the progress of the requests queued since the controller was last idle,
+     * from 0 to 1. This is 1 when no request is pending.
+     *
+     * @return The overall progress of the requests.
+     */
+    float getProgress() const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    LoadController();
+
+    /**
+     * Constructor.
+     */
+    LoadController(const LoadController& copy);
+
+    /**
+     * Controller initialize.
+     *
+     * @param threadCount The number of loader threads to start.
+     */
+    void initialize(unsigned int threadCount);
+
+    /**
+     * Controller finalize.
+     */
+    void finalize();
+
+    /**
+     * Finalizes loaded requests until the finalize budget is spent.
+     */
+    void update();
+
+    /**
+     * Function that creates a resource from the decoded data a step at a time, called on the
+     * main thread until it returns true. It then sets the new resource, with a reference owned
+     * by the request, or leaves it NULL on failure.
+     */
+    typedef std::function<bool(Ref** resource)> FinalizeStepFunction;
+
+    /**
+     * Function that returns the fraction of the finalize steps of a request that are done,
+     * from 0 to 1, called on the main thread.
+     */
+    typedef std::function<float()> ProgressFunction;
+
+    /**
+     * Queues a request to load a resource that is finalized in steps, with an optional
+     * function that reports the steps done.
+     */
+    Request* loadSteps(const LoadFunction& load, const FinalizeStepFunction& finalize,
+                       const ProgressFunction& progress, const Callback& callback);
+
+    /**
+     * Runs the load step of a request, and queues it for finalizing.
+     */
+    void loadRequest(Request* request);
+
+    /**
+     * Runs a finalize step of a loaded request. Once its last step is done, this calls
+     * its callback and releases it.
+     *
+     * @return true if the request is finished, false if more steps remain.
+     */
+    bool finalizeStep(Request* request);
+
+    /**
+     * Runs the remaining finalize steps of a loaded request, calls its callback and releases it.
+     */
+    void finalizeRequest(Request* request);
+
+    static void loaderThreadProc(LoadController* controller);
+
+    std::vector<std::thread*> _threads;
+    std::deque<Request*> _queued;
+    std::deque<Request*> _loaded;
+    mutable std::mutex _mutex;
+    std::condition_variable _queuedCondition;
+    std::condition_variable _loadedCondition;
+    unsigned int _pendingCount;
+    unsigned int _batchCount;
+    float _finalizeBudget;
+    bool _running;
+};
+
+}
+
+#endif
@@ -12,6 +12,7 @@ class MathUtil
 {
     friend class Matrix;
     friend class Vector3;
+    friend class MeshSkin;
 
 public:
 
@@ -56,6 +57,10 @@ private:
 
     inline static void multiplyMatrix(const float* m1, const float* m2, float* dst);
 
+    inline static void multiplyMatrixArray(const float* m, const float* array, float* dst, unsigned int count);
+
+    inline static void multiplyMatrixPalette(const float* m1, const float* m2, float* dst);
+
     inline static void negateMatrix(const float* m, float* dst);
 
     inline static void transposeMatrix(const float* m, float* dst);
@@ -64,6 +69,10 @@ private:
 
     inline static void transformVector4(const float* m, const float* v, float* dst);
 
+    inline static void transformVector4Array(const float* m, const float* v, float* dst, unsigned int count);
+
+    inline static void transformPointArray(const float* m, const float* v, float* dst, unsigned int count);
+
     inline static void crossVector3(const float* v1, const float* v2, float* dst);
 
     MathUtil();
@@ -73,8 +82,16 @@ private:
 
 #define MATRIX_SIZE ( sizeof(float) * 16)
 
-#ifdef GP_USE_NEON
+// Use the SSE (and, when compiling for it, AVX) kernels on x86 unless GP_NO_SSE is defined.
+#if !defined(GP_USE_NEON) && !defined(GP_USE_SSE) && !defined(GP_NO_SSE) && \
+    (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define GP_USE_SSE
+#endif
+
+#if defined(GP_USE_NEON)
 #include "MathUtilNeon.inl"
+#elif defined(GP_USE_SSE)
+#include "MathUtilSSE.inl"
 #else
 #include "MathUtil.inl"
 #endif
@@ -123,6 +123,25 @@ inline void MathUtil::multiplyMatrix(const float* m1, const float* m2, float* ds
     );
 }
 
+inline void MathUtil::multiplyMatrixArray(const float* m, const float* array, float* dst, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        multiplyMatrix(m, &array[i * 16], &dst[i * 16]);
+    }
+}
+
+inline void MathUtil::multiplyMatrixPalette(const float* m1, const float* m2, float* dst)
+{
+    // The first three rows of the product, one after the other.
+    float product[16];
+    multiplyMatrix(m1, m2, product);
+
+    dst[0]  = product[0]; dst[1]  = product[4]; dst[2]  = product[8];  dst[3]  = product[12];
+    dst[4]  = product[1]; dst[5]  = product[5]; dst[6]  = product[9];  dst[7]  = product[13];
+    dst[8]  = product[2]; dst[9]  = product[6]; dst[10] = product[10]; dst[11] = product[14];
+}
+
 inline void MathUtil::negateMatrix(const float* m, float* dst)
 {
     asm volatile(
@@ -201,6 +220,22 @@ inline void MathUtil::transformVector4(const float* m, const float* v, float* ds
     );
 }
 
+inline void MathUtil::transformVector4Array(const float* m, const float* v, float* dst, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        transformVector4(m, &v[i * 4], &dst[i * 4]);
+    }
+}
+
+inline void MathUtil::transformPointArray(const float* m, const float* v, float* dst, unsigned int count)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        transformVector4(m, v[i * 3], v[i * 3 + 1], v[i * 3 + 2], 1.0f, &dst[i * 3]);
+    }
+}
+
 inline void MathUtil::crossVector3(const float* v1, const float* v2, float* dst)
 {
     asm volatile(
@@ -0,0 +1,308 @@
+#include <xmmintrin.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+namespace gameplay
+{
+
+inline void MathUtil::addMatrix(const float* m, float scalar, float* dst)
+{
+#ifdef __AVX__
+    __m256 s = _mm256_set1_ps(scalar);
+    _mm256_storeu_ps(&dst[0], _mm256_add_ps(_mm256_loadu_ps(&m[0]), s));
+    _mm256_storeu_ps(&dst[8], _mm256_add_ps(_mm256_loadu_ps(&m[8]), s));
+#else
+    __m128 s = _mm_set1_ps(scalar);
+    _mm_storeu_ps(&dst[0],  _mm_add_ps(_mm_loadu_ps(&m[0]),  s));
+    _mm_storeu_ps(&dst[4],  _mm_add_ps(_mm_loadu_ps(&m[4]),  s));
+    _mm_storeu_ps(&dst[8],  _mm_add_ps(_mm_loadu_ps(&m[8]),  s));
+    _mm_storeu_ps(&dst[12], _mm_add_ps(_mm_loadu_ps(&m[12]), s));
+#endif
+}
+
+inline void MathUtil::addMatrix(const float* m1, const float* m2, float* dst)
+{
+#ifdef __AVX__
+    _mm256_storeu_ps(&dst[0], _mm256_add_ps(_mm256_loadu_ps(&m1[0]), _mm256_loadu_ps(&m2[0])));
+    _mm256_storeu_ps(&dst[8], _mm256_add_ps(_mm256_loadu_ps(&m1[8]), _mm256_loadu_ps(&m2[8])));
+#else
+    _mm_storeu_ps(&dst[0],  _mm_add_ps(_mm_loadu_ps(&m1[0]),  _mm_loadu_ps(&m2[0])));
+    _mm_storeu_ps(&dst[4],  _mm_add_ps(_mm_loadu_ps(&m1[4]),  _mm_loadu_ps(&m2[4])));
+    _mm_storeu_ps(&dst[8],  _mm_add_ps(_mm_loadu_ps(&m1[8]),  _mm_loadu_ps(&m2[8])));
+    _mm_storeu_ps(&dst[12], _mm_add_ps(_mm_loadu_ps(&m1[12]), _mm_loadu_ps(&m2[12])));
+#endif
+}
+
+inline void MathUtil::subtractMatrix(const float* m1, const float* m2, float* dst)
+{
+#ifdef __AVX__
+    _mm256_storeu_ps(&dst[0], _mm256_sub_ps(_mm256_loadu_ps(&m1[0]), _mm256_loadu_ps(&m2[0])));
+    _mm256_storeu_ps(&dst[8], _mm256_sub_ps(_mm256_loadu_ps(&m1[8]), _mm256_loadu_ps(&m2[8])));
+#else
+    _mm_storeu_ps(&dst[0],  _mm_sub_ps(_mm_loadu_ps(&m1[0]),  _mm_loadu_ps(&m2[0])));
+    _mm_storeu_ps(&dst[4],  _mm_sub_ps(_mm_loadu_ps(&m1[4]),  _mm_loadu_ps(&m2[4])));
+    _mm_storeu_ps(&dst[8],  _mm_sub_ps(_mm_loadu_ps(&m1[8]),  _mm_loadu_ps(&m2[8])));
+    _mm_storeu_ps(&dst[12], _mm_sub_ps(_mm_loadu_ps(&m1[12]), _mm_loadu_ps(&m2[12])));
+#endif
+}
+
+inline void MathUtil::multiplyMatrix(const float* m, float scalar, float* dst)
+{
+#ifdef __AVX__
+    __m256 s = _mm256_set1_ps(scalar);
+    _mm256_storeu_ps(&dst[0], _mm256_mul_ps(_mm256_loadu_ps(&m[0]), s));
+    _mm256_storeu_ps(&dst[8], _mm256_mul_ps(_mm256_loadu_ps(&m[8]), s));
+#else
+    __m128 s = _mm_set1_ps(scalar);
+    _mm_storeu_ps(&dst[0],  _mm_mul_ps(_mm_loadu_ps(&m[0]),  s));
+    _mm_storeu_ps(&dst[4],  _mm_mul_ps(_mm_loadu_ps(&m[4]),  s));
+    _mm_storeu_ps(&dst[8],  _mm_mul_ps(_mm_loadu_ps(&m[8]),  s));
+    _mm_storeu_ps(&dst[12], _mm_mul_ps(_mm_loadu_ps(&m[12]), s));
+#endif
+}
+
+inline void MathUtil::multiplyMatrix(const float* m1, const float* m2, float* dst)
+{
+    // Each column of the product is a linear combination of the columns of m1, weighted
+    // by the matching column of m2. Both operands are loaded before anything is stored,
+    // which supports the case where m1 or m2 is the same array as dst.
+#ifdef __AVX__
+    // Two columns of the product at a time: every 128-bit lane holds one column.
+    __m256 c0 = _mm256_broadcast_ps((const __m128*)&m1[0]);
+    __m256 c1 = _mm256_broadcast_ps((const __m128*)&m1[4]);
+    __m256 c2 = _mm256_broadcast_ps((const __m128*)&m1[8]);
+    __m256 c3 = _mm256_broadcast_ps((const __m128*)&m1[12]);
+    __m256 b01 = _mm256_loadu_ps(&m2[0]);
+    __m256 b23 = _mm256_loadu_ps(&m2[8]);
+
+    __m256 r01 = _mm256_mul_ps(c0, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(0, 0, 0, 0)));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(c1, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(1, 1, 1, 1))));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(c2, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(2, 2, 2, 2))));
+    r01 = _mm256_add_ps(r01, _mm256_mul_ps(c3, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(3, 3, 3, 3))));
+
+    __m256 r23 = _mm256_mul_ps(c0, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(0, 0, 0, 0)));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(c1, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(1, 1, 1, 1))));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(c2, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(2, 2, 2, 2))));
+    r23 = _mm256_add_ps(r23, _mm256_mul_ps(c3, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(3, 3, 3, 3))));
+
+    _mm256_storeu_ps(&dst[0], r01);
+    _mm256_storeu_ps(&dst[8], r23);
+#else
+    __m128 c0 = _mm_loadu_ps(&m1[0]);
+    __m128 c1 = _mm_loadu_ps(&m1[4]);
+    __m128 c2 = _mm_loadu_ps(&m1[8]);
+    __m128 c3 = _mm_loadu_ps(&m1[12]);
+    __m128 r[4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128 b = _mm_loadu_ps(&m2[i * 4]);
+        __m128 v = _mm_mul_ps(c0, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 0, 0, 0)));
+        v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 1, 1))));
+        v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 2, 2))));
+        v = _mm_add_ps(v, _mm_mul_ps(c3, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 3, 3))));
+        r[i] = v;
+    }
+
+    _mm_storeu_ps(&dst[0],  r[0]);
+    _mm_storeu_ps(&dst[4],  r[1]);
+    _mm_storeu_ps(&dst[8],  r[2]);
+    _mm_storeu_ps(&dst[12], r[3]);
+#endif
+}
+
+inline void MathUtil::multiplyMatrixArray(const float* m, const float* array, float* dst, unsigned int count)
+{
+    // The columns of m stay in registers for the whole array.
+#ifdef __AVX__
+    __m256 c0 = _mm256_broadcast_ps((const __m128*)&m[0]);
+    __m256 c1 = _mm256_broadcast_ps((const __m128*)&m[4]);
+    __m256 c2 = _mm256_broadcast_ps((const __m128*)&m[8]);
+    __m256 c3 = _mm256_broadcast_ps((const __m128*)&m[12]);
+
+    for (unsigned int i = 0; i < count; ++i, array += 16, dst += 16)
+    {
+        __m256 b01 = _mm256_loadu_ps(&array[0]);
+        __m256 b23 = _mm256_loadu_ps(&array[8]);
+
+        __m256 r01 = _mm256_mul_ps(c0, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(0, 0, 0, 0)));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(c1, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(1, 1, 1, 1))));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(c2, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(2, 2, 2, 2))));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(c3, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(3, 3, 3, 3))));
+
+        __m256 r23 = _mm256_mul_ps(c0, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(0, 0, 0, 0)));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(c1, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(1, 1, 1, 1))));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(c2, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(2, 2, 2, 2))));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(c3, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(3, 3, 3, 3))));
+
+        _mm256_storeu_ps(&dst[0], r01);
+        _mm256_storeu_ps(&dst[8], r23);
+    }
+#else
+    __m128 c0 = _mm_loadu_ps(&m[0]);
+    __m128 c1 = _mm_loadu_ps(&m[4]);
+    __m128 c2 = _mm_loadu_ps(&m[8]);
+    __m128 c3 = _mm_loadu_ps(&m[12]);
+
+    for (unsigned int i = 0; i < count; ++i, array += 16, dst += 16)
+    {
+        __m128 r[4];
+        for (int j = 0; j < 4; ++j)
+        {
+            __m128 b = _mm_loadu_ps(&array[j * 4]);
+            __m128 v = _mm_mul_ps(c0, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 0, 0, 0)));
+            v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 1, 1))));
+            v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 2, 2))));
+            v = _mm_add_ps(v, _mm_mul_ps(c3, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 3, 3))));
+            r[j] = v;
+        }
+        _mm_storeu_ps(&dst[0],  r[0]);
+        _mm_storeu_ps(&dst[4],  r[1]);
+        _mm_storeu_ps(&dst[8],  r[2]);
+        _mm_storeu_ps(&dst[12], r[3]);
+    }
+#endif
+}
+
+inline void MathUtil::multiplyMatrixPalette(const float* m1, const float* m2, float* dst)
+{
+    // The columns of the product are transposed in registers, and the first three rows stored.
+    __m128 c0 = _mm_loadu_ps(&m1[0]);
+    __m128 c1 = _mm_loadu_ps(&m1[4]);
+    __m128 c2 = _mm_loadu_ps(&m1[8]);
+    __m128 c3 = _mm_loadu_ps(&m1[12]);
+    __m128 r[4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128 b = _mm_loadu_ps(&m2[i * 4]);
+        __m128 v = _mm_mul_ps(c0, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 0, 0, 0)));
+        v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 1, 1))));
+        v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 2, 2))));
+        v = _mm_add_ps(v, _mm_mul_ps(c3, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 3, 3))));
+        r[i] = v;
+    }
+
+    _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+
+    _mm_storeu_ps(&dst[0], r[0]);
+    _mm_storeu_ps(&dst[4], r[1]);
+    _mm_storeu_ps(&dst[8], r[2]);
+}
+
+inline void MathUtil::negateMatrix(const float* m, float* dst)
+{
+#ifdef __AVX__
+    __m256 sign = _mm256_set1_ps(-0.0f);
+    _mm256_storeu_ps(&dst[0], _mm256_xor_ps(_mm256_loadu_ps(&m[0]), sign));
+    _mm256_storeu_ps(&dst[8], _mm256_xor_ps(_mm256_loadu_ps(&m[8]), sign));
+#else
+    __m128 sign = _mm_set1_ps(-0.0f);
+    _mm_storeu_ps(&dst[0],  _mm_xor_ps(_mm_loadu_ps(&m[0]),  sign));
+    _mm_storeu_ps(&dst[4],  _mm_xor_ps(_mm_loadu_ps(&m[4]),  sign));
+    _mm_storeu_ps(&dst[8],  _mm_xor_ps(_mm_loadu_ps(&m[8]),  sign));
+    _mm_storeu_ps(&dst[12], _mm_xor_ps(_mm_loadu_ps(&m[12]), sign));
+#endif
+}
+
+inline void MathUtil::transposeMatrix(const float* m, float* dst)
+{
+    __m128 c0 = _mm_loadu_ps(&m[0]);
+    __m128 c1 = _mm_loadu_ps(&m[4]);
+    __m128 c2 = _mm_loadu_ps(&m[8]);
+    __m128 c3 = _mm_loadu_ps(&m[12]);
+
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    _mm_storeu_ps(&dst[0],  c0);
+    _mm_storeu_ps(&dst[4],  c1);
+    _mm_storeu_ps(&dst[8],  c2);
+    _mm_storeu_ps(&dst[12], c3);
+}
+
+inline void MathUtil::transformVector4(const float* m, float x, float y, float z, float w, float* dst)
+{
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(&m[0]), _mm_set1_ps(x));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(&m[4]), _mm_set1_ps(y)));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(&m[8]), _mm_set1_ps(z)));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(&m[12]), _mm_set1_ps(w)));
+
+    // Only three components are written, since dst is usually a Vector3.
+    float t[4];
+    _mm_storeu_ps(t, v);
+    dst[0] = t[0];
+    dst[1] = t[1];
+    dst[2] = t[2];
+}
+
+inline void MathUtil::transformVector4(const float* m, const float* v, float* dst)
+{
+    // Handle case where v == dst: v is fully loaded before dst is written.
+    __m128 b = _mm_loadu_ps(v);
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(&m[0]), _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&m[4]), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&m[8]), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 2, 2))));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&m[12]), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 3, 3))));
+    _mm_storeu_ps(dst, r);
+}
+
+inline void MathUtil::transformVector4Array(const float* m, const float* v, float* dst, unsigned int count)
+{
+    __m128 c0 = _mm_loadu_ps(&m[0]);
+    __m128 c1 = _mm_loadu_ps(&m[4]);
+    __m128 c2 = _mm_loadu_ps(&m[8]);
+    __m128 c3 = _mm_loadu_ps(&m[12]);
+
+    for (unsigned int i = 0; i < count; ++i, v += 4, dst += 4)
+    {
+        __m128 b = _mm_loadu_ps(v);
+        __m128 r = _mm_mul_ps(c0, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 0, 0, 0)));
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 1, 1, 1))));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 2, 2))));
+        r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 3, 3))));
+        _mm_storeu_ps(dst, r);
+    }
+}
+
+inline void MathUtil::transformPointArray(const float* m, const float* v, float* dst, unsigned int count)
+{
+    __m128 c0 = _mm_loadu_ps(&m[0]);
+    __m128 c1 = _mm_loadu_ps(&m[4]);
+    __m128 c2 = _mm_loadu_ps(&m[8]);
+    __m128 c3 = _mm_loadu_ps(&m[12]);
+
+    for (unsigned int i = 0; i < count; ++i, v += 3, dst += 3)
+    {
+        // Points are three floats apart, so they are loaded and stored one component
+        // at a time to stay within the arrays and to support the case where v == dst.
+        __m128 r = _mm_add_ps(c3, _mm_mul_ps(c0, _mm_set1_ps(v[0])));
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(v[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(v[2])));
+
+        float t[4];
+        _mm_storeu_ps(t, r);
+        dst[0] = t[0];
+        dst[1] = t[1];
+        dst[2] = t[2];
+    }
+}
+
+inline void MathUtil::crossVector3(const float* v1, const float* v2, float* dst)
+{
+    __m128 a = _mm_set_ps(0.0f, v1[2], v1[1], v1[0]);
+    __m128 b = _mm_set_ps(0.0f, v2[2], v2[1], v2[0]);
+
+    // (a.yzx * b.zxy) - (a.zxy * b.yzx)
+    __m128 r = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2))),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1))));
+
+    float t[4];
+    _mm_storeu_ps(t, r);
+    dst[0] = t[0];
+    dst[1] = t[1];
+    dst[2] = t[2];
+}
+
+}
@@ -734,6 +734,15 @@ void Matrix::multiply(const Matrix& m1, const Matrix& m2, Matrix* dst)
     MathUtil::multiplyMatrix(m1.m, m2.m, dst->m);
 }
 
+void Matrix::multiply(const Matrix& m, const Matrix* array, unsigned int count, Matrix* dst)
+{
+    GP_ASSERT(array || count == 0);
+    GP_ASSERT(dst || count == 0);
+
+    if (count > 0)
+        MathUtil::multiplyMatrixArray(m.m, array[0].m, dst[0].m, count);
+}
+
 void Matrix::negate()
 {
     negate(this);
@@ -934,6 +943,24 @@ void Matrix::transformVector(const Vector4& vector, Vector4* dst) const
     MathUtil::transformVector4(m, (const float*) &vector, (float*)dst);
 }
 
+void Matrix::transformVector(const Vector4* vectors, unsigned int count, Vector4* dst) const
+{
+    GP_ASSERT(vectors || count == 0);
+    GP_ASSERT(dst || count == 0);
+
+    if (count > 0)
+        MathUtil::transformVector4Array(m, (const float*)vectors, (float*)dst, count);
+}
+
+void Matrix::transformPoint(const Vector3* points, unsigned int count, Vector3* dst) const
+{
+    GP_ASSERT(points || count == 0);
+    GP_ASSERT(dst || count == 0);
+
+    if (count > 0)
+        MathUtil::transformPointArray(m, (const float*)points, (float*)dst, count);
+}
+
 void Matrix::translate(float x, float y, float z)
 {
     translate(x, y, z, this);
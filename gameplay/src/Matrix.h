@@ -527,6 +527,19 @@ public:
      */
     static void multiply(const Matrix& m1, const Matrix& m2, Matrix* dst);
 
+    /**
+     * Multiplies m by each matrix of the given array and stores the results in dst.
+     *
+     * This gives the same results as calling multiply(m, array[i], &dst[i]) for each
+     * matrix, but is faster for large arrays. dst may be the same array as array.
+     *
+     * @param m The matrix to multiply each matrix of the array by.
+     * @param array The array of matrices to multiply.
+     * @param count The number of matrices in the array.
+     * @param dst An array of at least count matrices to store the results in.
+     */
+    static void multiply(const Matrix& m, const Matrix* array, unsigned int count, Matrix* dst);
+
     /**
      * Negates this matrix.
      */
@@ -810,6 +823,24 @@ public:
      */
     void transformVector(const Vector4& vector, Vector4* dst) const;
 
+    /**
+     * Transforms each vector of the given array by this matrix.
+     *
+     * @param vectors The array of vectors to transform.
+     * @param count The number of vectors in the array.
+     * @param dst An array of at least count vectors to store the results in (may be the same array as vectors).
+     */
+    void transformVector(const Vector4* vectors, unsigned int count, Vector4* dst) const;
+
+    /**
+     * Transforms each point of the given array by this matrix.
+     *
+     * @param points The array of points to transform.
+     * @param count The number of points in the array.
+     * @param dst An array of at least count points to store the results in (may be the same array as points).
+     */
+    void transformPoint(const Vector3* points, unsigned int count, Vector3* dst) const;
+
     /**
      * Post-multiplies this matrix by the matrix corresponding to the
      * specified translation.
@@ -2,16 +2,206 @@
 #include "MeshSkin.h"
 #include "Joint.h"
 #include "Model.h"
+#include "MathUtil.h"
+#include "Game.h"
 
 // The number of rows in each palette matrix.
 #define PALETTE_ROWS 3
 
+// The number of floats of each joint in the dual quaternion palette.
+#define DUAL_QUATERNION_SIZE 8
+
+// The number of vertices skinned by a single job.
+#define MESH_SKIN_JOB_SIZE 512
+
 namespace gameplay
 {
 
+// Skins a vertex: blends the palette matrices of its influences, transforms its position
+// and transforms and normalizes its directions (normal, tangent and binormal).
+static inline void skinVertex(const float* palette, const float* src, float* dst, int positionOffset, const int* directionOffsets,
+                              const float* blendIndices, const float* blendWeights, unsigned int influenceCount)
+{
+#ifdef GP_USE_SSE
+    __m128 r0 = _mm_setzero_ps();
+    __m128 r1 = _mm_setzero_ps();
+    __m128 r2 = _mm_setzero_ps();
+    for (unsigned int i = 0; i < influenceCount; ++i)
+    {
+        if (blendWeights[i] == 0.0f)
+            continue;
+        const float* m = palette + (unsigned int)blendIndices[i] * PALETTE_ROWS * 4;
+        __m128 w = _mm_set1_ps(blendWeights[i]);
+        r0 = _mm_add_ps(r0, _mm_mul_ps(_mm_loadu_ps(&m[0]), w));
+        r1 = _mm_add_ps(r1, _mm_mul_ps(_mm_loadu_ps(&m[4]), w));
+        r2 = _mm_add_ps(r2, _mm_mul_ps(_mm_loadu_ps(&m[8]), w));
+    }
+
+    // Transpose the rows to the columns of the blended matrix (with a zero w).
+    __m128 r3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    float v[4];
+    if (positionOffset >= 0)
+    {
+        const float* p = src + positionOffset;
+        __m128 t = _mm_mul_ps(r0, _mm_set1_ps(p[0]));
+        t = _mm_add_ps(t, _mm_mul_ps(r1, _mm_set1_ps(p[1])));
+        t = _mm_add_ps(t, _mm_mul_ps(r2, _mm_set1_ps(p[2])));
+        _mm_storeu_ps(v, _mm_add_ps(t, r3));
+        memcpy(dst + positionOffset, v, 3 * sizeof(float));
+    }
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+        if (directionOffsets[d] < 0)
+            continue;
+        const float* n = src + directionOffsets[d];
+        __m128 t = _mm_mul_ps(r0, _mm_set1_ps(n[0]));
+        t = _mm_add_ps(t, _mm_mul_ps(r1, _mm_set1_ps(n[1])));
+        t = _mm_add_ps(t, _mm_mul_ps(r2, _mm_set1_ps(n[2])));
+        __m128 lengthSq = _mm_mul_ps(t, t);
+        _mm_storeu_ps(v, lengthSq);
+        float length = v[0] + v[1] + v[2];
+        if (length > 0.0f)
+            t = _mm_mul_ps(t, _mm_set1_ps(1.0f / sqrt(length)));
+        _mm_storeu_ps(v, t);
+        memcpy(dst + directionOffsets[d], v, 3 * sizeof(float));
+    }
+#else
+    float m[PALETTE_ROWS * 4] = { 0 };
+    for (unsigned int i = 0; i < influenceCount; ++i)
+    {
+        float w = blendWeights[i];
+        if (w == 0.0f)
+            continue;
+        const float* joint = palette + (unsigned int)blendIndices[i] * PALETTE_ROWS * 4;
+        for (unsigned int j = 0; j < PALETTE_ROWS * 4; ++j)
+            m[j] += joint[j] * w;
+    }
+
+    if (positionOffset >= 0)
+    {
+        const float* p = src + positionOffset;
+        float* q = dst + positionOffset;
+        q[0] = m[0] * p[0] + m[1] * p[1] + m[2]  * p[2] + m[3];
+        q[1] = m[4] * p[0] + m[5] * p[1] + m[6]  * p[2] + m[7];
+        q[2] = m[8] * p[0] + m[9] * p[1] + m[10] * p[2] + m[11];
+    }
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+        if (directionOffsets[d] < 0)
+            continue;
+        const float* n = src + directionOffsets[d];
+        float x = m[0] * n[0] + m[1] * n[1] + m[2]  * n[2];
+        float y = m[4] * n[0] + m[5] * n[1] + m[6]  * n[2];
+        float z = m[8] * n[0] + m[9] * n[1] + m[10] * n[2];
+        float length = x * x + y * y + z * z;
+        if (length > 0.0f)
+        {
+            length = 1.0f / sqrt(length);
+            x *= length;
+            y *= length;
+            z *= length;
+        }
+        float* q = dst + directionOffsets[d];
+        q[0] = x;
+        q[1] = y;
+        q[2] = z;
+    }
+#endif
+}
+
+// Converts a palette matrix (three rows) to a dual quaternion: the rotation followed by
+// half the translation multiplied by the rotation.
+static inline void toDualQuaternion(const float* rows, float* dst)
+{
+    Matrix m(rows[0], rows[1], rows[2],  rows[3],
+             rows[4], rows[5], rows[6],  rows[7],
+             rows[8], rows[9], rows[10], rows[11],
+             0.0f,    0.0f,    0.0f,     1.0f);
+    Quaternion q;
+    m.getRotation(&q);
+    if (q.w < 0.0f)
+        q.set(-q.x, -q.y, -q.z, -q.w);
+
+    float tx = rows[3], ty = rows[7], tz = rows[11];
+    dst[0] = q.x;
+    dst[1] = q.y;
+    dst[2] = q.z;
+    dst[3] = q.w;
+    dst[4] = 0.5f * (q.w * tx + ty * q.z - tz * q.y);
+    dst[5] = 0.5f * (q.w * ty + tz * q.x - tx * q.z);
+    dst[6] = 0.5f * (q.w * tz + tx * q.y - ty * q.x);
+    dst[7] = -0.5f * (tx * q.x + ty * q.y + tz * q.z);
+}
+
+// Rotates a vector by a unit quaternion (x, y, z, w).
+static inline void rotateVector(const float* q, const float* v, float* dst)
+{
+    // v + 2 * cross(q.xyz, cross(q.xyz, v) + q.w * v)
+    float cx = q[1] * v[2] - q[2] * v[1] + q[3] * v[0];
+    float cy = q[2] * v[0] - q[0] * v[2] + q[3] * v[1];
+    float cz = q[0] * v[1] - q[1] * v[0] + q[3] * v[2];
+    dst[0] = v[0] + 2.0f * (q[1] * cz - q[2] * cy);
+    dst[1] = v[1] + 2.0f * (q[2] * cx - q[0] * cz);
+    dst[2] = v[2] + 2.0f * (q[0] * cy - q[1] * cx);
+}
+
+// Skins a vertex with dual quaternions: blends the dual quaternions of its influences in
+// the hemisphere of the first one, normalizes the blend, and transforms the position and
+// directions of the vertex by it. This is the reference for the dual quaternion shaders.
+static inline void skinVertexDualQuaternion(const float* palette, const float* src, float* dst, int positionOffset, const int* directionOffsets,
+                                            const float* blendIndices, const float* blendWeights, unsigned int influenceCount)
+{
+    float b[DUAL_QUATERNION_SIZE] = { 0 };
+    const float* first = NULL;
+    for (unsigned int i = 0; i < influenceCount; ++i)
+    {
+        float w = blendWeights[i];
+        if (w == 0.0f)
+            continue;
+        const float* dq = palette + (unsigned int)blendIndices[i] * DUAL_QUATERNION_SIZE;
+        if (first == NULL)
+            first = dq;
+        else if (first[0] * dq[0] + first[1] * dq[1] + first[2] * dq[2] + first[3] * dq[3] < 0.0f)
+            w = -w;
+        for (unsigned int j = 0; j < DUAL_QUATERNION_SIZE; ++j)
+            b[j] += dq[j] * w;
+    }
+
+    float length = sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2] + b[3] * b[3]);
+    if (length > 0.0f)
+    {
+        length = 1.0f / length;
+        for (unsigned int j = 0; j < DUAL_QUATERNION_SIZE; ++j)
+            b[j] *= length;
+    }
+    const float* r = b;
+    const float* d = b + 4;
+
+    if (positionOffset >= 0)
+    {
+        // The translation is 2 * (r.w * d.xyz - d.w * r.xyz + cross(r.xyz, d.xyz)).
+        float* q = dst + positionOffset;
+        rotateVector(r, src + positionOffset, q);
+        q[0] += 2.0f * (r[3] * d[0] - d[3] * r[0] + r[1] * d[2] - r[2] * d[1]);
+        q[1] += 2.0f * (r[3] * d[1] - d[3] * r[1] + r[2] * d[0] - r[0] * d[2]);
+        q[2] += 2.0f * (r[3] * d[2] - d[3] * r[2] + r[0] * d[1] - r[1] * d[0]);
+    }
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        if (directionOffsets[i] >= 0)
+            rotateVector(r, src + directionOffsets[i], dst + directionOffsets[i]);
+    }
+}
+
 MeshSkin::MeshSkin()
-    : _rootJoint(NULL), _rootNode(NULL), _matrixPalette(NULL), _model(NULL)
+    : _rootJoint(NULL), _rootNode(NULL), _matrixPalette(NULL), _model(NULL),
+      _bindMatricesDirty(true), _matrixPaletteDirty(true), _matrixPaletteVersion(0),
+      _dualQuaternionEnabled(false), _bindVertices(NULL), _skinnedVertices(NULL), _skinnedVersion(0), _vertexStride(0),
+      _positionOffset(-1), _blendIndicesOffset(-1), _blendWeightsOffset(-1), _influenceCount(0)
 {
+    _directionOffsets[0] = _directionOffsets[1] = _directionOffsets[2] = -1;
 }
 
 MeshSkin::~MeshSkin()
@@ -19,6 +209,8 @@ MeshSkin::~MeshSkin()
     clearJoints();
 
     SAFE_DELETE_ARRAY(_matrixPalette);
+    SAFE_DELETE_ARRAY(_bindVertices);
+    SAFE_DELETE_ARRAY(_skinnedVertices);
 }
 
 const Matrix& MeshSkin::getBindShape() const
@@ -29,6 +221,7 @@ const Matrix& MeshSkin::getBindShape() const
 void MeshSkin::setBindShape(const float* matrix)
 {
     _bindShape.set(matrix);
+    setMatrixPaletteDirty(true);
 }
 
 unsigned int MeshSkin::getJointCount() const
@@ -134,6 +327,7 @@ void MeshSkin::setJointCount(unsigned int jointCount)
             _matrixPalette[i+2].set(0.0f, 0.0f, 1.0f, 0.0f);
         }
     }
+    setMatrixPaletteDirty(true);
 }
 
 void MeshSkin::setJoint(Joint* joint, unsigned int index)
@@ -153,18 +347,253 @@ void MeshSkin::setJoint(Joint* joint, unsigned int index)
         joint->addRef();
         joint->addSkin(this);
     }
+    setMatrixPaletteDirty(true);
 }
 
 Vector4* MeshSkin::getMatrixPalette() const
 {
     GP_ASSERT(_matrixPalette);
 
-    for (size_t i = 0, count = _joints.size(); i < count; i++)
+    updateMatrixPalette();
+    return _matrixPalette;
+}
+
+void MeshSkin::updateMatrixPalette() const
+{
+    if (!_matrixPaletteDirty.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> lock(_matrixPaletteMutex);
+    if (!_matrixPaletteDirty.load(std::memory_order_relaxed))
+        return;
+
+    size_t count = _joints.size();
+    if (_bindMatricesDirty)
+    {
+        _bindMatrices.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            GP_ASSERT(_joints[i]);
+            Matrix::multiply(_joints[i]->getInverseBindPose(), _bindShape, &_bindMatrices[i]);
+        }
+        _bindMatricesDirty = false;
+    }
+
+    // Resolve the world matrices of the joint hierarchy from its root, then write the
+    // three rows of each joint's palette matrix.
+    if (_rootJoint)
+        _rootJoint->getWorldMatrix();
+    float* palette = &_matrixPalette[0].x;
+    for (size_t i = 0; i < count; i++, palette += PALETTE_ROWS * 4)
     {
         GP_ASSERT(_joints[i]);
-        _joints[i]->updateJointMatrix(getBindShape(), &_matrixPalette[i * PALETTE_ROWS]);
+        MathUtil::multiplyMatrixPalette(_joints[i]->getWorldMatrix().m, _bindMatrices[i].m, palette);
     }
-    return _matrixPalette;
+
+    if (_dualQuaternionEnabled)
+    {
+        _dualQuaternionPalette.resize(count * 2);
+        for (size_t i = 0; i < count; i++)
+            toDualQuaternion(&_matrixPalette[i * PALETTE_ROWS].x, &_dualQuaternionPalette[i * 2].x);
+    }
+
+    _matrixPaletteVersion++;
+    _matrixPaletteDirty.store(false, std::memory_order_release);
+}
+
+void MeshSkin::setDualQuaternionEnabled(bool enabled)
+{
+    if (_dualQuaternionEnabled != enabled)
+    {
+        std::lock_guard<std::mutex> lock(_matrixPaletteMutex);
+        _dualQuaternionEnabled = enabled;
+        if (!enabled)
+            _dualQuaternionPalette.clear();
+        setMatrixPaletteDirty(false);
+    }
+}
+
+bool MeshSkin::isDualQuaternionEnabled() const
+{
+    return _dualQuaternionEnabled;
+}
+
+Vector4* MeshSkin::getDualQuaternionPalette() const
+{
+    if (!_dualQuaternionEnabled || _joints.empty())
+        return NULL;
+
+    updateMatrixPalette();
+    return &_dualQuaternionPalette[0];
+}
+
+unsigned int MeshSkin::getDualQuaternionPaletteSize() const
+{
+    return _dualQuaternionEnabled ? (unsigned int)_joints.size() * 2 : 0;
+}
+
+bool MeshSkin::setCpuSkinning(const void* bindVertexData)
+{
+    Mesh* mesh = _model ? _model->getMesh() : NULL;
+    if (bindVertexData == NULL)
+    {
+        // Restore the bind pose vertices, for skinning in the vertex shader.
+        if (_bindVertices && mesh)
+            mesh->setVertexData(_bindVertices, 0, mesh->getVertexCount());
+        SAFE_DELETE_ARRAY(_bindVertices);
+        SAFE_DELETE_ARRAY(_skinnedVertices);
+        return false;
+    }
+
+    if (mesh == NULL)
+    {
+        GP_ERROR("Failed to skin on the CPU a mesh skin that is not set on a model with a mesh.");
+        return false;
+    }
+
+    // Find the elements to skin.
+    const VertexFormat& format = mesh->getVertexFormat();
+    int positionOffset = -1;
+    int directionOffsets[3] = { -1, -1, -1 };
+    int blendIndicesOffset = -1;
+    int blendWeightsOffset = -1;
+    unsigned int blendIndicesSize = 0;
+    unsigned int blendWeightsSize = 0;
+    unsigned int offset = 0;
+    for (unsigned int i = 0, count = format.getElementCount(); i < count; ++i)
+    {
+        const VertexFormat::Element& element = format.getElement(i);
+        switch (element.usage)
+        {
+        case VertexFormat::POSITION:
+            if (element.size >= 3)
+                positionOffset = (int)offset;
+            break;
+        case VertexFormat::NORMAL:
+        case VertexFormat::TANGENT:
+        case VertexFormat::BINORMAL:
+            if (element.size >= 3)
+                directionOffsets[element.usage == VertexFormat::NORMAL ? 0 : (element.usage == VertexFormat::TANGENT ? 1 : 2)] = (int)offset;
+            break;
+        case VertexFormat::BLENDINDICES:
+            blendIndicesOffset = (int)offset;
+            blendIndicesSize = element.size;
+            break;
+        case VertexFormat::BLENDWEIGHTS:
+            blendWeightsOffset = (int)offset;
+            blendWeightsSize = element.size;
+            break;
+        default:
+            break;
+        }
+        offset += element.size;
+    }
+    GP_ASSERT(format.getVertexSize() == offset * sizeof(float));
+    if (blendIndicesOffset < 0 || blendWeightsOffset < 0)
+    {
+        GP_ERROR("Failed to skin on the CPU a mesh without BLENDINDICES and BLENDWEIGHTS elements.");
+        return false;
+    }
+
+    _vertexStride = offset;
+    _positionOffset = positionOffset;
+    memcpy(_directionOffsets, directionOffsets, sizeof(directionOffsets));
+    _blendIndicesOffset = blendIndicesOffset;
+    _blendWeightsOffset = blendWeightsOffset;
+    _influenceCount = std::min(blendIndicesSize, blendWeightsSize);
+
+    unsigned int floatCount = _vertexStride * mesh->getVertexCount();
+    SAFE_DELETE_ARRAY(_bindVertices);
+    SAFE_DELETE_ARRAY(_skinnedVertices);
+    _bindVertices = new float[floatCount];
+    memcpy(_bindVertices, bindVertexData, floatCount * sizeof(float));
+    _skinnedVertices = new float[floatCount];
+    _skinnedVersion = _matrixPaletteVersion - 1;
+    setMatrixPaletteDirty(false);
+
+    // Switch the materials already set on the model to their effects without skinning.
+    if (_model->_material)
+        _model->removeShaderSkinning(_model->_material);
+    if (_model->_partMaterials)
+    {
+        for (unsigned int i = 0; i < _model->_partCount; ++i)
+        {
+            if (_model->_partMaterials[i])
+                _model->removeShaderSkinning(_model->_partMaterials[i]);
+        }
+    }
+
+    return true;
+}
+
+bool MeshSkin::isCpuSkinning() const
+{
+    return _bindVertices != NULL;
+}
+
+void MeshSkin::updateSkinnedVertices()
+{
+    if (_bindVertices == NULL)
+        return;
+
+    updateMatrixPalette();
+    if (_skinnedVersion == _matrixPaletteVersion)
+        return;
+
+    skinVertices(_skinnedVertices);
+    _skinnedVersion = _matrixPaletteVersion;
+
+    Mesh* mesh = _model->getMesh();
+    GP_ASSERT(mesh);
+    mesh->setVertexData(_skinnedVertices, 0, mesh->getVertexCount());
+}
+
+void MeshSkin::skinVertices(void* vertexData) const
+{
+    GP_ASSERT(_bindVertices);
+    GP_ASSERT(vertexData);
+    GP_ASSERT(_model && _model->getMesh());
+
+    bool dualQuaternion = _dualQuaternionEnabled;
+    const float* palette = dualQuaternion ? &getDualQuaternionPalette()->x : &getMatrixPalette()->x;
+    const float* src = _bindVertices;
+    float* dst = (float*)vertexData;
+    unsigned int stride = _vertexStride;
+    int positionOffset = _positionOffset;
+    const int* directionOffsets = _directionOffsets;
+    int blendIndicesOffset = _blendIndicesOffset;
+    int blendWeightsOffset = _blendWeightsOffset;
+    unsigned int influenceCount = _influenceCount;
+    GP_ASSERT(influenceCount > 0);
+
+    // Each range of vertices reads and writes its own vertices only.
+    JobController::RangeFunction skinRange = [=](unsigned int begin, unsigned int end)
+    {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            const float* vertex = src + i * stride;
+            float* skinned = dst + i * stride;
+            memcpy(skinned, vertex, stride * sizeof(float));
+            if (dualQuaternion)
+            {
+                skinVertexDualQuaternion(palette, vertex, skinned, positionOffset, directionOffsets,
+                                         vertex + blendIndicesOffset, vertex + blendWeightsOffset, influenceCount);
+            }
+            else
+            {
+                skinVertex(palette, vertex, skinned, positionOffset, directionOffsets,
+                           vertex + blendIndicesOffset, vertex + blendWeightsOffset, influenceCount);
+            }
+        }
+    };
+
+    unsigned int vertexCount = _model->getMesh()->getVertexCount();
+    Game* game = Game::getInstance();
+    JobController* jobs = game ? game->getJobController() : NULL;
+    if (jobs && vertexCount > MESH_SKIN_JOB_SIZE)
+        jobs->parallelFor(vertexCount, MESH_SKIN_JOB_SIZE, skinRange);
+    else
+        skinRange(0, vertexCount);
 }
 
 unsigned int MeshSkin::getMatrixPaletteSize() const
@@ -261,6 +690,13 @@ void MeshSkin::setRootNode(Node* node)
     }
 }
 
+void MeshSkin::setMatrixPaletteDirty(bool bindPoseChanged)
+{
+    if (bindPoseChanged)
+        _bindMatricesDirty = true;
+    _matrixPaletteDirty.store(true, std::memory_order_release);
+}
+
 void MeshSkin::clearJoints()
 {
     setRootJoint(NULL);
@@ -285,6 +721,7 @@ void MeshSkin::serialize(Serializer* serializer)
 void MeshSkin::deserialize(Serializer* serializer)
 {
     _bindShape = serializer->readMatrix("bindShape", Matrix::identity());
+    setMatrixPaletteDirty(true);
 }
 
 Serializable* MeshSkin::createInstance()
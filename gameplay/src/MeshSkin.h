@@ -94,11 +94,29 @@ public:
 
     /**
      * Returns the pointer to the Vector4 array for the purpose of binding to a shader.
+     *
+     * The palette is computed if the joints changed since it was last computed.
      * 
      * @return The pointer to the matrix palette.
      */
     Vector4* getMatrixPalette() const;
 
+    /**
+     * Computes the matrix palette if the joints, their inverse bind poses or the bind shape
+     * changed since it was last computed.
+     *
+     * The palette is cached, so the passes that bind it (including shadow passes) share a
+     * single computation per change of the joints. Each palette matrix is the product of the
+     * world matrix of a joint with the inverse bind pose of the joint and the bind shape of
+     * the skin; the last two are combined once and kept until they change.
+     *
+     * This may be called from worker threads, for example to compute the palettes of the
+     * visible skins in parallel before they are drawn. Skins that share joints should only
+     * be updated concurrently once the world matrices of their joints are up to date, since
+     * the world matrices are resolved when read.
+     */
+    void updateMatrixPalette() const;
+
     /**
      * Returns the number of elements in the matrix palette array.
      * Each element is a Vector4* that represents a row.
@@ -108,6 +126,95 @@ public:
      */
     unsigned int getMatrixPaletteSize() const;
 
+    /**
+     * Sets whether the skin computes a dual quaternion palette along with the matrix palette.
+     *
+     * Dual quaternion skinning blends the rigid transforms of the joints without the loss of
+     * volume of linear blend skinning at twisted or bent joints, and takes 2 rather than 3
+     * Vector4 per joint. Shaders use it with the SKINNING_DUAL_QUATERNION define and the
+     * DUAL_QUATERNION_PALETTE auto-binding. Vertices skinned on the CPU use the dual
+     * quaternions too when enabled, which serves as a reference for the shaders. The joints
+     * and the bind shape must not be scaled, since dual quaternions only represent
+     * rotations and translations.
+     *
+     * @param enabled true to compute the dual quaternion palette, false otherwise.
+     */
+    void setDualQuaternionEnabled(bool enabled);
+
+    /**
+     * Determines whether the skin computes a dual quaternion palette.
+     *
+     * @return true if the dual quaternion palette is computed, false otherwise.
+     */
+    bool isDualQuaternionEnabled() const;
+
+    /**
+     * Returns the pointer to the dual quaternion palette for the purpose of binding to a shader.
+     *
+     * Each joint is represented by 2 Vector4: the real part (the rotation, as x, y, z, w)
+     * followed by the dual part (half the translation multiplied by the rotation).
+     *
+     * @return The pointer to the dual quaternion palette, or NULL if it is not enabled.
+     */
+    Vector4* getDualQuaternionPalette() const;
+
+    /**
+     * Returns the number of elements in the dual quaternion palette array.
+     *
+     * @return The dual quaternion palette size, or 0 if it is not enabled.
+     */
+    unsigned int getDualQuaternionPaletteSize() const;
+
+    /**
+     * Sets whether the vertices of the model's mesh are skinned on the CPU rather than in
+     * the vertex shader.
+     *
+     * When skinning on the CPU, the positions, normals, tangents and binormals of the mesh
+     * are transformed by the matrix palette and written to the vertex buffer of the mesh
+     * before the model is drawn. The passes of the model's materials are switched to their
+     * effects without the SKINNING defines and palette bindings, including materials set
+     * later. The number of joints is then not limited by the uniforms available to the
+     * vertex shader, and every pass draws the same skinned vertices. The vertices are only
+     * skinned again when the joints change, and the work is split across the JobController.
+     *
+     * The mesh must use float vertex elements with BLENDINDICES and BLENDWEIGHTS, and must
+     * not be shared with other models, since its vertex buffer is overwritten.
+     *
+     * @param bindVertexData The vertices of the mesh in its bind pose, in the vertex format
+     *      of the mesh, or NULL to skin in the vertex shader again. The data is copied.
+     *      Materials switched to effects without skinning must be set on the model again
+     *      when skinning in the vertex shader again.
+     *
+     * @return true if the vertices are skinned on the CPU, false otherwise.
+     */
+    bool setCpuSkinning(const void* bindVertexData);
+
+    /**
+     * Determines whether the vertices of the model's mesh are skinned on the CPU.
+     *
+     * @return true if the vertices are skinned on the CPU, false otherwise.
+     */
+    bool isCpuSkinning() const;
+
+    /**
+     * Skins the vertices of the mesh with the current pose of the joints and writes them
+     * to the vertex buffer of the mesh, if the joints changed since they were last skinned.
+     *
+     * This is called when the model is drawn while skinning on the CPU.
+     */
+    void updateSkinnedVertices();
+
+    /**
+     * Skins the vertices of the mesh with the current pose of the joints.
+     *
+     * This does not use the graphics device, so it may also be used to skin vertices for
+     * other purposes or to measure skinning headlessly.
+     *
+     * @param vertexData The skinned vertices, in the vertex format of the mesh. There must
+     *      be room for all the vertices of the mesh.
+     */
+    void skinVertices(void* vertexData) const;
+
     /**
      * Returns our parent Model.
      */
@@ -197,6 +304,13 @@ private:
      */
     void clearJoints();
 
+    /**
+     * Marks the matrix palette to be computed again.
+     *
+     * @param bindPoseChanged true if the bind shape or the inverse bind pose of a joint changed.
+     */
+    void setMatrixPaletteDirty(bool bindPoseChanged);
+
     Matrix _bindShape;
     std::vector<Joint*> _joints;
     Joint* _rootJoint;
@@ -212,6 +326,29 @@ private:
     // The number of Vector4's is (_joints.size() * 3).
     Vector4* _matrixPalette;
     Model* _model;
+
+    // The inverse bind pose of each joint multiplied by the bind shape.
+    mutable std::vector<Matrix> _bindMatrices;
+    mutable bool _bindMatricesDirty;
+    mutable std::atomic<bool> _matrixPaletteDirty;
+    mutable std::mutex _matrixPaletteMutex;
+    mutable unsigned int _matrixPaletteVersion;
+
+    // The dual quaternion palette, 2 Vector4 per joint, when it is enabled.
+    bool _dualQuaternionEnabled;
+    mutable std::vector<Vector4> _dualQuaternionPalette;
+
+    // The vertices of the mesh in the bind pose and skinned on the CPU, and the offset in
+    // floats of each element used for skinning (-1 for elements the format doesn't have).
+    float* _bindVertices;
+    float* _skinnedVertices;
+    unsigned int _skinnedVersion;
+    unsigned int _vertexStride;
+    int _positionOffset;
+    int _directionOffsets[3];
+    int _blendIndicesOffset;
+    int _blendWeightsOffset;
+    unsigned int _influenceCount;
 };
 
 }
@@ -142,6 +142,10 @@ void Model::setMaterial(Material* material, int partIndex)
 
     if (material)
     {
+        // Models skinned on the CPU must not be skinned again in the vertex shader.
+        if (_skin && _skin->isCpuSkinning())
+            removeShaderSkinning(material);
+
         // Hookup vertex attribute bindings for all passes in the new material.
         for (unsigned int i = 0, tCount = material->getTechniqueCount(); i < tCount; ++i)
         {
@@ -330,6 +334,9 @@ unsigned int Model::draw(bool wireframe)
 {
     GP_ASSERT(_mesh);
 
+    if (_skin)
+        _skin->updateSkinnedVertices();
+
     unsigned int partCount = _mesh->getPartCount();
     if (partCount == 0)
     {
@@ -444,6 +451,30 @@ void Model::setMaterialNodeBinding(Material *material)
     }
 }
 
+void Model::removeShaderSkinning(Material* material)
+{
+    GP_ASSERT(material);
+
+    material->removeSkinningBindings();
+    for (unsigned int i = 0, tCount = material->getTechniqueCount(); i < tCount; ++i)
+    {
+        Technique* t = material->getTechniqueByIndex(i);
+        GP_ASSERT(t);
+        t->removeSkinningBindings();
+        for (unsigned int j = 0, pCount = t->getPassCount(); j < pCount; ++j)
+        {
+            Pass* p = t->getPassByIndex(j);
+            GP_ASSERT(p);
+            if (p->removeSkinning() && p->getVertexAttributeBinding())
+            {
+                VertexAttributeBinding* b = VertexAttributeBinding::create(_mesh, p->getEffect());
+                p->setVertexAttributeBinding(b);
+                SAFE_RELEASE(b);
+            }
+        }
+    }
+}
+
 Drawable* Model::clone(NodeCloneContext& context)
 {
     Model* model = Model::create(getMesh());
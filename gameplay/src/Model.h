@@ -26,6 +26,7 @@ class Model : public Ref, public Serializable, public Drawable
     friend class Scene;
     friend class Mesh;
     friend class Bundle;
+    friend class MeshSkin;
 
 public:
 
@@ -206,6 +207,12 @@ private:
      */
     void setMaterialNodeBinding(Material *m);
 
+    /**
+     * Switches the passes of a material that skin in the vertex shader to their effects
+     * without skinning, since the vertices of the mesh are already skinned on the CPU.
+     */
+    void removeShaderSkinning(Material* material);
+
     void validatePartCount();
 
     Mesh* _mesh;
@@ -25,7 +25,8 @@ namespace gameplay
 
 Node::Node() : _scene(NULL), _id(""), _firstChild(NULL), _nextSibling(NULL), _prevSibling(NULL), _parent(NULL), _childCount(0), _enabled(true), _tags(NULL),
     _drawable(NULL), _camera(NULL), _light(NULL), _collisionObject(NULL), _audioSource(NULL),
-    _agent(NULL), _userObject(NULL), _dirtyBits(NODE_DIRTY_ALL)
+    _agent(NULL), _userObject(NULL), _dirtyBits(NODE_DIRTY_ALL),
+    _spatialProxy(BoundingBoxTree::NULL_PROXY), _spatialDirty(false), _spatialQuery(0)
 {
     GP_REGISTER_SCRIPT_EVENTS();
 }
@@ -34,7 +35,8 @@ Node::Node(const char* id) :
     _scene(NULL), _id(id ? id : ""), _firstChild(NULL), _nextSibling(NULL), _prevSibling(NULL), _parent(NULL),
     _childCount(0), _enabled(true), _tags(NULL),
     _drawable(NULL), _camera(NULL), _light(NULL), _collisionObject(NULL), _audioSource(NULL),
-    _agent(NULL), _userObject(NULL), _dirtyBits(NODE_DIRTY_ALL)
+    _agent(NULL), _userObject(NULL), _dirtyBits(NODE_DIRTY_ALL),
+    _spatialProxy(BoundingBoxTree::NULL_PROXY), _spatialDirty(false), _spatialQuery(0)
 {
     GP_REGISTER_SCRIPT_EVENTS();
 }
@@ -121,6 +123,10 @@ void Node::addChild(Node* child)
     ++_childCount;
     setBoundsDirty();
 
+    Scene* scene = getScene();
+    if (scene && scene->_spatialIndex)
+        scene->addToSpatialIndex(child);
+
     if (_dirtyBits & NODE_DIRTY_HIERARCHY)
     {
         hierarchyChanged();
@@ -152,6 +158,10 @@ void Node::removeAllChildren()
 
 void Node::remove()
 {
+    Scene* scene = getScene();
+    if (scene && scene->_spatialIndex)
+        scene->removeFromSpatialIndex(this);
+
     // Re-link our neighbours.
     if (_prevSibling)
     {
@@ -436,24 +446,10 @@ const Matrix& Node::getWorldMatrix() const
 {
     if (_dirtyBits & NODE_DIRTY_WORLD)
     {
-        // Clear our dirty flag immediately to prevent this block from being entered if our
-        // parent calls our getWorldMatrix() method as a result of the following calculations.
-        _dirtyBits &= ~NODE_DIRTY_WORLD;
+        updateWorldMatrix();
 
         if (!isStatic())
         {
-            // If we have a parent, multiply our parent world transform by our local
-            // transform to obtain our final resolved world transform.
-            Node* parent = getParent();
-            if (parent && (!_collisionObject || _collisionObject->isKinematic()))
-            {
-                Matrix::multiply(parent->getWorldMatrix(), getMatrix(), &_world);
-            }
-            else
-            {
-                _world = getMatrix();
-            }
-
             // Our world matrix was just updated, so call getWorldMatrix() on all child nodes
             // to force their resolved world matrices to be updated.
             for (Node* child = getFirstChild(); child != NULL; child = child->getNextSibling())
@@ -646,10 +642,41 @@ Vector3 Node::getActiveCameraTranslationView() const
     return Vector3::zero();
 }
 
+void Node::updateWorldMatrix() const
+{
+    if (!(_dirtyBits & NODE_DIRTY_WORLD))
+        return;
+
+    // Clear our dirty flag immediately to prevent this method from being entered again if
+    // our parent calls our getWorldMatrix() method as a result of the following calculations.
+    _dirtyBits &= ~NODE_DIRTY_WORLD;
+
+    if (!isStatic())
+    {
+        // If we have a parent, multiply our parent world transform by our local
+        // transform to obtain our final resolved world transform.
+        Node* parent = getParent();
+        if (parent && (!_collisionObject || _collisionObject->isKinematic()))
+        {
+            Matrix::multiply(parent->getWorldMatrix(), getMatrix(), &_world);
+        }
+        else
+        {
+            _world = getMatrix();
+        }
+    }
+}
+
 void Node::hierarchyChanged()
 {
     // When our hierarchy changes our world transform is affected, so we must dirty it.
     _dirtyBits |= NODE_DIRTY_HIERARCHY;
+
+    // Our depth within the scene may have changed as well.
+    Scene* scene = getScene();
+    if (scene)
+        scene->_transformOrderDirty = true;
+
     transformChanged();
 }
 
@@ -658,6 +685,14 @@ void Node::transformChanged()
     // Our local transform was changed, so mark our world matrices dirty.
     _dirtyBits |= NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS;
 
+    // Our proxy in the spatial index of the scene must be refit.
+    if (_spatialProxy != BoundingBoxTree::NULL_PROXY && !_spatialDirty)
+    {
+        Scene* scene = getScene();
+        if (scene)
+            scene->markSpatialDirty(this);
+    }
+
     // Notify our children that their transform has also changed (since transforms are inherited).
     for (Node* n = getFirstChild(); n != NULL; n = n->getNextSibling())
     {
@@ -683,6 +718,13 @@ void Node::setBoundsDirty()
     // Mark ourself and our parent nodes as dirty
     _dirtyBits |= NODE_DIRTY_BOUNDS;
 
+    if (_spatialProxy != BoundingBoxTree::NULL_PROXY && !_spatialDirty)
+    {
+        Scene* scene = getScene();
+        if (scene)
+            scene->markSpatialDirty(this);
+    }
+
     // Mark our parent bounds as dirty as well
     if (_parent)
         _parent->setBoundsDirty();
@@ -1240,13 +1282,9 @@ void Node::serialize(Serializer* serializer)
     serializer->writeVector("rotate", Vector4(rotation.x, rotation.y, rotation.z, rotation.w), Vector4::zero());
     serializer->writeVector("scale", scale, Vector3::one());
     
-    if (_drawable)
-    {
-        Model* model = dynamic_cast<Model*>(_drawable);
-        if (model)
-            serializer->writeObject("drawable", model);
-        // TODO: Other drawables
-    }
+    // The drawable is always written, since it is always read back.
+    // TODO: Other drawables
+    serializer->writeObject("drawable", dynamic_cast<Model*>(_drawable));
     serializer->writeObject("camera", _camera);
     serializer->writeObject("light", _light);
     
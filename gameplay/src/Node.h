@@ -258,6 +258,10 @@ public:
     /**
      * Gets the world matrix corresponding to this node.
      *
+     * The world matrix is resolved lazily, together with the world matrices of all
+     * descendants. For scenes with many moving nodes, Scene::updateTransforms() resolves
+     * the world matrices of all nodes in one pass instead.
+     *
      * @return The world matrix of this node.
      */
     virtual const Matrix& getWorldMatrix() const;
@@ -666,6 +670,11 @@ protected:
      */
     void hierarchyChanged();
 
+    /**
+     * Resolves the world matrix of this node only, if it is dirty, from the world matrix of its parent.
+     */
+    void updateWorldMatrix() const;
+
     /**
      * Marks the bounding volume of the node as dirty.
      */
@@ -763,6 +772,12 @@ protected:
     mutable BoundingSphere _bounds;
     /** The dirty bits used for optimization. */
     mutable int _dirtyBits;
+    /** The proxy of this node in the spatial index of its scene. */
+    int _spatialProxy;
+    /** Whether the proxy of this node is waiting to be updated. */
+    bool _spatialDirty;
+    /** The last spatial index frustum query this node was found visible by. */
+    unsigned int _spatialQuery;
 };
 
 /**
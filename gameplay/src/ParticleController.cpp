@@ -0,0 +1,176 @@
+#include "Base.h"
+#include "ParticleController.h"
+#include "ParticleEmitter.h"
+#include "JobController.h"
+#include "Game.h"
+#include "Node.h"
+
+namespace gameplay
+{
+
+ParticleController::ParticleController()
+    : _state(STOPPED), _particleCount(0), _parallelEnabled(true)
+{
+}
+
+ParticleController::~ParticleController()
+{
+}
+
+unsigned int ParticleController::getActiveEmitterCount() const
+{
+    return (unsigned int)_activeEmitters.size();
+}
+
+unsigned int ParticleController::getParticleCount() const
+{
+    return _particleCount;
+}
+
+void ParticleController::setParallelEnabled(bool enabled)
+{
+    _parallelEnabled = enabled;
+}
+
+bool ParticleController::isParallelEnabled() const
+{
+    return _parallelEnabled;
+}
+
+void ParticleController::initialize()
+{
+    _state = RUNNING;
+}
+
+void ParticleController::finalize()
+{
+    for (size_t i = 0, count = _activeEmitters.size(); i < count; ++i)
+    {
+        _activeEmitters[i]->_scheduled = false;
+    }
+    _activeEmitters.clear();
+    _particleCount = 0;
+    _state = STOPPED;
+}
+
+void ParticleController::pause()
+{
+    _state = PAUSED;
+}
+
+void ParticleController::resume()
+{
+    _state = RUNNING;
+}
+
+void ParticleController::update(float elapsedTime)
+{
+    resolveNodes();
+    updateEmitters(elapsedTime);
+}
+
+void ParticleController::resolveNodes()
+{
+    if (_state != RUNNING)
+        return;
+
+    for (size_t i = 0, count = _activeEmitters.size(); i < count; ++i)
+    {
+        Node* node = _activeEmitters[i]->getNode();
+        if (node)
+        {
+            node->getWorldMatrix();
+        }
+    }
+}
+
+void ParticleController::updateEmitters(float elapsedTime)
+{
+    if (_state != RUNNING)
+        return;
+
+    JobController* jobs = _parallelEnabled ? Game::getInstance()->getJobController() : NULL;
+    if (jobs && jobs->getWorkerCount() == 0)
+        jobs = NULL;
+
+    unsigned int emitterCount = (unsigned int)_activeEmitters.size();
+
+    // Emitters that are not attached to a node have nowhere to emit from,
+    // but stay registered until they are attached or stopped.
+    if (jobs)
+    {
+        jobs->parallelFor(emitterCount, 1, [this, elapsedTime, jobs](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                ParticleEmitter* emitter = _activeEmitters[i];
+                if (emitter->getNode())
+                {
+                    emitter->updateInternal(elapsedTime, jobs);
+                }
+            }
+        });
+    }
+    else
+    {
+        for (unsigned int i = 0; i < emitterCount; ++i)
+        {
+            ParticleEmitter* emitter = _activeEmitters[i];
+            if (emitter->getNode())
+            {
+                emitter->updateInternal(elapsedTime, NULL);
+            }
+        }
+    }
+
+    // Drop the emitters that have gone idle by moving the
+    // last emitter in the list into their slot.
+    _particleCount = 0;
+    size_t i = 0;
+    while (i < _activeEmitters.size())
+    {
+        ParticleEmitter* emitter = _activeEmitters[i];
+        GP_ASSERT(emitter);
+
+        if (emitter->isStarted() || (emitter->getNode() && emitter->getParticlesCount() > 0))
+        {
+            _particleCount += emitter->getParticlesCount();
+            ++i;
+        }
+        else
+        {
+            emitter->_scheduled = false;
+            _activeEmitters[i] = _activeEmitters.back();
+            _activeEmitters.pop_back();
+        }
+    }
+}
+
+void ParticleController::addActiveEmitter(ParticleEmitter* emitter)
+{
+    GP_ASSERT(emitter);
+
+    if (!emitter->_scheduled)
+    {
+        emitter->_scheduled = true;
+        _activeEmitters.push_back(emitter);
+    }
+}
+
+void ParticleController::removeActiveEmitter(ParticleEmitter* emitter)
+{
+    GP_ASSERT(emitter);
+
+    if (!emitter->_scheduled)
+        return;
+
+    std::vector<ParticleEmitter*>::iterator itr = std::find(_activeEmitters.begin(), _activeEmitters.end(), emitter);
+    if (itr != _activeEmitters.end())
+    {
+        *itr = _activeEmitters.back();
+        _activeEmitters.pop_back();
+    }
+    emitter->_scheduled = false;
+}
+
+}
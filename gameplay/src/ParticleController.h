@@ -0,0 +1,137 @@
+#ifndef PARTICLECONTROLLER_H_
+#define PARTICLECONTROLLER_H_
+
+namespace gameplay
+{
+
+class ParticleEmitter;
+
+/**
+ * Defines a class for controlling the simulation of particle emitters.
+ *
+ * Emitters register themselves with the controller when they are started or
+ * emit particles, and unregister once they no longer have live particles. All
+ * registered emitters are then updated together in a single pass each frame,
+ * so idle emitters cost nothing and the per-frame particle cost scales with
+ * the number of active emitters and live particles.
+ */
+class ParticleController
+{
+    friend class Game;
+    friend class ParticleEmitter;
+
+public:
+
+    /**
+     * Destructor.
+     */
+    ~ParticleController();
+
+    /**
+     * Gets the number of emitters currently being simulated.
+     *
+     * @return The number of active emitters.
+     */
+    unsigned int getActiveEmitterCount() const;
+
+    /**
+     * Gets the total number of live particles across all active emitters
+     * as of the last update.
+     *
+     * @return The number of live particles.
+     */
+    unsigned int getParticleCount() const;
+
+    /**
+     * Sets whether emitters are simulated in parallel on the game's worker threads.
+     *
+     * Each active emitter is updated as a separate job, and emitters with very
+     * many live particles are further split into chunks. Every emitter draws from
+     * its own random stream, so results are the same regardless of the number of
+     * worker threads. Enabled by default.
+     *
+     * @param enabled true to simulate emitters in parallel, false to simulate them on the calling thread.
+     */
+    void setParallelEnabled(bool enabled);
+
+    /**
+     * Gets whether emitters are simulated in parallel on the game's worker threads.
+     *
+     * @return true if emitters are simulated in parallel.
+     */
+    bool isParallelEnabled() const;
+
+private:
+
+    /**
+     * The states that the ParticleController may be in.
+     */
+    enum State
+    {
+        RUNNING,
+        PAUSED,
+        STOPPED
+    };
+
+    /**
+     * Constructor.
+     */
+    ParticleController();
+
+    /**
+     * Constructor.
+     */
+    ParticleController(const ParticleController& copy);
+
+    /**
+     * Controller initialize.
+     */
+    void initialize();
+
+    /**
+     * Controller finalize.
+     */
+    void finalize();
+
+    /**
+     * Controller pause.
+     */
+    void pause();
+
+    /**
+     * Controller resume.
+     */
+    void resume();
+
+    /**
+     * Controller update.
+     */
+    void update(float elapsedTime);
+
+    /**
+     * Resolves the world matrices of the emitters' nodes, on the main thread.
+     *
+     * Node::getWorldMatrix() lazily updates parent nodes, which is not safe to do from
+     * several threads at once, so this must run before the emitters are updated.
+     */
+    void resolveNodes();
+
+    /**
+     * Updates the emitters, once their nodes are resolved. This may run on a worker thread
+     * while the main thread does work that does not touch the emitters.
+     */
+    void updateEmitters(float elapsedTime);
+
+    void addActiveEmitter(ParticleEmitter* emitter);
+
+    void removeActiveEmitter(ParticleEmitter* emitter);
+
+    State _state;
+    std::vector<ParticleEmitter*> _activeEmitters;
+    unsigned int _particleCount;
+    bool _parallelEnabled;
+};
+
+}
+
+#endif
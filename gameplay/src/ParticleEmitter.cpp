@@ -4,17 +4,184 @@
 #include "Node.h"
 #include "Scene.h"
 #include "Quaternion.h"
+#include "MathUtil.h"
 
 #define PARTICLE_COUNT_MAX                       100
 #define PARTICLE_EMISSION_RATE                   10
 #define PARTICLE_EMISSION_RATE_TIME_INTERVAL     1000.0f / (float)PARTICLE_EMISSION_RATE
-#define PARTICLE_UPDATE_RATE_MAX                 8
+#define PARTICLE_UPDATE_STEP                     1000.0f / 60.0f
+#define PARTICLE_UPDATE_STEPS_MAX                4
+#define PARTICLE_STREAM_COUNT                    33
+#define PARTICLE_JOB_SIZE                        4096
+
+#if defined(GP_USE_NEON)
+#include <arm_neon.h>
+#elif defined(GP_USE_SSE)
+#include <xmmintrin.h>
+#endif
 
 namespace gameplay
 {
 
+// Four-wide float operations used by the particle update kernels.
+#if defined(GP_USE_NEON)
+typedef float32x4_t simd4;
+static inline simd4 simdLoad(const float* p) { return vld1q_f32(p); }
+static inline void simdStore(float* p, simd4 v) { vst1q_f32(p, v); }
+static inline simd4 simdSplat(float s) { return vdupq_n_f32(s); }
+static inline simd4 simdSub(simd4 a, simd4 b) { return vsubq_f32(a, b); }
+static inline simd4 simdMul(simd4 a, simd4 b) { return vmulq_f32(a, b); }
+static inline simd4 simdMultiplyAdd(simd4 a, simd4 b, simd4 c) { return vmlaq_f32(a, b, c); }
+#elif defined(GP_USE_SSE)
+typedef __m128 simd4;
+static inline simd4 simdLoad(const float* p) { return _mm_load_ps(p); }
+static inline void simdStore(float* p, simd4 v) { _mm_store_ps(p, v); }
+static inline simd4 simdSplat(float s) { return _mm_set1_ps(s); }
+static inline simd4 simdSub(simd4 a, simd4 b) { return _mm_sub_ps(a, b); }
+static inline simd4 simdMul(simd4 a, simd4 b) { return _mm_mul_ps(a, b); }
+static inline simd4 simdMultiplyAdd(simd4 a, simd4 b, simd4 c) { return _mm_add_ps(a, _mm_mul_ps(b, c)); }
+#else
+struct simd4 { float v[4]; };
+static inline simd4 simdLoad(const float* p) { simd4 r = { { p[0], p[1], p[2], p[3] } }; return r; }
+static inline void simdStore(float* p, simd4 v) { p[0] = v.v[0]; p[1] = v.v[1]; p[2] = v.v[2]; p[3] = v.v[3]; }
+static inline simd4 simdSplat(float s) { simd4 r = { { s, s, s, s } }; return r; }
+static inline simd4 simdSub(simd4 a, simd4 b) { simd4 r = { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; return r; }
+static inline simd4 simdMul(simd4 a, simd4 b) { simd4 r = { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; return r; }
+static inline simd4 simdMultiplyAdd(simd4 a, simd4 b, simd4 c) { simd4 r = { { a.v[0] + b.v[0] * c.v[0], a.v[1] + b.v[1] * c.v[1], a.v[2] + b.v[2] * c.v[2], a.v[3] + b.v[3] * c.v[3] } }; return r; }
+#endif
+
+// The kernels below operate on whole groups of four, which is safe since particle
+// streams are padded to a multiple of four. Lanes past the live count hold stale data
+// that is never read back.
+
+// dst[i] += src[i] * scalar
+static void particleMultiplyAdd(float* dst, const float* src, float scalar, unsigned int count)
+{
+    const simd4 s = simdSplat(scalar);
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        simdStore(dst + i, simdMultiplyAdd(simdLoad(dst + i), simdLoad(src + i), s));
+    }
+}
+
+// dst[i] -= scalar
+static void particleSubtract(float* dst, float scalar, unsigned int count)
+{
+    const simd4 s = simdSplat(scalar);
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        simdStore(dst + i, simdSub(simdLoad(dst + i), s));
+    }
+}
+
+// dst[i] = start[i] + (end[i] - start[i]) * (1 - energy[i] / energyStart[i])
+static void particleLerp(float* dst, const float* start, const float* end, const float* energy, const float* energyStartInv, unsigned int count)
+{
+    const simd4 one = simdSplat(1.0f);
+    for (unsigned int i = 0; i < count; i += 4)
+    {
+        simd4 percent = simdSub(one, simdMul(simdLoad(energy + i), simdLoad(energyStartInv + i)));
+        simd4 from = simdLoad(start + i);
+        simdStore(dst + i, simdMultiplyAdd(from, simdSub(simdLoad(end + i), from), percent));
+    }
+}
+
+// Rotates a point around a normalized axis by the angle with the given cosine and sine.
+// This is Rodrigues' rotation formula and matches Matrix::createRotation followed by transformPoint.
+static inline void rotateAroundAxis(float ax, float ay, float az, float c, float s, float* x, float* y, float* z)
+{
+    float d = (ax * *x + ay * *y + az * *z) * (1.0f - c);
+    float rx = *x * c + (ay * *z - az * *y) * s + ax * d;
+    float ry = *y * c + (az * *x - ax * *z) * s + ay * d;
+    float rz = *z * c + (ax * *y - ay * *x) * s + az * d;
+    *x = rx;
+    *y = ry;
+    *z = rz;
+}
+
+ParticleEmitter::ParticleData::ParticleData() : _frame(NULL), _capacity(0), _data(NULL), _dataAligned(NULL)
+{
+    bindStreams(NULL, 0);
+}
+
+ParticleEmitter::ParticleData::~ParticleData()
+{
+    SAFE_DELETE_ARRAY(_data);
+    SAFE_DELETE_ARRAY(_frame);
+}
+
+void ParticleEmitter::ParticleData::allocate(unsigned int capacity, unsigned int preserveCount)
+{
+    GP_ASSERT(preserveCount <= _capacity && preserveCount <= capacity);
+
+    // Round up so every stream holds whole groups of four and stays 16-byte aligned.
+    unsigned int stride = (capacity + 3) & ~3u;
+    float* data = new float[stride * PARTICLE_STREAM_COUNT + 3];
+    float* dataAligned = (float*)(((size_t)data + 15) & ~(size_t)15);
+    memset(dataAligned, 0, stride * PARTICLE_STREAM_COUNT * sizeof(float));
+    unsigned int* frame = new unsigned int[stride];
+    memset(frame, 0, stride * sizeof(unsigned int));
+
+    if (preserveCount > 0)
+    {
+        for (unsigned int i = 0; i < PARTICLE_STREAM_COUNT; ++i)
+        {
+            memcpy(dataAligned + i * stride, _dataAligned + i * _capacity, preserveCount * sizeof(float));
+        }
+        memcpy(frame, _frame, preserveCount * sizeof(unsigned int));
+    }
+
+    SAFE_DELETE_ARRAY(_data);
+    SAFE_DELETE_ARRAY(_frame);
+    _data = data;
+    _dataAligned = dataAligned;
+    _frame = frame;
+    _capacity = stride;
+    bindStreams(_dataAligned, _capacity);
+}
+
+void ParticleEmitter::ParticleData::copy(unsigned int dst, unsigned int src)
+{
+    GP_ASSERT(dst < _capacity && src < _capacity);
+
+    for (unsigned int i = 0; i < PARTICLE_STREAM_COUNT; ++i)
+    {
+        float* stream = _dataAligned + i * _capacity;
+        stream[dst] = stream[src];
+    }
+    _frame[dst] = _frame[src];
+}
+
+void ParticleEmitter::ParticleData::bindStreams(float* data, unsigned int capacity)
+{
+    unsigned int stream = 0;
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        _position[i] = data + capacity * stream++;
+        _velocity[i] = data + capacity * stream++;
+        _acceleration[i] = data + capacity * stream++;
+        _rotationAxis[i] = data + capacity * stream++;
+    }
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        _colorStart[i] = data + capacity * stream++;
+        _colorEnd[i] = data + capacity * stream++;
+        _color[i] = data + capacity * stream++;
+    }
+    _rotationPerParticleSpeed = data + capacity * stream++;
+    _rotationSpeed = data + capacity * stream++;
+    _angle = data + capacity * stream++;
+    _energy = data + capacity * stream++;
+    _energyStartInv = data + capacity * stream++;
+    _sizeStart = data + capacity * stream++;
+    _sizeEnd = data + capacity * stream++;
+    _size = data + capacity * stream++;
+    _timeOnCurrentFrame = data + capacity * stream++;
+    GP_ASSERT(stream == PARTICLE_STREAM_COUNT);
+}
+
 ParticleEmitter::ParticleEmitter(unsigned int particleCountMax) : Drawable(),
-    _particleCountMax(particleCountMax), _particleCount(0), _particles(NULL),
+    _particleCountMax(particleCountMax), _particleCount(0),
     _emissionRate(PARTICLE_EMISSION_RATE), _started(false), _ellipsoid(false),
     _sizeStartMin(1.0f), _sizeStartMax(1.0f), _sizeEndMin(1.0f), _sizeEndMax(1.0f),
     _energyMin(1000L), _energyMax(1000L),
@@ -24,20 +191,30 @@ ParticleEmitter::ParticleEmitter(unsigned int particleCountMax) : Drawable(),
     _acceleration(Vector3::zero()), _accelerationVar(Vector3::zero()),
     _rotationPerParticleSpeedMin(0.0f), _rotationPerParticleSpeedMax(0.0f),
     _rotationSpeedMin(0.0f), _rotationSpeedMax(0.0f),
-    _rotationAxis(Vector3::zero()), _rotation(Matrix::identity()),
+    _rotationAxis(Vector3::zero()),
     _spriteBatch(NULL), _spriteBlendMode(BLEND_ALPHA),  _spriteTextureWidth(0), _spriteTextureHeight(0), _spriteTextureWidthRatio(0), _spriteTextureHeightRatio(0), _spriteTextureCoords(NULL),
     _spriteAnimated(false),  _spriteLooped(false), _spriteFrameCount(1), _spriteFrameRandomOffset(0),_spriteFrameDuration(0L), _spriteFrameDurationSecs(0.0f), _spritePercentPerFrame(0.0f),
     _orbitPosition(false), _orbitVelocity(false), _orbitAcceleration(false),
-    _timePerEmission(PARTICLE_EMISSION_RATE_TIME_INTERVAL), _emitTime(0), _lastUpdated(0)
+    _timePerEmission(PARTICLE_EMISSION_RATE_TIME_INTERVAL), _emitTime(0),
+    _updateStep(PARTICLE_UPDATE_STEP), _updateStepsMax(PARTICLE_UPDATE_STEPS_MAX), _updateTime(0), _scheduled(false),
+    _randomState(0)
 {
     GP_ASSERT(particleCountMax);
-    _particles = new Particle[particleCountMax];
+    _particles.allocate(particleCountMax, 0);
+
+    // Give every emitter its own random stream so simulation results don't depend
+    // on the order or the thread emitters are updated on.
+    static std::atomic<unsigned int> __seed(0);
+    setRandomSeed(++__seed);
 }
 
 ParticleEmitter::~ParticleEmitter()
 {
+    if (_scheduled)
+    {
+        Game::getInstance()->getParticleController()->removeActiveEmitter(this);
+    }
     SAFE_DELETE(_spriteBatch);
-    SAFE_DELETE_ARRAY(_particles);
     SAFE_DELETE_ARRAY(_spriteTextureCoords);
 }
 
@@ -250,6 +427,16 @@ Texture* ParticleEmitter::getTexture() const
 
 void ParticleEmitter::setParticleCountMax(unsigned int max)
 {
+    GP_ASSERT(max);
+
+    if (_particleCount > max)
+    {
+        _particleCount = max;
+    }
+    if (max > _particles._capacity)
+    {
+        _particles.allocate(max, _particleCount);
+    }
     _particleCountMax = max;
 }
 
@@ -273,7 +460,8 @@ void ParticleEmitter::setEmissionRate(unsigned int rate)
 void ParticleEmitter::start()
 {
     _started = true;
-    _lastUpdated = 0;
+    _updateTime = 0;
+    scheduleUpdate();
 }
 
 void ParticleEmitter::stop()
@@ -298,9 +486,28 @@ bool ParticleEmitter::isActive() const
 }
 
 void ParticleEmitter::emitOnce(unsigned int particleCount)
+{
+    emit(particleCount);
+
+    if (_particleCount > 0)
+    {
+        scheduleUpdate();
+    }
+}
+
+void ParticleEmitter::scheduleUpdate()
+{
+    Game* game = Game::getInstance();
+    ParticleController* controller = game ? game->getParticleController() : NULL;
+    if (controller)
+    {
+        controller->addActiveEmitter(this);
+    }
+}
+
+void ParticleEmitter::emit(unsigned int particleCount)
 {
     GP_ASSERT(_node);
-    GP_ASSERT(_particles);
 
     // Limit particleCount so as not to go over _particleCountMax.
     if (particleCount + _particleCount > _particleCountMax)
@@ -318,63 +525,100 @@ void ParticleEmitter::emitOnce(unsigned int particleCount)
     world.m[14] = 0.0f;
 
     // Emit the new particles.
+    ParticleData& p = _particles;
+    Vector4 colorStart;
+    Vector4 colorEnd;
+    Vector3 position;
+    Vector3 velocity;
+    Vector3 acceleration;
+    Vector3 rotationAxis;
     for (unsigned int i = 0; i < particleCount; i++)
     {
-        Particle* p = &_particles[_particleCount];
-
-        generateColor(_colorStart, _colorStartVar, &p->_colorStart);
-        generateColor(_colorEnd, _colorEndVar, &p->_colorEnd);
-        p->_color.set(p->_colorStart);
-
-        p->_energy = p->_energyStart = generateScalar(_energyMin, _energyMax);
-        p->_size = p->_sizeStart = generateScalar(_sizeStartMin, _sizeStartMax);
-        p->_sizeEnd = generateScalar(_sizeEndMin, _sizeEndMax);
-        p->_rotationPerParticleSpeed = generateScalar(_rotationPerParticleSpeedMin, _rotationPerParticleSpeedMax);
-        p->_angle = generateScalar(0.0f, p->_rotationPerParticleSpeed);
-        p->_rotationSpeed = generateScalar(_rotationSpeedMin, _rotationSpeedMax);
+        unsigned int index = _particleCount;
+
+        generateColor(_colorStart, _colorStartVar, &colorStart);
+        generateColor(_colorEnd, _colorEndVar, &colorEnd);
+
+        float energy = generateScalar(_energyMin, _energyMax);
+        float sizeStart = generateScalar(_sizeStartMin, _sizeStartMax);
+        float rotationPerParticleSpeed = generateScalar(_rotationPerParticleSpeedMin, _rotationPerParticleSpeedMax);
+        float rotationSpeed = generateScalar(_rotationSpeedMin, _rotationSpeedMax);
+        p._energy[index] = energy;
+        p._energyStartInv[index] = 1.0f / energy;
+        p._size[index] = p._sizeStart[index] = sizeStart;
+        p._sizeEnd[index] = generateScalar(_sizeEndMin, _sizeEndMax);
+        p._rotationPerParticleSpeed[index] = rotationPerParticleSpeed;
+        p._angle[index] = generateScalar(0.0f, rotationPerParticleSpeed);
+        p._rotationSpeed[index] = rotationSpeed;
 
         // Only initial position can be generated within an ellipsoidal domain.
-        generateVector(_position, _positionVar, &p->_position, _ellipsoid);
-        generateVector(_velocity, _velocityVar, &p->_velocity, false);
-        generateVector(_acceleration, _accelerationVar, &p->_acceleration, false);
-        generateVector(_rotationAxis, _rotationAxisVar, &p->_rotationAxis, false);
+        generateVector(_position, _positionVar, &position, _ellipsoid);
+        generateVector(_velocity, _velocityVar, &velocity, false);
+        generateVector(_acceleration, _accelerationVar, &acceleration, false);
+        generateVector(_rotationAxis, _rotationAxisVar, &rotationAxis, false);
 
         // Initial position, velocity and acceleration can all be relative to the emitter's transform.
         // Rotate specified properties by the node's rotation.
         if (_orbitPosition)
         {
-            world.transformPoint(p->_position, &p->_position);
+            world.transformPoint(position, &position);
         }
 
         if (_orbitVelocity)
         {
-            world.transformPoint(p->_velocity, &p->_velocity);
+            world.transformPoint(velocity, &velocity);
         }
 
         if (_orbitAcceleration)
         {
-            world.transformPoint(p->_acceleration, &p->_acceleration);
+            world.transformPoint(acceleration, &acceleration);
         }
 
-        // The rotation axis always orbits the node.
-        if (p->_rotationSpeed != 0.0f && !p->_rotationAxis.isZero())
+        // The rotation axis always orbits the node. It is stored normalized so
+        // update() can rotate without rebuilding a rotation matrix per particle.
+        if (rotationSpeed != 0.0f && !rotationAxis.isZero())
         {
-            world.transformPoint(p->_rotationAxis, &p->_rotationAxis);
+            world.transformPoint(rotationAxis, &rotationAxis);
+            if (rotationAxis.length() > 0.000001f)
+            {
+                rotationAxis.normalize();
+            }
         }
 
         // Translate position relative to the node's world space.
-        p->_position.add(translation);
+        position.add(translation);
+
+        p._position[0][index] = position.x;
+        p._position[1][index] = position.y;
+        p._position[2][index] = position.z;
+        p._velocity[0][index] = velocity.x;
+        p._velocity[1][index] = velocity.y;
+        p._velocity[2][index] = velocity.z;
+        p._acceleration[0][index] = acceleration.x;
+        p._acceleration[1][index] = acceleration.y;
+        p._acceleration[2][index] = acceleration.z;
+        p._rotationAxis[0][index] = rotationAxis.x;
+        p._rotationAxis[1][index] = rotationAxis.y;
+        p._rotationAxis[2][index] = rotationAxis.z;
+        p._colorStart[0][index] = p._color[0][index] = colorStart.x;
+        p._colorStart[1][index] = p._color[1][index] = colorStart.y;
+        p._colorStart[2][index] = p._color[2][index] = colorStart.z;
+        p._colorStart[3][index] = p._color[3][index] = colorStart.w;
+        p._colorEnd[0][index] = colorEnd.x;
+        p._colorEnd[1][index] = colorEnd.y;
+        p._colorEnd[2][index] = colorEnd.z;
+        p._colorEnd[3][index] = colorEnd.w;
 
         // Initial sprite frame.
         if (_spriteFrameRandomOffset > 0)
         {
-            p->_frame = rand() % _spriteFrameRandomOffset;
+            p._frame[index] = generateRandom() % _spriteFrameRandomOffset;
         }
         else
         {
-            p->_frame = 0;
+            p._frame[index] = 0;
         }
-        p->_timeOnCurrentFrame = 0.0f;
+        p._timeOnCurrentFrame[index] = 0.0f;
 
         ++_particleCount;
     }
@@ -744,17 +988,47 @@ bool ParticleEmitter::getOrbitAcceleration() const
     return _orbitAcceleration;
 }
 
+void ParticleEmitter::setRandomSeed(unsigned int seed)
+{
+    // Scramble the seed so consecutive seeds start far apart, and
+    // avoid the all-zero state which xorshift can never leave.
+    seed = (seed ^ 61) ^ (seed >> 16);
+    seed *= 9;
+    seed = seed ^ (seed >> 4);
+    seed *= 0x27d4eb2d;
+    seed = seed ^ (seed >> 15);
+    _randomState = seed ? seed : 0x9e3779b9;
+}
+
+unsigned int ParticleEmitter::generateRandom()
+{
+    // xorshift32
+    unsigned int x = _randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    _randomState = x;
+    return x;
+}
+
+float ParticleEmitter::generateRandom0To1()
+{
+    // Use the top 24 bits so the result is exactly representable.
+    return (float)(generateRandom() >> 8) * (1.0f / 16777215.0f);
+}
+
+float ParticleEmitter::generateRandomMinus1To1()
+{
+    return 2.0f * generateRandom0To1() - 1.0f;
+}
+
 long ParticleEmitter::generateScalar(long min, long max)
 {
-    // Note: this is not a very good RNG, but it should be suitable for our purposes.
-    long r = 0;
-    for (unsigned int i = 0; i < sizeof(long)/sizeof(int); i++)
-    {
-        r = r << 8; // sizeof(int) * CHAR_BITS
-        r |= rand();
-    }
+    if (max <= min)
+        return min;
 
-    // Now we have a random long between 0 and MAX_LONG.  We need to clamp it between min and max.
+    // Clamp a random value between min and max.
+    long r = (long)(generateRandom() & 0x7fffffff);
     r %= max - min;
     r += min;
 
@@ -763,7 +1037,7 @@ long ParticleEmitter::generateScalar(long min, long max)
 
 float ParticleEmitter::generateScalar(float min, float max)
 {
-    return min + (max - min) * MATH_RANDOM_0_1();
+    return min + (max - min) * generateRandom0To1();
 }
 
 void ParticleEmitter::generateVectorInRect(const Vector3& base, const Vector3& variance, Vector3* dst)
@@ -772,9 +1046,9 @@ void ParticleEmitter::generateVectorInRect(const Vector3& base, const Vector3& v
 
     // Scale each component of the variance vector by a random float
     // between -1 and 1, then add this to the corresponding base component.
-    dst->x = base.x + variance.x * MATH_RANDOM_MINUS1_1();
-    dst->y = base.y + variance.y * MATH_RANDOM_MINUS1_1();
-    dst->z = base.z + variance.z * MATH_RANDOM_MINUS1_1();
+    dst->x = base.x + variance.x * generateRandomMinus1To1();
+    dst->y = base.y + variance.y * generateRandomMinus1To1();
+    dst->z = base.z + variance.z * generateRandomMinus1To1();
 }
 
 void ParticleEmitter::generateVectorInEllipsoid(const Vector3& center, const Vector3& scale, Vector3* dst)
@@ -784,9 +1058,9 @@ void ParticleEmitter::generateVectorInEllipsoid(const Vector3& center, const Vec
     // Generate a point within a unit cube, then reject if the point is not in a unit sphere.
     do
     {
-        dst->x = MATH_RANDOM_MINUS1_1();
-        dst->y = MATH_RANDOM_MINUS1_1();
-        dst->z = MATH_RANDOM_MINUS1_1();
+        dst->x = generateRandomMinus1To1();
+        dst->y = generateRandomMinus1To1();
+        dst->z = generateRandomMinus1To1();
     } while (dst->length() > 1.0f);
     
     // Scale this point by the scaling vector.
@@ -816,10 +1090,10 @@ void ParticleEmitter::generateColor(const Vector4& base, const Vector4& variance
 
     // Scale each component of the variance color by a random float
     // between -1 and 1, then add this to the corresponding base component.
-    dst->x = base.x + variance.x * MATH_RANDOM_MINUS1_1();
-    dst->y = base.y + variance.y * MATH_RANDOM_MINUS1_1();
-    dst->z = base.z + variance.z * MATH_RANDOM_MINUS1_1();
-    dst->w = base.w + variance.w * MATH_RANDOM_MINUS1_1();
+    dst->x = base.x + variance.x * generateRandomMinus1To1();
+    dst->y = base.y + variance.y * generateRandomMinus1To1();
+    dst->z = base.z + variance.z * generateRandomMinus1To1();
+    dst->w = base.w + variance.w * generateRandomMinus1To1();
 }
 
 ParticleEmitter::BlendMode ParticleEmitter::getBlendModeFromString(const char* str)
@@ -856,24 +1130,64 @@ ParticleEmitter::BlendMode ParticleEmitter::getBlendModeFromString(const char* s
     }
 }
 
+void ParticleEmitter::setUpdateStep(float step)
+{
+    GP_ASSERT(step > 0.0f);
+    _updateStep = step;
+}
+
+float ParticleEmitter::getUpdateStep() const
+{
+    return _updateStep;
+}
+
+void ParticleEmitter::setUpdateStepsMax(unsigned int steps)
+{
+    GP_ASSERT(steps);
+    _updateStepsMax = steps;
+}
+
+unsigned int ParticleEmitter::getUpdateStepsMax() const
+{
+    return _updateStepsMax;
+}
+
 void ParticleEmitter::update(float elapsedTime)
+{
+    // Emitters scheduled with the ParticleController are updated by it every frame.
+    if (_scheduled)
+        return;
+
+    updateInternal(elapsedTime, NULL);
+}
+
+void ParticleEmitter::updateInternal(float elapsedTime, JobController* jobs)
 {
     if (!isActive())
         return;
 
-    // Cap particle updates at a maximum rate. This saves processing
-    // and also improves precision since updating with very small
+    // Advance the simulation in fixed steps. This keeps the cost of an update
+    // bounded and also improves precision since updating with very small
     // time increments is more lossy.
-    static double runningTime = 0;
-    runningTime += elapsedTime;
-    if (runningTime < PARTICLE_UPDATE_RATE_MAX)
-        return;    
-
-    float elapsedMs = runningTime;
-    runningTime = 0;
+    _updateTime += elapsedTime;
+    unsigned int steps = 0;
+    while (_updateTime >= _updateStep && steps < _updateStepsMax)
+    {
+        simulate(_updateStep, jobs);
+        _updateTime -= _updateStep;
+        ++steps;
+    }
 
-    float elapsedSecs = elapsedMs * 0.001f;
+    // Drop whatever could not be caught up on so a long stall
+    // doesn't keep the emitter running behind in later frames.
+    if (_updateTime >= _updateStep)
+    {
+        _updateTime = fmod(_updateTime, _updateStep);
+    }
+}
 
+void ParticleEmitter::simulate(float elapsedMs, JobController* jobs)
+{
     if (_started && _emissionRate)
     {
         // Calculate how much time has passed since we last emitted particles.
@@ -889,93 +1203,127 @@ void ParticleEmitter::update(float elapsedTime)
             {
                 _emitTime = fmod((double)_emitTime, (double)_timePerEmission);
             }
-            emitOnce(emitCount);
+            emit(emitCount);
         }
     }
 
-    // Now update all currently living particles.
-    GP_ASSERT(_particles);
-    for (unsigned int particlesIndex = 0; particlesIndex < _particleCount; ++particlesIndex)
-    {
-        Particle* p = &_particles[particlesIndex];
-        p->_energy -= elapsedMs;
+    if (_particleCount == 0)
+        return;
+
+    ParticleData& p = _particles;
 
-        if (p->_energy > 0L)
+    // Age all particles, then remove the dead ones. The last living particle is moved
+    // down to take the place of each dead one so the live range stays packed.
+    particleSubtract(p._energy, elapsedMs, _particleCount);
+    unsigned int particlesIndex = 0;
+    while (particlesIndex < _particleCount)
+    {
+        if (p._energy[particlesIndex] > 0.0f)
         {
-            if (p->_rotationSpeed != 0.0f && !p->_rotationAxis.isZero())
-            {
-                Matrix::createRotation(p->_rotationAxis, p->_rotationSpeed * elapsedSecs, &_rotation);
+            ++particlesIndex;
+            continue;
+        }
 
-                _rotation.transformPoint(p->_velocity, &p->_velocity);
-                _rotation.transformPoint(p->_acceleration, &p->_acceleration);
-            }
+        --_particleCount;
+        if (particlesIndex != _particleCount)
+        {
+            p.copy(particlesIndex, _particleCount);
+        }
+    }
 
-            // Particle is still alive.
-            p->_velocity.x += p->_acceleration.x * elapsedSecs;
-            p->_velocity.y += p->_acceleration.y * elapsedSecs;
-            p->_velocity.z += p->_acceleration.z * elapsedSecs;
+    // Every remaining step is independent per particle, so very large
+    // emitters are split into chunks that run on the worker threads.
+    if (jobs && _particleCount > PARTICLE_JOB_SIZE)
+    {
+        jobs->parallelFor(_particleCount, PARTICLE_JOB_SIZE, [this, elapsedMs](unsigned int begin, unsigned int end)
+        {
+            simulateRange(begin, end, elapsedMs);
+        });
+    }
+    else
+    {
+        simulateRange(0, _particleCount, elapsedMs);
+    }
+}
 
-            p->_position.x += p->_velocity.x * elapsedSecs;
-            p->_position.y += p->_velocity.y * elapsedSecs;
-            p->_position.z += p->_velocity.z * elapsedSecs;
+void ParticleEmitter::simulateRange(unsigned int begin, unsigned int end, float elapsedMs)
+{
+    // Ranges must start on a group of four to keep the kernels aligned.
+    GP_ASSERT((begin & 3) == 0);
+    GP_ASSERT(end <= _particleCount);
 
-            p->_angle += p->_rotationPerParticleSpeed * elapsedSecs;
+    float elapsedSecs = elapsedMs * 0.001f;
+    unsigned int count = end - begin;
+    ParticleData& p = _particles;
 
-            // Simple linear interpolation of color and size.
-            float percent = 1.0f - ((float)p->_energy / (float)p->_energyStart);
+    // Spin velocity and acceleration around each particle's rotation axis.
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        float rotationSpeed = p._rotationSpeed[i];
+        if (rotationSpeed == 0.0f)
+            continue;
+
+        float ax = p._rotationAxis[0][i];
+        float ay = p._rotationAxis[1][i];
+        float az = p._rotationAxis[2][i];
+        if (ax == 0.0f && ay == 0.0f && az == 0.0f)
+            continue;
+
+        float angle = rotationSpeed * elapsedSecs;
+        float c = cos(angle);
+        float s = sin(angle);
+        rotateAroundAxis(ax, ay, az, c, s, &p._velocity[0][i], &p._velocity[1][i], &p._velocity[2][i]);
+        rotateAroundAxis(ax, ay, az, c, s, &p._acceleration[0][i], &p._acceleration[1][i], &p._acceleration[2][i]);
+    }
 
-            p->_color.x = p->_colorStart.x + (p->_colorEnd.x - p->_colorStart.x) * percent;
-            p->_color.y = p->_colorStart.y + (p->_colorEnd.y - p->_colorStart.y) * percent;
-            p->_color.z = p->_colorStart.z + (p->_colorEnd.z - p->_colorStart.z) * percent;
-            p->_color.w = p->_colorStart.w + (p->_colorEnd.w - p->_colorStart.w) * percent;
+    // Integrate motion.
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        particleMultiplyAdd(p._velocity[i] + begin, p._acceleration[i] + begin, elapsedSecs, count);
+        particleMultiplyAdd(p._position[i] + begin, p._velocity[i] + begin, elapsedSecs, count);
+    }
+    particleMultiplyAdd(p._angle + begin, p._rotationPerParticleSpeed + begin, elapsedSecs, count);
 
-            p->_size = p->_sizeStart + (p->_sizeEnd - p->_sizeStart) * percent;
+    // Simple linear interpolation of color and size.
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        particleLerp(p._color[i] + begin, p._colorStart[i] + begin, p._colorEnd[i] + begin, p._energy + begin, p._energyStartInv + begin, count);
+    }
+    particleLerp(p._size + begin, p._sizeStart + begin, p._sizeEnd + begin, p._energy + begin, p._energyStartInv + begin, count);
 
-            // Handle sprite animations.
-            if (_spriteAnimated)
+    // Handle sprite animations.
+    if (_spriteAnimated)
+    {
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            if (!_spriteLooped)
             {
-                if (!_spriteLooped)
+                // The last frame should finish exactly when the particle dies.
+                float percent = 1.0f - p._energy[i] * p._energyStartInv[i];
+                float percentSpent = p._frame[i] * _spritePercentPerFrame;
+                p._timeOnCurrentFrame[i] = percent - percentSpent;
+                if (p._frame[i] < _spriteFrameCount - 1 &&
+                    p._timeOnCurrentFrame[i] >= _spritePercentPerFrame)
                 {
-                    // The last frame should finish exactly when the particle dies.
-                    float percentSpent = 0.0f;
-                    for (unsigned int i = 0; i < p->_frame; i++)
-                    {
-                        percentSpent += _spritePercentPerFrame;
-                    }
-                    p->_timeOnCurrentFrame = percent - percentSpent;
-                    if (p->_frame < _spriteFrameCount - 1 &&
-                        p->_timeOnCurrentFrame >= _spritePercentPerFrame)
-                    {
-                        ++p->_frame;
-                    }
+                    ++p._frame[i];
                 }
-                else
+            }
+            else
+            {
+                // _spriteFrameDurationSecs is an absolute time measured in seconds,
+                // and the animation repeats indefinitely.
+                p._timeOnCurrentFrame[i] += elapsedSecs;
+                if (p._timeOnCurrentFrame[i] >= _spriteFrameDurationSecs)
                 {
-                    // _spriteFrameDurationSecs is an absolute time measured in seconds,
-                    // and the animation repeats indefinitely.
-                    p->_timeOnCurrentFrame += elapsedSecs;
-                    if (p->_timeOnCurrentFrame >= _spriteFrameDurationSecs)
+                    p._timeOnCurrentFrame[i] -= _spriteFrameDurationSecs;
+                    ++p._frame[i];
+                    if (p._frame[i] == _spriteFrameCount)
                     {
-                        p->_timeOnCurrentFrame -= _spriteFrameDurationSecs;
-                        ++p->_frame;
-                        if (p->_frame == _spriteFrameCount)
-                        {
-                            p->_frame = 0;
-                        }
+                        p._frame[i] = 0;
                     }
                 }
             }
         }
-        else
-        {
-            // Particle is dead.  Move the particle furthest from the start of the array
-            // down to take its place, and re-use the slot at the end of the list of living particles.
-            if (particlesIndex != _particleCount - 1)
-            {
-                _particles[particlesIndex] = _particles[_particleCount - 1];
-            }
-            --_particleCount;
-        }
     }
 }
 
@@ -987,7 +1335,6 @@ unsigned int ParticleEmitter::draw(bool wireframe)
     if (_particleCount > 0)
     {
         GP_ASSERT(_spriteBatch);
-        GP_ASSERT(_particles);
         GP_ASSERT(_spriteTextureCoords);
 
         // Set our node's view projection matrix to this emitter's effect.
@@ -1011,13 +1358,16 @@ unsigned int ParticleEmitter::draw(bool wireframe)
         Vector3 up;
         cameraWorldMatrix.getUpVector(&up);
 
+        const ParticleData& p = _particles;
         for (unsigned int i = 0; i < _particleCount; i++)
         {
-            Particle* p = &_particles[i];
+            Vector3 position(p._position[0][i], p._position[1][i], p._position[2][i]);
+            Vector4 color(p._color[0][i], p._color[1][i], p._color[2][i], p._color[3][i]);
+            const float* texCoords = &_spriteTextureCoords[p._frame[i] * 4];
 
-            _spriteBatch->draw(p->_position, right, up, p->_size, p->_size,
-                                _spriteTextureCoords[p->_frame * 4], _spriteTextureCoords[p->_frame * 4 + 1], _spriteTextureCoords[p->_frame * 4 + 2], _spriteTextureCoords[p->_frame * 4 + 3],
-                                p->_color, pivot, p->_angle);
+            _spriteBatch->draw(position, right, up, p._size[i], p._size[i],
+                                texCoords[0], texCoords[1], texCoords[2], texCoords[3],
+                                color, pivot, p._angle[i]);
         }
 
         // Render.
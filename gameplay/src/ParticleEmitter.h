@@ -14,6 +14,7 @@ namespace gameplay
 {
 
 class Node;
+class JobController;
 
 /**
  * Defines a particle emitter that can be made to simulate and render a particle system.
@@ -139,6 +140,7 @@ class Node;
 class ParticleEmitter : public Ref, public Drawable
 {
     friend class Node;
+    friend class ParticleController;
 
 public:
 
@@ -697,9 +699,60 @@ public:
      */
     BlendMode getBlendMode() const;
 
+    /**
+     * Sets the fixed time step the particle simulation advances by.
+     *
+     * Time passed to update() is accumulated per emitter and the simulation
+     * is advanced in whole steps of this size. The default is 1/60th of a second.
+     *
+     * @param step The simulation time step, in milliseconds.
+     */
+    void setUpdateStep(float step);
+
+    /**
+     * Gets the fixed time step the particle simulation advances by.
+     *
+     * @return The simulation time step, in milliseconds.
+     */
+    float getUpdateStep() const;
+
+    /**
+     * Sets the maximum number of simulation steps taken by a single call to update().
+     *
+     * When more time than this has accumulated (for example after a stall), the
+     * remaining time is dropped rather than simulated in later frames. The default is 4.
+     *
+     * @param steps The maximum number of steps per update.
+     */
+    void setUpdateStepsMax(unsigned int steps);
+
+    /**
+     * Gets the maximum number of simulation steps taken by a single call to update().
+     *
+     * @return The maximum number of steps per update.
+     */
+    unsigned int getUpdateStepsMax() const;
+
+    /**
+     * Seeds the random stream used to generate new particles.
+     *
+     * Each emitter has its own stream, so emitters seeded with the same value
+     * and driven with the same elapsed times produce identical particles.
+     *
+     * @param seed The seed value.
+     */
+    void setRandomSeed(unsigned int seed);
+
     /**
      * Updates the particles currently being emitted.
      *
+     * Started emitters, and emitters that still have live particles, are updated
+     * automatically each frame by the game's ParticleController, and calling this
+     * method does nothing for them, so that they are not advanced twice in a frame.
+     * Games that used to call update() on their emitters every frame keep working
+     * unchanged, and can drop the call. This only updates emitters when there is no
+     * ParticleController, such as before the game has started.
+     *
      * @param elapsedTime The amount of time that has passed since the last call to update(), in milliseconds.
      */
     void update(float elapsedTime);
@@ -743,6 +796,30 @@ private:
      */
     static ParticleEmitter* create(Texture* texture, BlendMode blendMode,  unsigned int particleCountMax);
 
+    // Registers the emitter with the game's ParticleController, if there is one, to be updated every frame.
+    void scheduleUpdate();
+
+    // Emits particles without registering with the ParticleController. Safe to call from a job.
+    void emit(unsigned int particleCount);
+
+    // Updates the emitter, splitting large simulation steps into jobs when a job controller is given.
+    void updateInternal(float elapsedTime, JobController* jobs);
+
+    // Advances the simulation by a single step.
+    void simulate(float elapsedMs, JobController* jobs);
+
+    // Advances the particles in the range [begin, end) by a single step; begin must be a multiple of four.
+    void simulateRange(unsigned int begin, unsigned int end, float elapsedMs);
+
+    // Generates the next number in this emitter's random stream.
+    unsigned int generateRandom();
+
+    // Generates a random float between 0 and 1.
+    float generateRandom0To1();
+
+    // Generates a random float between -1 and 1.
+    float generateRandomMinus1To1();
+
     // Generates a scalar within the range defined by min and max.
     float generateScalar(float min, float max);
 
@@ -763,34 +840,76 @@ private:
     static ParticleEmitter::BlendMode getBlendModeFromString(const char* src);
 
     /**
-     * Defines the data for a single particle in the system.
+     * Defines the particle data for the system, stored as a structure of arrays.
+     *
+     * Every attribute lives in its own contiguous, 16-byte aligned stream whose length is
+     * rounded up to a multiple of four, so the update kernels can process four particles
+     * per instruction. Live particles are always packed at the front of the streams.
      */
-    class Particle
+    class ParticleData
     {
-
     public:
-        Vector3 _position;
-        Vector3 _velocity;
-        Vector3 _acceleration;
-        Vector4 _colorStart;
-        Vector4 _colorEnd;
-        Vector4 _color;
-        float _rotationPerParticleSpeed;
-        Vector3 _rotationAxis;
-        float _rotationSpeed;
-        float _angle;
-        long _energyStart;
-        long _energy;
-        float _sizeStart;
-        float _sizeEnd;
-        float _size;
-        unsigned int _frame;
-        float _timeOnCurrentFrame;
+
+        /**
+         * Constructor.
+         */
+        ParticleData();
+
+        /**
+         * Destructor.
+         */
+        ~ParticleData();
+
+        /**
+         * (Re)allocates the streams to hold the specified number of particles.
+         *
+         * @param capacity The number of particles to allocate storage for.
+         * @param preserveCount The number of leading particles to copy into the new storage.
+         */
+        void allocate(unsigned int capacity, unsigned int preserveCount);
+
+        /**
+         * Copies a particle from one slot to another.
+         *
+         * @param dst The destination slot.
+         * @param src The source slot.
+         */
+        void copy(unsigned int dst, unsigned int src);
+
+        float* _position[3];
+        float* _velocity[3];
+        float* _acceleration[3];
+        float* _rotationAxis[3];
+        float* _colorStart[4];
+        float* _colorEnd[4];
+        float* _color[4];
+        float* _rotationPerParticleSpeed;
+        float* _rotationSpeed;
+        float* _angle;
+        float* _energy;
+        float* _energyStartInv;
+        float* _sizeStart;
+        float* _sizeEnd;
+        float* _size;
+        float* _timeOnCurrentFrame;
+        unsigned int* _frame;
+        unsigned int _capacity;
+
+    private:
+
+        ParticleData(const ParticleData&);
+
+        ParticleData& operator=(const ParticleData&);
+
+        void bindStreams(float* data, unsigned int capacity);
+
+        float* _data;
+        float* _dataAligned;
     };
 
     unsigned int _particleCountMax;
     unsigned int _particleCount;
-    Particle* _particles;
+    ParticleData _particles;
     unsigned int _emissionRate;
     bool _started;
     bool _ellipsoid;
@@ -816,7 +935,6 @@ private:
     float _rotationSpeedMax;
     Vector3 _rotationAxis;
     Vector3 _rotationAxisVar;
-    Matrix _rotation;
     SpriteBatch* _spriteBatch;
     BlendMode _spriteBlendMode;
     float _spriteTextureWidth;
@@ -836,7 +954,11 @@ private:
     bool _orbitAcceleration;
     float _timePerEmission;
     float _emitTime;
-    double _lastUpdated;
+    float _updateStep;
+    unsigned int _updateStepsMax;
+    float _updateTime;
+    bool _scheduled;
+    unsigned int _randomState;
 };
 
 }
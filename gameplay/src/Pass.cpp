@@ -43,6 +43,50 @@ bool Pass::initialize(const char* vshPath, const char* fshPath, const char* defi
     return true;
 }
 
+bool Pass::removeSkinning()
+{
+    removeSkinningBindings();
+    if (_effect == NULL || _effect->_vshPath.empty())
+        return false;
+
+    // Rebuild the semicolon delimited defines without SKINNING, SKINNING_JOINT_COUNT and SKINNING_DUAL_QUATERNION.
+    std::string defines;
+    bool skinned = false;
+    size_t start = 0;
+    while (start <= _effect->_defines.length())
+    {
+        size_t end = _effect->_defines.find(';', start);
+        if (end == std::string::npos)
+            end = _effect->_defines.length();
+        std::string define = _effect->_defines.substr(start, end - start);
+        start = end + 1;
+
+        size_t nameStart = define.find_first_not_of(" \t");
+        if (nameStart == std::string::npos)
+            continue;
+        if (define.compare(nameStart, 8, "SKINNING") == 0)
+        {
+            skinned = true;
+            continue;
+        }
+        if (!defines.empty())
+            defines += ';';
+        defines += define;
+    }
+    if (!skinned)
+        return false;
+
+    Effect* effect = Effect::createFromFile(_effect->_vshPath.c_str(), _effect->_fshPath.c_str(), defines.c_str());
+    if (effect == NULL)
+    {
+        GP_WARN("Failed to create effect without skinning for pass. vertexShader = %s, fragmentShader = %s, defines = %s", _effect->_vshPath.c_str(), _effect->_fshPath.c_str(), defines.c_str());
+        return false;
+    }
+    SAFE_RELEASE(_effect);
+    _effect = effect;
+    return true;
+}
+
 const char* Pass::getId() const
 {
     return _id.c_str();
@@ -23,6 +23,7 @@ class Pass : public RenderState
     friend class Technique;
     friend class Material;
     friend class RenderState;
+    friend class Model;
 
 public:
 
@@ -111,6 +112,13 @@ private:
      */
     bool initialize(const char* vshPath, const char* fshPath, const char* defines);
 
+    /**
+     * Switches the pass to its effect without the skinning defines, for models skinned on the CPU.
+     *
+     * @return true if the effect of the pass changed, false otherwise.
+     */
+    bool removeSkinning();
+
     /**
      * Hidden copy assignment operator.
      */
@@ -0,0 +1,475 @@
+#include "Base.h"
+#include "RenderQueue.h"
+#include "Model.h"
+#include "MeshPart.h"
+#include "Terrain.h"
+#include "Scene.h"
+#include "Material.h"
+#include "Technique.h"
+#include "Pass.h"
+#include "MeshSkin.h"
+#include "FrustumCuller.h"
+
+// Layout of the sort keys. Opaque items sort by effect, material, vertex binding and then
+// front to back; translucent items sort after them, back to front first.
+#define RENDER_KEY_TRANSLUCENT          (1ULL << 63)
+#define RENDER_KEY_EFFECT_BITS          15
+#define RENDER_KEY_ID_BITS              16
+
+// Items whose keys only differ in these bits share an effect, a material and a vertex binding.
+#define RENDER_KEY_GROUP_MASK           (~0xFFFFULL)
+
+namespace gameplay
+{
+
+// Folds a pointer into a small identifier used to group items in sort keys.
+// Collisions only make the grouping less effective.
+static inline unsigned long long getKeyId(const void* p, unsigned int bits)
+{
+    unsigned long long value = (unsigned long long)(size_t)p;
+    value = (value >> 4) ^ (value >> 20) ^ (value >> 36);
+    return value & ((1ULL << bits) - 1);
+}
+
+// Gets the upper 16 bits of a non-negative depth, which sort like the depth itself.
+static inline unsigned int getDepthBits(float depth)
+{
+    if (!(depth > 0.0f))
+        return 0;
+    unsigned int bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    return bits >> 16;
+}
+
+// The per-instance elements of the instance buffer: the columns of a world matrix.
+static const VertexFormat::Element __instanceElements[] =
+{
+    VertexFormat::Element(VertexFormat::INSTANCE_MATRIX0, 4),
+    VertexFormat::Element(VertexFormat::INSTANCE_MATRIX1, 4),
+    VertexFormat::Element(VertexFormat::INSTANCE_MATRIX2, 4),
+    VertexFormat::Element(VertexFormat::INSTANCE_MATRIX3, 4)
+};
+
+// Determines whether instanced draw calls are available on the current context.
+static bool isInstancingSupported()
+{
+#ifdef GP_USE_INSTANCING
+    return glVertexAttribDivisor && glDrawElementsInstanced && glDrawArraysInstanced;
+#else
+    return false;
+#endif
+}
+
+RenderQueue::RenderQueue()
+    : _instanceBuffer(0), _instanceBufferSize(0), _instancingEnabled(true), _camera(NULL), _culler(NULL), _effectChanges(0), _materialChanges(0), _vertexBindingChanges(0),
+      _indexBufferChanges(0), _stateChangesSaved(0),
+      _instancedItems(0)
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+    SAFE_RELEASE(_camera);
+    SAFE_DELETE(_culler);
+
+    if (_instanceBuffer)
+    {
+        GL_ASSERT( glDeleteBuffers(1, &_instanceBuffer) );
+        _instanceBuffer = 0;
+    }
+}
+
+void RenderQueue::setCamera(Camera* camera)
+{
+    if (_camera != camera)
+    {
+        SAFE_RELEASE(_camera);
+        _camera = camera;
+        if (_camera)
+            _camera->addRef();
+    }
+}
+
+Camera* RenderQueue::getCamera() const
+{
+    return _camera;
+}
+
+void RenderQueue::add(Drawable* drawable)
+{
+    GP_ASSERT(drawable);
+    Node* node = drawable->getNode();
+    GP_ASSERT(node);
+
+    // Compute the view depth of the node.
+    unsigned int depth = 0;
+    Camera* camera = _camera;
+    if (!camera && node->getScene())
+        camera = node->getScene()->getActiveCamera();
+    if (camera && camera->getNode())
+    {
+        Node* cameraNode = camera->getNode();
+        Vector3 offset = node->getTranslationWorld() - cameraNode->getTranslationWorld();
+        depth = getDepthBits(offset.dot(cameraNode->getForwardVectorWorld()));
+    }
+
+    Model* model = dynamic_cast<Model*>(drawable);
+    if (model && model->getMesh())
+    {
+        // Vertices skinned on the CPU are written before the items of the model are drawn.
+        if (model->getSkin())
+            model->getSkin()->updateSkinnedVertices();
+
+        Mesh* mesh = model->getMesh();
+        unsigned int partCount = mesh->getPartCount();
+        if (partCount == 0)
+        {
+            // No mesh parts (index buffers).
+            addPasses(model, mesh, NULL, 0, depth);
+        }
+        else
+        {
+            for (unsigned int i = 0; i < partCount; ++i)
+            {
+                addPasses(model, mesh, mesh->getPart(i), i, depth);
+            }
+        }
+    }
+    else
+    {
+        Item item = { drawable, NULL, NULL, NULL };
+        if (dynamic_cast<Terrain*>(drawable))
+            addItem(item, depth);
+        else
+            addItem(item, RENDER_KEY_TRANSLUCENT | ((unsigned long long)(0xFFFF - depth) << 47));
+    }
+}
+
+unsigned int RenderQueue::add(Scene* scene)
+{
+    GP_ASSERT(scene);
+
+    Camera* camera = _camera ? _camera : scene->getActiveCamera();
+    if (camera == NULL)
+    {
+        GP_WARN("Failed to add the visible drawables of a scene without a camera to the render queue.");
+        return 0;
+    }
+
+    if (_culler == NULL)
+        _culler = new FrustumCuller();
+    _culler->cull(scene, camera->getFrustum());
+
+    unsigned int count = _culler->getVisibleCount();
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        add(_culler->getVisibleNode(i)->getDrawable());
+    }
+    return count;
+}
+
+void RenderQueue::addPasses(Model* model, Mesh* mesh, MeshPart* part, unsigned int materialIndex, unsigned int depth)
+{
+    Material* material = part ? model->getMaterial(materialIndex) : model->getMaterial();
+    if (!material)
+        return;
+
+    Technique* technique = material->getTechnique();
+    GP_ASSERT(technique);
+    for (unsigned int i = 0, passCount = technique->getPassCount(); i < passCount; ++i)
+    {
+        Pass* pass = technique->getPassByIndex(i);
+        GP_ASSERT(pass);
+
+        unsigned long long effect = getKeyId(pass->getEffect(), RENDER_KEY_EFFECT_BITS);
+        unsigned long long materialId = getKeyId(material, RENDER_KEY_ID_BITS);
+        unsigned long long binding = getKeyId(pass->getVertexAttributeBinding(), RENDER_KEY_ID_BITS);
+
+        unsigned long long key;
+        if (pass->isBlendEnabled())
+        {
+            // Passes of the same material keep their order, since depth ties are broken by
+            // the remaining bits and items are sorted stably.
+            key = RENDER_KEY_TRANSLUCENT | ((unsigned long long)(0xFFFF - depth) << 47) | (effect << 32) | (materialId << 16) | binding;
+        }
+        else
+        {
+            key = (effect << 48) | (materialId << 32) | (binding << 16) | depth;
+        }
+
+        Item item = { model, pass, mesh, part };
+        addItem(item, key);
+    }
+}
+
+void RenderQueue::addItem(const Item& item, unsigned long long key)
+{
+    _keys.push_back(std::make_pair(key, (unsigned int)_items.size()));
+    _items.push_back(item);
+}
+
+static bool compareKeys(const std::pair<unsigned long long, unsigned int>& a, const std::pair<unsigned long long, unsigned int>& b)
+{
+    return a.first < b.first;
+}
+
+unsigned int RenderQueue::draw()
+{
+    _effectChanges = 0;
+    _materialChanges = 0;
+    _vertexBindingChanges = 0;
+    _indexBufferChanges = 0;
+    _stateChangesSaved = 0;
+    _instancedItems = 0;
+
+    std::stable_sort(_keys.begin(), _keys.end(), compareKeys);
+
+    bool instancing = _instancingEnabled && isInstancingSupported();
+    _instanced.assign(_keys.size(), false);
+
+    unsigned int drawCalls = 0;
+    Effect* currentEffect = NULL;
+    RenderState* currentMaterial = NULL;
+    VertexAttributeBinding* currentBinding = NULL;
+    IndexBufferHandle currentIndexBuffer = 0;
+    bool indexBufferKnown = false;
+
+    for (size_t i = 0, count = _keys.size(); i < count; ++i)
+    {
+        // Skip the items already drawn as instances of an earlier item.
+        if (_instanced[i])
+            continue;
+
+        const Item& item = _items[_keys[i].second];
+        Pass* pass = item.pass;
+        if (pass == NULL)
+        {
+            // The drawable binds its own state, so nothing can be assumed to be bound afterwards.
+            if (currentBinding)
+            {
+                currentBinding->unbind();
+                currentBinding = NULL;
+            }
+            currentEffect = NULL;
+            currentMaterial = NULL;
+            indexBufferKnown = false;
+
+            drawCalls += item.drawable->draw();
+            continue;
+        }
+
+        Effect* effect = pass->getEffect();
+        GP_ASSERT(effect);
+        if (effect != currentEffect)
+        {
+            effect->bind();
+            currentEffect = effect;
+            ++_effectChanges;
+        }
+        else
+        {
+            ++_stateChangesSaved;
+        }
+
+        // Parameters and state blocks are bound for every item, since their values
+        // (such as the world matrix) differ from one node to the next.
+        RenderState* technique = static_cast<RenderState*>(pass)->_parent;
+        RenderState* material = technique ? technique->_parent : NULL;
+        if (material != currentMaterial)
+        {
+            currentMaterial = material;
+            ++_materialChanges;
+        }
+        static_cast<RenderState*>(pass)->bind(pass);
+
+        VertexAttributeBinding* binding = pass->getVertexAttributeBinding();
+        if (binding != currentBinding)
+        {
+            if (currentBinding)
+                currentBinding->unbind();
+            if (binding)
+                binding->bind();
+            currentBinding = binding;
+            ++_vertexBindingChanges;
+
+            // The element array buffer binding is part of the vertex array object state.
+            indexBufferKnown = false;
+        }
+        else
+        {
+            ++_stateChangesSaved;
+        }
+
+        IndexBufferHandle indexBuffer = item.part ? item.part->getIndexBuffer() : 0;
+        if (!indexBufferKnown || indexBuffer != currentIndexBuffer)
+        {
+            GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer) );
+            currentIndexBuffer = indexBuffer;
+            indexBufferKnown = true;
+            ++_indexBufferChanges;
+        }
+        else
+        {
+            ++_stateChangesSaved;
+        }
+
+        VertexAttribute instanceAttribute = effect->getVertexAttribute(VERTEX_ATTRIBUTE_INSTANCE_MATRIX_NAME);
+        if (instanceAttribute == -1)
+        {
+            drawItem(item);
+        }
+        else if (instancing && !(_keys[i].first & RENDER_KEY_TRANSLUCENT) && !static_cast<Model*>(item.drawable)->getSkin())
+        {
+            // Gather the later items of the same group that draw the same mesh part with the same pass.
+            _instanceData.clear();
+            _instanceData.push_back(item.drawable->getNode()->getWorldMatrix());
+            unsigned long long group = _keys[i].first & RENDER_KEY_GROUP_MASK;
+            for (size_t j = i + 1; j < count && (_keys[j].first & RENDER_KEY_GROUP_MASK) == group; ++j)
+            {
+                const Item& other = _items[_keys[j].second];
+                if (!_instanced[j] && other.pass == pass && other.mesh == item.mesh && other.part == item.part &&
+                    !static_cast<Model*>(other.drawable)->getSkin())
+                {
+                    _instanceData.push_back(other.drawable->getNode()->getWorldMatrix());
+                    _instanced[j] = true;
+                }
+            }
+
+            drawInstances(item, instanceAttribute);
+            _instancedItems += (unsigned int)_instanceData.size();
+        }
+        else
+        {
+            // Supply the world matrix as a constant value of the instance attribute.
+            const float* m = item.drawable->getNode()->getWorldMatrix().m;
+            for (unsigned int c = 0; c < 4; ++c)
+            {
+                GL_ASSERT( glVertexAttrib4fv(instanceAttribute + c, m + c * 4) );
+            }
+            drawItem(item);
+        }
+        ++drawCalls;
+    }
+
+    if (currentBinding)
+        currentBinding->unbind();
+
+    return drawCalls;
+}
+
+void RenderQueue::drawItem(const Item& item)
+{
+    if (item.part)
+    {
+        GL_ASSERT( glDrawElements(item.part->getPrimitiveType(), item.part->getIndexCount(), item.part->getIndexFormat(), 0) );
+    }
+    else
+    {
+        GL_ASSERT( glDrawArrays(item.mesh->getPrimitiveType(), 0, item.mesh->getVertexCount()) );
+    }
+}
+
+void RenderQueue::drawInstances(const Item& item, VertexAttribute instanceAttribute)
+{
+#ifdef GP_USE_INSTANCING
+    GP_ASSERT(!_instanceData.empty());
+    GLsizei instanceCount = (GLsizei)_instanceData.size();
+    unsigned int size = (unsigned int)(_instanceData.size() * sizeof(Matrix));
+
+    if (!_instanceBuffer)
+    {
+        GL_ASSERT( glGenBuffers(1, &_instanceBuffer) );
+    }
+    GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, _instanceBuffer) );
+    if (size > _instanceBufferSize)
+    {
+        // Grow the buffer geometrically so it is rarely reallocated.
+        _instanceBufferSize = std::max(size, _instanceBufferSize * 2);
+        GL_ASSERT( glBufferData(GL_ARRAY_BUFFER, _instanceBufferSize, NULL, GL_DYNAMIC_DRAW) );
+    }
+    GL_ASSERT( glBufferSubData(GL_ARRAY_BUFFER, 0, size, &_instanceData[0]) );
+
+    // Bind each column of the world matrix to its attribute location, advancing once per instance.
+    size_t offset = 0;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        const VertexFormat::Element& e = __instanceElements[i];
+        GLuint attribute = (GLuint)(instanceAttribute + (e.usage - VertexFormat::INSTANCE_MATRIX0));
+        GL_ASSERT( glVertexAttribPointer(attribute, (GLint)e.size, GL_FLOAT, GL_FALSE, (GLsizei)sizeof(Matrix), (void*)offset) );
+        GL_ASSERT( glEnableVertexAttribArray(attribute) );
+        GL_ASSERT( glVertexAttribDivisor(attribute, 1) );
+        offset += e.size * sizeof(float);
+    }
+
+    if (item.part)
+    {
+        GL_ASSERT( glDrawElementsInstanced(item.part->getPrimitiveType(), item.part->getIndexCount(), item.part->getIndexFormat(), 0, instanceCount) );
+    }
+    else
+    {
+        GL_ASSERT( glDrawArraysInstanced(item.mesh->getPrimitiveType(), 0, item.mesh->getVertexCount(), instanceCount) );
+    }
+
+    // Restore the attributes, which may be part of the state of the bound vertex array object.
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        GLuint attribute = (GLuint)(instanceAttribute + i);
+        GL_ASSERT( glVertexAttribDivisor(attribute, 0) );
+        GL_ASSERT( glDisableVertexAttribArray(attribute) );
+    }
+    GL_ASSERT( glBindBuffer(GL_ARRAY_BUFFER, 0) );
+#endif
+}
+
+void RenderQueue::clear()
+{
+    _items.clear();
+    _keys.clear();
+}
+
+unsigned int RenderQueue::getItemCount() const
+{
+    return (unsigned int)_items.size();
+}
+
+unsigned int RenderQueue::getEffectChangeCount() const
+{
+    return _effectChanges;
+}
+
+unsigned int RenderQueue::getMaterialChangeCount() const
+{
+    return _materialChanges;
+}
+
+unsigned int RenderQueue::getVertexBindingChangeCount() const
+{
+    return _vertexBindingChanges;
+}
+
+unsigned int RenderQueue::getIndexBufferChangeCount() const
+{
+    return _indexBufferChanges;
+}
+
+unsigned int RenderQueue::getStateChangesSaved() const
+{
+    return _stateChangesSaved;
+}
+
+void RenderQueue::setInstancingEnabled(bool enabled)
+{
+    _instancingEnabled = enabled;
+}
+
+bool RenderQueue::isInstancingEnabled() const
+{
+    return _instancingEnabled;
+}
+
+unsigned int RenderQueue::getInstancedItemCount() const
+{
+    return _instancedItems;
+}
+
+}
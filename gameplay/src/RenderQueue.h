@@ -0,0 +1,248 @@
+#ifndef RENDERQUEUE_H_
+#define RENDERQUEUE_H_
+
+#include "Vector3.h"
+#include "Matrix.h"
+
+namespace gameplay
+{
+
+class Camera;
+class Drawable;
+class FrustumCuller;
+class Scene;
+class Model;
+class Mesh;
+class MeshPart;
+class Pass;
+
+/**
+ * Defines a queue of draw items that are sorted to minimize state changes before they are submitted.
+ *
+ * Models added to the queue are broken down into one draw item per mesh part and pass.
+ * Each item is given a 64-bit sort key packing whether it is translucent, its effect,
+ * its material, its vertex attribute binding and its depth from the camera. Opaque
+ * items are drawn first, grouped by effect, material and vertex binding and then front
+ * to back; translucent items (those whose render state enables blending) are drawn
+ * afterwards, back to front. Submission only binds an effect, a vertex attribute
+ * binding or an index buffer when it differs from the previous item.
+ *
+ * Opaque items that share a pass and a mesh part are drawn with a single instanced draw
+ * call when their effect declares the per-instance world matrix attribute
+ * (VERTEX_ATTRIBUTE_INSTANCE_MATRIX_NAME, a mat4). The world matrices of the instances
+ * are packed into an instance buffer and read through the VertexFormat::INSTANCE_MATRIX
+ * elements, so such effects should transform vertices by the instance matrix and the
+ * VIEW_PROJECTION_MATRIX rather than by the WORLD_VIEW_PROJECTION_MATRIX. The built-in
+ * colored and textured shaders do so with the INSTANCED define, in which case materials
+ * bind u_viewProjectionMatrix to VIEW_PROJECTION_MATRIX, and u_viewMatrix to VIEW_MATRIX
+ * when lit; instances must then be scaled uniformly. Models sharing a mesh must also
+ * share the material for their items to be instanced. Instanced draw calls are only used
+ * on desktop OpenGL (GP_USE_INSTANCING). Elsewhere (OpenGL ES 2), or for translucent and
+ * skinned items, the world matrix is supplied as a constant attribute value and each item
+ * is drawn separately.
+ *
+ * Drawables other than models (terrain, sprites, text, forms and particle emitters)
+ * manage their own state, so they are drawn as a whole: terrain with the opaque items
+ * and the others with the translucent items.
+ *
+ * The queue is typically filled each frame with the drawables of a scene that are visible
+ * to the camera, using add(Scene*), drawn, and cleared.
+ */
+class RenderQueue
+{
+public:
+
+    /**
+     * Constructor.
+     */
+    RenderQueue();
+
+    /**
+     * Destructor.
+     */
+    ~RenderQueue();
+
+    /**
+     * Sets the camera used to compute the depth of the items added to the queue.
+     *
+     * If no camera is set, the active camera of the scene of each drawable is used.
+     *
+     * @param camera The camera, or NULL.
+     */
+    void setCamera(Camera* camera);
+
+    /**
+     * Gets the camera used to compute the depth of the items added to the queue.
+     *
+     * @return The camera, or NULL.
+     */
+    Camera* getCamera() const;
+
+    /**
+     * Adds the draw items of a drawable to the queue.
+     *
+     * The drawable must be attached to a node, and must not be released before the
+     * queue is drawn or cleared.
+     *
+     * @param drawable The drawable to add.
+     */
+    void add(Drawable* drawable);
+
+    /**
+     * Adds the draw items of the drawables of a scene that are visible to the camera.
+     *
+     * The drawables of the scene's enabled nodes are culled against the frustum of the
+     * camera of the queue, or of the scene's active camera if the queue has none, with a
+     * FrustumCuller kept by the queue, and the visible ones are added.
+     *
+     * @param scene The scene to add the visible drawables of.
+     *
+     * @return The number of drawables added.
+     */
+    unsigned int add(Scene* scene);
+
+    /**
+     * Sorts and draws all items in the queue.
+     *
+     * The queue is not cleared, so it may be drawn several times.
+     *
+     * @return The number of graphics draw calls issued.
+     */
+    unsigned int draw();
+
+    /**
+     * Removes all items from the queue.
+     */
+    void clear();
+
+    /**
+     * Gets the number of items in the queue.
+     *
+     * @return The number of items.
+     */
+    unsigned int getItemCount() const;
+
+    /**
+     * Gets the number of effect (shader program) changes made by the last call to draw().
+     *
+     * @return The number of effect changes.
+     */
+    unsigned int getEffectChangeCount() const;
+
+    /**
+     * Gets the number of material changes made by the last call to draw().
+     *
+     * @return The number of material changes.
+     */
+    unsigned int getMaterialChangeCount() const;
+
+    /**
+     * Gets the number of vertex attribute binding changes made by the last call to draw().
+     *
+     * @return The number of vertex attribute binding changes.
+     */
+    unsigned int getVertexBindingChangeCount() const;
+
+    /**
+     * Gets the number of index buffer changes made by the last call to draw().
+     *
+     * @return The number of index buffer changes.
+     */
+    unsigned int getIndexBufferChangeCount() const;
+
+    /**
+     * Gets the number of effect, vertex attribute binding and index buffer changes saved by
+     * the last call to draw(), compared to binding all of them for every item as Model::draw does.
+     *
+     * @return The number of state changes saved.
+     */
+    unsigned int getStateChangesSaved() const;
+
+    /**
+     * Sets whether opaque items that share a pass and a mesh part are drawn with instanced
+     * draw calls. Instancing is enabled by default.
+     *
+     * @param enabled true to enable instancing, false to draw every item separately.
+     */
+    void setInstancingEnabled(bool enabled);
+
+    /**
+     * Determines whether opaque items that share a pass and a mesh part are drawn with
+     * instanced draw calls.
+     *
+     * @return true if instancing is enabled, false otherwise.
+     */
+    bool isInstancingEnabled() const;
+
+    /**
+     * Gets the number of items drawn by instanced draw calls in the last call to draw().
+     *
+     * @return The number of instanced items.
+     */
+    unsigned int getInstancedItemCount() const;
+
+private:
+
+    /**
+     * A single draw call: a mesh part (or a whole mesh without parts) drawn with a pass,
+     * or a drawable that is drawn as a whole when pass is NULL.
+     */
+    struct Item
+    {
+        Drawable* drawable;
+        Pass* pass;
+        Mesh* mesh;
+        MeshPart* part;
+    };
+
+    /**
+     * Hidden copy constructor.
+     */
+    RenderQueue(const RenderQueue& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    RenderQueue& operator=(const RenderQueue&);
+
+    /**
+     * Adds an item for each pass of a material.
+     */
+    void addPasses(Model* model, Mesh* mesh, MeshPart* part, unsigned int materialIndex, unsigned int depth);
+
+    /**
+     * Adds an item with the given sort key.
+     */
+    void addItem(const Item& item, unsigned long long key);
+
+    /**
+     * Issues the draw call of an item, whose state is already bound.
+     */
+    void drawItem(const Item& item);
+
+    /**
+     * Uploads the world matrices in _instanceData to the instance buffer and issues an
+     * instanced draw call of an item for them.
+     */
+    void drawInstances(const Item& item, VertexAttribute instanceAttribute);
+
+    std::vector<Item> _items;
+    std::vector<std::pair<unsigned long long, unsigned int> > _keys;
+    std::vector<bool> _instanced;
+    std::vector<Matrix> _instanceData;
+    GLuint _instanceBuffer;
+    unsigned int _instanceBufferSize;
+    bool _instancingEnabled;
+    Camera* _camera;
+    FrustumCuller* _culler;
+    unsigned int _effectChanges;
+    unsigned int _materialChanges;
+    unsigned int _vertexBindingChanges;
+    unsigned int _indexBufferChanges;
+    unsigned int _stateChangesSaved;
+    unsigned int _instancedItems;
+};
+
+}
+
+#endif
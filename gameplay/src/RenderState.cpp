@@ -110,6 +110,23 @@ void RenderState::removeParameter(const char* name)
     }
 }
 
+void RenderState::removeSkinningBindings()
+{
+    std::map<std::string, std::string>::iterator itr = _autoBindings.begin();
+    while (itr != _autoBindings.end())
+    {
+        if (itr->second == "MATRIX_PALETTE" || itr->second == "DUAL_QUATERNION_PALETTE")
+        {
+            removeParameter(itr->first.c_str());
+            _autoBindings.erase(itr++);
+        }
+        else
+        {
+            ++itr;
+        }
+    }
+}
+
 /**
  * @script{ignore}
  */
@@ -142,6 +159,8 @@ const char* autoBindingToString(RenderState::AutoBinding autoBinding)
         return "MATRIX_PALETTE";
     case RenderState::SCENE_AMBIENT_COLOR:
         return "SCENE_AMBIENT_COLOR";
+    case RenderState::DUAL_QUATERNION_PALETTE:
+        return "DUAL_QUATERNION_PALETTE";
     default:
         return "";
     }
@@ -293,6 +312,10 @@ void RenderState::applyAutoBinding(const char* uniformName, const char* autoBind
         {
             param->bindValue(this, &RenderState::autoBindingGetAmbientColor);
         }
+        else if (strcmp(autoBinding, "DUAL_QUATERNION_PALETTE") == 0)
+        {
+            param->bindValue(this, &RenderState::autoBindingGetDualQuaternionPalette, &RenderState::autoBindingGetDualQuaternionPaletteSize);
+        }
         else
         {
             bound = false;
@@ -381,6 +404,30 @@ unsigned int RenderState::autoBindingGetMatrixPaletteSize() const
     return 0;
 }
 
+const Vector4* RenderState::autoBindingGetDualQuaternionPalette() const
+{
+    Model* model = dynamic_cast<Model*>(_nodeBinding->getDrawable());
+    if (model)
+    {
+        MeshSkin* skin = model->getSkin();
+        if (skin)
+            return skin->getDualQuaternionPalette();
+    }
+    return NULL;
+}
+
+unsigned int RenderState::autoBindingGetDualQuaternionPaletteSize() const
+{
+    Model* model = dynamic_cast<Model*>(_nodeBinding->getDrawable());
+    if (model)
+    {
+        MeshSkin* skin = model->getSkin();
+        if (skin)
+            return skin->getDualQuaternionPaletteSize();
+    }
+    return 0;
+}
+
 const Vector3& RenderState::autoBindingGetAmbientColor() const
 {
     Scene* scene = _nodeBinding ? _nodeBinding->getScene() : NULL;
@@ -424,6 +471,16 @@ void RenderState::bind(Pass* pass)
     }
 }
 
+bool RenderState::isBlendEnabled() const
+{
+    for (const RenderState* rs = this; rs != NULL; rs = rs->_parent)
+    {
+        if (rs->_state && (rs->_state->_bits & RS_BLEND))
+            return rs->_state->_blendEnabled;
+    }
+    return false;
+}
+
 RenderState* RenderState::getTopmost(RenderState* below)
 {
     RenderState* rs = this;
@@ -1000,6 +1057,8 @@ const char* RenderState::enumToString(const char* enumName, int value)
                 return "MATRIX_PALETTE";
             case RenderState::SCENE_AMBIENT_COLOR:
                 return "SCENE_AMBIENT_COLOR";
+            case RenderState::DUAL_QUATERNION_PALETTE:
+                return "DUAL_QUATERNION_PALETTE";
             default:
                 return NULL;
         }
@@ -1161,6 +1220,8 @@ int RenderState::enumParse(const char* enumName, const char* str)
             return RenderState::MATRIX_PALETTE;
         else if (std::strcmp("SCENE_AMBIENT_COLOR", str) == 0)
             return RenderState::SCENE_AMBIENT_COLOR;
+        else if (std::strcmp("DUAL_QUATERNION_PALETTE", str) == 0)
+            return RenderState::DUAL_QUATERNION_PALETTE;
     }
     else if (std::strcmp("gameplay::RenderState::BlendMode", enumName) == 0)
     {
@@ -25,6 +25,7 @@ class RenderState : public Ref, public Serializable
     friend class Technique;
     friend class Pass;
     friend class Model;
+    friend class RenderQueue;
 
 public:
 
@@ -161,7 +162,14 @@ public:
         /**
          * Binds the current scene's ambient color (Vector3).
          */
-        SCENE_AMBIENT_COLOR
+        SCENE_AMBIENT_COLOR,
+
+        /**
+         * Binds the dual quaternion palette of MeshSkin attached to a node's model.
+         *
+         * @see MeshSkin::setDualQuaternionEnabled
+         */
+        DUAL_QUATERNION_PALETTE
     };
 
     /**
@@ -644,6 +652,12 @@ protected:
      */
     void bind(Pass* pass);
 
+    /**
+     * Determines if blending is enabled by the state blocks of this RenderState,
+     * or of the nearest of its parents that sets the blend state.
+     */
+    bool isBlendEnabled() const;
+
     /**
      * Returns the topmost RenderState in the hierarchy below the given RenderState.
      */
@@ -657,6 +671,11 @@ protected:
      */
     void cloneInto(RenderState* renderState, NodeCloneContext& context) const;
 
+    /**
+     * Removes the parameters bound to the matrix or dual quaternion palette of a skin.
+     */
+    void removeSkinningBindings();
+
 private:
 
     /**
@@ -692,6 +711,8 @@ private:
     Vector3 autoBindingGetCameraViewPosition() const;
     const Vector4* autoBindingGetMatrixPalette() const;
     unsigned int autoBindingGetMatrixPaletteSize() const;
+    const Vector4* autoBindingGetDualQuaternionPalette() const;
+    unsigned int autoBindingGetDualQuaternionPaletteSize() const;
     const Vector3& autoBindingGetAmbientColor() const;
     const Vector3& autoBindingGetLightColor() const;
     const Vector3& autoBindingGetLightDirection() const;
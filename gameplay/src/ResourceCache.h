@@ -0,0 +1,82 @@
+#ifndef RESOURCECACHE_H_
+#define RESOURCECACHE_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines a cache of shared resources, looked up by path.
+ *
+ * Resources are hashed by their path (or another key that identifies them uniquely, such
+ * as the shader paths and defines of an effect) so that finding a loaded resource takes
+ * constant time. The cache does not hold references to the resources: a resource is added
+ * when it is loaded, and removes itself when it is destroyed. Reference counts are not
+ * atomic, so the cache, like the resources it holds, must only be used from the main thread.
+ *
+ * @script{ignore}
+ */
+template <class T>
+class ResourceCache
+{
+public:
+
+    /**
+     * Finds the resource loaded from a path, and adds a reference to it.
+     *
+     * @param path The path of the resource.
+     *
+     * @return The resource, with a reference added, or NULL if no resource is cached for the path.
+     */
+    T* acquire(const std::string& path)
+    {
+        typename std::unordered_map<std::string, T*>::const_iterator itr = _resources.find(path);
+        if (itr == _resources.end())
+            return NULL;
+        GP_ASSERT(itr->second);
+        itr->second->addRef();
+        return itr->second;
+    }
+
+    /**
+     * Adds a resource loaded from a path, replacing any resource cached for the path.
+     *
+     * @param path The path of the resource.
+     * @param resource The resource.
+     */
+    void add(const std::string& path, T* resource)
+    {
+        GP_ASSERT(resource);
+        _resources[path] = resource;
+    }
+
+    /**
+     * Removes a resource from the cache, if it is the resource cached for its path.
+     *
+     * @param path The path of the resource.
+     * @param resource The resource.
+     */
+    void remove(const std::string& path, T* resource)
+    {
+        typename std::unordered_map<std::string, T*>::iterator itr = _resources.find(path);
+        if (itr != _resources.end() && itr->second == resource)
+            _resources.erase(itr);
+    }
+
+    /**
+     * Gets the number of resources in the cache.
+     *
+     * @return The number of resources.
+     */
+    size_t size() const
+    {
+        return _resources.size();
+    }
+
+private:
+
+    std::unordered_map<std::string, T*> _resources;
+};
+
+}
+
+#endif
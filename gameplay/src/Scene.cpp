@@ -7,6 +7,10 @@
 #include "Terrain.h"
 #include "Bundle.h"
 #include "SerializerJson.h"
+#include "Game.h"
+
+// The number of nodes per batch when resolving world matrices in parallel.
+#define SCENE_TRANSFORM_JOB_SIZE 512
 
 namespace gameplay
 {
@@ -62,7 +66,8 @@ static bool endsWith(const char* str, const char* suffix, bool ignoreCase)
 
 Scene::Scene() :
     _id(""), _ambientColor(Vector3::zero()), _activeCamera(NULL), _bindAudioListenerToCamera(true),
-    _firstNode(NULL), _lastNode(NULL), _nodeCount(0), _nextItr(NULL), _nextReset(true)
+    _firstNode(NULL), _lastNode(NULL), _nodeCount(0), _nextItr(NULL), _nextReset(true),
+    _transformOrderDirty(true), _spatialIndex(NULL), _spatialQuery(0)
 {
     __sceneList.push_back(this);
 }
@@ -83,6 +88,7 @@ Scene::~Scene()
 
     // Remove all nodes from the scene
     removeAllNodes();
+    SAFE_DELETE(_spatialIndex);
 
     // Remove the scene from global list
     std::vector<Scene*>::iterator itr = std::find(__sceneList.begin(), __sceneList.end(), this);
@@ -278,6 +284,10 @@ void Scene::addNode(Node* node)
     node->_scene = this;
 
     ++_nodeCount;
+    _transformOrderDirty = true;
+
+    if (_spatialIndex)
+        addToSpatialIndex(node);
 
     // If we don't have an active camera set, then check for one and set it.
     if (_activeCamera == NULL)
@@ -312,6 +322,7 @@ void Scene::removeNode(Node* node)
     SAFE_RELEASE(node);
 
     --_nodeCount;
+    _transformOrderDirty = true;
 }
 
 void Scene::removeAllNodes()
@@ -401,6 +412,265 @@ void Scene::update(float elapsedTime)
     }
 }
 
+void Scene::updateTransforms()
+{
+    if (_transformOrderDirty)
+        buildTransformOrder();
+
+    Game* game = Game::getInstance();
+    JobController* jobs = game ? game->getJobController() : NULL;
+
+    // The parents of the nodes in each depth level are all resolved by the previous
+    // level, so the nodes within a level can be resolved independently.
+    for (size_t level = 0, levelCount = _transformLevels.size() - 1; level < levelCount; ++level)
+    {
+        Node** nodes = &_transformNodes[0] + _transformLevels[level];
+        unsigned int nodeCount = _transformLevels[level + 1] - _transformLevels[level];
+
+        if (jobs && nodeCount > SCENE_TRANSFORM_JOB_SIZE)
+        {
+            jobs->parallelFor(nodeCount, SCENE_TRANSFORM_JOB_SIZE, [nodes](unsigned int begin, unsigned int end)
+            {
+                for (unsigned int i = begin; i < end; ++i)
+                {
+                    nodes[i]->updateWorldMatrix();
+                }
+            });
+        }
+        else
+        {
+            for (unsigned int i = 0; i < nodeCount; ++i)
+            {
+                nodes[i]->updateWorldMatrix();
+            }
+        }
+    }
+}
+
+void Scene::buildTransformOrder()
+{
+    _transformNodes.clear();
+    _transformLevels.clear();
+
+    // Breadth-first traversal, recording where each depth level starts.
+    for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
+    {
+        _transformNodes.push_back(node);
+    }
+    unsigned int begin = 0;
+    while (begin < _transformNodes.size())
+    {
+        unsigned int end = (unsigned int)_transformNodes.size();
+        _transformLevels.push_back(begin);
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            for (Node* child = _transformNodes[i]->_firstChild; child != NULL; child = child->_nextSibling)
+            {
+                _transformNodes.push_back(child);
+            }
+        }
+        begin = end;
+    }
+    _transformLevels.push_back((unsigned int)_transformNodes.size());
+
+    _transformOrderDirty = false;
+}
+
+void Scene::setSpatialIndexEnabled(bool enabled)
+{
+    if (enabled == (_spatialIndex != NULL))
+        return;
+
+    if (enabled)
+    {
+        _spatialIndex = new BoundingBoxTree();
+        for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
+        {
+            addToSpatialIndex(node);
+        }
+    }
+    else
+    {
+        for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
+        {
+            removeFromSpatialIndex(node);
+        }
+        SAFE_DELETE(_spatialIndex);
+    }
+}
+
+bool Scene::isSpatialIndexEnabled() const
+{
+    return _spatialIndex != NULL;
+}
+
+static bool intersectsBox(Node* node, const BoundingBox& box)
+{
+    return node->getBoundingSphere().intersects(box);
+}
+
+static bool intersectsSphere(Node* node, const BoundingSphere& sphere)
+{
+    return node->getBoundingSphere().intersects(sphere);
+}
+
+static bool intersectsFrustum(Node* node, const Frustum& frustum)
+{
+    return node->getBoundingSphere().intersects(frustum);
+}
+
+static bool intersectsRay(Node* node, const Ray& ray)
+{
+    return node->getBoundingSphere().intersects(ray) != Ray::INTERSECTS_NONE;
+}
+
+unsigned int Scene::queryNodes(const BoundingBox& box, std::vector<Node*>& nodes)
+{
+    return queryNodes(box, nodes, &intersectsBox);
+}
+
+unsigned int Scene::queryNodes(const BoundingSphere& sphere, std::vector<Node*>& nodes)
+{
+    return queryNodes(sphere, nodes, &intersectsSphere);
+}
+
+unsigned int Scene::queryNodes(const Frustum& frustum, std::vector<Node*>& nodes)
+{
+    return queryNodes(frustum, nodes, &intersectsFrustum);
+}
+
+unsigned int Scene::queryNodes(const Ray& ray, std::vector<Node*>& nodes)
+{
+    return queryNodes(ray, nodes, &intersectsRay);
+}
+
+template <class V>
+unsigned int Scene::queryNodes(const V& volume, std::vector<Node*>& nodes, bool (*test)(Node*, const V&))
+{
+    size_t count = nodes.size();
+    if (_spatialIndex)
+    {
+        // The index returns the nodes whose enlarged bounding box intersects the
+        // volume, so refine the results with the exact bounding spheres.
+        updateSpatialIndex();
+        _spatialProxies.clear();
+        _spatialIndex->query(volume, _spatialProxies);
+        for (size_t i = 0, proxyCount = _spatialProxies.size(); i < proxyCount; ++i)
+        {
+            Node* node = static_cast<Node*>(_spatialIndex->getUserData(_spatialProxies[i]));
+            if (test(node, volume))
+                nodes.push_back(node);
+        }
+    }
+    else
+    {
+        std::vector<Node*> stack;
+        for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
+        {
+            stack.push_back(node);
+        }
+        while (!stack.empty())
+        {
+            Node* node = stack.back();
+            stack.pop_back();
+            if (test(node, volume))
+                nodes.push_back(node);
+            for (Node* child = node->_firstChild; child != NULL; child = child->_nextSibling)
+            {
+                stack.push_back(child);
+            }
+        }
+    }
+    return (unsigned int)(nodes.size() - count);
+}
+
+bool Scene::isNodeInFrustum(Node* node, const Frustum& frustum)
+{
+    if (_spatialIndex && node->_spatialProxy != BoundingBoxTree::NULL_PROXY)
+        return node->_spatialQuery == _spatialQuery;
+
+    return node->getBoundingSphere().intersects(frustum);
+}
+
+void Scene::markSpatialVisible(const Frustum& frustum)
+{
+    GP_ASSERT(_spatialIndex);
+
+    updateSpatialIndex();
+    ++_spatialQuery;
+    _spatialProxies.clear();
+    _spatialIndex->query(frustum, _spatialProxies);
+    for (size_t i = 0, proxyCount = _spatialProxies.size(); i < proxyCount; ++i)
+    {
+        Node* node = static_cast<Node*>(_spatialIndex->getUserData(_spatialProxies[i]));
+        if (node->getBoundingSphere().intersects(frustum))
+            node->_spatialQuery = _spatialQuery;
+    }
+}
+
+void Scene::addToSpatialIndex(Node* node)
+{
+    // The proxy is created the next time the index is used.
+    markSpatialDirty(node);
+
+    for (Node* child = node->_firstChild; child != NULL; child = child->_nextSibling)
+    {
+        addToSpatialIndex(child);
+    }
+}
+
+void Scene::removeFromSpatialIndex(Node* node)
+{
+    GP_ASSERT(_spatialIndex);
+
+    if (node->_spatialProxy != BoundingBoxTree::NULL_PROXY)
+    {
+        _spatialIndex->destroyProxy(node->_spatialProxy);
+        node->_spatialProxy = BoundingBoxTree::NULL_PROXY;
+    }
+    if (node->_spatialDirty)
+    {
+        std::vector<Node*>::iterator itr = std::find(_spatialDirtyNodes.begin(), _spatialDirtyNodes.end(), node);
+        GP_ASSERT(itr != _spatialDirtyNodes.end());
+        *itr = _spatialDirtyNodes.back();
+        _spatialDirtyNodes.pop_back();
+        node->_spatialDirty = false;
+    }
+
+    for (Node* child = node->_firstChild; child != NULL; child = child->_nextSibling)
+    {
+        removeFromSpatialIndex(child);
+    }
+}
+
+void Scene::markSpatialDirty(Node* node)
+{
+    if (!node->_spatialDirty)
+    {
+        node->_spatialDirty = true;
+        _spatialDirtyNodes.push_back(node);
+    }
+}
+
+void Scene::updateSpatialIndex()
+{
+    GP_ASSERT(_spatialIndex);
+
+    BoundingBox box;
+    for (size_t i = 0, count = _spatialDirtyNodes.size(); i < count; ++i)
+    {
+        Node* node = _spatialDirtyNodes[i];
+        node->_spatialDirty = false;
+
+        box.set(node->getBoundingSphere());
+        if (node->_spatialProxy == BoundingBoxTree::NULL_PROXY)
+            node->_spatialProxy = _spatialIndex->createProxy(box, node);
+        else
+            _spatialIndex->moveProxy(node->_spatialProxy, box);
+    }
+    _spatialDirtyNodes.clear();
+}
+
 void Scene::reset()
 {
     _nextItr = NULL;
@@ -411,6 +681,8 @@ Node* Scene::getNext()
 {
     if (_nextReset)
     {
+        if (_spatialIndex && _activeCamera)
+            markSpatialVisible(_activeCamera->getFrustum());
         _nextItr = findNextVisibleSibling(getFirstNode());
         _nextReset = false;
     }
@@ -460,7 +732,7 @@ bool Scene::isNodeVisible(Node* node)
     }
     else
     {
-        return node->getBoundingSphere().intersects(_activeCamera->getFrustum());
+        return isNodeInFrustum(node, _activeCamera->getFrustum());
     }
 }
 
@@ -494,6 +766,7 @@ void Scene::deserialize(Serializer* serializer)
         if (node)
         {
             addNode(node);
+            node->release(); // scene now owns node
         }
     }
     _activeCamera = dynamic_cast<Camera*>(serializer->readObject("activeCamera"));
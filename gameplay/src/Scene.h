@@ -7,6 +7,7 @@
 #include "ScriptController.h"
 #include "Light.h"
 #include "Model.h"
+#include "BoundingBoxTree.h"
 
 namespace gameplay
 {
@@ -17,6 +18,7 @@ namespace gameplay
 class Scene : public Ref, public Serializable
 {
     friend class Serializer::Activator;
+    friend class Node;
     
 public:
 
@@ -193,6 +195,88 @@ public:
      */
     void update(float elapsedTime);
 
+    /**
+     * Resolves the world matrices of all nodes in the scene whose transform changed.
+     *
+     * Nodes are processed one hierarchy depth at a time, in flat arrays ordered by depth,
+     * and large depth levels are split into batches that run in parallel on the game's
+     * worker threads. Node::getWorldMatrix() still resolves lazily, so calling this is
+     * optional, but it is considerably faster than resolving many moving nodes one by one.
+     * It is best called once per frame, after the scene has been animated and simulated
+     * and before it is drawn.
+     *
+     * The scene hierarchy and node transforms must not be modified during this call.
+     */
+    void updateTransforms();
+
+    /**
+     * Enables or disables the spatial index of the scene.
+     *
+     * The spatial index is a dynamic bounding volume hierarchy over the bounding spheres
+     * of all nodes in the scene, kept up to date as nodes are added, removed and moved.
+     * It speeds up the query methods of the scene and frustum-culled traversals with
+     * visit() and getNext() for scenes with many nodes, particularly static ones.
+     * It is disabled by default.
+     *
+     * @param enabled true to enable the spatial index, false to disable it.
+     */
+    void setSpatialIndexEnabled(bool enabled);
+
+    /**
+     * Determines if the spatial index of the scene is enabled.
+     *
+     * @return true if the spatial index is enabled, false otherwise.
+     * @see setSpatialIndexEnabled
+     */
+    bool isSpatialIndexEnabled() const;
+
+    /**
+     * Finds the nodes whose bounding sphere intersects the given bounding box.
+     *
+     * The bounding sphere of a node includes the bounds of its children. The results
+     * are the same whether the spatial index is enabled or not, but without it all
+     * nodes of the scene are tested.
+     *
+     * @param box The bounding box to test.
+     * @param nodes The list to append the nodes to.
+     *
+     * @return The number of nodes appended.
+     */
+    unsigned int queryNodes(const BoundingBox& box, std::vector<Node*>& nodes);
+
+    /**
+     * Finds the nodes whose bounding sphere intersects the given bounding sphere.
+     *
+     * @param sphere The bounding sphere to test.
+     * @param nodes The list to append the nodes to.
+     *
+     * @return The number of nodes appended.
+     * @see queryNodes(const BoundingBox&, std::vector<Node*>&)
+     */
+    unsigned int queryNodes(const BoundingSphere& sphere, std::vector<Node*>& nodes);
+
+    /**
+     * Finds the nodes whose bounding sphere intersects the given frustum.
+     *
+     * @param frustum The frustum to test.
+     * @param nodes The list to append the nodes to.
+     *
+     * @return The number of nodes appended.
+     * @see queryNodes(const BoundingBox&, std::vector<Node*>&)
+     */
+    unsigned int queryNodes(const Frustum& frustum, std::vector<Node*>& nodes);
+
+    /**
+     * Finds the nodes whose bounding sphere intersects the given ray.
+     *
+     * @param ray The ray to test.
+     * @param nodes The list to append the nodes to.
+     *
+     * @return The number of nodes appended.
+     * @see queryNodes(const BoundingBox&, std::vector<Node*>&)
+     */
+    unsigned int queryNodes(const Ray& ray, std::vector<Node*>& nodes);
+
     /**
      * Visits each node in the scene and calls the specified method pointer.
      *
@@ -251,6 +335,25 @@ public:
      */
     inline void visit(const char* visitMethod);
 
+    /**
+     * Visits each node in the scene that intersects the given frustum and calls the
+     * specified method pointer.
+     *
+     * A node is visited when its bounding sphere, which includes the bounds of its
+     * children, intersects the frustum, so nodes outside of the frustum are skipped
+     * along with their whole subtree. When the spatial index is enabled, the visible
+     * nodes are found with a single query of the index.
+     *
+     * Returning false from the visit method skips the children of the node, as with
+     * the other visit methods.
+     *
+     * @param instance The pointer to an instance of the object that contains visitMethod.
+     * @param visitMethod The pointer to the class method to call for each node in the scene.
+     * @param frustum The frustum to cull the scene's nodes against.
+     */
+    template <class T>
+    void visit(T* instance, bool (T::*visitMethod)(Node*), const Frustum& frustum);
+
     /**
      * @see VisibleSet#getNext
      */
@@ -320,10 +423,60 @@ private:
      */
     void visitNode(Node* node, const char* visitMethod);
 
+    /**
+     * Visits the given node and its children recursively, skipping the nodes outside of the frustum.
+     */
+    template <class T>
+    void visitNode(Node* node, T* instance, bool (T::*visitMethod)(Node*), const Frustum& frustum);
+
     Node* findNextVisibleSibling(Node* node);
 
     bool isNodeVisible(Node* node);
 
+    /**
+     * Rebuilds the depth-ordered node arrays used by updateTransforms().
+     */
+    void buildTransformOrder();
+
+    /**
+     * Determines if the bounding sphere of the given node intersects the frustum.
+     *
+     * When the spatial index is enabled, this uses the result of the last call to
+     * markSpatialVisible() for the same frustum.
+     */
+    bool isNodeInFrustum(Node* node, const Frustum& frustum);
+
+    /**
+     * Marks the nodes that intersect the given frustum with a new query number.
+     */
+    void markSpatialVisible(const Frustum& frustum);
+
+    /**
+     * Adds the given node and its children to the spatial index.
+     */
+    void addToSpatialIndex(Node* node);
+
+    /**
+     * Removes the given node and its children from the spatial index.
+     */
+    void removeFromSpatialIndex(Node* node);
+
+    /**
+     * Queues the given node for its proxy in the spatial index to be refit.
+     */
+    void markSpatialDirty(Node* node);
+
+    /**
+     * Refits the proxies of all nodes queued by markSpatialDirty().
+     */
+    void updateSpatialIndex();
+
+    /**
+     * Gathers the nodes matching a query of the spatial index, or of all nodes when it is disabled.
+     */
+    template <class V>
+    unsigned int queryNodes(const V& volume, std::vector<Node*>& nodes, bool (*test)(Node*, const V&));
+
     std::string _id;
     Vector3 _ambientColor;
     Camera* _activeCamera;
@@ -333,6 +486,13 @@ private:
     unsigned int _nodeCount;
     Node* _nextItr;
     bool _nextReset;
+    std::vector<Node*> _transformNodes;
+    std::vector<unsigned int> _transformLevels;
+    bool _transformOrderDirty;
+    BoundingBoxTree* _spatialIndex;
+    std::vector<Node*> _spatialDirtyNodes;
+    std::vector<int> _spatialProxies;
+    unsigned int _spatialQuery;
 };
 
 template <class T>
@@ -361,6 +521,43 @@ inline void Scene::visit(const char* visitMethod)
     }
 }
 
+template <class T>
+void Scene::visit(T* instance, bool (T::*visitMethod)(Node*), const Frustum& frustum)
+{
+    if (_spatialIndex)
+        markSpatialVisible(frustum);
+
+    for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
+    {
+        visitNode(node, instance, visitMethod, frustum);
+    }
+}
+
+template <class T>
+void Scene::visitNode(Node* node, T* instance, bool (T::*visitMethod)(Node*), const Frustum& frustum)
+{
+    // Our bounds contain those of our children, so they can all be skipped.
+    if (!isNodeInFrustum(node, frustum))
+        return;
+
+    // Invoke the visit method for this node.
+    if (!(instance->*visitMethod)(node))
+        return;
+
+    // Joint hierarchies are not part of the scene, so they are visited without culling.
+    Model* model = dynamic_cast<Model*>(node->getDrawable());
+    if (model && model->_skin && model->_skin->_rootNode)
+    {
+        visitNode(model->_skin->_rootNode, instance, visitMethod);
+    }
+
+    // Recurse for all children.
+    for (Node* child = node->getFirstChild(); child != NULL; child = child->getNextSibling())
+    {
+        visitNode(child, instance, visitMethod, frustum);
+    }
+}
+
 template <class T>
 void Scene::visitNode(Node* node, T* instance, bool (T::*visitMethod)(Node*))
 {
@@ -0,0 +1,447 @@
+#include "Base.h"
+#include "SceneStreamer.h"
+#include "Bundle.h"
+#include "Camera.h"
+#include "Game.h"
+#include "Mesh.h"
+#include "MeshPart.h"
+#include "Model.h"
+#include "Node.h"
+#include "Scene.h"
+
+// Default number of nodes attached to the scene in an update.
+#define SCENE_STREAMER_ATTACH_BUDGET 8
+
+// Maximum number of cells being loaded at a time, so that the nearest cells are requested first.
+#define SCENE_STREAMER_MAX_PENDING_LOADS 4
+
+namespace gameplay
+{
+
+// Estimates the memory used by the vertex and index data of the models of a node and its children.
+// Meshes already in the counted set are shared with models counted before, and are skipped.
+static size_t getNodeMemory(Node* node, std::set<Mesh*>* counted)
+{
+    size_t memory = 0;
+    Model* model = dynamic_cast<Model*>(node->getDrawable());
+    if (model && model->getMesh() && counted->insert(model->getMesh()).second)
+    {
+        Mesh* mesh = model->getMesh();
+        memory += (size_t)mesh->getVertexCount() * mesh->getVertexSize();
+        for (unsigned int i = 0, count = mesh->getPartCount(); i < count; ++i)
+        {
+            MeshPart* part = mesh->getPart(i);
+            switch (part->getIndexFormat())
+            {
+            case Mesh::INDEX8:
+                memory += part->getIndexCount();
+                break;
+            case Mesh::INDEX16:
+                memory += part->getIndexCount() * 2;
+                break;
+            case Mesh::INDEX32:
+                memory += part->getIndexCount() * 4;
+                break;
+            }
+        }
+    }
+    for (Node* child = node->getFirstChild(); child; child = child->getNextSibling())
+    {
+        memory += getNodeMemory(child, counted);
+    }
+    return memory;
+}
+
+// Gets the distance from a position to a cell on the XZ plane.
+static inline float getCellDistance(const Vector3& position, int x, int z, float cellSize)
+{
+    float minX = x * cellSize;
+    float minZ = z * cellSize;
+    float dx = max(max(minX - position.x, position.x - (minX + cellSize)), 0.0f);
+    float dz = max(max(minZ - position.z, position.z - (minZ + cellSize)), 0.0f);
+    return sqrt(dx * dx + dz * dz);
+}
+
+SceneStreamer::SceneStreamer(Scene* scene, float cellSize)
+    : _scene(scene), _cellSize(cellSize), _loadRadius(cellSize), _evictRadius(cellSize * 2.0f), _memoryBudget(0),
+      _attachBudget(SCENE_STREAMER_ATTACH_BUDGET), _residentMemory(0), _loadCount(0), _totalLoadLatency(0.0), _maxLoadLatency(0.0)
+{
+    _scene->addRef();
+}
+
+SceneStreamer::~SceneStreamer()
+{
+    for (size_t i = 0, count = _cells.size(); i < count; ++i)
+    {
+        evictCell(_cells[i]);
+        SAFE_DELETE(_cells[i]);
+    }
+    SAFE_RELEASE(_scene);
+}
+
+SceneStreamer* SceneStreamer::create(Scene* scene, float cellSize)
+{
+    GP_ASSERT(scene);
+    GP_ASSERT(cellSize > 0.0f);
+
+    return new SceneStreamer(scene, cellSize);
+}
+
+Scene* SceneStreamer::getScene() const
+{
+    return _scene;
+}
+
+float SceneStreamer::getCellSize() const
+{
+    return _cellSize;
+}
+
+unsigned int SceneStreamer::addCell(int x, int z, const char* url)
+{
+    GP_ASSERT(url);
+
+    Cell* cell = new Cell();
+    cell->x = x;
+    cell->z = z;
+    cell->url = url;
+    cell->path = cell->url.substr(0, cell->url.find('#'));
+    cell->state = CELL_UNLOADED;
+    cell->request = NULL;
+    cell->attachedCount = 0;
+    cell->memory = 0;
+    cell->requestTime = 0.0;
+    cell->distance = 0.0f;
+    _cells.push_back(cell);
+    return (unsigned int)_cells.size() - 1;
+}
+
+unsigned int SceneStreamer::getCellCount() const
+{
+    return (unsigned int)_cells.size();
+}
+
+SceneStreamer::CellState SceneStreamer::getCellState(unsigned int index) const
+{
+    GP_ASSERT(index < _cells.size());
+    return _cells[index]->state;
+}
+
+unsigned int SceneStreamer::getResidentCellCount() const
+{
+    unsigned int count = 0;
+    for (size_t i = 0, cellCount = _cells.size(); i < cellCount; ++i)
+    {
+        if (_cells[i]->state == CELL_RESIDENT)
+            count++;
+    }
+    return count;
+}
+
+float SceneStreamer::getLoadRadius() const
+{
+    return _loadRadius;
+}
+
+void SceneStreamer::setLoadRadius(float radius)
+{
+    _loadRadius = radius;
+}
+
+float SceneStreamer::getEvictRadius() const
+{
+    return _evictRadius;
+}
+
+void SceneStreamer::setEvictRadius(float radius)
+{
+    _evictRadius = radius;
+}
+
+size_t SceneStreamer::getMemoryBudget() const
+{
+    return _memoryBudget;
+}
+
+void SceneStreamer::setMemoryBudget(size_t budget)
+{
+    _memoryBudget = budget;
+}
+
+unsigned int SceneStreamer::getAttachBudget() const
+{
+    return _attachBudget;
+}
+
+void SceneStreamer::setAttachBudget(unsigned int nodeCount)
+{
+    _attachBudget = max(nodeCount, 1u);
+}
+
+void SceneStreamer::update()
+{
+    Camera* camera = _scene->getActiveCamera();
+    if (camera && camera->getNode())
+        update(camera->getNode()->getTranslationWorld());
+}
+
+void SceneStreamer::update(const Vector3& position)
+{
+    // Sort the cells by distance, so that the nearest are loaded and attached first
+    // and the farthest are evicted first.
+    std::vector<Cell*> cells(_cells);
+    for (size_t i = 0, count = cells.size(); i < count; ++i)
+    {
+        cells[i]->distance = getCellDistance(position, cells[i]->x, cells[i]->z, _cellSize);
+    }
+    std::sort(cells.begin(), cells.end(), [](const Cell* a, const Cell* b) { return a->distance < b->distance; });
+
+    // Evict the cells beyond the evict radius, then the farthest cells outside the
+    // load radius while over the memory budget.
+    unsigned int pendingCount = 0;
+    for (size_t i = cells.size(); i-- > 0;)
+    {
+        Cell* cell = cells[i];
+        if (cell->state == CELL_UNLOADED || cell->state == CELL_FAILED)
+            continue;
+        if (cell->distance > _evictRadius || (cell->distance > _loadRadius && _memoryBudget > 0 && _residentMemory > _memoryBudget))
+            evictCell(cell);
+        else if (cell->state == CELL_LOADING)
+            pendingCount++;
+    }
+
+    // Request the content of the cells whose bundle is loaded, and take the nodes of the
+    // cells that finished loading.
+    for (size_t i = 0, count = cells.size(); i < count; ++i)
+    {
+        Cell* cell = cells[i];
+        if (cell->state != CELL_LOADING)
+            continue;
+        if (cell->request == NULL && !requestCellContent(cell))
+        {
+            GP_WARN("Failed to load cell (%d, %d) from '%s'.", cell->x, cell->z, cell->url.c_str());
+            cell->state = CELL_FAILED;
+            releaseBundle(cell);
+            pendingCount--;
+        }
+        else if (cell->request && cell->request->isDone())
+        {
+            receiveCell(cell);
+            pendingCount--;
+        }
+    }
+
+    attachCells(cells);
+
+    // Request the nearest cells within the load radius, while under the memory budget.
+    for (size_t i = 0, count = cells.size(); i < count && pendingCount < SCENE_STREAMER_MAX_PENDING_LOADS; ++i)
+    {
+        Cell* cell = cells[i];
+        if (cell->distance > _loadRadius || (_memoryBudget > 0 && _residentMemory >= _memoryBudget))
+            break;
+        if (cell->state == CELL_UNLOADED)
+        {
+            requestCell(cell);
+            pendingCount++;
+        }
+    }
+}
+
+size_t SceneStreamer::getResidentMemory() const
+{
+    return _residentMemory;
+}
+
+unsigned int SceneStreamer::getLoadCount() const
+{
+    return _loadCount;
+}
+
+float SceneStreamer::getAverageLoadLatency() const
+{
+    return _loadCount > 0 ? (float)(_totalLoadLatency / _loadCount) : 0.0f;
+}
+
+float SceneStreamer::getMaxLoadLatency() const
+{
+    return (float)_maxLoadLatency;
+}
+
+void SceneStreamer::resetMetrics()
+{
+    _loadCount = 0;
+    _totalLoadLatency = 0.0;
+    _maxLoadLatency = 0.0;
+}
+
+void SceneStreamer::requestCell(Cell* cell)
+{
+    GP_ASSERT(cell);
+    GP_ASSERT(cell->state == CELL_UNLOADED);
+
+    // Load the bundle first, unless another cell holds it.
+    SharedBundle& shared = _bundles[cell->path];
+    if (shared.cellCount++ == 0)
+    {
+        LoadController* loadController = Game::getInstance()->getLoadController();
+        GP_ASSERT(loadController);
+        shared.request = loadController->loadBundle(cell->path.c_str());
+    }
+    cell->state = CELL_LOADING;
+    cell->requestTime = Game::getAbsoluteTime();
+}
+
+bool SceneStreamer::requestCellContent(Cell* cell)
+{
+    GP_ASSERT(cell);
+    GP_ASSERT(cell->request == NULL);
+
+    std::map<std::string, SharedBundle>::iterator itr = _bundles.find(cell->path);
+    GP_ASSERT(itr != _bundles.end());
+    SharedBundle& shared = itr->second;
+    if (shared.request)
+    {
+        if (!shared.request->isDone())
+            return true;
+
+        // Hold on to the bundle while its cells are loading or resident.
+        shared.bundle = static_cast<Bundle*>(shared.request->getResource());
+        if (shared.bundle)
+            shared.bundle->addRef();
+        SAFE_RELEASE(shared.request);
+    }
+    if (shared.bundle == NULL)
+        return false;
+
+    LoadController* loadController = Game::getInstance()->getLoadController();
+    GP_ASSERT(loadController);
+
+    // Cells that name a node in a bundle load only that node, others load the first scene of their bundle.
+    if (cell->url.find('#') != std::string::npos)
+        cell->request = loadController->loadNode(cell->url.c_str());
+    else
+        cell->request = loadController->loadScene(cell->url.c_str());
+    return true;
+}
+
+void SceneStreamer::releaseBundle(Cell* cell)
+{
+    GP_ASSERT(cell);
+
+    std::map<std::string, SharedBundle>::iterator itr = _bundles.find(cell->path);
+    GP_ASSERT(itr != _bundles.end() && itr->second.cellCount > 0);
+    if (--itr->second.cellCount == 0)
+    {
+        if (itr->second.request)
+        {
+            itr->second.request->cancel();
+            SAFE_RELEASE(itr->second.request);
+        }
+        SAFE_RELEASE(itr->second.bundle);
+        _bundles.erase(itr);
+    }
+}
+
+void SceneStreamer::receiveCell(Cell* cell)
+{
+    GP_ASSERT(cell);
+    GP_ASSERT(cell->request);
+    GP_ASSERT(cell->nodes.empty());
+
+    Ref* resource = cell->request->getResource();
+    if (resource == NULL)
+    {
+        GP_WARN("Failed to load cell (%d, %d) from '%s'.", cell->x, cell->z, cell->url.c_str());
+        cell->state = CELL_FAILED;
+        SAFE_RELEASE(cell->request);
+        releaseBundle(cell);
+        return;
+    }
+
+    Scene* scene = dynamic_cast<Scene*>(resource);
+    if (scene)
+    {
+        // Hold on to the top level nodes, which are moved to our scene when attached.
+        for (Node* node = scene->getFirstNode(); node; node = node->getNextSibling())
+        {
+            node->addRef();
+            cell->nodes.push_back(node);
+        }
+    }
+    else
+    {
+        Node* node = static_cast<Node*>(resource);
+        node->addRef();
+        cell->nodes.push_back(node);
+    }
+    cell->state = CELL_ATTACHING;
+    cell->attachedCount = 0;
+    SAFE_RELEASE(cell->request);
+}
+
+void SceneStreamer::attachCells(const std::vector<Cell*>& cells)
+{
+    unsigned int budget = _attachBudget;
+    for (size_t i = 0, count = cells.size(); i < count && budget > 0; ++i)
+    {
+        Cell* cell = cells[i];
+        if (cell->state != CELL_ATTACHING)
+            continue;
+
+        while (cell->attachedCount < cell->nodes.size() && budget > 0)
+        {
+            Node* node = cell->nodes[cell->attachedCount++];
+            _scene->addNode(node);
+            size_t memory = getNodeMemory(node, &cell->meshes);
+            cell->memory += memory;
+            _residentMemory += memory;
+            budget--;
+        }
+
+        if (cell->attachedCount == cell->nodes.size())
+        {
+            cell->state = CELL_RESIDENT;
+
+            double latency = Game::getAbsoluteTime() - cell->requestTime;
+            _loadCount++;
+            _totalLoadLatency += latency;
+            _maxLoadLatency = max(_maxLoadLatency, latency);
+        }
+    }
+}
+
+void SceneStreamer::evictCell(Cell* cell)
+{
+    GP_ASSERT(cell);
+
+    if (cell->request)
+    {
+        cell->request->cancel();
+        SAFE_RELEASE(cell->request);
+    }
+    for (size_t i = 0, count = cell->nodes.size(); i < count; ++i)
+    {
+        Node* node = cell->nodes[i];
+        if (i < cell->attachedCount)
+        {
+            if (node->getParent())
+                node->getParent()->removeChild(node);
+            else if (node->getScene() == _scene)
+                _scene->removeNode(node);
+        }
+        SAFE_RELEASE(node);
+    }
+    cell->nodes.clear();
+    cell->attachedCount = 0;
+    GP_ASSERT(_residentMemory >= cell->memory);
+    _residentMemory -= cell->memory;
+    cell->memory = 0;
+    cell->meshes.clear();
+    if (cell->state != CELL_FAILED && cell->state != CELL_UNLOADED)
+    {
+        releaseBundle(cell);
+        cell->state = CELL_UNLOADED;
+    }
+}
+
+}
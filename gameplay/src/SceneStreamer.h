@@ -0,0 +1,314 @@
+#ifndef SCENESTREAMER_H_
+#define SCENESTREAMER_H_
+
+#include "Ref.h"
+#include "Vector3.h"
+#include "LoadController.h"
+
+namespace gameplay
+{
+
+class Bundle;
+class Mesh;
+class Node;
+class Scene;
+
+/**
+ * Defines a class that streams the content of a large scene in and out around the camera.
+ *
+ * The world is partitioned into square cells on the XZ plane, each backed by a bundle or
+ * by a node in a bundle, so that a single bundle can hold the ranges of several cells.
+ * Every update, the cells within the load radius of the camera are loaded in the
+ * background through the LoadController, nearest first, and their nodes are attached to
+ * the scene a few at a time so that a cell never stalls a frame. Cells beyond the evict
+ * radius are removed from the scene and released.
+ *
+ * The bundle of a cell is loaded in the background before its content, and kept open
+ * while any of its cells is loading or resident, so that the cells that share a bundle
+ * do not read its header again. The content is finalized by the LoadController in steps
+ * within its finalize budget.
+ *
+ * The streamer also keeps the resident memory under a budget: while the estimated
+ * memory of the resident cells is over the budget, no new cell is loaded and the
+ * farthest cells outside the load radius are evicted first. The resident memory is
+ * estimated from the vertex and index data of the models of the cells.
+ */
+class SceneStreamer : public Ref
+{
+public:
+
+    /**
+     * The state of a cell.
+     */
+    enum CellState
+    {
+        CELL_UNLOADED,
+        CELL_LOADING,
+        CELL_ATTACHING,
+        CELL_RESIDENT,
+        CELL_FAILED
+    };
+
+    /**
+     * Creates a streamer for a scene.
+     *
+     * @param scene The scene that the nodes of the cells are attached to.
+     * @param cellSize The size of the cells on the X and Z axes.
+     *
+     * @return The new streamer.
+     * @script{create}
+     */
+    static SceneStreamer* create(Scene* scene, float cellSize);
+
+    /**
+     * Gets the scene that the nodes of the cells are attached to.
+     *
+     * @return The scene.
+     */
+    Scene* getScene() const;
+
+    /**
+     * Gets the size of the cells on the X and Z axes.
+     *
+     * @return The cell size.
+     */
+    float getCellSize() const;
+
+    /**
+     * Adds a cell to the streamer.
+     *
+     * The url is the path of a .gpb bundle, whose first scene is loaded and has its nodes
+     * attached, or the path of a bundle followed by '#' and the id of the node to attach.
+     * A cell may be added more than once, for example to stream its layers separately.
+     *
+     * @param x The index of the cell on the X axis, which covers [x * cellSize, (x + 1) * cellSize).
+     * @param z The index of the cell on the Z axis, which covers [z * cellSize, (z + 1) * cellSize).
+     * @param url The url of the content of the cell.
+     *
+     * @return The index of the cell.
+     */
+    unsigned int addCell(int x, int z, const char* url);
+
+    /**
+     * Gets the number of cells.
+     *
+     * @return The number of cells.
+     */
+    unsigned int getCellCount() const;
+
+    /**
+     * Gets the state of a cell.
+     *
+     * @param index The index of the cell.
+     *
+     * @return The state of the cell.
+     */
+    CellState getCellState(unsigned int index) const;
+
+    /**
+     * Gets the number of cells whose nodes are all attached to the scene.
+     *
+     * @return The number of resident cells.
+     */
+    unsigned int getResidentCellCount() const;
+
+    /**
+     * Gets the distance from the camera within which cells are loaded.
+     *
+     * @return The load radius.
+     */
+    float getLoadRadius() const;
+
+    /**
+     * Sets the distance from the camera within which cells are loaded.
+     *
+     * @param radius The load radius.
+     */
+    void setLoadRadius(float radius);
+
+    /**
+     * Gets the distance from the camera beyond which cells are evicted.
+     *
+     * @return The evict radius.
+     */
+    float getEvictRadius() const;
+
+    /**
+     * Sets the distance from the camera beyond which cells are evicted.
+     *
+     * This should be larger than the load radius, so that cells on the edge of the load
+     * radius are not loaded and evicted over and over as the camera moves back and forth.
+     *
+     * @param radius The evict radius.
+     */
+    void setEvictRadius(float radius);
+
+    /**
+     * Gets the estimated memory that the resident cells may use, in bytes.
+     *
+     * @return The memory budget, or 0 for no budget.
+     */
+    size_t getMemoryBudget() const;
+
+    /**
+     * Sets the estimated memory that the resident cells may use, in bytes.
+     *
+     * @param budget The memory budget, or 0 for no budget.
+     */
+    void setMemoryBudget(size_t budget);
+
+    /**
+     * Gets the number of nodes attached to the scene in an update.
+     *
+     * @return The attach budget.
+     */
+    unsigned int getAttachBudget() const;
+
+    /**
+     * Sets the number of nodes attached to the scene in an update.
+     *
+     * @param nodeCount The attach budget, at least 1.
+     */
+    void setAttachBudget(unsigned int nodeCount);
+
+    /**
+     * Streams the cells around the active camera of the scene.
+     */
+    void update();
+
+    /**
+     * Streams the cells around a position.
+     *
+     * @param position The position in world space that cells are streamed around.
+     */
+    void update(const Vector3& position);
+
+    /**
+     * Gets the estimated memory used by the attached nodes of the cells, in bytes.
+     *
+     * @return The resident memory.
+     */
+    size_t getResidentMemory() const;
+
+    /**
+     * Gets the number of cells loaded since the metrics were last reset.
+     *
+     * @return The number of loaded cells.
+     */
+    unsigned int getLoadCount() const;
+
+    /**
+     * Gets the average time between requesting a cell and attaching its last node,
+     * in milliseconds, since the metrics were last reset.
+     *
+     * @return The average load latency.
+     */
+    float getAverageLoadLatency() const;
+
+    /**
+     * Gets the longest time between requesting a cell and attaching its last node,
+     * in milliseconds, since the metrics were last reset.
+     *
+     * @return The maximum load latency.
+     */
+    float getMaxLoadLatency() const;
+
+    /**
+     * Resets the load count and load latencies.
+     */
+    void resetMetrics();
+
+private:
+
+    /**
+     * A cell of the world and its content.
+     */
+    struct Cell
+    {
+        int x;
+        int z;
+        std::string url;
+        std::string path;               // The path of the bundle.
+        CellState state;
+        LoadController::Request* request;
+        std::vector<Node*> nodes;       // The loaded nodes, attached or waiting to be.
+        unsigned int attachedCount;     // The number of nodes attached to the scene.
+        size_t memory;                  // The estimated memory of the attached nodes.
+        std::set<Mesh*> meshes;         // The meshes counted in the memory, which models may share.
+        double requestTime;             // The time the cell was requested at.
+        float distance;                 // The distance from the camera in the last update.
+    };
+
+    /**
+     * A bundle shared by the cells that are loading or resident.
+     */
+    struct SharedBundle
+    {
+        Bundle* bundle;
+        LoadController::Request* request;   // The request loading the bundle, until it finishes.
+        unsigned int cellCount;             // The number of cells loading or resident.
+    };
+
+    /**
+     * Constructor.
+     */
+    SceneStreamer(Scene* scene, float cellSize);
+
+    /**
+     * Destructor.
+     */
+    ~SceneStreamer();
+
+    /**
+     * Hidden copy constructor.
+     */
+    SceneStreamer(const SceneStreamer& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    SceneStreamer& operator=(const SceneStreamer&);
+
+    void requestCell(Cell* cell);
+
+    /**
+     * Requests the content of a cell whose bundle is loaded.
+     *
+     * @return false if the bundle failed to load, true otherwise.
+     */
+    bool requestCellContent(Cell* cell);
+
+    /**
+     * Releases the bundle of a cell that is no longer loading or resident.
+     */
+    void releaseBundle(Cell* cell);
+
+    /**
+     * Takes the nodes of a cell from its finished request.
+     */
+    void receiveCell(Cell* cell);
+
+    /**
+     * Attaches nodes of loaded cells to the scene, nearest cells first, up to the attach budget.
+     */
+    void attachCells(const std::vector<Cell*>& cells);
+
+    void evictCell(Cell* cell);
+
+    Scene* _scene;
+    float _cellSize;
+    std::vector<Cell*> _cells;
+    std::map<std::string, SharedBundle> _bundles;
+    float _loadRadius;
+    float _evictRadius;
+    size_t _memoryBudget;
+    unsigned int _attachBudget;
+    size_t _residentMemory;
+    unsigned int _loadCount;
+    double _totalLoadLatency;
+    double _maxLoadLatency;
+};
+
+}
+
+#endif
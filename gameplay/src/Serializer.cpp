@@ -167,7 +167,7 @@ Serializer* Serializer::createReader(const char* path)
 {
     GP_ASSERT(path);
     
-    Stream* stream = FileSystem::open(path);
+    Stream* stream = FileSystem::open(path, FileSystem::READ | FileSystem::MAPPED);
     if (!stream)
     {
         GP_WARN("Failed to open file '%s'.", path);
@@ -11,7 +11,7 @@ class Vector4;
 class Matrix;
 class Stream;
 
-const unsigned char SERIALIZER_VERSION[2] = {4, 0};
+const unsigned char SERIALIZER_VERSION[2] = {4, 1};
 
 /**
  * Defines an abstract class for reading/writing an objects data to a stream.
@@ -449,6 +449,7 @@ public:
     class Activator
     {
         friend class Serializer;
+        friend class SerializerBinary;
         
     public:
         
@@ -15,8 +15,27 @@ unsigned char SerializerBinary::BIT_VALUE = 0x01;
 unsigned char SerializerBinary::BIT_XREF = 0x02;
 unsigned char SerializerBinary::BIT_DEFAULT = 0x04;
 
+// Maps signed ints to unsigned ints so that values near zero have short varint encodings.
+static inline unsigned int zigzagEncode(int value)
+{
+    return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+}
+
+static inline int zigzagDecode(unsigned int value)
+{
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+// Whether the strings of a property are identifiers, which are usually unique to their
+// object and so are not worth interning.
+static inline bool isIdentifier(const char* propertyName)
+{
+    return propertyName && strcmp(propertyName, "id") == 0;
+}
+
 SerializerBinary::SerializerBinary(const char* path, Stream* stream, unsigned int versionMajor, unsigned int versionMinor)
-    : Serializer(path, stream, versionMajor, versionMinor)
+    : Serializer(path, stream, versionMajor, versionMinor),
+      _compact(versionMajor > 4 || (versionMajor == 4 && versionMinor >= 1))
 {
 }
     
@@ -103,7 +122,7 @@ void SerializerBinary::writeInt(const char* propertyName, int value, int default
     else
     {
         _stream->write(&BIT_VALUE, sizeof(unsigned char), 1);
-        _stream->write(&value, sizeof(int), 1);
+        writeVarint(zigzagEncode(value));
     }
 }
 
@@ -239,7 +258,7 @@ void SerializerBinary::writeString(const char* propertyName, const char* value,
     else
     {
         _stream->write(&BIT_VALUE, sizeof(unsigned char), 1);
-        writeLengthPrefixedString(value);
+        writeInternedString(value ? value : "", !isIdentifier(propertyName));
     }
 }
 
@@ -248,7 +267,7 @@ void SerializerBinary::writeStringList(const char* propertyName, unsigned int co
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Serializer::WRITER);
 
-    _stream->write(&count, sizeof(unsigned int), 1);
+    writeCount(count);
 }
     
 void SerializerBinary::writeObject(const char* propertyName, Serializable* value)
@@ -261,40 +280,33 @@ void SerializerBinary::writeObject(const char* propertyName, Serializable* value
         return;
     }
     
-    bool writeValue = true;
     Ref* xref = dynamic_cast<Ref*>(value);
     if (xref && xref->getRefCount() > 1)
     {
         _stream->write(&BIT_XREF, sizeof(unsigned char), 1);
-        unsigned long xrefAddress = reinterpret_cast<unsigned long>(value);
-        _stream->write(&xrefAddress, sizeof(unsigned long), 1);
-        
-        // Check if already serialized from xref table
-        std::map<unsigned long, Ref*>::const_iterator itr = _xrefs.find(xrefAddress);
-        if (itr == _xrefs.end())
-        {
-            writeValue = true;
-            _xrefs[xrefAddress] = xref;
-        }
-        else
+
+        // Objects that were already written are only referenced by their xref id.
+        std::unordered_map<Ref*, unsigned int>::const_iterator itr = _xrefIds.find(xref);
+        if (itr != _xrefIds.end())
         {
-            writeValue = false;
+            writeVarint(itr->second);
+            return;
         }
+        unsigned int xrefId = (unsigned int)_xrefIds.size();
+        _xrefIds[xref] = xrefId;
+        writeVarint(xrefId);
     }
     else
     {
         // Write out this is a object value
         _stream->write(&BIT_VALUE, sizeof(unsigned char), 1);
     }
-    
-    if (writeValue)
-    {
-        // Write out the objects class
-        writeLengthPrefixedString(value->getSerializedClassName());
-        
-        // Serialize the object properties
-        value->serialize(this);
-    }
+
+    // Write out the objects class
+    writeClass(value->getSerializedClassName());
+
+    // Serialize the object properties
+    value->serialize(this);
 }
 
 void SerializerBinary::writeObjectList(const char* propertyName, unsigned int count)
@@ -302,7 +314,7 @@ void SerializerBinary::writeObjectList(const char* propertyName, unsigned int co
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Serializer::WRITER);
     
-    _stream->write(&count, sizeof(unsigned int), 1);
+    writeCount(count);
 }
 
 void SerializerBinary::writeIntArray(const char* propertyName, const int* data, unsigned int count)
@@ -310,7 +322,7 @@ void SerializerBinary::writeIntArray(const char* propertyName, const int* data,
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Serializer::WRITER);
     
-    _stream->write(&count, sizeof(unsigned int), 1);
+    writeCount(count);
     if (count > 0 && data )
     {
         _stream->write(data, sizeof(int), count);
@@ -322,7 +334,7 @@ void SerializerBinary::writeFloatArray(const char* propertyName, const float* da
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Serializer::WRITER);
     
-    _stream->write(&count, sizeof(unsigned int), 1);
+    writeCount(count);
     if (count > 0 && data )
     {
         _stream->write(data, sizeof(float), count);
@@ -334,7 +346,7 @@ void SerializerBinary::writeByteArray(const char* propertyName, const unsigned c
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Serializer::WRITER);
     
-    _stream->write(&count, sizeof(unsigned int), 1);
+    writeCount(count);
     if (count > 0 && data )
     {
         _stream->write(data, sizeof(unsigned char), count);
@@ -369,6 +381,10 @@ int SerializerBinary::readInt(const char* propertyName, int defaultValue)
     {
         return defaultValue;
     }
+    else if (_compact)
+    {
+        return zigzagDecode(readVarint());
+    }
     else
     {
         int value;
@@ -525,7 +541,14 @@ void SerializerBinary::readString(const char* propertyName, std::string& value,
     _stream->read(&bit, sizeof(unsigned char), 1);
     if (bit == BIT_DEFAULT)
     {
-        std::strcpy(&value[0], defaultValue);
+        if (defaultValue)
+            value = defaultValue;
+        else
+            value.clear();
+    }
+    else if (_compact)
+    {
+        readInternedString(value);
     }
     else
     {
@@ -538,40 +561,86 @@ unsigned int SerializerBinary::readStringList(const char* propertyName)
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Serializer::READER);
 
-    unsigned int count;
-    _stream->read(&count, sizeof(unsigned int), 1);
-    return count;
+    return readCount();
 }
 
 Serializable* SerializerBinary::readObject(const char* propertyName, Serializable* dst)
 {
     GP_ASSERT(_type == Serializer::READER);
     
-    long readOffset = -1;
-    
     unsigned char bit;
     _stream->read(&bit, sizeof(unsigned char), 1);
-    
-    unsigned long xrefAddress = 0L;
     if (bit == BIT_NULL)
     {
         return NULL;
     }
-    else if (bit == BIT_XREF)
+
+    if (!_compact)
     {
-        _stream->read(&xrefAddress, sizeof(unsigned long), 1);
-        
-        std::map<unsigned long, Ref*>::const_iterator itr = _xrefs.find(xrefAddress);
-        if (itr != _xrefs.end())
+        unsigned long xrefAddress = 0L;
+        if (bit == BIT_XREF)
         {
-            return dynamic_cast<Serializable*>(itr->second);
+            _stream->read(&xrefAddress, sizeof(unsigned long), 1);
+
+            std::map<unsigned long, Ref*>::const_iterator itr = _xrefs.find(xrefAddress);
+            if (itr != _xrefs.end())
+            {
+                return dynamic_cast<Serializable*>(itr->second);
+            }
         }
+
+        // The class name for the object being read
+        std::string className;
+        readLengthPrefixedString(className);
+
+        Serializable* value = NULL;
+        if (dst)
+        {
+            value = dst;
+        }
+        else
+        {
+            value = Serializer::getActivator()->createInstance(className.c_str());
+            if (value == NULL)
+            {
+                GP_WARN("Failed to deserialize binary class: %s for propertyName:%s", className.c_str(), propertyName);
+                return NULL;
+            }
+        }
+
+        // Deserialize the properties
+        value->deserialize(this);
+
+        if (xrefAddress != 0)
+        {
+            _xrefs[xrefAddress] = dynamic_cast<Ref*>(value);
+        }
+
+        return value;
     }
-    
-    // The class name for the object being read
-    std::string className;
-    readLengthPrefixedString(className);
-    
+
+    // Objects that were already read are referenced by their xref id, and new ones take the next id.
+    int xrefId = -1;
+    if (bit == BIT_XREF)
+    {
+        unsigned int id = readVarint();
+        if (id < _xrefTable.size())
+        {
+            return dynamic_cast<Serializable*>(_xrefTable[id]);
+        }
+        if (id != _xrefTable.size())
+        {
+            GP_WARN("Invalid xref id %u for propertyName:%s", id, propertyName);
+            return NULL;
+        }
+        xrefId = (int)id;
+        _xrefTable.push_back(NULL);
+    }
+
+    const ClassEntry* classEntry = readClass();
+    if (classEntry == NULL)
+        return NULL;
+
     Serializable* value = NULL;
     if (dst)
     {
@@ -579,22 +648,22 @@ Serializable* SerializerBinary::readObject(const char* propertyName, Serializabl
     }
     else
     {
-        value = Serializer::getActivator()->createInstance(className.c_str());
+        value = classEntry->createInstance ? classEntry->createInstance() : NULL;
         if (value == NULL)
         {
-            GP_WARN("Failed to deserialize binary class: %s for propertyName:%s", className.c_str(), propertyName);
+            GP_WARN("Failed to deserialize binary class: %s for propertyName:%s", classEntry->name.c_str(), propertyName);
             return NULL;
         }
     }
-    
+
     // Deserialize the properties
     value->deserialize(this);
-    
-    if (xrefAddress != 0)
+
+    if (xrefId >= 0)
     {
-        _xrefs[xrefAddress] = dynamic_cast<Ref*>(value);
+        _xrefTable[xrefId] = dynamic_cast<Ref*>(value);
     }
-    
+
     return value;
 }
     
@@ -603,9 +672,7 @@ unsigned int SerializerBinary::readObjectList(const char* propertyName)
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Serializer::READER);
     
-    unsigned int count;
-    _stream->read(&count, sizeof(unsigned int), 1);
-    return count;
+    return readCount();
 }
 
 unsigned int SerializerBinary::readIntArray(const char* propertyName, int** data)
@@ -613,8 +680,7 @@ unsigned int SerializerBinary::readIntArray(const char* propertyName, int** data
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Serializer::READER);
 
-    unsigned int count = 0;
-    _stream->read(&count, sizeof(unsigned int), 1);
+    unsigned int count = readCount();
     int* buffer = NULL;
     if (count > 0)
     {
@@ -638,8 +704,7 @@ unsigned int SerializerBinary::readFloatArray(const char* propertyName, float**
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Serializer::READER);
     
-    unsigned int count = 0;
-    _stream->read(&count, sizeof(unsigned int), 1);
+    unsigned int count = readCount();
     float* buffer = NULL;
     if (count > 0)
     {
@@ -663,8 +728,7 @@ unsigned int SerializerBinary::readByteArray(const char* propertyName, unsigned
     GP_ASSERT(propertyName);
     GP_ASSERT(_type == Serializer::READER);
     
-    unsigned int count = 0;
-    _stream->read(&count, sizeof(unsigned int), 1);
+    unsigned int count = readCount();
     unsigned char* buffer = NULL;
     if (count > 0)
     {
@@ -686,7 +750,7 @@ unsigned int SerializerBinary::readByteArray(const char* propertyName, unsigned
 void SerializerBinary::writeLengthPrefixedString(const char* str)
 {
     unsigned int length = strlen(str);
-    _stream->write(&length, sizeof(unsigned int), 1);
+    writeCount(length);
     if (length > 0)
     {
         _stream->write(str, sizeof(char), length);
@@ -695,8 +759,7 @@ void SerializerBinary::writeLengthPrefixedString(const char* str)
     
 void SerializerBinary::readLengthPrefixedString(std::string& str)
 {
-    unsigned int length;
-    _stream->read(&length, sizeof(unsigned int), 1);
+    unsigned int length = readCount();
     if (length > 0)
     {
         str.resize(length);
@@ -708,4 +771,131 @@ void SerializerBinary::readLengthPrefixedString(std::string& str)
     }
 }
 
+
+void SerializerBinary::writeVarint(unsigned int value)
+{
+    // Seven bits per byte, lowest first, with the high bit set on every byte but the last.
+    unsigned char bytes[5];
+    unsigned int count = 0;
+    while (value >= 0x80)
+    {
+        bytes[count++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[count++] = (unsigned char)value;
+    _stream->write(bytes, sizeof(unsigned char), count);
+}
+
+unsigned int SerializerBinary::readVarint()
+{
+    unsigned int value = 0;
+    for (unsigned int shift = 0; shift < 35; shift += 7)
+    {
+        unsigned char byte;
+        if (_stream->read(&byte, sizeof(unsigned char), 1) != 1)
+            break;
+        value |= (unsigned int)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            break;
+    }
+    return value;
+}
+
+void SerializerBinary::writeCount(unsigned int count)
+{
+    if (_compact)
+        writeVarint(count);
+    else
+        _stream->write(&count, sizeof(unsigned int), 1);
+}
+
+unsigned int SerializerBinary::readCount()
+{
+    if (_compact)
+        return readVarint();
+
+    unsigned int count = 0;
+    _stream->read(&count, sizeof(unsigned int), 1);
+    return count;
+}
+
+void SerializerBinary::writeInternedString(const char* str, bool intern)
+{
+    GP_ASSERT(str);
+    GP_ASSERT(_compact);
+
+    // Index 0 is a string written in full that is not entered in the table.
+    if (!intern)
+    {
+        writeVarint(0);
+        writeLengthPrefixedString(str);
+        return;
+    }
+    std::pair<std::unordered_map<std::string, unsigned int>::iterator, bool> result =
+        _stringIds.insert(std::make_pair(std::string(str), (unsigned int)_stringIds.size()));
+    writeVarint(result.first->second + 1);
+    if (result.second)
+        writeLengthPrefixedString(str);
+}
+
+void SerializerBinary::readInternedString(std::string& str)
+{
+    GP_ASSERT(_compact);
+
+    unsigned int index = readVarint();
+    if (index == 0)
+    {
+        readLengthPrefixedString(str);
+        return;
+    }
+    if (--index < _strings.size())
+    {
+        str = _strings[index];
+        return;
+    }
+    if (index != _strings.size())
+    {
+        GP_WARN("Invalid string index %u in binary file: %s", index, _path.c_str());
+        str.clear();
+        return;
+    }
+    readLengthPrefixedString(str);
+    _strings.push_back(str);
+}
+
+void SerializerBinary::writeClass(const char* className)
+{
+    GP_ASSERT(className);
+    GP_ASSERT(_compact);
+
+    std::pair<std::unordered_map<std::string, unsigned int>::iterator, bool> result =
+        _classIds.insert(std::make_pair(std::string(className), (unsigned int)_classIds.size()));
+    writeVarint(result.first->second);
+    if (result.second)
+        writeLengthPrefixedString(className);
+}
+
+const SerializerBinary::ClassEntry* SerializerBinary::readClass()
+{
+    GP_ASSERT(_compact);
+
+    unsigned int classId = readVarint();
+    if (classId < _classes.size())
+        return &_classes[classId];
+    if (classId != _classes.size())
+    {
+        GP_WARN("Invalid class id %u in binary file: %s", classId, _path.c_str());
+        return NULL;
+    }
+
+    // Resolve the class once, rather than for every object of the class.
+    ClassEntry entry;
+    readLengthPrefixedString(entry.name);
+    Serializer::Activator* activator = Serializer::getActivator();
+    std::map<std::string, Serializer::Activator::CreateInstanceCallback>::const_iterator itr = activator->_classes.find(entry.name);
+    entry.createInstance = itr != activator->_classes.end() ? itr->second : NULL;
+    _classes.push_back(entry);
+    return &_classes.back();
+}
+
 }
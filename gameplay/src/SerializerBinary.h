@@ -10,6 +10,15 @@ namespace gameplay
 /**
  * Defines a binary serializer.
  *
+ * Files of version 4.1 and later use a compact layout. Strings and class names are
+ * interned in tables that are built as the file is written: the first occurrence of
+ * a string is written in full after its new index, and every later occurrence is
+ * written as the index alone. Identifiers, which rarely repeat, are written in full
+ * after the reserved string index 0 instead. Class ids, xref ids, counts and ints are written as
+ * variable length integers, and xref ids are dense indices into the table of the
+ * objects read so far rather than addresses. Arrays are written as a single block.
+ * Files of version 4.0 can still be read.
+ *
  * @see Serializer
  */
 class SerializerBinary : public Serializer
@@ -225,13 +234,58 @@ protected:
     void readLengthPrefixedString(std::string& str);
     
 private:
-    
+
+    /**
+     * A class of the class table, with the callback that creates its instances.
+     */
+    struct ClassEntry
+    {
+        std::string name;
+        Serializer::Activator::CreateInstanceCallback createInstance;
+    };
+
+    void writeVarint(unsigned int value);
+
+    unsigned int readVarint();
+
+    void writeCount(unsigned int count);
+
+    unsigned int readCount();
+
+    /**
+     * Writes a string as an index into the string table, followed by the string if it is new.
+     *
+     * @param str The string to write.
+     * @param intern false to write the string in full without entering it in the table,
+     *      for strings that are unlikely to repeat.
+     */
+    void writeInternedString(const char* str, bool intern = true);
+
+    void readInternedString(std::string& str);
+
+    /**
+     * Writes the class of an object as an index into the class table, followed by its name if it is new.
+     */
+    void writeClass(const char* className);
+
+    /**
+     * Reads the class of an object, and resolves the callback that creates its instances the first time.
+     */
+    const ClassEntry* readClass();
+
     static unsigned char BIT_NULL;
     static unsigned char BIT_VALUE;
     static unsigned char BIT_XREF;
     static unsigned char BIT_DEFAULT;
 
-    std::map<unsigned long, Ref*> _xrefs;
+    bool _compact;                                              // Whether the stream uses the compact layout of version 4.1.
+    std::map<unsigned long, Ref*> _xrefs;                       // Objects read from a version 4.0 file, by address.
+    std::vector<Ref*> _xrefTable;                               // Objects read, by xref id.
+    std::unordered_map<Ref*, unsigned int> _xrefIds;            // Objects written, and their xref ids.
+    std::vector<std::string> _strings;                          // Strings read, by index.
+    std::unordered_map<std::string, unsigned int> _stringIds;   // Strings written, and their indices.
+    std::vector<ClassEntry> _classes;                           // Classes read, by class id.
+    std::unordered_map<std::string, unsigned int> _classIds;    // Classes written, and their class ids.
 };
 
 }
@@ -81,6 +81,21 @@ public:
      * @see canRead()
      */
     virtual char* readLine(char* str, int num) = 0;
+
+    /**
+     * Reads bytes from the stream without copying them, if the stream supports it.
+     *
+     * Streams over memory, such as memory-mapped files, return a pointer to the next
+     * <code>size</code> bytes of the stream and advance the position past them. The
+     * returned memory is read-only and remains valid until the stream is closed.
+     *
+     * @param size The number of bytes to read.
+     *
+     * @return A pointer to the bytes read, or NULL if the stream does not support reading
+     *         in place or fewer than <code>size</code> bytes remain, in which case the
+     *         position is unchanged.
+     */
+    virtual const void* readInPlace(size_t size) { return NULL; }
     
     /**
      * Writes an array of <code>count</code> elements, each of size <code>size</code>.
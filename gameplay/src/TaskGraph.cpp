@@ -0,0 +1,114 @@
+#include "Base.h"
+#include "TaskGraph.h"
+
+namespace gameplay
+{
+
+TaskGraph::TaskGraph()
+    : _remaining(0)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+    GP_ASSERT(_remaining.load() == 0);
+
+    for (size_t i = 0, count = _tasks.size(); i < count; ++i)
+    {
+        SAFE_DELETE(_tasks[i]);
+    }
+}
+
+unsigned int TaskGraph::addTask(const char* id, const std::function<void()>& function, Affinity affinity)
+{
+    GP_ASSERT(_remaining.load() == 0);
+
+    Task* task = new Task();
+    task->id = id ? id : "";
+    task->function = function;
+    task->affinity = affinity;
+    task->dependencyCount = 0;
+    task->pending = 0;
+    _tasks.push_back(task);
+    return (unsigned int)_tasks.size() - 1;
+}
+
+bool TaskGraph::addDependency(unsigned int task, unsigned int dependency)
+{
+    GP_ASSERT(task < _tasks.size() && dependency < _tasks.size());
+    GP_ASSERT(_remaining.load() == 0);
+
+    if (task == dependency || dependsOn(dependency, task))
+    {
+        GP_WARN("Ignoring dependency of task '%s' on '%s'; it would create a cycle.", _tasks[task]->id.c_str(), _tasks[dependency]->id.c_str());
+        return false;
+    }
+
+    std::vector<unsigned int>& dependents = _tasks[dependency]->dependents;
+    if (std::find(dependents.begin(), dependents.end(), task) == dependents.end())
+    {
+        dependents.push_back(task);
+        ++_tasks[task]->dependencyCount;
+    }
+    return true;
+}
+
+void TaskGraph::removeDependency(unsigned int task, unsigned int dependency)
+{
+    GP_ASSERT(task < _tasks.size() && dependency < _tasks.size());
+    GP_ASSERT(_remaining.load() == 0);
+
+    std::vector<unsigned int>& dependents = _tasks[dependency]->dependents;
+    std::vector<unsigned int>::iterator itr = std::find(dependents.begin(), dependents.end(), task);
+    if (itr != dependents.end())
+    {
+        dependents.erase(itr);
+        --_tasks[task]->dependencyCount;
+    }
+}
+
+int TaskGraph::findTask(const char* id) const
+{
+    GP_ASSERT(id);
+
+    for (size_t i = 0, count = _tasks.size(); i < count; ++i)
+    {
+        if (_tasks[i]->id == id)
+            return (int)i;
+    }
+    return -1;
+}
+
+const char* TaskGraph::getTaskId(unsigned int task) const
+{
+    GP_ASSERT(task < _tasks.size());
+    return _tasks[task]->id.c_str();
+}
+
+unsigned int TaskGraph::getTaskCount() const
+{
+    return (unsigned int)_tasks.size();
+}
+
+bool TaskGraph::dependsOn(unsigned int task, unsigned int dependency) const
+{
+    // Walk the dependents of the dependency looking for the task.
+    std::vector<unsigned int> stack(1, dependency);
+    std::vector<bool> visited(_tasks.size(), false);
+    while (!stack.empty())
+    {
+        unsigned int current = stack.back();
+        stack.pop_back();
+        if (current == task)
+            return true;
+        if (visited[current])
+            continue;
+        visited[current] = true;
+
+        const std::vector<unsigned int>& dependents = _tasks[current]->dependents;
+        stack.insert(stack.end(), dependents.begin(), dependents.end());
+    }
+    return false;
+}
+
+}
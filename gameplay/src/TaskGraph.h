@@ -0,0 +1,131 @@
+#ifndef TASKGRAPH_H_
+#define TASKGRAPH_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines a set of tasks and the dependencies between them.
+ *
+ * A task graph is built once and then run any number of times with
+ * JobController::run(). Each run executes every task exactly once, and a task
+ * only starts after all of the tasks it depends on have completed. Tasks with
+ * no dependency path between them may run concurrently on worker threads.
+ */
+class TaskGraph
+{
+    friend class JobController;
+
+public:
+
+    /**
+     * Defines the threads a task is allowed to run on.
+     */
+    enum Affinity
+    {
+        /** The task may run on any thread, including worker threads. */
+        ANY_THREAD,
+        /** The task always runs on the thread that called JobController::run(). */
+        MAIN_THREAD
+    };
+
+    /**
+     * Constructor.
+     */
+    TaskGraph();
+
+    /**
+     * Destructor.
+     */
+    ~TaskGraph();
+
+    /**
+     * Adds a task to the graph.
+     *
+     * @param id The task's identifier.
+     * @param function The function to run.
+     * @param affinity The threads the task is allowed to run on.
+     *
+     * @return The index of the new task.
+     */
+    unsigned int addTask(const char* id, const std::function<void()>& function, Affinity affinity = ANY_THREAD);
+
+    /**
+     * Makes a task wait for another task to complete before it starts.
+     *
+     * Dependencies that would create a cycle are ignored.
+     *
+     * @param task The index of the dependent task.
+     * @param dependency The index of the task it depends on.
+     *
+     * @return true if the dependency was added, false if it would create a cycle.
+     */
+    bool addDependency(unsigned int task, unsigned int dependency);
+
+    /**
+     * Removes a dependency previously added with addDependency().
+     *
+     * @param task The index of the dependent task.
+     * @param dependency The index of the task it depends on.
+     */
+    void removeDependency(unsigned int task, unsigned int dependency);
+
+    /**
+     * Finds a task by its identifier.
+     *
+     * @param id The task's identifier.
+     *
+     * @return The index of the task, or -1 if there is no task with the given identifier.
+     */
+    int findTask(const char* id) const;
+
+    /**
+     * Gets the identifier of a task.
+     *
+     * @param task The index of the task.
+     *
+     * @return The task's identifier.
+     */
+    const char* getTaskId(unsigned int task) const;
+
+    /**
+     * Gets the number of tasks in the graph.
+     *
+     * @return The number of tasks.
+     */
+    unsigned int getTaskCount() const;
+
+private:
+
+    /**
+     * A task and its run state.
+     */
+    struct Task
+    {
+        std::string id;
+        std::function<void()> function;
+        Affinity affinity;
+        std::vector<unsigned int> dependents;
+        unsigned int dependencyCount;
+        std::atomic<unsigned int> pending;
+    };
+
+    /**
+     * Constructor.
+     */
+    TaskGraph(const TaskGraph& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    TaskGraph& operator=(const TaskGraph&);
+
+    bool dependsOn(unsigned int task, unsigned int dependency) const;
+
+    std::vector<Task*> _tasks;
+    std::atomic<unsigned int> _remaining;
+};
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include "Image.h"
 #include "Texture.h"
 #include "FileSystem.h"
+#include "ResourceCache.h"
 
 // PVRTC (GL_IMG_texture_compression_pvrtc) : Imagination based gpus
 #ifndef GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG
@@ -47,7 +48,7 @@
 namespace gameplay
 {
 
-static std::vector<Texture*> __textureCache;
+static ResourceCache<Texture> __textureCache;
 static TextureHandle __currentTextureId = 0;
 static Texture::Type __currentTextureType = Texture::TEXTURE_2D;
 
@@ -68,11 +69,7 @@ Texture::~Texture()
     }
     if (_cached)
     {
-        std::vector<Texture*>::iterator itr = std::find(__textureCache.begin(), __textureCache.end(), this);
-        if (itr != __textureCache.end())
-        {
-            __textureCache.erase(itr);
-        }
+        __textureCache.remove(_path, this);
     }
 }
 
@@ -81,23 +78,16 @@ Texture* Texture::create(const char* path, bool generateMipmaps)
     GP_ASSERT( path );
 
     // Search texture cache first.
-    for (size_t i = 0, count = __textureCache.size(); i < count; ++i)
+    Texture* t = getCached(path);
+    if (t)
     {
-        Texture* t = __textureCache[i];
-        GP_ASSERT( t );
-        if (t->_path == path)
+        // If 'generateMipmaps' is true, call Texture::generateMipamps() to force the
+        // texture to generate its mipmap chain if it hasn't already done so.
+        if (generateMipmaps)
         {
-            // If 'generateMipmaps' is true, call Texture::generateMipamps() to force the
-            // texture to generate its mipmap chain if it hasn't already done so.
-            if (generateMipmaps)
-            {
-                t->generateMipmaps();
-            }
-            // Found a match.
-            t->addRef();
-
-            return t;
+            t->generateMipmaps();
         }
+        return t;
     }
 
     Texture* texture = NULL;
@@ -116,15 +106,12 @@ Texture* Texture::create(const char* path, bool generateMipmaps)
                     texture = create(image, generateMipmaps);
                 SAFE_RELEASE(image);
             }
-            else if (tolower(ext[1]) == 'p' && tolower(ext[2]) == 'v' && tolower(ext[3]) == 'r')
-            {
-                // PowerVR Compressed Texture RGBA.
-                texture = createCompressedPVRTC(path);
-            }
-            else if (tolower(ext[1]) == 'd' && tolower(ext[2]) == 'd' && tolower(ext[3]) == 's')
+            else
             {
-                // DDS file format (DXT/S3TC) compressed textures
-                texture = createCompressedDDS(path);
+                // DDS and PVR files.
+                FileData data;
+                if (readFile(path, &data))
+                    texture = create(&data);
             }
             break;
         }
@@ -132,11 +119,8 @@ Texture* Texture::create(const char* path, bool generateMipmaps)
 
     if (texture)
     {
-        texture->_path = path;
-        texture->_cached = true;
-
         // Add to texture cache.
-        __textureCache.push_back(texture);
+        addToCache(path, texture);
 
         return texture;
     }
@@ -145,6 +129,22 @@ Texture* Texture::create(const char* path, bool generateMipmaps)
     return NULL;
 }
 
+Texture* Texture::getCached(const char* path)
+{
+    GP_ASSERT( path );
+    return __textureCache.acquire(path);
+}
+
+void Texture::addToCache(const char* path, Texture* texture)
+{
+    GP_ASSERT( path );
+    GP_ASSERT( texture );
+
+    texture->_path = path;
+    texture->_cached = true;
+    __textureCache.add(path, texture);
+}
+
 Texture* Texture::create(Image* image, bool generateMipmaps)
 {
     GP_ASSERT( image );
@@ -384,6 +384,82 @@ void Texture::setData(const unsigned char* data)
     // Restore the texture id
     GL_ASSERT( glBindTexture((GLenum)__currentTextureType, __currentTextureId) );
 }
+Texture::FileData::FileData()
+    : type(TEXTURE_2D), format(0), internalFormat(0), compressed(false), width(0), height(0), mipMapCount(0), data(NULL)
+{
+}
+
+Texture::FileData::~FileData()
+{
+    SAFE_DELETE_ARRAY(data);
+}
+
+bool Texture::readFile(const char* path, FileData* file)
+{
+    GP_ASSERT( path );
+    GP_ASSERT( file );
+
+    // Filter loading based on file extension.
+    const char* ext = strrchr(FileSystem::resolvePath(path), '.');
+    if (ext && strlen(ext) == 4)
+    {
+        if (tolower(ext[1]) == 'p' && tolower(ext[2]) == 'v' && tolower(ext[3]) == 'r')
+        {
+            // PowerVR Compressed Texture RGBA.
+            return readCompressedPVRTCFile(path, file);
+        }
+        else if (tolower(ext[1]) == 'd' && tolower(ext[2]) == 'd' && tolower(ext[3]) == 's')
+        {
+            // DDS file format (DXT/S3TC) compressed textures
+            return readCompressedDDSFile(path, file);
+        }
+    }
+    GP_ERROR("Unsupported texture file '%s'.", path);
+    return false;
+}
+
+Texture* Texture::create(const FileData* data)
+{
+    GP_ASSERT( data );
+
+    // Generate GL texture.
+    GLenum target = (GLenum)data->type;
+    GLuint textureId;
+    GL_ASSERT( glGenTextures(1, &textureId) );
+    GL_ASSERT( glBindTexture(target, textureId) );
+
+    Filter filterMin = data->mipMapCount > 1 ? NEAREST_MIPMAP_LINEAR : LINEAR;
+    GL_ASSERT( glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filterMin) );
+
+    // Create gameplay texture.
+    Texture* texture = new Texture();
+    texture->_handle = textureId;
+    texture->_type = data->type;
+    texture->_width = data->width;
+    texture->_height = data->height;
+    texture->_compressed = data->compressed;
+    texture->_mipmapped = data->mipMapCount > 1;
+    texture->_filterMin = filterMin;
+
+    // Load texture data.
+    for (size_t i = 0, count = data->levels.size(); i < count; ++i)
+    {
+        const FileData::Level& level = data->levels[i];
+        if (data->compressed)
+        {
+            GL_ASSERT( glCompressedTexImage2D(level.target, level.level, data->format, level.width, level.height, 0, level.size, level.data) );
+        }
+        else
+        {
+            GL_ASSERT( glTexImage2D(level.target, level.level, data->internalFormat, level.width, level.height, 0, data->format, GL_UNSIGNED_BYTE, level.data) );
+        }
+    }
+
+    // Restore the texture id
+    GL_ASSERT( glBindTexture((GLenum)__currentTextureType, __currentTextureId) );
+
+    return texture;
+}
 
 // Computes the size of a PVRTC data chunk for a mipmap level of the given size.
 static unsigned int computePVRTCDataSize(int width, int height, int bpp)
@@ -408,13 +484,15 @@ static unsigned int computePVRTCDataSize(int width, int height, int bpp)
     return widthBlocks * heightBlocks * ((blockSize  * bpp) >> 3);
 }
 
-Texture* Texture::createCompressedPVRTC(const char* path)
+bool Texture::readCompressedPVRTCFile(const char* path, FileData* file)
 {
+    GP_ASSERT( file );
+
     std::unique_ptr<Stream> stream(FileSystem::open(path));
     if (stream.get() == NULL || !stream->canRead())
     {
         GP_ERROR("Failed to load file '%s'.", path);
-        return NULL;
+        return false;
     }
 
     // Read first 4 bytes to determine PVRTC format.
@@ -424,14 +502,14 @@ Texture* Texture::createCompressedPVRTC(const char* path)
     if (read != 1)
     {
         GP_ERROR("Failed to read PVR version.");
-        return NULL;
+        return false;
     }
 
     // Rewind to start of header.
     if (stream->seek(0, SEEK_SET) == false)
     {
         GP_ERROR("Failed to seek backwards to beginning of file after reading PVR version.");
-        return NULL;
+        return false;
     }
 
     // Read texture data.
@@ -455,31 +533,21 @@ Texture* Texture::createCompressedPVRTC(const char* path)
     if (data == NULL)
     {
         GP_ERROR("Failed to read texture data from PVR file '%s'.", path);
-        return NULL;
+        return false;
     }
     stream->close();
 
     int bpp = (format == GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG || format == GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG) ? 2 : 4;
 
-    // Generate our texture.
-    GLenum target = faceCount > 1 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
-    GLuint textureId;
-    GL_ASSERT( glGenTextures(1, &textureId) );
-    GL_ASSERT( glBindTexture(target, textureId) );
-
-    Filter filterMin = mipMapCount > 1 ? NEAREST_MIPMAP_LINEAR : LINEAR;
-    GL_ASSERT( glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filterMin) );
+    file->type = faceCount > 1 ? TEXTURE_CUBE : TEXTURE_2D;
+    file->format = file->internalFormat = format;
+    file->compressed = true;
+    file->width = width;
+    file->height = height;
+    file->mipMapCount = mipMapCount;
+    file->data = data;
 
-    Texture* texture = new Texture();
-    texture->_handle = textureId;
-    texture->_type = faceCount > 1 ? TEXTURE_CUBE : TEXTURE_2D;
-    texture->_width = width;
-    texture->_height = height;
-    texture->_mipmapped = mipMapCount > 1;
-    texture->_compressed = true;
-    texture->_filterMin = filterMin;
-
-    // Load the data for each level.
+    // Find the data of each level.
     GLubyte* ptr = data;
     for (unsigned int level = 0; level < mipMapCount; ++level)
     {
@@ -487,8 +555,8 @@ Texture* Texture::createCompressedPVRTC(const char* path)
 
         for (unsigned int face = 0; face < faceCount; ++face)
         {
-            // Upload data to GL.
-            GL_ASSERT(glCompressedTexImage2D(faces[face], level, format, width, height, 0, dataSize, &ptr[face * dataSize]));
+            FileData::Level fileLevel = { faces[face], (GLint)level, width, height, (GLsizei)dataSize, &ptr[face * dataSize] };
+            file->levels.push_back(fileLevel);
         }
 
         width = std::max(width >> 1, 1);
@@ -496,13 +564,7 @@ Texture* Texture::createCompressedPVRTC(const char* path)
         ptr += dataSize * faceCount;
     }
 
-    // Free data.
-    SAFE_DELETE_ARRAY(data);
-
-    // Restore the texture id
-    GL_ASSERT( glBindTexture((GLenum)__currentTextureType, __currentTextureId) );
-
-    return texture;
+    return true;
 }
 
 GLubyte* Texture::readCompressedPVRTC(const char* path, Stream* stream, GLsizei* width, GLsizei* height, GLenum* format, unsigned int* mipMapCount, unsigned int* faceCount, GLenum* faces)
@@ -791,9 +853,10 @@ int Texture::getMaskByteIndex(unsigned int mask)
     }
 }
 
-Texture* Texture::createCompressedDDS(const char* path)
+bool Texture::readCompressedDDSFile(const char* path, FileData* file)
 {
     GP_ASSERT( path );
+    GP_ASSERT( file );
 
     // DDS file structures.
     struct dds_pixel_format
@@ -826,22 +889,12 @@ Texture* Texture::createCompressedDDS(const char* path)
         unsigned int     dwReserved2;
     };
 
-    struct dds_mip_level
-    {
-        GLubyte* data;
-        GLsizei width;
-        GLsizei height;
-        GLsizei size;
-    };
-
-    Texture* texture = NULL;
-
     // Read DDS file.
     std::unique_ptr<Stream> stream(FileSystem::open(path));
     if (stream.get() == NULL || !stream->canRead())
     {
         GP_ERROR("Failed to open file '%s'.", path);
-        return NULL;
+        return false;
     }
 
     // Validate DDS magic number.
@@ -849,7 +902,7 @@ Texture* Texture::createCompressedDDS(const char* path)
     if (stream->read(code, 1, 4) != 4 || strncmp(code, "DDS ", 4) != 0)
     {
         GP_ERROR("Failed to read DDS file '%s': invalid DDS magic number.", path);
-        return NULL;
+        return false;
     }
 
     // Read DDS header.
@@ -857,7 +910,7 @@ Texture* Texture::createCompressedDDS(const char* path)
     if (stream->read(&header, sizeof(dds_header), 1) != 1)
     {
         GP_ERROR("Failed to read header for DDS file '%s'.", path);
-        return NULL;
+        return false;
     }
 
     if ((header.dwFlags & 0x20000/*DDSD_MIPMAPCOUNT*/) == 0)
@@ -869,10 +922,11 @@ Texture* Texture::createCompressedDDS(const char* path)
     // Check type of images. Default is a regular texture
     unsigned int facecount = 1;
     GLenum faces[6] = { GL_TEXTURE_2D };
-    GLenum target = GL_TEXTURE_2D;
+    Type type = TEXTURE_2D;
     if ((header.dwCaps2 & 0x200/*DDSCAPS2_CUBEMAP*/) != 0)
     {
         facecount = 0;
+        type = TEXTURE_CUBE;
         for (unsigned int off = 0, flag = 0x400/*DDSCAPS2_CUBEMAP_POSITIVEX*/; off < 6; ++off, flag <<= 1)
         {
             if ((header.dwCaps2 & flag) != 0)
@@ -880,30 +934,24 @@ Texture* Texture::createCompressedDDS(const char* path)
                 faces[facecount++] = GL_TEXTURE_CUBE_MAP_POSITIVE_X + off;
             }
         }
-        target = GL_TEXTURE_CUBE_MAP;
     }
     else if ((header.dwCaps2 & 0x200000/*DDSCAPS2_VOLUME*/) != 0)
     {
         // Volume textures unsupported.
         GP_ERROR("Failed to create texture from DDS file '%s': volume textures are unsupported.", path);
-        return NULL;
+        return false;
     }
 
-    // Allocate mip level structures.
-    dds_mip_level* mipLevels = new dds_mip_level[header.dwMipMapCount * facecount];
-    memset(mipLevels, 0, sizeof(dds_mip_level) * header.dwMipMapCount * facecount);
-
     GLenum format = 0;
     GLenum internalFormat = 0;
     bool compressed = false;
-    GLsizei width = header.dwWidth;
-    GLsizei height = header.dwHeight;
-    Texture::Format textureFormat = Texture::UNKNOWN;
+    int bytesPerBlock = 0;
+    bool colorConvert = false;
+    int ridx = 0, gidx = 1, bidx = 2, aidx = 3;
 
     if (header.ddspf.dwFlags & 0x4/*DDPF_FOURCC*/)
     {
         compressed = true;
-        int bytesPerBlock;
 
         // Compressed.
         switch (header.ddspf.dwFourCC)
@@ -938,63 +986,25 @@ Texture* Texture::createCompressedDDS(const char* path)
             break;
         default:
             GP_ERROR("Unsupported compressed texture format (%d) for DDS file '%s'.", header.ddspf.dwFourCC, path);
-            SAFE_DELETE_ARRAY(mipLevels);
-            return NULL;
-        }
-
-        for (unsigned int face = 0; face < facecount; ++face)
-        {
-            for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
-            {
-                dds_mip_level& level = mipLevels[i + face * header.dwMipMapCount];
-
-                level.width = width;
-                level.height = height;
-                level.size = std::max(1, (width + 3) >> 2) * std::max(1, (height + 3) >> 2) * bytesPerBlock;
-                level.data = new GLubyte[level.size];
-
-                if (stream->read(level.data, 1, level.size) != (unsigned int)level.size)
-                {
-                    GP_ERROR("Failed to load dds compressed texture bytes for texture: %s", path);
-
-                    // Cleanup mip data.
-                    for (unsigned int face = 0; face < facecount; ++face)
-                        for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
-                            SAFE_DELETE_ARRAY(mipLevels[i + face * header.dwMipMapCount].data);
-                    SAFE_DELETE_ARRAY(mipLevels);
-                    return texture;
-                }
-
-                width = std::max(1, width >> 1);
-                height = std::max(1, height >> 1);
-            }
-            width = header.dwWidth;
-            height = header.dwHeight;
+            return false;
         }
     }
     else if (header.ddspf.dwFlags & 0x40/*DDPF_RGB*/)
     {
         // RGB/RGBA (uncompressed)
-        bool colorConvert = false;
-        unsigned int rmask = header.ddspf.dwRBitMask;
-        unsigned int gmask = header.ddspf.dwGBitMask;
-        unsigned int bmask = header.ddspf.dwBBitMask;
-        unsigned int amask = header.ddspf.dwABitMask;
-        int ridx = getMaskByteIndex(rmask);
-        int gidx = getMaskByteIndex(gmask);
-        int bidx = getMaskByteIndex(bmask);
-        int aidx = getMaskByteIndex(amask);
+        ridx = getMaskByteIndex(header.ddspf.dwRBitMask);
+        gidx = getMaskByteIndex(header.ddspf.dwGBitMask);
+        bidx = getMaskByteIndex(header.ddspf.dwBBitMask);
+        aidx = getMaskByteIndex(header.ddspf.dwABitMask);
 
         if (header.ddspf.dwRGBBitCount == 24)
         {
             format = internalFormat = GL_RGB;
-            textureFormat = Texture::RGB;
             colorConvert = (ridx != 0) || (gidx != 1) || (bidx != 2);
         }
         else if (header.ddspf.dwRGBBitCount == 32)
         {
             format = internalFormat = GL_RGBA;
-            textureFormat = Texture::RGBA;
             if (ridx == 0 && gidx == 1 && bidx == 2)
             {
                 aidx = 3; // XBGR or ABGR
@@ -1014,142 +1024,90 @@ Texture* Texture::createCompressedDDS(const char* path)
         if (format == 0)
         {
             GP_ERROR("Failed to create texture from uncompressed DDS file '%s': Unsupported color format (must be one of R8G8B8, A8R8G8B8, A8B8G8R8, X8R8G8B8, X8B8G8R8.", path);
-            SAFE_DELETE_ARRAY(mipLevels);
-            return NULL;
-        }
-
-        // Read data.
-        for (unsigned int face = 0; face < facecount; ++face)
-        {
-            for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
-            {
-                dds_mip_level& level = mipLevels[i + face * header.dwMipMapCount];
-
-                level.width = width;
-                level.height = height;
-                level.size = width * height * (header.ddspf.dwRGBBitCount >> 3);
-                level.data = new GLubyte[level.size];
-
-                if (stream->read(level.data, 1, level.size) != (unsigned int)level.size)
-                {
-                    GP_ERROR("Failed to load bytes for RGB dds texture: %s", path);
-
-                    // Cleanup mip data.
-                    for (unsigned int face = 0; face < facecount; ++face)
-                        for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
-                            SAFE_DELETE_ARRAY(mipLevels[i + face * header.dwMipMapCount].data);
-                    SAFE_DELETE_ARRAY(mipLevels);
-                    return texture;
-                }
-
-                width = std::max(1, width >> 1);
-                height = std::max(1, height >> 1);
-            }
-            width = header.dwWidth;
-            height = header.dwHeight;
-        }
-
-        // Perform color conversion.
-        if (colorConvert)
-        {
-            // Note: While it's possible to use BGRA_EXT texture formats here and avoid CPU color conversion below,
-            // there seems to be different flavors of the BGRA extension, with some vendors requiring an internal
-            // format of RGBA and others requiring an internal format of BGRA.
-            // We could be smarter here later and skip color conversion in favor of GL_BGRA_EXT (for format
-            // and/or internal format) based on which GL extensions are available.
-            // Tip: Using A8B8G8R8 and X8B8G8R8 DDS format maps directly to GL RGBA and requires on no color conversion.
-            GLubyte *pixel, r, g, b, a;
-            if (format == GL_RGB)
-            {
-                for (unsigned int face = 0; face < facecount; ++face)
-                {
-                    for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
-                    {
-                        dds_mip_level& level = mipLevels[i + face * header.dwMipMapCount];
-                        for (int j = 0; j < level.size; j += 3)
-                        {
-                            pixel = &level.data[j];
-                            r = pixel[ridx]; g = pixel[gidx]; b = pixel[bidx];
-                            pixel[0] = r; pixel[1] = g; pixel[2] = b;
-                        }
-                    }
-                }
-            }
-            else if (format == GL_RGBA)
-            {
-                for (unsigned int face = 0; face < facecount; ++face)
-                {
-                    for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
-                    {
-                        dds_mip_level& level = mipLevels[i + face * header.dwMipMapCount];
-                        for (int j = 0; j < level.size; j += 4)
-                        {
-                            pixel = &level.data[j];
-                            r = pixel[ridx]; g = pixel[gidx]; b = pixel[bidx]; a = pixel[aidx];
-                            pixel[0] = r; pixel[1] = g; pixel[2] = b; pixel[3] = a;
-                        }
-                    }
-                }
-            }
+            return false;
         }
     }
     else
     {
         // Unsupported.
         GP_ERROR("Failed to create texture from DDS file '%s': unsupported flags (%d).", path, header.ddspf.dwFlags);
-        SAFE_DELETE_ARRAY(mipLevels);
-        return NULL;
+        return false;
     }
 
-    // Close file.
-    stream->close();
-
-    // Generate GL texture.
-    GLuint textureId;
-    GL_ASSERT( glGenTextures(1, &textureId) );
-    GL_ASSERT( glBindTexture(target, textureId) );
-
-    Filter filterMin = header.dwMipMapCount > 1 ? NEAREST_MIPMAP_LINEAR : LINEAR;
-    GL_ASSERT( glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filterMin ) );
-
-    // Create gameplay texture.
-    texture = new Texture();
-    texture->_handle = textureId;
-    texture->_type = (Type)target;
-    texture->_width = header.dwWidth;
-    texture->_height = header.dwHeight;
-    texture->_compressed = compressed;
-    texture->_mipmapped = header.dwMipMapCount > 1;
-    texture->_filterMin = filterMin;
-
-    // Load texture data.
+    // Find the size of each level. The levels follow each other in the file, face by face.
+    file->type = type;
+    file->format = format;
+    file->internalFormat = internalFormat;
+    file->compressed = compressed;
+    file->width = header.dwWidth;
+    file->height = header.dwHeight;
+    file->mipMapCount = header.dwMipMapCount;
+    size_t dataSize = 0;
     for (unsigned int face = 0; face < facecount; ++face)
     {
-        GLenum texImageTarget = faces[face];
+        GLsizei width = header.dwWidth;
+        GLsizei height = header.dwHeight;
         for (unsigned int i = 0; i < header.dwMipMapCount; ++i)
         {
-            dds_mip_level& level = mipLevels[i + face * header.dwMipMapCount];
+            FileData::Level level = { faces[face], (GLint)i, width, height, 0, NULL };
             if (compressed)
-            {
-                GL_ASSERT(glCompressedTexImage2D(texImageTarget, i, format, level.width, level.height, 0, level.size, level.data));
-            }
+                level.size = std::max(1, (width + 3) >> 2) * std::max(1, (height + 3) >> 2) * bytesPerBlock;
             else
-            {
-                GL_ASSERT(glTexImage2D(texImageTarget, i, internalFormat, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, level.data));
-            }
+                level.size = width * height * (header.ddspf.dwRGBBitCount >> 3);
+            file->levels.push_back(level);
+            dataSize += level.size;
 
-            // Clean up the texture data.
-            SAFE_DELETE_ARRAY(level.data);
+            width = std::max(1, width >> 1);
+            height = std::max(1, height >> 1);
         }
     }
 
-    // Clean up mip levels structure.
-    SAFE_DELETE_ARRAY(mipLevels);
+    // Read data.
+    file->data = new GLubyte[dataSize];
+    if (stream->read(file->data, 1, dataSize) != dataSize)
+    {
+        GP_ERROR("Failed to load bytes for dds texture: %s", path);
+        return false;
+    }
+    stream->close();
+    GLubyte* ptr = file->data;
+    for (size_t i = 0, count = file->levels.size(); i < count; ++i)
+    {
+        file->levels[i].data = ptr;
+        ptr += file->levels[i].size;
+    }
 
-    // Restore the texture id
-    GL_ASSERT( glBindTexture((GLenum)__currentTextureType, __currentTextureId) );
+    // Perform color conversion.
+    if (colorConvert)
+    {
+        // Note: While it's possible to use BGRA_EXT texture formats here and avoid CPU color conversion below,
+        // there seems to be different flavors of the BGRA extension, with some vendors requiring an internal
+        // format of RGBA and others requiring an internal format of BGRA.
+        // We could be smarter here later and skip color conversion in favor of GL_BGRA_EXT (for format
+        // and/or internal format) based on which GL extensions are available.
+        // Tip: Using A8B8G8R8 and X8B8G8R8 DDS format maps directly to GL RGBA and requires on no color conversion.
+        GLubyte *pixel, r, g, b, a;
+        if (format == GL_RGB)
+        {
+            for (size_t j = 0; j < dataSize; j += 3)
+            {
+                pixel = &file->data[j];
+                r = pixel[ridx]; g = pixel[gidx]; b = pixel[bidx];
+                pixel[0] = r; pixel[1] = g; pixel[2] = b;
+            }
+        }
+        else if (format == GL_RGBA)
+        {
+            for (size_t j = 0; j < dataSize; j += 4)
+            {
+                pixel = &file->data[j];
+                r = pixel[ridx]; g = pixel[gidx]; b = pixel[bidx]; a = pixel[aidx];
+                pixel[0] = r; pixel[1] = g; pixel[2] = b; pixel[3] = a;
+            }
+        }
+    }
 
-    return texture;
+    return true;
 }
 
 Texture::Format Texture::getFormat() const
@@ -17,6 +17,7 @@ class Texture : public Ref, public Serializable
 {
     friend class Serializer::Activator;
     friend class Sampler;
+    friend class LoadController;
 
 public:
 
@@ -345,6 +346,40 @@ public:
 
 private:
 
+    /**
+     * The levels of a DDS or PVR file, read and decoded so that the texture can be created
+     * from them without touching the file. Reading a file does not use the graphics API,
+     * so it may be done on a loader thread.
+     */
+    struct FileData
+    {
+        /**
+         * A mipmap level of a face.
+         */
+        struct Level
+        {
+            GLenum target;          // GL_TEXTURE_2D, or the face of a cube map.
+            GLint level;
+            GLsizei width;
+            GLsizei height;
+            GLsizei size;
+            GLubyte* data;          // Points into the data of the file.
+        };
+
+        FileData();
+        ~FileData();
+
+        Type type;
+        GLenum format;
+        GLenum internalFormat;
+        bool compressed;
+        unsigned int width;
+        unsigned int height;
+        unsigned int mipMapCount;
+        std::vector<Level> levels;
+        GLubyte* data;
+    };
+
     /**
      * Constructor.
      */
@@ -380,9 +415,34 @@ private:
      */
     static int enumParse(const char* enumName, const char* str);
 
-    static Texture* createCompressedPVRTC(const char* path);
+    /**
+     * Finds the texture loaded from the given path in the cache, and adds a reference to it.
+     */
+    static Texture* getCached(const char* path);
+
+    /**
+     * Adds a texture loaded from the given path to the cache.
+     */
+    static void addToCache(const char* path, Texture* texture);
+
+    /**
+     * Reads the levels of a DDS or PVR file.
+     *
+     * @param path The path of the file.
+     * @param file Receives the levels of the file.
+     *
+     * @return true if the file was read, false otherwise.
+     */
+    static bool readFile(const char* path, FileData* file);
+
+    /**
+     * Creates a texture from the levels of a DDS or PVR file, on the main thread.
+     */
+    static Texture* create(const FileData* data);
+
+    static bool readCompressedPVRTCFile(const char* path, FileData* file);
 
-    static Texture* createCompressedDDS(const char* path);
+    static bool readCompressedDDSFile(const char* path, FileData* file);
 
     static GLubyte* readCompressedPVRTC(const char* path, Stream* stream, GLsizei* width, GLsizei* height,
                                         GLenum* format, unsigned int* mipMapCount, unsigned int* faceCount,
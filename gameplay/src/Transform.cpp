@@ -10,7 +10,7 @@ int Transform::_suspendTransformChanged(0);
 std::vector<Transform*> Transform::_transformsChanged;
 
 Transform::Transform()
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _listeners(NULL), _poseIndex(-1)
 {
     GP_REGISTER_SCRIPT_EVENTS();
 
@@ -19,7 +19,7 @@ Transform::Transform()
 }
 
 Transform::Transform(const Vector3& scale, const Quaternion& rotation, const Vector3& translation)
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _listeners(NULL), _poseIndex(-1)
 {
     GP_REGISTER_SCRIPT_EVENTS();
 
@@ -28,7 +28,7 @@ Transform::Transform(const Vector3& scale, const Quaternion& rotation, const Vec
 }
 
 Transform::Transform(const Vector3& scale, const Matrix& rotation, const Vector3& translation)
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _listeners(NULL), _poseIndex(-1)
 {
     GP_REGISTER_SCRIPT_EVENTS();
 
@@ -37,7 +37,7 @@ Transform::Transform(const Vector3& scale, const Matrix& rotation, const Vector3
 }
 
 Transform::Transform(const Transform& copy)
-    : _matrixDirtyBits(0), _listeners(NULL)
+    : _matrixDirtyBits(0), _listeners(NULL), _poseIndex(-1)
 {
     GP_REGISTER_SCRIPT_EVENTS();
 
@@ -48,6 +48,14 @@ Transform::Transform(const Transform& copy)
 Transform::~Transform()
 {
     SAFE_DELETE(_listeners);
+
+    // Make sure a pending animation pose is not written to this transform.
+    if (_poseIndex != -1)
+    {
+        Game* game = Game::getInstance();
+        if (game && game->getAnimationController())
+            game->getAnimationController()->removePose(this);
+    }
 }
 
 void Transform::suspendTransformChanged()
@@ -832,86 +840,100 @@ void Transform::setAnimationPropertyValue(int propertyId, AnimationValue* value,
     GP_ASSERT(value);
     GP_ASSERT(blendWeight >= 0.0f && blendWeight <= 1.0f);
 
+    if (isStatic())
+        return;
+
+    char dirtyBits = blendAnimationPropertyValue(propertyId, value, blendWeight, &_scale, &_rotation, &_translation);
+    if (dirtyBits)
+        dirty(dirtyBits);
+}
+
+char Transform::blendAnimationPropertyValue(int propertyId, AnimationValue* value, float blendWeight,
+                                            Vector3* scale, Quaternion* rotation, Vector3* translation)
+{
+    GP_ASSERT(value);
+    GP_ASSERT(scale && rotation && translation);
+
     switch (propertyId)
     {
         case ANIMATE_SCALE_UNIT:
         {
-            float scale = Curve::lerp(blendWeight, _scale.x, value->getFloat(0));
-            setScale(scale);
-            break;
-        }   
+            float unit = Curve::lerp(blendWeight, scale->x, value->getFloat(0));
+            scale->set(unit, unit, unit);
+            return DIRTY_SCALE;
+        }
         case ANIMATE_SCALE:
         {
-            setScale(Curve::lerp(blendWeight, _scale.x, value->getFloat(0)), Curve::lerp(blendWeight, _scale.y, value->getFloat(1)), Curve::lerp(blendWeight, _scale.z, value->getFloat(2)));
-            break;
+            blendVector(blendWeight, value, 0, scale);
+            return DIRTY_SCALE;
         }
         case ANIMATE_SCALE_X:
         {
-            setScaleX(Curve::lerp(blendWeight, _scale.x, value->getFloat(0)));
-            break;
+            scale->x = Curve::lerp(blendWeight, scale->x, value->getFloat(0));
+            return DIRTY_SCALE;
         }
         case ANIMATE_SCALE_Y:
         {
-            setScaleY(Curve::lerp(blendWeight, _scale.y, value->getFloat(0)));
-            break;
+            scale->y = Curve::lerp(blendWeight, scale->y, value->getFloat(0));
+            return DIRTY_SCALE;
         }
         case ANIMATE_SCALE_Z:
         {
-            setScaleZ(Curve::lerp(blendWeight, _scale.z, value->getFloat(0)));
-            break;
+            scale->z = Curve::lerp(blendWeight, scale->z, value->getFloat(0));
+            return DIRTY_SCALE;
         }
         case ANIMATE_ROTATE:
         {
-            applyAnimationValueRotation(value, 0, blendWeight);
-            break;
+            blendRotation(blendWeight, value, 0, rotation);
+            return DIRTY_ROTATION;
         }
         case ANIMATE_TRANSLATE:
         {
-            setTranslation(Curve::lerp(blendWeight, _translation.x, value->getFloat(0)), Curve::lerp(blendWeight, _translation.y, value->getFloat(1)), Curve::lerp(blendWeight, _translation.z, value->getFloat(2)));
-            break;
+            blendVector(blendWeight, value, 0, translation);
+            return DIRTY_TRANSLATION;
         }
         case ANIMATE_TRANSLATE_X:
         {
-            setTranslationX(Curve::lerp(blendWeight, _translation.x, value->getFloat(0)));
-            break;
+            translation->x = Curve::lerp(blendWeight, translation->x, value->getFloat(0));
+            return DIRTY_TRANSLATION;
         }
         case ANIMATE_TRANSLATE_Y:
         {
-            setTranslationY(Curve::lerp(blendWeight, _translation.y, value->getFloat(0)));
-            break;
+            translation->y = Curve::lerp(blendWeight, translation->y, value->getFloat(0));
+            return DIRTY_TRANSLATION;
         }
         case ANIMATE_TRANSLATE_Z:
         {
-            setTranslationZ(Curve::lerp(blendWeight, _translation.z, value->getFloat(0)));
-            break;
+            translation->z = Curve::lerp(blendWeight, translation->z, value->getFloat(0));
+            return DIRTY_TRANSLATION;
         }
         case ANIMATE_ROTATE_TRANSLATE:
         {
-            applyAnimationValueRotation(value, 0, blendWeight);
-            setTranslation(Curve::lerp(blendWeight, _translation.x, value->getFloat(4)), Curve::lerp(blendWeight, _translation.y, value->getFloat(5)), Curve::lerp(blendWeight, _translation.z, value->getFloat(6)));
-            break;
+            blendRotation(blendWeight, value, 0, rotation);
+            blendVector(blendWeight, value, 4, translation);
+            return DIRTY_ROTATION | DIRTY_TRANSLATION;
         }
         case ANIMATE_SCALE_ROTATE:
         {
-            setScale(Curve::lerp(blendWeight, _scale.x, value->getFloat(0)), Curve::lerp(blendWeight, _scale.y, value->getFloat(1)), Curve::lerp(blendWeight, _scale.z, value->getFloat(2)));
-            applyAnimationValueRotation(value, 3, blendWeight);
-            break;
+            blendVector(blendWeight, value, 0, scale);
+            blendRotation(blendWeight, value, 3, rotation);
+            return DIRTY_SCALE | DIRTY_ROTATION;
         }
         case ANIMATE_SCALE_TRANSLATE:
         {
-            setScale(Curve::lerp(blendWeight, _scale.x, value->getFloat(0)), Curve::lerp(blendWeight, _scale.y, value->getFloat(1)), Curve::lerp(blendWeight, _scale.z, value->getFloat(2)));
-            setTranslation(Curve::lerp(blendWeight, _translation.x, value->getFloat(3)), Curve::lerp(blendWeight, _translation.y, value->getFloat(4)), Curve::lerp(blendWeight, _translation.z, value->getFloat(5)));
-            break;
+            blendVector(blendWeight, value, 0, scale);
+            blendVector(blendWeight, value, 3, translation);
+            return DIRTY_SCALE | DIRTY_TRANSLATION;
         }
         case ANIMATE_SCALE_ROTATE_TRANSLATE:
         {
-            setScale(Curve::lerp(blendWeight, _scale.x, value->getFloat(0)), Curve::lerp(blendWeight, _scale.y, value->getFloat(1)), Curve::lerp(blendWeight, _scale.z, value->getFloat(2)));
-            applyAnimationValueRotation(value, 3, blendWeight);
-            setTranslation(Curve::lerp(blendWeight, _translation.x, value->getFloat(7)), Curve::lerp(blendWeight, _translation.y, value->getFloat(8)), Curve::lerp(blendWeight, _translation.z, value->getFloat(9)));
-            break;
+            blendVector(blendWeight, value, 0, scale);
+            blendRotation(blendWeight, value, 3, rotation);
+            blendVector(blendWeight, value, 7, translation);
+            return DIRTY_SCALE | DIRTY_ROTATION | DIRTY_TRANSLATION;
         }
         default:
-            break;
+            return 0;
     }
 }
 
@@ -998,15 +1020,19 @@ void Transform::cloneInto(Transform* transform, NodeCloneContext &context) const
     transform->dirty(DIRTY_TRANSLATION | DIRTY_ROTATION | DIRTY_SCALE);
 }
 
-void Transform::applyAnimationValueRotation(AnimationValue* value, unsigned int index, float blendWeight)
+void Transform::blendVector(float blendWeight, AnimationValue* value, unsigned int index, Vector3* dst)
 {
-    if (isStatic())
-        return;
+    GP_ASSERT(value && dst);
+    dst->set(Curve::lerp(blendWeight, dst->x, value->getFloat(index)),
+             Curve::lerp(blendWeight, dst->y, value->getFloat(index + 1)),
+             Curve::lerp(blendWeight, dst->z, value->getFloat(index + 2)));
+}
 
-    GP_ASSERT(value);
-    Quaternion::slerp(_rotation.x, _rotation.y, _rotation.z, _rotation.w, value->getFloat(index), value->getFloat(index + 1), value->getFloat(index + 2), value->getFloat(index + 3), blendWeight, 
-        &_rotation.x, &_rotation.y, &_rotation.z, &_rotation.w);
-    dirty(DIRTY_ROTATION);
+void Transform::blendRotation(float blendWeight, AnimationValue* value, unsigned int index, Quaternion* dst)
+{
+    GP_ASSERT(value && dst);
+    Quaternion::slerp(dst->x, dst->y, dst->z, dst->w, value->getFloat(index), value->getFloat(index + 1), value->getFloat(index + 2), value->getFloat(index + 3), blendWeight,
+        &dst->x, &dst->y, &dst->z, &dst->w);
 }
 
 }
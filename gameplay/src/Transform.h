@@ -30,6 +30,8 @@ class ScriptListener;
  */
 class Transform : public AnimationTarget, public ScriptTarget
 {
+    friend class AnimationController;
+
     GP_SCRIPT_EVENTS_START();
     GP_SCRIPT_EVENT(transformChanged, "<Transform>");
     GP_SCRIPT_EVENTS_END();
@@ -881,12 +883,23 @@ protected:
     std::list<TransformListener>* _listeners;
 
 private:
-   
-    void applyAnimationValueRotation(AnimationValue* value, unsigned int index, float blendWeight);
+
+    /**
+     * Blends an animation value of the given property into a scale, rotation and translation.
+     *
+     * @return The dirty bits of the components that were changed.
+     */
+    static char blendAnimationPropertyValue(int propertyId, AnimationValue* value, float blendWeight,
+                                            Vector3* scale, Quaternion* rotation, Vector3* translation);
+
+    static void blendVector(float blendWeight, AnimationValue* value, unsigned int index, Vector3* dst);
+
+    static void blendRotation(float blendWeight, AnimationValue* value, unsigned int index, Quaternion* dst);
 
     static int _suspendTransformChanged;
     static std::vector<Transform*> _transformsChanged;
-    
+
+    int _poseIndex;     // The index of this transform's pose in the animation controller during its update, or -1.
 };
 
 }
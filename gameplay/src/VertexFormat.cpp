@@ -129,6 +129,14 @@ const char* VertexFormat::enumToString(const char* enumName, int value)
                 return "TEXCOORD6";
             case VertexFormat::TEXCOORD7:
                 return "TEXCOORD7";
+            case VertexFormat::INSTANCE_MATRIX0:
+                return "INSTANCE_MATRIX0";
+            case VertexFormat::INSTANCE_MATRIX1:
+                return "INSTANCE_MATRIX1";
+            case VertexFormat::INSTANCE_MATRIX2:
+                return "INSTANCE_MATRIX2";
+            case VertexFormat::INSTANCE_MATRIX3:
+                return "INSTANCE_MATRIX3";
             default:
                 return "UNKNOWN";
         }
@@ -170,6 +178,14 @@ int VertexFormat::enumParse(const char* enumName, const char* str)
             return VertexFormat::TEXCOORD6;
         else if (std::strcmp("TEXCOORD7", str) == 0)
             return VertexFormat::TEXCOORD7;
+        else if (std::strcmp("INSTANCE_MATRIX0", str) == 0)
+            return VertexFormat::INSTANCE_MATRIX0;
+        else if (std::strcmp("INSTANCE_MATRIX1", str) == 0)
+            return VertexFormat::INSTANCE_MATRIX1;
+        else if (std::strcmp("INSTANCE_MATRIX2", str) == 0)
+            return VertexFormat::INSTANCE_MATRIX2;
+        else if (std::strcmp("INSTANCE_MATRIX3", str) == 0)
+            return VertexFormat::INSTANCE_MATRIX3;
     }
     return -1;
 }
@@ -20,6 +20,10 @@ public:
 
     /**
      * Defines a set of usages for vertex elements.
+     *
+     * The INSTANCE_MATRIX usages are per-instance elements rather than per-vertex ones:
+     * the four columns of a world matrix, read once per instance from an instance buffer
+     * through the VERTEX_ATTRIBUTE_INSTANCE_MATRIX_NAME attribute of an effect.
      */
     enum Usage
     {
@@ -37,7 +41,11 @@ public:
         TEXCOORD4 = 12,
         TEXCOORD5 = 13,
         TEXCOORD6 = 14,
-        TEXCOORD7 = 15
+        TEXCOORD7 = 15,
+        INSTANCE_MATRIX0 = 16,
+        INSTANCE_MATRIX1 = 17,
+        INSTANCE_MATRIX2 = 18,
+        INSTANCE_MATRIX3 = 19
     };
 
     /**
@@ -27,8 +27,10 @@
 #include "Ray.h"
 #include "Plane.h"
 #include "Frustum.h"
+#include "FrustumCuller.h"
 #include "BoundingSphere.h"
 #include "BoundingBox.h"
+#include "BoundingBoxTree.h"
 #include "Curve.h"
 
 // Graphics
@@ -39,6 +41,7 @@
 #include "Effect.h"
 #include "Material.h"
 #include "RenderState.h"
+#include "RenderQueue.h"
 #include "VertexFormat.h"
 #include "VertexAttributeBinding.h"
 #include "Drawable.h"
@@ -48,12 +51,17 @@
 #include "Node.h"
 #include "Joint.h"
 #include "Scene.h"
+#include "SceneStreamer.h"
 #include "Font.h"
 #include "SpriteBatch.h"
 #include "Sprite.h"
 #include "Text.h"
 #include "TileSet.h"
 #include "ParticleEmitter.h"
+#include "ParticleController.h"
+#include "JobController.h"
+#include "LoadController.h"
+#include "TaskGraph.h"
 #include "FrameBuffer.h"
 #include "RenderTarget.h"
 #include "DepthStencilTarget.h"
@@ -74,6 +82,8 @@
 #include "AnimationValue.h"
 #include "Animation.h"
 #include "AnimationClip.h"
+#include "AnimationRetarget.h"
+#include "BakedCurve.h"
 
 // Physics
 #include "PhysicsController.h"